@@ -31,10 +31,102 @@
 #include <stdarg.h>
 #include <stdbool.h>
 #include <ctype.h>
+#include <stddef.h>
 
 #include "jmlist.h"
 
+/* memory prefetch hint, used to overlap the cache misses of batched lookups */
+#ifdef __GNUC__
+#define JMLIST_PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define JMLIST_PREFETCH(addr)
+#endif
+
+/* index of the lowest bit set (x != 0) */
+#ifdef __GNUC__
+#define JMLIST_CTZ(x) __builtin_ctz(x)
+#else
+#define JMLIST_CTZ(x) ijmlist_ctz(x)
+static uint32_t ijmlist_ctz(uint32_t x)
+{
+	uint32_t i = 0;
+
+	while( !(x & 1) )
+	{
+		x >>= 1;
+		i++;
+	}
+
+	return i;
+}
+#endif
+
+/* vectors of entry pointers compared JMLIST_VEC_LANES at a time by
+   jmlist_find_builtin, the compiler maps them to the simd instructions of the
+   target (sse2/avx2 on x86, neon on arm) and to scalar code without them */
+#define JMLIST_VEC_LANES 4
+#ifdef __GNUC__
+#define JMLIST_VECTORS
+typedef uintptr_t jmlist_uvec __attribute__((vector_size(JMLIST_VEC_LANES*sizeof(uintptr_t))));
+typedef intptr_t jmlist_svec __attribute__((vector_size(JMLIST_VEC_LANES*sizeof(intptr_t))));
+#endif
+
+/* atomics on counters shared by threads: increment returning the old value,
+   load, and compare and swap (on failure *expected is set to the value) */
+#ifdef __GNUC__
+#define JMLIST_FETCH_INC(ptr) __atomic_fetch_add(ptr,1,__ATOMIC_RELAXED)
+#define JMLIST_LOAD(ptr) __atomic_load_n(ptr,__ATOMIC_RELAXED)
+#define JMLIST_CAS(ptr,expected,desired) \
+	__atomic_compare_exchange_n(ptr,expected,desired,false,__ATOMIC_RELAXED,__ATOMIC_RELAXED)
+#else
+#define JMLIST_FETCH_INC(ptr) ijmlist_fetch_inc(ptr)
+#define JMLIST_LOAD(ptr) ijmlist_load(ptr)
+#define JMLIST_CAS(ptr,expected,desired) ijmlist_cas(ptr,expected,desired)
+static pthread_mutex_t jmlist_atomic_lock = PTHREAD_MUTEX_INITIALIZER;
+static jmlist_index ijmlist_fetch_inc(jmlist_index *ptr)
+{
+	jmlist_index old;
+
+	pthread_mutex_lock(&jmlist_atomic_lock);
+	old = (*ptr)++;
+	pthread_mutex_unlock(&jmlist_atomic_lock);
+	return old;
+}
+static jmlist_index ijmlist_load(jmlist_index *ptr)
+{
+	jmlist_index value;
+
+	pthread_mutex_lock(&jmlist_atomic_lock);
+	value = *ptr;
+	pthread_mutex_unlock(&jmlist_atomic_lock);
+	return value;
+}
+static bool ijmlist_cas(jmlist_index *ptr,jmlist_index *expected,jmlist_index desired)
+{
+	bool swapped;
+
+	pthread_mutex_lock(&jmlist_atomic_lock);
+	swapped = (*ptr == *expected);
+	if( swapped )
+		*ptr = desired;
+	else
+		*expected = *ptr;
+	pthread_mutex_unlock(&jmlist_atomic_lock);
+	return swapped;
+}
+#endif
+
+/* per thread storage of the error status and of the memory counters in use */
+#if defined(__GNUC__)
+#define JMLIST_THREAD __thread
+#elif defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L)
+#define JMLIST_THREAD _Thread_local
+#else
+#define JMLIST_THREAD
+#endif
+
 /* private functions declarations */
+jmlist_status ijmlist_changed(jmlist jml,jmlist_status status);
 jmlist_status ijmlist_idx_get_by_index(jmlist jml,jmlist_index index,void **ptr);
 jmlist_status ijmlist_idx_insert(jmlist jml,void *ptr);
 jmlist_status ijmlist_idx_remove_by_ptr(jmlist jml,void *ptr);
@@ -67,7 +159,10 @@ jmlist_status ijmlist_lnk_seek_next(jmlist jml,jmlist_seek_handle *handle_ptr,vo
 /* associative list routines */
 jmlist_status ijmlist_ass_get_by_index(jmlist jml,jmlist_index index,void **ptr);
 jmlist_status ijmlist_ass_get_by_key(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,void **ptr);
+jmlist_status ijmlist_ass_get_by_keys(jmlist jml,jmlist_key *keys,jmlist_key_length *lens,jmlist_index n,
+		void **out_ptrs,bool *out_found);
 jmlist_status ijmlist_ass_insert(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,void *ptr);
+jmlist_status ijmlist_ass_insert_at(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,void *ptr,jmlist_position pos);
 jmlist_status ijmlist_ass_remove_by_ptr(jmlist jml,void *ptr);
 jmlist_status ijmlist_ass_remove_by_key(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len);
 jmlist_status ijmlist_ass_dump(jmlist jml);
@@ -79,11 +174,196 @@ jmlist_status ijmlist_ass_remove_by_index(jmlist jml,jmlist_index index);
 jmlist_status ijmlist_ass_replace_by_index(jmlist jml,jmlist_index index,void *new_ptr);
 jmlist_status ijmlist_ass_seek_start(jmlist jml,jmlist_seek_handle *handle_ptr);
 jmlist_status ijmlist_ass_seek_next(jmlist jml,jmlist_seek_handle *handle_ptr,void **ptr);
+jmlist_status ijmlist_ass_init(jmlist jml,jmlist_params *params);
+
+/* concurrent associative lists private functions */
+jmlist_status ijmlist_shard_init(jmlist jml,jmlist_params *params);
+assoc_shard *ijmlist_shard_of(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len);
+struct _jmlist_memory_info *ijmlist_shard_enter(assoc_shard *shard);
+void ijmlist_shard_leave(assoc_shard *shard,struct _jmlist_memory_info *prev);
+bool ijmlist_shard_reject(jmlist jml,const char *func);
+jmlist_status ijmlist_shard_insert(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,void *ptr,jmlist_position pos);
+jmlist_status ijmlist_shard_get_by_key(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,void **ptr);
+jmlist_status ijmlist_shard_key_exists(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,jmlist_lookup_result *result);
+jmlist_status ijmlist_shard_get_all_by_key(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,void **out_ptrs,
+		jmlist_index cap,jmlist_index *n);
+jmlist_status ijmlist_shard_get_by_keys(jmlist jml,jmlist_key *keys,jmlist_key_length *lens,jmlist_index n,
+		void **out_ptrs,bool *out_found);
+jmlist_status ijmlist_shard_remove_by_key(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len);
+jmlist_index ijmlist_shard_usage(jmlist jml);
+jmlist_status ijmlist_shard_parse(jmlist jml,JMLISTPARSERCALLBACK callback,void *param);
+jmlist_status ijmlist_shard_find(jmlist jml,JMLISTFINDCALLBACK callback,void *param,jmlist_lookup_result *result,void **ptr);
+jmlist_status ijmlist_shard_dump(jmlist jml);
+jmlist_status ijmlist_shard_free(jmlist jml);
+
+/* key interning private functions */
+intern_key **ijmlist_intern_slot(jmlist_intern_table table,uint32_t hash,jmlist_key key_ptr,jmlist_key_length key_len);
+jmlist_status ijmlist_intern_grow(jmlist_intern_table table);
+intern_key *ijmlist_intern_alloc(jmlist_intern_table table,jmlist_key_length key_len);
+bool ijmlist_intern_owns(jmlist_intern_table table,jmlist_key key_ptr);
+uint32_t ijmlist_ass_hash(jmlist_key key_ptr,jmlist_key_length key_len);
+uint32_t ijmlist_ass_hash_interned(jmlist_key key_ptr,jmlist_key_length key_len);
+bool ijmlist_ass_key_valid(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len);
+bool ijmlist_ass_hash_contains(jmlist jml,uint32_t hash,assoc_entry *pentry);
+uint32_t ijmlist_ass_hash_int(jmlist_key key_ptr,jmlist_key_length key_len);
+void ijmlist_ass_entry_set_key(jmlist jml,assoc_entry *pentry,jmlist_key key_ptr,jmlist_key_length key_len);
+jmlist_status ijmlist_ikey_to_key(jmlist jml,uint64_t key,jmlist_key_value *key_val);
+jmlist_status ijmlist_ass_hash_grow(jmlist jml);
+void ijmlist_ass_rehash_step(jmlist jml);
+void ijmlist_ass_hash_link(jmlist jml,assoc_entry *pentry,bool front);
+void ijmlist_ass_hash_unlink(jmlist jml,assoc_entry *pentry);
+assoc_entry **ijmlist_ass_hash_bucket(jmlist jml,uint32_t hash);
+bool ijmlist_ass_same_key(jmlist jml,assoc_entry *pa,assoc_entry *pb);
+jmlist_status ijmlist_ass_get_all_by_key(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,void **out_ptrs,
+		jmlist_index cap,jmlist_index *n);
+assoc_entry *ijmlist_ass_key_group(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len);
+jmlist_status ijmlist_ass_seek_key_next(jmlist jml,jmlist_seek_handle *handle_ptr,void **ptr);
+void ijmlist_ass_hash_chain_link(jmlist jml,assoc_entry **pbucket,assoc_entry *pentry,bool front);
+assoc_entry *ijmlist_ass_hash_chain_find(assoc_entry *pseeker,uint32_t hash,jmlist_key key_ptr,jmlist_key_length key_len,
+		jmlist_key_value *key_val);
+assoc_entry *ijmlist_ass_hash_lookup(jmlist jml,uint32_t hash,jmlist_key key_ptr,jmlist_key_length key_len);
+assoc_entry *ijmlist_ass_hash_find(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len);
+void ijmlist_ass_hash_shrink(jmlist jml);
+void ijmlist_ass_small_sync(jmlist jml);
+jmlist_status ijmlist_ass_order_build(jmlist jml);
+void ijmlist_ass_order_free(jmlist jml);
+jmlist_index ijmlist_ass_order_count(assoc_order *node);
+uint32_t ijmlist_ass_order_priority(jmlist jml);
+void ijmlist_ass_order_rotate(jmlist jml,assoc_order *node);
+void ijmlist_ass_order_attach(jmlist jml,assoc_order *node);
+void ijmlist_ass_order_detach(jmlist jml,assoc_order *node);
+void ijmlist_ass_order_link(jmlist jml,assoc_entry *pentry);
+void ijmlist_ass_order_unlink(jmlist jml,assoc_entry *pentry);
+assoc_entry *ijmlist_ass_order_select(jmlist jml,jmlist_index index);
+jmlist_status ijmlist_ass_find_entry(jmlist jml,jmlist_index index,assoc_entry **pentry);
+assoc_entry *ijmlist_ass_small_find(jmlist jml,uint32_t hash,jmlist_key key_ptr,jmlist_key_length key_len,
+		jmlist_key_value *key_val);
+void ijmlist_ass_lru_promote(jmlist jml,assoc_entry *pentry);
+void ijmlist_ass_hash_move_front(jmlist jml,assoc_entry *pentry);
+void ijmlist_ass_lru_evict(jmlist jml);
+jmlist_time ijmlist_ass_now(jmlist jml);
+bool ijmlist_ass_expired(jmlist jml,assoc_entry *pentry);
+assoc_entry *ijmlist_ass_first_live(jmlist jml,assoc_entry *pentry);
+jmlist_status ijmlist_ass_wheel_init(jmlist jml);
+void ijmlist_ass_wheel_place(jmlist jml,assoc_entry *pentry);
+void ijmlist_ass_wheel_unlink(jmlist jml,assoc_entry *pentry);
+void ijmlist_ass_drop(jmlist jml,assoc_entry *pentry);
+void ijmlist_ass_unlink(jmlist jml,assoc_entry *pentry);
+void ijmlist_ass_wheel_tick(jmlist jml);
+assoc_filter *ijmlist_ass_filter_alloc(jmlist_index capacity,double fpr);
+void ijmlist_ass_filter_free(assoc_filter *filter);
+bool ijmlist_ass_filter_update(assoc_filter *filter,uint32_t hash,int delta);
+bool ijmlist_ass_filter_reject(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len);
+jmlist_status ijmlist_ass_filter_rebuild(jmlist jml,jmlist_index capacity);
+uint64_t ijmlist_frozen_hash(jmlist jml,uint64_t seed,jmlist_key key_ptr,jmlist_key_length key_len);
+uint32_t ijmlist_frozen_bucket(assoc_frozen *frozen,uint64_t hash);
+uint32_t ijmlist_frozen_slot(assoc_frozen *frozen,uint64_t hash,uint32_t pilot);
+assoc_frozen_slot *ijmlist_frozen_lookup(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len);
+jmlist_status ijmlist_frozen_get_by_keys(jmlist jml,jmlist_key *keys,jmlist_key_length *lens,jmlist_index n,
+		void **out_ptrs,bool *out_found);
+jmlist_status ijmlist_frozen_build(assoc_frozen *frozen,uint64_t *hashes,assoc_entry **entries,uint32_t *order,uint32_t *start,
+		uint8_t *taken);
+void ijmlist_frozen_free(assoc_frozen *frozen);
+jmlist_status ijmlist_frozen_freeze(jmlist jml);
+jmlist_status ijmlist_frozen_thaw(jmlist jml);
+bool ijmlist_frozen_reject(jmlist jml,const char *func);
+
+/* frozen ordered associative list (sorted array) routines */
+jmlist_status ijmlist_sorted_freeze(jmlist jml);
+jmlist_status ijmlist_sorted_thaw(jmlist jml);
+void ijmlist_sorted_free(assoc_sorted *sorted);
+int ijmlist_sorted_compare(jmlist jml,jmlist_index rank,uint64_t pfx,jmlist_key key_ptr,jmlist_key_length key_len);
+uint32_t ijmlist_sorted_search(jmlist jml,uint64_t pfx,jmlist_key key_ptr,jmlist_key_length key_len,bool upper);
+jmlist_index ijmlist_sorted_bound(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,bool upper);
+jmlist_status ijmlist_sorted_find_key(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,jmlist_index *node);
+jmlist_status ijmlist_ass_get_nearest(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,bool below,bool inclusive,
+		jmlist_key *found_ptr,jmlist_key_length *found_len,void **ptr);
+
+/* ordered associative list (b+tree) routines */
+uint64_t ijmlist_bpt_prefix(jmlist_key key_ptr,jmlist_key_length key_len);
+int ijmlist_bpt_compare(jmlist jml,uint64_t pfx1,jmlist_key key1_ptr,jmlist_key_length key1_len,
+		uint64_t pfx2,jmlist_key key2_ptr,jmlist_key_length key2_len);
+jmlist_index ijmlist_bpt_node_search(jmlist jml,bpt_node *node,uint64_t pfx,jmlist_key key_ptr,jmlist_key_length key_len,bool upper);
+bpt_node *ijmlist_bpt_find_leaf(jmlist jml,uint64_t pfx,jmlist_key key_ptr,jmlist_key_length key_len,bool upper);
+bpt_node *ijmlist_bpt_first_leaf(jmlist jml);
+void ijmlist_bpt_lower_bound(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,bpt_node **leaf,jmlist_index *slot);
+jmlist_status ijmlist_bpt_node_alloc(bool leaf,bpt_node **node);
+jmlist_index ijmlist_bpt_node_size(bpt_node *node);
+void ijmlist_bpt_size_add(bpt_node *node,int delta);
+void ijmlist_bpt_node_free(bpt_node *node);
+jmlist_key ijmlist_bpt_key_copy(jmlist_key key_ptr,jmlist_key_length key_len);
+jmlist_index ijmlist_bpt_child_index(bpt_node *parent,bpt_node *child);
+void ijmlist_bpt_insert_parent(jmlist jml,bpt_node *left,bpt_node *right,uint64_t sep_pfx,jmlist_key sep_ptr,
+		jmlist_key_length sep_len,bpt_node **spare);
+void ijmlist_bpt_rebalance(jmlist jml,bpt_node *node);
+jmlist_status ijmlist_bpt_insert(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,void *ptr);
+jmlist_status ijmlist_bpt_remove_at(jmlist jml,bpt_node *leaf,jmlist_index slot);
+jmlist_status ijmlist_bpt_find_index(jmlist jml,jmlist_index index,bpt_node **leaf,jmlist_index *slot);
+jmlist_status ijmlist_bpt_find_key(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,bpt_node **leaf,jmlist_index *slot);
+jmlist_status ijmlist_bpt_find_ptr(jmlist jml,void *ptr,bpt_node **leaf,jmlist_index *slot);
+jmlist_status ijmlist_bpt_get_by_key(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,void **ptr);
+jmlist_status ijmlist_bpt_key_exists(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,jmlist_lookup_result *result);
+jmlist_status ijmlist_bpt_remove_by_key(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len);
+jmlist_status ijmlist_bpt_remove_by_ptr(jmlist jml,void *ptr);
+jmlist_status ijmlist_bpt_ptr_exists(jmlist jml,void *ptr,jmlist_lookup_result *result);
+jmlist_status ijmlist_bpt_get_by_index(jmlist jml,jmlist_index index,void **ptr);
+jmlist_status ijmlist_bpt_remove_by_index(jmlist jml,jmlist_index index);
+jmlist_status ijmlist_bpt_replace_by_index(jmlist jml,jmlist_index index,void *new_ptr);
+void ijmlist_bpt_free_node(bpt_node *node);
+jmlist_status ijmlist_bpt_free(jmlist jml);
+jmlist_status ijmlist_bpt_dump(jmlist jml);
+jmlist_status ijmlist_bpt_seek_range(jmlist jml,jmlist_seek_handle *handle_ptr,jmlist_key lo_ptr,jmlist_key_length lo_len,
+		jmlist_key hi_ptr,jmlist_key_length hi_len);
+jmlist_status ijmlist_bpt_seek_next(jmlist jml,jmlist_seek_handle *handle_ptr,void **ptr);
+jmlist_index ijmlist_idx_seek_next_batch(jmlist jml,jmlist_seek_handle *handle_ptr,void **out,jmlist_index cap);
+jmlist_index ijmlist_lnk_seek_next_batch(jmlist_seek_handle *handle_ptr,void **out,jmlist_index cap);
+jmlist_index ijmlist_ass_seek_next_batch(jmlist jml,jmlist_seek_handle *handle_ptr,void **out,jmlist_index cap);
+jmlist_index ijmlist_bpt_seek_next_batch(jmlist jml,jmlist_seek_handle *handle_ptr,void **out,jmlist_index cap);
+jmlist_status ijmlist_idx_seek_prev(jmlist jml,jmlist_seek_handle *handle_ptr,void **ptr);
+jmlist_status ijmlist_lnk_seek_prev(jmlist jml,jmlist_seek_handle *handle_ptr,void **ptr);
+jmlist_status ijmlist_lnk_seek_stack(jmlist jml,jmlist_seek_handle *handle_ptr);
+void ijmlist_seek_release(jmlist_seek_handle *handle_ptr);
+jmlist_status ijmlist_ass_seek_prev(jmlist jml,jmlist_seek_handle *handle_ptr,void **ptr);
+jmlist_status ijmlist_bpt_seek_prev(jmlist jml,jmlist_seek_handle *handle_ptr,void **ptr);
+jmlist_status ijmlist_idx_remove_current(jmlist jml,jmlist_seek_handle *handle_ptr);
+jmlist_status ijmlist_lnk_remove_current(jmlist jml,jmlist_seek_handle *handle_ptr);
+jmlist_status ijmlist_ass_remove_current(jmlist jml,jmlist_seek_handle *handle_ptr);
+bpt_node *ijmlist_bpt_last_leaf(jmlist jml);
+void ijmlist_parse_split(jmlist jml,parse_chunk *chunks,jmlist_index chunk_count,jmlist_index entry_count);
+jmlist_status ijmlist_parse_job(jmlist jml,parse_job *job,unsigned int nthreads);
+void ijmlist_pipeline_entry(jmlist_pipeline *pipe,void *acc,void *ptr);
+jmlist_status ijmlist_pipeline_check(jmlist_pipeline *pipe,const char *func);
+jmlist_index ijmlist_idx_find_builtin(jmlist jml,jmlist_predicate pred,uintptr_t a,uintptr_t b,
+		jmlist_match_output output,jmlist_index *indexes,jmlist_index cap);
+void ijmlist_parse_done(parse_job *job);
+bool ijmlist_parse_entry(parse_job *job,jmlist_index chunk,void *ptr);
+void ijmlist_parse_chunk(parse_job *job,jmlist_index chunk_index);
+void ijmlist_parse_run(parse_job *job,unsigned int worker);
+void *ijmlist_pool_thread(void *arg);
+unsigned int ijmlist_pool_grow(unsigned int count);
+void ijmlist_pool_stop(void);
+void ijmlist_snap_idx_write(jmlist jml,jmlist_index first,jmlist_index last);
+void ijmlist_snap_node_write(jmlist jml,void *node);
+void ijmlist_snap_free(jmlist jml,void *node);
+snapshot_node *ijmlist_snap_node_slot(jmlist_snap snap,void *node);
+jmlist_status ijmlist_snap_node_grow(jmlist_snap snap);
+jmlist_index ijmlist_snap_next_batch(jmlist_snap snap,jmlist_seek_handle *handle_ptr,void **out,jmlist_index cap);
+void ijmlist_snap_close(jmlist jml);
+void ijmlist_snap_lock_release(snapshot_lock *lock);
 
 static jmlist jmlist_ilist = 0;
 static struct _jmlist_init_params jmlist_cfg = { .flags = 0 };
-static jmlist_status jmlist_errno = JMLIST_ERROR_SUCCESS;
-static struct _jmlist_memory_info jmlist_mem = {
+static JMLIST_THREAD jmlist_status jmlist_errno = JMLIST_ERROR_SUCCESS;
+static parse_pool jmlist_pool = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.work_lock = PTHREAD_MUTEX_INITIALIZER,
+	.work_cond = PTHREAD_COND_INITIALIZER,
+	.done_cond = PTHREAD_COND_INITIALIZER,
+	.thread_count = 0
+};
+/* set in the threads running the callbacks of a parallel parse */
+static JMLIST_THREAD bool jmlist_parse_worker = false;
+static struct _jmlist_memory_info jmlist_mem_global = {
 	.idx_list.total = 0,
 	.idx_list.used = 0,
 	.lnk_list.total = 0,
@@ -94,6 +374,14 @@ static struct _jmlist_memory_info jmlist_mem = {
 	.used = 0
 };
 
+/* memory counters updated by the calling thread, the ones of a shard while
+   the thread holds its lock */
+static JMLIST_THREAD struct _jmlist_memory_info *jmlist_mem_cur = &jmlist_mem_global;
+#define jmlist_mem (*jmlist_mem_cur)
+
+/* header of an interned key */
+#define JMLIST_INTERN_KEY(key_ptr) ((intern_key*)((char*)(key_ptr) - offsetof(intern_key,key)))
+
 /*
  * Sets jmlist internal flags at this moment, only internal list flag is available.
  */
@@ -132,6 +420,15 @@ jmlist_status jmlist_disable_debug(void)
 	return JMLIST_ERROR_SUCCESS;
 }
 
+/*
+ * Returns the error of the last call of the calling thread that returned
+ * JMLIST_ERROR_FAILURE.
+ */
+jmlist_status jmlist_get_errno(void)
+{
+	return jmlist_errno;
+}
+
 /*
    jmlist_cleanup
 
@@ -141,6 +438,9 @@ jmlist_status jmlist_disable_debug(void)
 jmlist_status
 jmlist_cleanup(void)
 {
+	/* threads of jmlist_parse_parallel */
+	ijmlist_pool_stop();
+
 	/* test for internal list flag, warn if there's any list to be freed */
 	if( jmlist_cfg.flags & JMLIST_FLAG_INTERNAL_LIST )
 	{
@@ -211,6 +511,9 @@ ijmlist_idx_set_capacity(jmlist jml,jmlist_index capacity)
 	
 	jmlist_debug(__func__,"reallocating plist (old plist is %p) from capacity %u to capacity %u",
 					jml->idx_list.plist, jml->idx_list.capacity, capacity);
+	
+	/* realloc can move the buffer, snapshots need their own copy first */
+	ijmlist_snap_idx_write(jml,0,jml->idx_list.capacity);
 		
 	jml->idx_list.plist = realloc(jml->idx_list.plist,sizeof(void*)*capacity);
 	if( !jml->idx_list.plist )
@@ -260,6 +563,7 @@ ijmlist_idx_free(jmlist jml)
 {
 	jmlist_debug(__func__,"called with jml=%p",jml);
 	
+	ijmlist_snap_idx_write(jml,0,jml->idx_list.capacity);
 	if( jml->idx_list.plist )
 		free(jml->idx_list.plist);
 	
@@ -333,6 +637,7 @@ ijmlist_idx_push(jmlist jml,void *ptr)
 	jmlist_debug(__func__,"shifting entries one position");
 	
 	jmlist_index i;
+	ijmlist_snap_idx_write(jml,0,jml->idx_list.usage+1);
 	for( i = jml->idx_list.usage ; i >= 1 ; i-- )
 		jml->idx_list.plist[i] = jml->idx_list.plist[i-1];
 	
@@ -441,6 +746,7 @@ ijmlist_idx_pop(jmlist jml,void **ptr)
 	jmlist_index i;
 	*ptr = jml->idx_list.plist[0];
 	jmlist_debug(__func__,"poped entry has ptr=%p, shifting the list entries.",*ptr);
+	ijmlist_snap_idx_write(jml,0,jml->idx_list.capacity);
 	for ( i = 0 ; i < (jml->idx_list.capacity-1) ; i++) {
 		jml->idx_list.plist[i] = jml->idx_list.plist[i+1];
 	}
@@ -501,7 +807,7 @@ ijmlist_lnk_pop(jmlist jml,void **ptr)
 	*ptr = pentry->ptr;
 	
 	jmlist_debug(__func__,"freeing pentry=%p",pentry);
-	free(pentry);
+	ijmlist_snap_free(jml,pentry);
 	
 	jml->lnk_list.usage--;
 	jmlist_debug(__func__,"decreased usage to %u",jml->lnk_list.usage);
@@ -584,6 +890,7 @@ ijmlist_idx_remove_by_ptr(jmlist jml,void *ptr)
 		jmlist_debug(__func__,"found entry (ptr=%p) from list %p in index %u",ptr,jml,i);
 		
 		/* found the entry, clear it */
+		ijmlist_snap_idx_write(jml,i,(jml->flags & JMLIST_IDX_USE_SHIFT) ? jml->idx_list.capacity : i+1);
 		jml->idx_list.plist[i] = JMLIST_EMPTY_PTR;
 		jml->idx_list.usage--;
 		
@@ -660,6 +967,7 @@ ijmlist_lnk_remove_by_ptr(jmlist jml,void *ptr)
 		}
 		
 		jmlist_debug(__func__,"unlinking entry");
+		ijmlist_snap_node_write(jml,pprevious);
 		pprevious->next = pseeker->next;
 		jml->lnk_list.usage--;
 		
@@ -670,7 +978,7 @@ ijmlist_lnk_remove_by_ptr(jmlist jml,void *ptr)
 		
 		
 		jmlist_debug(__func__,"unlinked successfuly, new usage is %u, freeing entry",jml->lnk_list.usage);
-		free(pseeker);
+		ijmlist_snap_free(jml,pseeker);
 		
 		jmlist_debug(__func__,"returning with success.");
 		return JMLIST_ERROR_SUCCESS;
@@ -707,6 +1015,7 @@ ijmlist_idx_insert(jmlist jml,void *ptr)
 	jmlist_index i = 0;
 	while( jml->idx_list.plist[i] != JMLIST_EMPTY_PTR ) i++;
 	jmlist_debug(__func__,"found free entry in %u position (plist[%u]=%p)",i,i,jml->idx_list.plist[i]);
+	ijmlist_snap_idx_write(jml,i,i+1);
 	jml->idx_list.plist[i] = ptr;
 	jml->idx_list.usage++;
 	
@@ -750,6 +1059,7 @@ ijmlist_lnk_insert(jmlist jml,void *ptr)
 		pentry->next = 0;
 		jmlist_debug(__func__,"initialized new entry successfuly (ptr=%p, next=%p)",pentry->ptr,pentry->next);
 		
+		ijmlist_snap_node_write(jml,pseeker);
 		pseeker->next = pentry;
 		
 		jml->lnk_list.usage++;
@@ -779,6 +1089,9 @@ ijmlist_lnk_insert(jmlist jml,void *ptr)
 jmlist_status
 jmlist_create(jmlist *new_jml,jmlist_params *params)
 {
+	jmlist_flags key_flags;
+	jmlist_status status;
+
 	jmlist_debug(__func__,"called with new_jml=%p and params=%p",new_jml,params);
 	
 	/* verify new_jml argument */
@@ -789,6 +1102,73 @@ jmlist_create(jmlist *new_jml,jmlist_params *params)
 		jmlist_debug(__func__,"returning with failure.");
 		return JMLIST_ERROR_FAILURE;
 	}
+
+	/* lru lists need a capacity and keep their own order */
+	if( (params->flags & JMLIST_ASS_LRU) &&
+			(!params->ass_list.capacity || (params->flags & (JMLIST_ASS_ORDERED | JMLIST_ASS_INSERT_AT_TAIL))) )
+	{
+		jmlist_debug(__func__,"invalid lru list parameters (flags=%u, capacity=%u)",params->flags,params->ass_list.capacity);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	/* the filter hashes key bytes, a comparator could match different bytes */
+	if( (params->flags & JMLIST_ASS_FILTER) && (params->flags & JMLIST_ASS_ORDERED) && params->ass_list.compare )
+	{
+		jmlist_debug(__func__,"membership filter can't be used with a custom comparator (flags=%u)",params->flags);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	/* shards are unordered lists, an lru order would only be kept per shard */
+	if( (params->flags & JMLIST_ASS_CONCURRENT) && (params->flags & (JMLIST_ASS_ORDERED | JMLIST_ASS_LRU)) )
+	{
+		jmlist_debug(__func__,"concurrent lists can't be ordered or lru lists (flags=%u)",params->flags);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	/* interned keys are compared by id, the b+tree compares their bytes */
+	if( (params->flags & JMLIST_ASS_INTERNED) && (!params->ass_list.intern ||
+			(params->flags & (JMLIST_ASS_ORDERED | JMLIST_ASS_KEY_U32 | JMLIST_ASS_KEY_U64 | JMLIST_ASS_KEY_PTR))) )
+	{
+		jmlist_debug(__func__,"invalid interned keys list parameters (flags=%u, intern=%p)",params->flags,params->ass_list.intern);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	/* the hashes of small lists are kept in a fixed array */
+	if( (params->flags & JMLIST_ASSOCIATIVE) && (params->ass_list.small_max > JMLIST_ASS_SMALL_MAX) )
+	{
+		jmlist_debug(__func__,"small_max can't be greater than %u (small_max=%u)",JMLIST_ASS_SMALL_MAX,params->ass_list.small_max);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	/* one key width per list */
+	key_flags = params->flags & (JMLIST_ASS_KEY_U32 | JMLIST_ASS_KEY_U64 | JMLIST_ASS_KEY_PTR);
+	if( (params->flags & JMLIST_ASSOCIATIVE) && (key_flags & (key_flags - 1)) )
+	{
+		jmlist_debug(__func__,"only one of the fixed width key flags can be set (flags=%u)",params->flags);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	/* the b+tree doesn't store keys by value */
+	if( (params->flags & JMLIST_ASS_ORDERED) &&
+			(params->flags & (JMLIST_ASS_KEY_U32 | JMLIST_ASS_KEY_U64 | JMLIST_ASS_KEY_PTR)) )
+	{
+		jmlist_debug(__func__,"fixed width keys are not supported in ordered lists (flags=%u)",params->flags);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
 	
 	jmlist_debug(__func__,"allocating a jmlist structure");
 	
@@ -812,7 +1192,7 @@ jmlist_create(jmlist *new_jml,jmlist_params *params)
 	
 	memset(*new_jml,0,sizeof(struct _jmlist));
 	(*new_jml)->flags = params->flags;
-	(*new_jml)->seeking = false;
+	(*new_jml)->generation = 0;
 	memcpy((*new_jml)->tag,params->tag,sizeof((*new_jml)->tag));
 	
 	jmlist_debug(__func__,"initialized new jmlist successfuly (new_jml=%p)",new_jml);
@@ -846,9 +1226,27 @@ jmlist_create(jmlist *new_jml,jmlist_params *params)
 	{
 		jmlist_debug(__func__,"associative list flag detected (new_jml=%p)",*new_jml);
 
-		/* associative-list type, initialize list parameters */
-		(*new_jml)->ass_list.phead = 0;
-		(*new_jml)->ass_list.usage = 0;
+		if( params->flags & JMLIST_ASS_CONCURRENT )
+			status = ijmlist_shard_init(*new_jml,params);
+		else
+			status = ijmlist_ass_init(*new_jml,params);
+
+		if( status == JMLIST_ERROR_FAILURE )
+		{
+			if( (jmlist_cfg.flags & JMLIST_FLAG_INTERNAL_LIST) && !(params->flags & JMLIST_LNK_INTERNAL) )
+				jmlist_remove_by_ptr(jmlist_ilist,*new_jml);
+
+			jmlist_debug(__func__,"freeing new_jml structure memory (new_jml=%p)",*new_jml);
+			free(*new_jml);
+
+			jmlist_mem.total -= sizeof(struct _jmlist);
+			jmlist_mem.used -= sizeof(struct _jmlist);
+			jmlist_debug(__func__,"new jml_mem.total is %u",jmlist_mem.total);
+			jmlist_debug(__func__,"new jml_mem.used is %u",jmlist_mem.used);
+
+			jmlist_debug(__func__,"returning with failure.");
+			return JMLIST_ERROR_FAILURE;
+		}
 	} else
 	{
 		jmlist_debug(__func__,"invalid or unsupported list type new_jml=%p, flags=%u",*new_jml,(*new_jml)->flags);
@@ -870,6 +1268,86 @@ jmlist_create(jmlist *new_jml,jmlist_params *params)
 	return JMLIST_ERROR_SUCCESS;
 }
 
+/*
+ * initializes the fields of a new associative list, fails only when the
+ * membership filter can't be allocated.
+ */
+jmlist_status
+ijmlist_ass_init(jmlist jml,jmlist_params *params)
+{
+	/* associative-list type, initialize list parameters */
+	jml->ass_list.phead = 0;
+	jml->ass_list.ptail = 0;
+	jml->ass_list.usage = 0;
+	jml->ass_list.root = 0;
+	jml->ass_list.compare = params->ass_list.compare;
+	jml->ass_list.hash = ijmlist_ass_hash;
+	jml->ass_list.key_width = 0;
+
+	/* fixed width keys, select the integer hash */
+	if( params->flags & JMLIST_ASS_KEY_U32 )
+		jml->ass_list.key_width = sizeof(uint32_t);
+	else if( params->flags & JMLIST_ASS_KEY_U64 )
+		jml->ass_list.key_width = sizeof(uint64_t);
+	else if( params->flags & JMLIST_ASS_KEY_PTR )
+		jml->ass_list.key_width = sizeof(void*);
+
+	if( jml->ass_list.key_width )
+	{
+		jmlist_debug(__func__,"list has fixed width keys of %u bytes",jml->ass_list.key_width);
+		jml->ass_list.hash = ijmlist_ass_hash_int;
+	}
+
+	/* interned keys, the hash was computed when the key was interned */
+	jml->ass_list.intern = 0;
+	if( params->flags & JMLIST_ASS_INTERNED )
+	{
+		jmlist_debug(__func__,"list keys are interned in table %p",params->ass_list.intern);
+		jml->ass_list.intern = params->ass_list.intern;
+		jml->ass_list.hash = ijmlist_ass_hash_interned;
+	}
+
+	jml->ass_list.capacity = params->ass_list.capacity;
+	jml->ass_list.evict = params->ass_list.evict;
+	jml->ass_list.hits = 0;
+	jml->ass_list.misses = 0;
+	jml->ass_list.evictions = 0;
+	jml->ass_list.wheel = 0;
+	jml->ass_list.clock = params->ass_list.clock;
+	jml->ass_list.filter = 0;
+	jml->ass_list.filter_grow = params->ass_list.filter_grow;
+	jml->ass_list.frozen = 0;
+	jml->ass_list.sorted = 0;
+	jml->ass_list.buckets = 0;
+	jml->ass_list.bucket_count = 0;
+	jml->ass_list.old_buckets = 0;
+	jml->ass_list.old_bucket_count = 0;
+	jml->ass_list.rehash_pos = 0;
+	jml->ass_list.shards = 0;
+	jml->ass_list.shard_count = 0;
+	jml->ass_list.small_max = params->ass_list.small_max ? params->ass_list.small_max : JMLIST_ASS_DEF_SMALL;
+	jml->ass_list.small_count = 0;
+	jml->ass_list.small_chain = 0;
+	memset(jml->ass_list.small_hash,0,sizeof(jml->ass_list.small_hash));
+	jml->ass_list.order_root = 0;
+	jml->ass_list.order_seed = 0x9e3779b9;
+
+	if( params->flags & JMLIST_ASS_FILTER )
+	{
+		jmlist_debug(__func__,"allocating membership filter (jml=%p)",jml);
+		jml->ass_list.filter = ijmlist_ass_filter_alloc(
+				params->ass_list.filter_capacity ? params->ass_list.filter_capacity : JMLIST_ASS_FILTER_DEF_CAPACITY,
+				params->ass_list.filter_fpr > 0.0 ? params->ass_list.filter_fpr : JMLIST_ASS_FILTER_DEF_FPR);
+		if( !jml->ass_list.filter )
+		{
+			jmlist_debug(__func__,"returning with failure.");
+			return JMLIST_ERROR_FAILURE;
+		}
+	}
+
+	return JMLIST_ERROR_SUCCESS;
+}
+
 /*
    jmlist_ptr_exists
 
@@ -1055,6 +1533,19 @@ jmlist_get_by_index(jmlist jml,jmlist_index index,void **ptr)
 	return JMLIST_ERROR_FAILURE;
 }
 
+/*
+ * returns status, when it's a success the list changed and its generation is
+ * bumped: JMLIST_SEEK_CHECKED handles started before fail from now on. failed
+ * calls leave the list as it was and the handles valid.
+ */
+jmlist_status
+ijmlist_changed(jmlist jml,jmlist_status status)
+{
+	if( status == JMLIST_ERROR_SUCCESS )
+		jml->generation++;
+	return status;
+}
+
 /*
    jmlist_remove_by_ptr
   
@@ -1072,15 +1563,15 @@ jmlist_remove_by_ptr(jmlist jml,void *ptr)
 	if( jml->flags & JMLIST_INDEXED )
 	{
 		jmlist_debug(__func__,"passing control to indexed list remove_by_ptr routine.");
-		return ijmlist_idx_remove_by_ptr(jml,ptr);
+		return ijmlist_changed(jml,ijmlist_idx_remove_by_ptr(jml,ptr));
 	} else if( jml->flags & JMLIST_LINKED )
 	{
 		jmlist_debug(__func__,"passing control to linked list remove_by_ptr routine.");
-		return ijmlist_lnk_remove_by_ptr(jml,ptr);
+		return ijmlist_changed(jml,ijmlist_lnk_remove_by_ptr(jml,ptr));
 	} else if( jml->flags & JMLIST_ASSOCIATIVE )
 	{
 		jmlist_debug(__func__,"passing control to the associative list remove_by_ptr routine.");
-		return ijmlist_ass_remove_by_ptr(jml,ptr);
+		return ijmlist_changed(jml,ijmlist_ass_remove_by_ptr(jml,ptr));
 	}
 	
 	jmlist_debug(__func__,"invalid or unsupported list type (jml=%p, flags=%u)",jml,jml->flags);
@@ -1114,6 +1605,10 @@ jmlist_free(jmlist jml)
 		}
 	}
 
+	/* snapshots still open go stale, they only need jmlist_snapshot_free now */
+	if( jml->snap.lock )
+		ijmlist_snap_close(jml);
+
 	/* free the list depending on the type, call its own cleanup routine */
 	if( jml->flags & JMLIST_INDEXED )
 	{
@@ -1167,11 +1662,11 @@ jmlist_push(jmlist jml,void *ptr)
 	if( jml->flags & JMLIST_INDEXED )
 	{
 		jmlist_debug(__func__,"passing control to indexed list push routine.");
-		return ijmlist_idx_push(jml,ptr);
+		return ijmlist_changed(jml,ijmlist_idx_push(jml,ptr));
 	} else if( jml->flags & JMLIST_LINKED )
 	{
 		jmlist_debug(__func__,"passing control to linked list push routine.");
-		return ijmlist_lnk_push(jml,ptr);
+		return ijmlist_changed(jml,ijmlist_lnk_push(jml,ptr));
 	}
 	
 	jmlist_debug(__func__,"invalid or unsupported list type (jml=%p, flags=%u)",jml,jml->flags);
@@ -1199,15 +1694,15 @@ jmlist_pop(jmlist jml,void **ptr)
 		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
 		return JMLIST_ERROR_FAILURE;
 	}
-	
+
 	if( jml->flags & JMLIST_INDEXED )
 	{
 		jmlist_debug(__func__,"passing control to indexed list pop routine.");
-		return ijmlist_idx_pop(jml,ptr);
+		return ijmlist_changed(jml,ijmlist_idx_pop(jml,ptr));
 	} else if( jml->flags & JMLIST_LINKED )
 	{
 		jmlist_debug(__func__,"passing control to linked list pop routine.");
-		return ijmlist_lnk_pop(jml,ptr);
+		return ijmlist_changed(jml,ijmlist_lnk_pop(jml,ptr));
 	}
 	
 	jmlist_debug(__func__,"invalid or unsupported list type (jml=%p, flags=%u)",jml,jml->flags);
@@ -1360,6 +1855,12 @@ jmlist_status_to_string(jmlist_status status,char *output,size_t output_len)
 		case JMLIST_ERROR_UNSUPPORTED:
 			strncpy(output,"JMLIST_ERROR_UNSUPPORTED",output_len);
 			break;
+		case JMLIST_ERROR_FROZEN_LIST:
+			strncpy(output,"JMLIST_ERROR_FROZEN_LIST",output_len);
+			break;
+		case JMLIST_ERROR_STALE_SEEK:
+			strncpy(output,"JMLIST_ERROR_STALE_SEEK",output_len);
+			break;
 		default:
 			strncpy(output,"(unknown status code!)",output_len);
 			break;
@@ -1380,11 +1881,11 @@ jmlist_insert(jmlist jml,void *ptr)
 	if( jml->flags & JMLIST_INDEXED )
 	{
 		jmlist_debug(__func__,"passing control to indexed list insert routine.");
-		return ijmlist_idx_insert(jml,ptr);
+		return ijmlist_changed(jml,ijmlist_idx_insert(jml,ptr));
 	} else if( jml->flags & JMLIST_LINKED )
 	{
 		jmlist_debug(__func__,"passing control to linked list insert routine.");
-		return ijmlist_lnk_insert(jml,ptr);
+		return ijmlist_changed(jml,ijmlist_lnk_insert(jml,ptr));
 	}
 	
 	jmlist_debug(__func__,"invalid or unsupported list type (jml=%p, flags=%u)",jml,jml->flags);
@@ -1418,6 +1919,37 @@ jmlist_insert_with_key(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,v
 	return JMLIST_ERROR_FAILURE;
 }
 
+/*
+   jmlist_insert_with_key_at
+   same as jmlist_insert_with_key but the entry goes to the head (JMLIST_HEAD)
+   or to the tail (JMLIST_TAIL) of the list whatever JMLIST_ASS_INSERT_AT_TAIL
+   says. only for unordered associative lists, lru lists only insert at head.
+*/
+jmlist_status
+jmlist_insert_with_key_at(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,void *ptr,jmlist_position pos)
+{
+	jmlist_debug(__func__,"called with jml=%p, ptr=%p, pos=%u",jml,ptr,pos);
+
+	if( (pos != JMLIST_HEAD) && (pos != JMLIST_TAIL) )
+	{
+		jmlist_debug(__func__,"invalid position specified (pos=%u)",pos);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !(jml->flags & JMLIST_ASSOCIATIVE) || (jml->flags & JMLIST_ASS_ORDERED) ||
+			((jml->flags & JMLIST_ASS_LRU) && (pos == JMLIST_TAIL)) )
+	{
+		jmlist_debug(__func__,"unsuported call for this list (jml=%p, flags=%u) type",(void*)jml,jml->flags);
+		jmlist_errno = JMLIST_ERROR_UNSUPPORTED;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	return ijmlist_ass_insert_at(jml,key_ptr,key_len,ptr,pos);
+}
+
 jmlist_status
 jmlist_dump(jmlist jml)
 {
@@ -1580,1804 +2112,9398 @@ jmlist_free_all(void)
 }
 
 /*
- * associative list method get by index. associative list is nothing but an linked list
- * with a special parameter, the key, so an index access is equal in both lists.
+   associative list hash index
+
+   Key lookups on associative lists go through a hash index, each bucket is a
+   chain of entries (linked by hnext). Entries with the same key are next to
+   each other in the chain and in the same relative order of the list, so the
+   first entry found for a duplicate key is the same one a list walk would find
+   and all of them are found without walking the rest of the chain. The table
+   doubles when usage exceeds the bucket count, instead of rehashing everything
+   at once the old table is kept and JMLIST_ASS_REHASH_STEP of its buckets are
+   moved to the new table on each insert, lookup or remove. While this goes on,
+   old buckets below rehash_pos were already moved and the other ones are still
+   used (new entries are linked there too), so a key is always in one chain.
+*/
+
+/*
+ * FNV-1a hash of the key bytes.
  */
-jmlist_status
-ijmlist_ass_get_by_index(jmlist jml,jmlist_index index,void **ptr)
+uint32_t
+ijmlist_ass_hash(jmlist_key key_ptr,jmlist_key_length key_len)
 {
-	jmlist_debug(__func__,"called with jml=%p, index=%u",jml,index);
-	
-	if( !ptr )
+	uint32_t hash = 2166136261u;
+	jmlist_key_length i;
+
+	for( i = 0 ; i < key_len ; i++ )
 	{
-		jmlist_debug(__func__,"invalid ptr specified (ptr=0)");
-		jmlist_debug(__func__,"returning with failure.");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-		return JMLIST_ERROR_FAILURE;
+		hash ^= ((unsigned char*)key_ptr)[i];
+		hash *= 16777619u;
 	}
-	
-	if( !jml->ass_list.usage )
+
+	return hash;
+}
+
+/*
+ * hash of fixed width integer keys (the 64-bit finalizer of murmur3), the key
+ * is loaded the same way it's stored in assoc_entry.key_val.
+ */
+uint32_t
+ijmlist_ass_hash_int(jmlist_key key_ptr,jmlist_key_length key_len)
+{
+	jmlist_key_value key_val;
+	uint64_t hash;
+
+	key_val.u64 = 0;
+	memcpy(&key_val,key_ptr,key_len < sizeof(key_val) ? key_len : sizeof(key_val));
+	hash = key_val.u64;
+
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53ULL;
+	hash ^= hash >> 33;
+
+	return (uint32_t)hash;
+}
+
+/*
+ * hash of interned keys, stored in their header (same as ijmlist_ass_hash).
+ */
+uint32_t
+ijmlist_ass_hash_interned(jmlist_key key_ptr,jmlist_key_length key_len)
+{
+	return JMLIST_INTERN_KEY(key_ptr)->hash;
+}
+
+/*
+ * checks a key given to an associative list before it's hashed: fixed width
+ * keys must have key_width bytes, interned keys must be keys of the table of
+ * the list (their id and hash are read from the key header).
+ */
+bool
+ijmlist_ass_key_valid(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len)
+{
+	jmlist_intern_table table;
+	uint32_t id;
+
+	if( !(jml->flags & JMLIST_ASSOCIATIVE) )
+		return true;
+
+	if( jml->ass_list.key_width && (key_len != jml->ass_list.key_width) )
 	{
-		jmlist_debug(__func__,"cannot get by index on empty list (ass_list.usage=0)");
-		jmlist_debug(__func__,"returning with failure.");
-		jmlist_errno = JMLIST_ERROR_EMPTY_LIST;
-		return JMLIST_ERROR_FAILURE;
+		jmlist_debug(__func__,"invalid key_len specified (key_len=%u, list keys have %u bytes)",key_len,jml->ass_list.key_width);
+		return false;
 	}
-	
-	/* check bounds! */
-	if( index >= jml->ass_list.usage )
+
+	if( !jml->ass_list.intern )
+		return true;
+
+	table = jml->ass_list.intern;
+	if( !ijmlist_intern_owns(table,key_ptr) )
 	{
-		jmlist_debug(__func__,"index %u is out of bounds with list jml=%p which has %u entries",index,jml,jml->ass_list.usage);
-		jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
-		jmlist_debug(__func__,"returning with failure");
-		return JMLIST_ERROR_FAILURE;
+		jmlist_debug(__func__,"key_ptr=%p is not in the arena of the intern table of list jml=%p",key_ptr,jml);
+		return false;
 	}
-	
-	jmlist_debug(__func__,"parsing associative list for indexed item %u",index);
-	
-	jmlist_index i = 0;
-	assoc_entry *pseeker = jml->ass_list.phead;
-	/* Fix: when pseeker = 0, trow error! */
-	while( i != index )
+
+	id = JMLIST_INTERN_KEY(key_ptr)->id;
+	if( (id >= table->count) || (table->keys[id]->key != (char*)key_ptr) || (table->keys[id]->len != key_len) )
 	{
-		pseeker = pseeker->next;
-		i++;
+		jmlist_debug(__func__,"key_ptr=%p is not a key of the intern table of list jml=%p",key_ptr,jml);
+		return false;
 	}
 
-	*ptr = pseeker->ptr;
-	
-	jmlist_debug(__func__,"returning with success.");
-	return JMLIST_ERROR_SUCCESS;
+	return true;
 }
 
-jmlist_status
-ijmlist_ass_insert(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,void *ptr)
+/*
+ * sets the key of a new entry. lists with fixed width keys copy the key into
+ * the entry and point key_ptr to that copy, lists with interned keys keep the
+ * id of the key in key_val.
+ */
+void
+ijmlist_ass_entry_set_key(jmlist jml,assoc_entry *pentry,jmlist_key key_ptr,jmlist_key_length key_len)
 {
-	jmlist_debug(__func__,"called with jml=%p and ptr=%p",jml,ptr);
-	
-	/* verify key_ptr */
-	if( !key_ptr )
+	pentry->key_len = key_len;
+	pentry->hash = jml->ass_list.hash(key_ptr,key_len);
+
+	if( !jml->ass_list.key_width )
 	{
-		jmlist_debug(__func__,"invalid key_ptr specified (key_ptr=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-		jmlist_debug(__func__,"returning with failure.");
-		return JMLIST_ERROR_FAILURE;
+		pentry->key_ptr = key_ptr;
+		if( jml->ass_list.intern )
+			pentry->key_val.u64 = JMLIST_INTERN_KEY(key_ptr)->id;
+		return;
 	}
-	
-	/* verify key_len */
-	if( !key_len )
+
+	pentry->key_val.u64 = 0;
+	memcpy(&pentry->key_val,key_ptr,key_len);
+	pentry->key_ptr = &pentry->key_val;
+}
+
+/*
+ * allocates a new table with twice the buckets (or JMLIST_ASS_DEF_BUCKETS on
+ * small lists), the current table becomes the old table being migrated. the
+ * entries of a small list are moved to the new table at once.
+ */
+jmlist_status
+ijmlist_ass_hash_grow(jmlist jml)
+{
+	uint32_t bucket_count;
+	assoc_entry **buckets;
+	assoc_entry **ptail;
+	assoc_entry *pseeker;
+	assoc_entry *pnext;
+
+	jmlist_debug(__func__,"called with jml=%p (bucket_count=%u, usage=%u)",jml,jml->ass_list.bucket_count,jml->ass_list.usage);
+
+	/* a previous growth is still being migrated, finish it first */
+	while( jml->ass_list.old_buckets )
+		ijmlist_ass_rehash_step(jml);
+
+	bucket_count = jml->ass_list.bucket_count ? jml->ass_list.bucket_count*2 : JMLIST_ASS_DEF_BUCKETS;
+
+	buckets = (assoc_entry**)calloc(bucket_count,sizeof(assoc_entry*));
+	if( !buckets )
 	{
-		jmlist_debug(__func__,"invalid key_len specified (key_len=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"calloc failed (size %u)!",bucket_count*sizeof(assoc_entry*));
+		jmlist_errno = JMLIST_ERROR_MALLOC;
 		jmlist_debug(__func__,"returning with failure.");
 		return JMLIST_ERROR_FAILURE;
 	}
-	
-	if( (jml->flags & JMLIST_ASS_INSERT_AT_TAIL) )
+
+	jmlist_mem.ass_list.total += bucket_count*sizeof(assoc_entry*);
+	jmlist_mem.ass_list.used += bucket_count*sizeof(assoc_entry*);
+	jmlist_debug(__func__,"new jml_mem.ass_list.total is %u",jmlist_mem.ass_list.total);
+	jmlist_debug(__func__,"new jml_mem.ass_list.used is %u",jmlist_mem.ass_list.used);
+
+	if( jml->ass_list.bucket_count )
 	{
-		jmlist_debug(__func__,"inserting at tail");
-		
-		assoc_entry *pseeker = jml->ass_list.phead;
-		while( pseeker->next ) pseeker = pseeker->next;
-		
-		/* found entry */
-		jmlist_debug(__func__,"found tail at pseeker=%p",pseeker);
-		
-		jmlist_debug(__func__,"allocating linked entry");
-		assoc_entry *pentry = (assoc_entry*)malloc(sizeof(assoc_entry));
-		if( !pentry ) 
+		jml->ass_list.old_buckets = jml->ass_list.buckets;
+		jml->ass_list.old_bucket_count = jml->ass_list.bucket_count;
+		jml->ass_list.rehash_pos = 0;
+	} else
+	{
+		/* keys keep their chain order, so the entries of a key stay together */
+		jmlist_debug(__func__,"moving %u entries of small list jml=%p to the hash index",jml->ass_list.small_count,jml);
+		for( pseeker = jml->ass_list.small_chain ; pseeker ; pseeker = pnext )
 		{
-			jmlist_debug(__func__,"malloc failed (size %u)!",sizeof(assoc_entry));
-			jmlist_errno = JMLIST_ERROR_MALLOC;
-			jmlist_debug(__func__,"returning with failure.");
-			return JMLIST_ERROR_FAILURE;
+			pnext = pseeker->hnext;
+			pseeker->hnext = 0;
+			for( ptail = &buckets[pseeker->hash & (bucket_count-1)] ; *ptail ; ptail = &(*ptail)->hnext );
+			*ptail = pseeker;
+		}
+		jml->ass_list.small_chain = 0;
+		jml->ass_list.small_count = 0;
+	}
+
+	jml->ass_list.buckets = buckets;
+	jml->ass_list.bucket_count = bucket_count;
+	jmlist_debug(__func__,"new table has %u buckets",bucket_count);
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+ * moves up to JMLIST_ASS_REHASH_STEP buckets from the old table to the new
+ * one. each old bucket splits in two new buckets keeping the chain order, the
+ * new buckets are still empty since keys of old buckets not moved yet are
+ * linked in the old table.
+ */
+void
+ijmlist_ass_rehash_step(jmlist jml)
+{
+	assoc_entry *pseeker;
+	assoc_entry *pnext;
+	assoc_entry *head[2];
+	assoc_entry *tail[2];
+	uint32_t old_count = jml->ass_list.old_bucket_count;
+	uint32_t target;
+	uint32_t step;
+	int half;
+
+	for( step = 0 ; jml->ass_list.old_buckets && (step < JMLIST_ASS_REHASH_STEP) ; step++ )
+	{
+		/* old bucket b splits into new buckets b and b+old_count */
+		head[0] = head[1] = 0;
+		tail[0] = tail[1] = 0;
+		for( pseeker = jml->ass_list.old_buckets[jml->ass_list.rehash_pos] ; pseeker ; pseeker = pnext )
+		{
+			pnext = pseeker->hnext;
+			pseeker->hnext = 0;
+			half = (pseeker->hash & old_count) ? 1 : 0;
+			if( tail[half] )
+				tail[half]->hnext = pseeker;
+			else
+				head[half] = pseeker;
+			tail[half] = pseeker;
+		}
+
+		for( half = 0 ; half < 2 ; half++ )
+		{
+			if( !head[half] )
+				continue;
+
+			target = jml->ass_list.rehash_pos + (half ? old_count : 0);
+			jml->ass_list.buckets[target] = head[half];
+		}
+
+		jml->ass_list.old_buckets[jml->ass_list.rehash_pos] = 0;
+		jml->ass_list.rehash_pos++;
+
+		if( jml->ass_list.rehash_pos == old_count )
+		{
+			jmlist_debug(__func__,"migration of %u buckets finished, freeing old table",old_count);
+			free(jml->ass_list.old_buckets);
+			jmlist_mem.ass_list.total -= old_count*sizeof(assoc_entry*);
+			jmlist_mem.ass_list.used -= old_count*sizeof(assoc_entry*);
+			jml->ass_list.old_buckets = 0;
+			jml->ass_list.old_bucket_count = 0;
+			jml->ass_list.rehash_pos = 0;
+		}
+	}
+}
+
+/*
+ * links a new entry in the hash index, pentry->hash must be set. front is set
+ * when the entry was inserted at the head of the list.
+ */
+void
+ijmlist_ass_hash_link(jmlist jml,assoc_entry *pentry,bool front)
+{
+	if( jml->ass_list.filter )
+		ijmlist_ass_filter_update(jml->ass_list.filter,pentry->hash,1);
+
+	ijmlist_ass_hash_chain_link(jml,ijmlist_ass_hash_bucket(jml,pentry->hash),pentry,front);
+	if( !jml->ass_list.bucket_count )
+		ijmlist_ass_small_sync(jml);
+}
+
+/*
+ * returns the chain where a key with hash is, in the old table if its bucket
+ * wasn't migrated yet.
+ */
+assoc_entry **
+ijmlist_ass_hash_bucket(jmlist jml,uint32_t hash)
+{
+	uint32_t old_index;
+
+	if( !jml->ass_list.bucket_count )
+		return &jml->ass_list.small_chain;
+
+	if( jml->ass_list.old_buckets )
+	{
+		old_index = hash & (jml->ass_list.old_bucket_count-1);
+		if( old_index >= jml->ass_list.rehash_pos )
+			return &jml->ass_list.old_buckets[old_index];
+	}
+
+	return &jml->ass_list.buckets[hash & (jml->ass_list.bucket_count-1)];
+}
+
+/*
+ * true if pentry is in the hash chain of hash, compared by address only so
+ * pentry may be an entry already freed.
+ */
+bool
+ijmlist_ass_hash_contains(jmlist jml,uint32_t hash,assoc_entry *pentry)
+{
+	assoc_entry *pseeker;
+
+	for( pseeker = *ijmlist_ass_hash_bucket(jml,hash) ; pseeker ; pseeker = pseeker->hnext )
+	{
+		if( pseeker == pentry )
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * true if both entries have the same key.
+ */
+bool
+ijmlist_ass_same_key(jmlist jml,assoc_entry *pa,assoc_entry *pb)
+{
+	if( jml->ass_list.key_width || jml->ass_list.intern )
+		return pa->key_val.u64 == pb->key_val.u64;
+
+	return (pa->hash == pb->hash) && (pa->key_len == pb->key_len) && !memcmp(pa->key_ptr,pb->key_ptr,pa->key_len);
+}
+
+/*
+ * links an entry in a chain next to the entries with the same key, before
+ * them if front is set or after them otherwise. if there are none the entry
+ * goes to the head or to the end of the chain.
+ */
+void
+ijmlist_ass_hash_chain_link(jmlist jml,assoc_entry **pbucket,assoc_entry *pentry,bool front)
+{
+	assoc_entry **pgroup = 0;
+
+	for( ; *pbucket ; pbucket = &(*pbucket)->hnext )
+	{
+		if( ijmlist_ass_same_key(jml,*pbucket,pentry) )
+		{
+			pgroup = pbucket;
+			break;
+		}
+	}
+
+	if( pgroup )
+	{
+		if( !front )
+		{
+			while( *pgroup && ijmlist_ass_same_key(jml,*pgroup,pentry) )
+				pgroup = &(*pgroup)->hnext;
+		}
+		pbucket = pgroup;
+	} else if( front )
+	{
+		pbucket = ijmlist_ass_hash_bucket(jml,pentry->hash);
+	}
+
+	pentry->hnext = *pbucket;
+	*pbucket = pentry;
+}
+
+/*
+ * moves an entry to the front of the entries with the same key in its chain,
+ * when it became the first of them in list order. lookups return the first
+ * entry of the group, so it must be the first one in the list too.
+ */
+void
+ijmlist_ass_hash_move_front(jmlist jml,assoc_entry *pentry)
+{
+	assoc_entry **pbucket;
+	assoc_entry **pgroup = 0;
+
+	for( pbucket = ijmlist_ass_hash_bucket(jml,pentry->hash) ; *pbucket && (*pbucket != pentry) ; pbucket = &(*pbucket)->hnext )
+	{
+		if( !pgroup && ijmlist_ass_same_key(jml,*pbucket,pentry) )
+			pgroup = pbucket;
+	}
+
+	if( !pgroup || !*pbucket )
+		return;
+
+	jmlist_debug(__func__,"moving entry pentry=%p before its duplicate %p",pentry,*pgroup);
+	*pbucket = pentry->hnext;
+	pentry->hnext = *pgroup;
+	*pgroup = pentry;
+	if( !jml->ass_list.bucket_count )
+		ijmlist_ass_small_sync(jml);
+}
+
+/*
+ * unlinks an entry from the hash index.
+ */
+void
+ijmlist_ass_hash_unlink(jmlist jml,assoc_entry *pentry)
+{
+	assoc_entry **pbucket;
+
+	ijmlist_ass_rehash_step(jml);
+
+	if( jml->ass_list.filter )
+		ijmlist_ass_filter_update(jml->ass_list.filter,pentry->hash,-1);
+
+	for( pbucket = ijmlist_ass_hash_bucket(jml,pentry->hash) ; *pbucket ; pbucket = &(*pbucket)->hnext )
+	{
+		if( *pbucket != pentry )
+			continue;
+
+		*pbucket = pentry->hnext;
+		if( !jml->ass_list.bucket_count )
+			ijmlist_ass_small_sync(jml);
+		return;
+	}
+
+	jmlist_debug(__func__,"entry %p was not found in the hash index of jml=%p, damaged list?",pentry,jml);
+}
+
+/*
+ * walks a bucket chain, key_val is set for lists with fixed width or interned
+ * keys and then entries are matched with a single integer comparison.
+ */
+assoc_entry *
+ijmlist_ass_hash_chain_find(assoc_entry *pseeker,uint32_t hash,jmlist_key key_ptr,jmlist_key_length key_len,
+		jmlist_key_value *key_val)
+{
+	if( key_val )
+	{
+		while( pseeker && (pseeker->key_val.u64 != key_val->u64) )
+			pseeker = pseeker->hnext;
+
+		return pseeker;
+	}
+
+	while( pseeker )
+	{
+		if( (pseeker->hash == hash) && (pseeker->key_len == key_len) && !memcmp(pseeker->key_ptr,key_ptr,key_len) )
+			return pseeker;
+
+		pseeker = pseeker->hnext;
+	}
+
+	return 0;
+}
+
+/*
+ * returns the first entry (in list order) with the key and its hash already
+ * computed, 0 if there's none. no buckets are migrated here.
+ */
+assoc_entry *
+ijmlist_ass_hash_lookup(jmlist jml,uint32_t hash,jmlist_key key_ptr,jmlist_key_length key_len)
+{
+	jmlist_key_value key_val;
+	jmlist_key_value *pkey_val = 0;
+
+	if( jml->ass_list.key_width )
+	{
+		if( key_len != jml->ass_list.key_width )
+			return 0;
+
+		key_val.u64 = 0;
+		memcpy(&key_val,key_ptr,key_len);
+		pkey_val = &key_val;
+	} else if( jml->ass_list.intern )
+	{
+		key_val.u64 = JMLIST_INTERN_KEY(key_ptr)->id;
+		pkey_val = &key_val;
+	}
+
+	if( !jml->ass_list.bucket_count )
+		return ijmlist_ass_small_find(jml,hash,key_ptr,key_len,pkey_val);
+
+	return ijmlist_ass_hash_chain_find(*ijmlist_ass_hash_bucket(jml,hash),hash,key_ptr,key_len,pkey_val);
+}
+
+/*
+ * returns the first entry (in list order) with the key, 0 if there's none.
+ */
+assoc_entry *
+ijmlist_ass_hash_find(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len)
+{
+	ijmlist_ass_rehash_step(jml);
+	return ijmlist_ass_hash_lookup(jml,jml->ass_list.hash(key_ptr,key_len),key_ptr,key_len);
+}
+
+/*
+ * drops the hash index of a list that shrank to small_max/2 entries, the
+ * bucket chains are joined in the chain of the small list.
+ */
+void
+ijmlist_ass_hash_shrink(jmlist jml)
+{
+	assoc_entry **ptail = &jml->ass_list.small_chain;
+	uint32_t i;
+
+	jmlist_debug(__func__,"dropping hash index of jml=%p (bucket_count=%u, usage=%u)",jml,jml->ass_list.bucket_count,jml->ass_list.usage);
+
+	while( jml->ass_list.old_buckets )
+		ijmlist_ass_rehash_step(jml);
+
+	*ptail = 0;
+	for( i = 0 ; i < jml->ass_list.bucket_count ; i++ )
+	{
+		for( *ptail = jml->ass_list.buckets[i] ; *ptail ; ptail = &(*ptail)->hnext );
+	}
+
+	free(jml->ass_list.buckets);
+	jmlist_mem.ass_list.total -= jml->ass_list.bucket_count*sizeof(assoc_entry*);
+	jmlist_mem.ass_list.used -= jml->ass_list.bucket_count*sizeof(assoc_entry*);
+	jml->ass_list.buckets = 0;
+	jml->ass_list.bucket_count = 0;
+	ijmlist_ass_small_sync(jml);
+
+	jmlist_debug(__func__,"new jml_mem.ass_list.total is %u",jmlist_mem.ass_list.total);
+	jmlist_debug(__func__,"new jml_mem.ass_list.used is %u",jmlist_mem.ass_list.used);
+}
+
+/*
+ * copies the hashes of the entries of a small list to small_hash, in the
+ * order of its chain.
+ */
+void
+ijmlist_ass_small_sync(jmlist jml)
+{
+	assoc_entry *pseeker;
+	jmlist_index i = 0;
+
+	for( pseeker = jml->ass_list.small_chain ; pseeker && (i < JMLIST_ASS_SMALL_MAX) ; pseeker = pseeker->hnext, i++ )
+	{
+		jml->ass_list.small_hash[i] = pseeker->hash;
+		jml->ass_list.small_entry[i] = pseeker;
+	}
+
+	jml->ass_list.small_count = i;
+}
+
+/*
+ * first entry of a small list with the key, the hash is compared with all the
+ * hashes of the list without an early exit (branch free, the compiler can
+ * vectorize it), only the entries whose hash matched are compared by key.
+ */
+assoc_entry *
+ijmlist_ass_small_find(jmlist jml,uint32_t hash,jmlist_key key_ptr,jmlist_key_length key_len,
+		jmlist_key_value *key_val)
+{
+	assoc_entry *pentry;
+	uint32_t match = 0;
+	uint32_t i;
+
+	for( i = 0 ; i < jml->ass_list.small_count ; i++ )
+		match |= (uint32_t)(jml->ass_list.small_hash[i] == hash) << i;
+
+	for( ; match ; match &= match - 1 )
+	{
+		pentry = jml->ass_list.small_entry[JMLIST_CTZ(match)];
+		if( key_val ? (pentry->key_val.u64 == key_val->u64) :
+				((pentry->key_len == key_len) && !memcmp(pentry->key_ptr,key_ptr,key_len)) )
+			return pentry;
+	}
+
+	return 0;
+}
+
+/*
+ * moves an entry of an lru list to the head of the list (most recently used).
+ */
+void
+ijmlist_ass_lru_promote(jmlist jml,assoc_entry *pentry)
+{
+	if( pentry == jml->ass_list.phead )
+		return;
+
+	jmlist_debug(__func__,"moving entry pentry=%p to the head of jml=%p",pentry,jml);
+	jml->generation++;
+
+	if( pentry->order )
+		ijmlist_ass_order_detach(jml,pentry->order);
+
+	ijmlist_snap_node_write(jml,pentry->prev);
+	ijmlist_snap_node_write(jml,pentry);
+	pentry->prev->next = pentry->next;
+	if( pentry->next )
+		pentry->next->prev = pentry->prev;
+	else
+		jml->ass_list.ptail = pentry->prev;
+
+	pentry->prev = 0;
+	pentry->next = jml->ass_list.phead;
+	jml->ass_list.phead->prev = pentry;
+	jml->ass_list.phead = pentry;
+
+	/* it's the first of its duplicates in the list now */
+	ijmlist_ass_hash_move_front(jml,pentry);
+
+	if( pentry->order )
+		ijmlist_ass_order_attach(jml,pentry->order);
+}
+
+/*
+ * removes the tail entry of an lru list (least recently used), the evict
+ * callback is called before the entry is freed.
+ */
+void
+ijmlist_ass_lru_evict(jmlist jml)
+{
+	assoc_entry *pentry = jml->ass_list.ptail;
+
+	if( !pentry )
+		return;
+
+	jmlist_debug(__func__,"evicting entry pentry=%p (ptr=%p) from jml=%p",pentry,pentry->ptr,jml);
+
+	ijmlist_ass_drop(jml,pentry);
+	jml->ass_list.evictions++;
+}
+
+/*
+ * associative list membership filter (counting bloom filter)
+ */
+
+/*
+ * allocates a filter for capacity keys with the false positive rate fpr. the
+ * number of counters per key is k/ln(2) with k = -log2(fpr) counters set.
+ */
+assoc_filter *
+ijmlist_ass_filter_alloc(jmlist_index capacity,double fpr)
+{
+	assoc_filter *filter;
+	uint32_t blocks;
+	uint32_t k = 0;
+	double p;
+
+	for( p = fpr ; (p < 1.0) && (k < 16) ; p *= 2.0 )
+		k++;
+	if( !k )
+		k = 1;
+
+	blocks = (uint32_t)(((double)capacity*k*1.4427)/JMLIST_ASS_FILTER_BLOCK_COUNTERS) + 1;
+
+	filter = (assoc_filter*)calloc(1,sizeof(assoc_filter) + blocks*JMLIST_ASS_FILTER_BLOCK_COUNTERS/2);
+	if( !filter )
+	{
+		jmlist_debug(__func__,"calloc failed (size %u)!",sizeof(assoc_filter) + blocks*JMLIST_ASS_FILTER_BLOCK_COUNTERS/2);
+		jmlist_errno = JMLIST_ERROR_MALLOC;
+		return 0;
+	}
+
+	jmlist_mem.ass_list.total += sizeof(assoc_filter) + blocks*JMLIST_ASS_FILTER_BLOCK_COUNTERS/2;
+	jmlist_mem.ass_list.used += sizeof(assoc_filter) + blocks*JMLIST_ASS_FILTER_BLOCK_COUNTERS/2;
+
+	filter->blocks = blocks;
+	filter->k = k;
+	filter->capacity = capacity;
+	filter->fpr = fpr;
+
+	jmlist_debug(__func__,"new filter %p for %u keys has %u blocks and k=%u",filter,capacity,blocks,k);
+	return filter;
+}
+
+void
+ijmlist_ass_filter_free(assoc_filter *filter)
+{
+	jmlist_mem.ass_list.total -= sizeof(assoc_filter) + filter->blocks*JMLIST_ASS_FILTER_BLOCK_COUNTERS/2;
+	jmlist_mem.ass_list.used -= sizeof(assoc_filter) + filter->blocks*JMLIST_ASS_FILTER_BLOCK_COUNTERS/2;
+	free(filter);
+}
+
+/*
+ * adds (delta=1), removes (delta=-1) or tests (delta=0) a key hash. returns
+ * false if the key is surely not in the filter (only meaningful for tests).
+ */
+bool
+ijmlist_ass_filter_update(assoc_filter *filter,uint32_t hash,int delta)
+{
+	uint8_t *block;
+	uint32_t h1;
+	uint32_t h2;
+	uint32_t counter;
+	uint32_t value;
+	uint32_t i;
+
+	block = filter->counters + (((uint64_t)hash*filter->blocks) >> 32)*(JMLIST_ASS_FILTER_BLOCK_COUNTERS/2);
+	h1 = hash*0x9e3779b1u;
+	h1 ^= h1 >> 15;
+	h2 = (hash ^ (hash >> 16))*0x85ebca6bu;
+	h2 = (h2 ^ (h2 >> 13)) | 1;
+
+	for( i = 0 ; i < filter->k ; i++ )
+	{
+		counter = (h1 + i*h2) & (JMLIST_ASS_FILTER_BLOCK_COUNTERS-1);
+		value = (block[counter/2] >> ((counter & 1)*4)) & 0xf;
+
+		if( !delta )
+		{
+			if( !value )
+				return false;
+			continue;
+		}
+
+		/* saturated counters are not touched anymore */
+		if( (value == 0xf) || (!value && (delta < 0)) )
+			continue;
+
+		value += delta;
+		block[counter/2] = (block[counter/2] & ~(0xf << ((counter & 1)*4))) | (value << ((counter & 1)*4));
+	}
+
+	return true;
+}
+
+/*
+ * true if the key is surely not in the list.
+ */
+bool
+ijmlist_ass_filter_reject(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len)
+{
+	if( !jml->ass_list.filter )
+		return false;
+
+	return !ijmlist_ass_filter_update(jml->ass_list.filter,jml->ass_list.hash(key_ptr,key_len),0);
+}
+
+/*
+ * rebuilds the filter for capacity keys from the keys in the list, O(N).
+ */
+jmlist_status
+ijmlist_ass_filter_rebuild(jmlist jml,jmlist_index capacity)
+{
+	assoc_filter *filter;
+	assoc_entry *pseeker;
+	bpt_node *leaf;
+	jmlist_index i;
+
+	jmlist_debug(__func__,"rebuilding filter of jml=%p (capacity=%u, new capacity=%u, usage=%u)",
+			jml,jml->ass_list.filter->capacity,capacity,jml->ass_list.usage);
+
+	filter = ijmlist_ass_filter_alloc(capacity,jml->ass_list.filter->fpr);
+	if( !filter )
+	{
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( jml->flags & JMLIST_ASS_ORDERED )
+	{
+		for( leaf = ijmlist_bpt_first_leaf(jml) ; leaf ; leaf = leaf->next )
+		{
+			for( i = 0 ; i < leaf->count ; i++ )
+				ijmlist_ass_filter_update(filter,jml->ass_list.hash(leaf->key_ptr[i],leaf->key_len[i]),1);
 		}
-		jmlist_debug(__func__,"new associative entry pentry=%p allocated",pentry);
-		
-		/* initialize entry */
-		pentry->ptr = ptr;
-		pentry->key_ptr = key_ptr;
-		pentry->key_len = key_len;
-		pentry->next = 0;
-		jmlist_debug(__func__,"initialized new entry successfuly (ptr=%p, next=%p, key=%p, len=%u)",
-					 pentry->ptr,pentry->next,pentry->key_ptr,pentry->key_len);
-		
-		pseeker->next = pentry;
-		
-		jml->ass_list.usage++;
-		jmlist_debug(__func__,"new usage of list is %u",jml->ass_list.usage);
-		
-		jmlist_mem.ass_list.total += sizeof(assoc_entry);
-		jmlist_mem.ass_list.used += sizeof(assoc_entry);
-		jmlist_debug(__func__,"new jml_mem.ass_list.total is %u",jmlist_mem.ass_list.total);
-		jmlist_debug(__func__,"new jml_mem.ass_list.used is %u",jmlist_mem.ass_list.used);
-		
 	} else
 	{
-		jmlist_debug(__func__,"allocating associative entry");
-		assoc_entry *pentry = (assoc_entry*)malloc(sizeof(assoc_entry));
-		if( !pentry ) 
+		for( pseeker = jml->ass_list.phead ; pseeker ; pseeker = pseeker->next )
+			ijmlist_ass_filter_update(filter,pseeker->hash,1);
+	}
+
+	ijmlist_ass_filter_free(jml->ass_list.filter);
+	jml->ass_list.filter = filter;
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+   jmlist_filter_rebuild
+
+   rebuilds the membership filter of an associative list (JMLIST_ASS_FILTER)
+   from the keys in the list, with room for twice as many keys when the list
+   outgrew it. the filter keeps its size as the list grows, so its false
+   positive rate goes up past its capacity, this brings it back. it walks all
+   the entries, call it when an O(N) pause is fine (params.ass_list.filter_grow
+   does it from the insert that outgrows the filter instead).
+*/
+jmlist_status
+jmlist_filter_rebuild(jmlist jml)
+{
+	jmlist_index capacity;
+
+	jmlist_debug(__func__,"called with jml=%p",jml);
+
+	if( !jml ) {
+		jmlist_debug(__func__,"invalid jml specified (jml=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( ijmlist_shard_reject(jml,__func__) || ijmlist_frozen_reject(jml,__func__) )
+		return JMLIST_ERROR_FAILURE;
+
+	if( !(jml->flags & JMLIST_ASSOCIATIVE) || !jml->ass_list.filter ) {
+		jmlist_debug(__func__,"list jml=%p has no membership filter (flags=%u)",jml,jml->flags);
+		jmlist_errno = JMLIST_ERROR_UNSUPPORTED;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	capacity = jml->ass_list.filter->capacity;
+	if( jml->ass_list.usage >= capacity )
+		capacity = jml->ass_list.usage*2;
+
+	return ijmlist_ass_filter_rebuild(jml,capacity);
+}
+
+/*
+ * frozen associative lists (minimal perfect hash)
+ */
+
+/*
+ * 64-bit hash of a key for the perfect hash, distinct keys must not collide
+ * here so the 32-bit hash of the index can't be used.
+ */
+uint64_t
+ijmlist_frozen_hash(jmlist jml,uint64_t seed,jmlist_key key_ptr,jmlist_key_length key_len)
+{
+	jmlist_key_value key_val;
+	uint64_t hash;
+	jmlist_key_length i;
+
+	if( jml->ass_list.key_width )
+	{
+		key_val.u64 = 0;
+		memcpy(&key_val,key_ptr,key_len);
+		hash = key_val.u64 ^ seed;
+	} else if( jml->ass_list.intern )
+		hash = JMLIST_INTERN_KEY(key_ptr)->id ^ seed;
+	else
+	{
+		hash = 14695981039346656037ULL ^ seed;
+		for( i = 0 ; i < key_len ; i++ )
+		{
+			hash ^= ((unsigned char*)key_ptr)[i];
+			hash *= 1099511628211ULL;
+		}
+	}
+
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53ULL;
+	hash ^= hash >> 33;
+
+	return hash;
+}
+
+uint32_t
+ijmlist_frozen_bucket(assoc_frozen *frozen,uint64_t hash)
+{
+	return (uint32_t)(((hash >> 32)*frozen->bucket_count) >> 32);
+}
+
+uint32_t
+ijmlist_frozen_slot(assoc_frozen *frozen,uint64_t hash,uint32_t pilot)
+{
+	hash ^= (pilot + 1)*0x9e3779b97f4a7c15ULL;
+	hash ^= hash >> 29;
+	hash *= 0xbf58476d1ce4e5b9ULL;
+	hash ^= hash >> 32;
+
+	return (uint32_t)(((hash & 0xffffffffULL)*frozen->count) >> 32);
+}
+
+/*
+ * returns the slot of the key in a frozen list, 0 if there's none. the hash of
+ * fixed width keys (or of the id of interned keys) is a bijection of the key so
+ * their keys aren't compared.
+ */
+assoc_frozen_slot *
+ijmlist_frozen_lookup(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len)
+{
+	assoc_frozen *frozen = jml->ass_list.frozen;
+	assoc_frozen_slot *slot;
+	uint64_t hash;
+
+	if( !frozen->count )
+		return 0;
+
+	if( jml->ass_list.key_width && (key_len != jml->ass_list.key_width) )
+		return 0;
+
+	hash = ijmlist_frozen_hash(jml,frozen->seed,key_ptr,key_len);
+	slot = &frozen->slots[ijmlist_frozen_slot(frozen,hash,frozen->pilots[ijmlist_frozen_bucket(frozen,hash)])];
+
+	if( slot->hash != hash )
+		return 0;
+
+	if( !jml->ass_list.key_width && !jml->ass_list.intern &&
+			((slot->key_len != key_len) || memcmp(slot->key_ptr,key_ptr,key_len)) )
+		return 0;
+
+	return slot;
+}
+
+/*
+ * batched lookups of a frozen list, same as ijmlist_ass_get_by_keys: pilots
+ * of a group of keys are prefetched, then their slots, then keys are compared.
+ */
+jmlist_status
+ijmlist_frozen_get_by_keys(jmlist jml,jmlist_key *keys,jmlist_key_length *lens,jmlist_index n,
+		void **out_ptrs,bool *out_found)
+{
+	assoc_frozen *frozen = jml->ass_list.frozen;
+	assoc_frozen_slot *slot[JMLIST_ASS_BATCH_GROUP];
+	uint64_t hash[JMLIST_ASS_BATCH_GROUP];
+	jmlist_index base;
+	jmlist_index group;
+	jmlist_index i;
+
+	jmlist_debug(__func__,"called with jml=%p, n=%u",jml,n);
+
+	for( base = 0 ; base < n ; base += group )
+	{
+		group = (n - base) < JMLIST_ASS_BATCH_GROUP ? (n - base) : JMLIST_ASS_BATCH_GROUP;
+
+		for( i = 0 ; i < group ; i++ )
+		{
+			out_found[base+i] = false;
+			out_ptrs[base+i] = 0;
+			if( !frozen->count || (jml->ass_list.key_width && (lens[base+i] != jml->ass_list.key_width)) )
+				continue;
+
+			hash[i] = ijmlist_frozen_hash(jml,frozen->seed,keys[base+i],lens[base+i]);
+			JMLIST_PREFETCH(&frozen->pilots[ijmlist_frozen_bucket(frozen,hash[i])]);
+		}
+
+		for( i = 0 ; i < group ; i++ )
+		{
+			slot[i] = 0;
+			if( !frozen->count || (jml->ass_list.key_width && (lens[base+i] != jml->ass_list.key_width)) )
+				continue;
+
+			slot[i] = &frozen->slots[ijmlist_frozen_slot(frozen,hash[i],frozen->pilots[ijmlist_frozen_bucket(frozen,hash[i])])];
+			JMLIST_PREFETCH(slot[i]);
+		}
+
+		for( i = 0 ; i < group ; i++ )
+		{
+			if( !slot[i] || (slot[i]->hash != hash[i]) )
+				continue;
+
+			if( !jml->ass_list.key_width && !jml->ass_list.intern &&
+					((slot[i]->key_len != lens[base+i]) || memcmp(slot[i]->key_ptr,keys[base+i],lens[base+i])) )
+				continue;
+
+			out_found[base+i] = true;
+			out_ptrs[base+i] = slot[i]->ptr;
+		}
+	}
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+ * searches the pilots of all buckets with a seed, keys were already hashed
+ * with it. buckets are placed from the largest to the smallest, the pilot of
+ * a bucket is the first one that sends its keys to free and distinct slots.
+ */
+jmlist_status
+ijmlist_frozen_build(assoc_frozen *frozen,uint64_t *hashes,assoc_entry **entries,uint32_t *order,uint32_t *start,
+		uint8_t *taken)
+{
+	uint32_t *bucket_order;
+	uint32_t *size_start;
+	uint32_t max_size = 0;
+	uint32_t bucket;
+	uint32_t size;
+	uint32_t pilot;
+	uint32_t slot;
+	uint32_t i;
+	uint32_t j;
+
+	/* group keys by bucket (counting sort) */
+	memset(start,0,(frozen->bucket_count+1)*sizeof(uint32_t));
+	for( i = 0 ; i < frozen->count ; i++ )
+		start[ijmlist_frozen_bucket(frozen,hashes[i])+1]++;
+	for( i = 0 ; i < frozen->bucket_count ; i++ )
+	{
+		if( start[i+1] > max_size )
+			max_size = start[i+1];
+		start[i+1] += start[i];
+	}
+	for( i = 0 ; i < frozen->count ; i++ )
+	{
+		bucket = ijmlist_frozen_bucket(frozen,hashes[i]);
+		order[start[bucket]++] = i;
+	}
+	for( i = frozen->bucket_count ; i > 0 ; i-- )
+		start[i] = start[i-1];
+	start[0] = 0;
+
+	/* order buckets by decreasing size (counting sort) */
+	bucket_order = (uint32_t*)malloc(frozen->bucket_count*sizeof(uint32_t));
+	size_start = (uint32_t*)calloc(max_size+2,sizeof(uint32_t));
+	if( !bucket_order || !size_start )
+	{
+		jmlist_debug(__func__,"malloc failed for the bucket order of %u buckets!",frozen->bucket_count);
+		free(bucket_order);
+		free(size_start);
+		jmlist_errno = JMLIST_ERROR_MALLOC;
+		return JMLIST_ERROR_FAILURE;
+	}
+	for( i = 0 ; i < frozen->bucket_count ; i++ )
+		size_start[max_size - (start[i+1]-start[i]) + 1]++;
+	for( i = 0 ; i <= max_size ; i++ )
+		size_start[i+1] += size_start[i];
+	for( i = 0 ; i < frozen->bucket_count ; i++ )
+		bucket_order[size_start[max_size - (start[i+1]-start[i])]++] = i;
+	free(size_start);
+
+	memset(taken,0,frozen->count);
+	for( i = 0 ; i < frozen->bucket_count ; i++ )
+	{
+		bucket = bucket_order[i];
+		size = start[bucket+1] - start[bucket];
+		if( !size )
+		{
+			frozen->pilots[bucket] = 0;
+			continue;
+		}
+
+		for( pilot = 0 ; pilot < JMLIST_FROZEN_MAX_PILOT ; pilot++ )
+		{
+			for( j = 0 ; j < size ; j++ )
+			{
+				slot = ijmlist_frozen_slot(frozen,hashes[order[start[bucket]+j]],pilot);
+				if( taken[slot] )
+					break;
+				taken[slot] = 1;
+			}
+
+			if( j == size )
+				break;
+
+			/* undo the slots taken by this pilot */
+			while( j-- > 0 )
+				taken[ijmlist_frozen_slot(frozen,hashes[order[start[bucket]+j]],pilot)] = 0;
+		}
+
+		if( pilot == JMLIST_FROZEN_MAX_PILOT )
+		{
+			jmlist_debug(__func__,"no pilot found for bucket %u (%u keys) with seed %llu",bucket,size,
+					(unsigned long long)frozen->seed);
+			free(bucket_order);
+			jmlist_errno = JMLIST_ERROR_FAILURE;
+			return JMLIST_ERROR_FAILURE;
+		}
+
+		frozen->pilots[bucket] = pilot;
+		for( j = 0 ; j < size ; j++ )
+		{
+			slot = ijmlist_frozen_slot(frozen,hashes[order[start[bucket]+j]],pilot);
+			frozen->slots[slot].hash = hashes[order[start[bucket]+j]];
+			frozen->slots[slot].key_ptr = entries[order[start[bucket]+j]]->key_ptr;
+			frozen->slots[slot].key_len = entries[order[start[bucket]+j]]->key_len;
+			frozen->slots[slot].ptr = entries[order[start[bucket]+j]]->ptr;
+			frozen->slots[slot].entry = entries[order[start[bucket]+j]];
+		}
+	}
+
+	free(bucket_order);
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+   jmlist_freeze
+   replaces the hash index of an unordered associative list by a minimal
+   perfect hash, or the b+tree of an ordered one by a sorted array, the list
+   can't be changed until jmlist_thaw is called.
+*/
+jmlist_status
+jmlist_freeze(jmlist jml)
+{
+	jmlist_debug(__func__,"called with jml=%p",jml);
+
+	if( ijmlist_shard_reject(jml,__func__) )
+		return JMLIST_ERROR_FAILURE;
+
+	if( !(jml->flags & JMLIST_ASSOCIATIVE) || (jml->flags & JMLIST_ASS_LRU) ||
+			(jml->ass_list.wheel && jml->ass_list.wheel->count) )
+	{
+		jmlist_debug(__func__,"only associative lists without lru or ttl entries can be frozen (jml=%p, flags=%u)",jml,jml->flags);
+		jmlist_errno = JMLIST_ERROR_UNSUPPORTED;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( jml->ass_list.frozen || jml->ass_list.sorted )
+	{
+		jmlist_debug(__func__,"list jml=%p is already frozen",jml);
+		jmlist_debug(__func__,"returning with success.");
+		return JMLIST_ERROR_SUCCESS;
+	}
+
+	if( jml->flags & JMLIST_ASS_ORDERED )
+	{
+		/* the b+tree leaves seeks point to are freed */
+		jmlist_debug(__func__,"passing control to the ordered associative list freeze routine.");
+		return ijmlist_changed(jml,ijmlist_sorted_freeze(jml));
+	}
+
+	/* the hash chains are freed */
+	jmlist_debug(__func__,"passing control to the unordered associative list freeze routine.");
+	return ijmlist_changed(jml,ijmlist_frozen_freeze(jml));
+}
+
+/*
+ * replaces the hash index of an unordered associative list by a minimal
+ * perfect hash of its keys.
+ */
+jmlist_status
+ijmlist_frozen_freeze(jmlist jml)
+{
+	assoc_frozen *frozen;
+	assoc_entry *pseeker;
+	assoc_entry **entries = 0;
+	uint64_t *hashes = 0;
+	uint32_t *order = 0;
+	uint32_t *start = 0;
+	uint8_t *taken = 0;
+	uint32_t count = 0;
+	uint32_t bucket_count;
+	uint32_t seed;
+	size_t size;
+	uint32_t i;
+
+	jmlist_debug(__func__,"called with jml=%p",jml);
+
+	/* the perfect hash has the first entry of each key, the one the hash
+	   index returns */
+	if( jml->ass_list.usage )
+	{
+		entries = (assoc_entry**)malloc(jml->ass_list.usage*sizeof(assoc_entry*));
+		if( !entries )
+		{
+			jmlist_debug(__func__,"malloc failed (size %u)!",jml->ass_list.usage*sizeof(assoc_entry*));
+			jmlist_errno = JMLIST_ERROR_MALLOC;
+			jmlist_debug(__func__,"returning with failure.");
+			return JMLIST_ERROR_FAILURE;
+		}
+
+		for( pseeker = jml->ass_list.phead ; pseeker ; pseeker = pseeker->next )
+		{
+			if( ijmlist_ass_hash_lookup(jml,pseeker->hash,pseeker->key_ptr,pseeker->key_len) == pseeker )
+				entries[count++] = pseeker;
+		}
+	}
+
+	bucket_count = count/JMLIST_FROZEN_BUCKET_KEYS + 1;
+	size = sizeof(assoc_frozen) + count*sizeof(assoc_frozen_slot) + bucket_count*sizeof(uint32_t);
+	frozen = (assoc_frozen*)calloc(1,size);
+	if( count )
+	{
+		hashes = (uint64_t*)malloc(count*sizeof(uint64_t));
+		order = (uint32_t*)malloc(count*sizeof(uint32_t));
+		start = (uint32_t*)malloc((bucket_count+1)*sizeof(uint32_t));
+		taken = (uint8_t*)malloc(count);
+	}
+	if( !frozen || (count && (!hashes || !order || !start || !taken)) )
+	{
+		jmlist_debug(__func__,"malloc failed for the perfect hash of %u keys!",count);
+		free(frozen);
+		free(entries);
+		free(hashes);
+		free(order);
+		free(start);
+		free(taken);
+		jmlist_errno = JMLIST_ERROR_MALLOC;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	frozen->count = count;
+	frozen->bucket_count = bucket_count;
+	frozen->slots = (assoc_frozen_slot*)(frozen + 1);
+	frozen->pilots = (uint32_t*)(frozen->slots + count);
+
+	for( seed = 0 ; count && (seed < JMLIST_FROZEN_MAX_SEEDS) ; seed++ )
+	{
+		frozen->seed = seed*0x9e3779b97f4a7c15ULL;
+		for( i = 0 ; i < count ; i++ )
+			hashes[i] = ijmlist_frozen_hash(jml,frozen->seed,entries[i]->key_ptr,entries[i]->key_len);
+
+		if( ijmlist_frozen_build(frozen,hashes,entries,order,start,taken) == JMLIST_ERROR_SUCCESS )
+			break;
+
+		if( jmlist_errno == JMLIST_ERROR_MALLOC )
+			seed = JMLIST_FROZEN_MAX_SEEDS;
+	}
+
+	free(entries);
+	free(hashes);
+	free(order);
+	free(start);
+	free(taken);
+
+	if( count && (seed >= JMLIST_FROZEN_MAX_SEEDS) )
+	{
+		jmlist_debug(__func__,"perfect hash of %u keys couldn't be built",count);
+		free(frozen);
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	jmlist_mem.ass_list.total += size;
+	jmlist_mem.ass_list.used += size;
+
+	/* the hash index isn't needed anymore */
+	while( jml->ass_list.old_buckets )
+		ijmlist_ass_rehash_step(jml);
+	if( jml->ass_list.buckets )
+	{
+		free(jml->ass_list.buckets);
+		jmlist_mem.ass_list.total -= jml->ass_list.bucket_count*sizeof(assoc_entry*);
+		jmlist_mem.ass_list.used -= jml->ass_list.bucket_count*sizeof(assoc_entry*);
+		jml->ass_list.buckets = 0;
+		jml->ass_list.bucket_count = 0;
+	}
+	jmlist_debug(__func__,"new jml_mem.ass_list.total is %u",jmlist_mem.ass_list.total);
+	jmlist_debug(__func__,"new jml_mem.ass_list.used is %u",jmlist_mem.ass_list.used);
+
+	jml->ass_list.frozen = frozen;
+	jmlist_debug(__func__,"list jml=%p frozen with %u keys in %u pilot buckets",jml,count,bucket_count);
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+   jmlist_thaw
+   rebuilds the hash index (or the b+tree) of a frozen list so it can be
+   changed again.
+*/
+jmlist_status
+jmlist_thaw(jmlist jml)
+{
+	jmlist_debug(__func__,"called with jml=%p",jml);
+
+	if( !(jml->flags & JMLIST_ASSOCIATIVE) || (!jml->ass_list.frozen && !jml->ass_list.sorted) )
+	{
+		jmlist_debug(__func__,"list jml=%p is not frozen",jml);
+		jmlist_debug(__func__,"returning with success.");
+		return JMLIST_ERROR_SUCCESS;
+	}
+
+	if( jml->ass_list.sorted )
+	{
+		jmlist_debug(__func__,"passing control to the ordered associative list thaw routine.");
+		return ijmlist_changed(jml,ijmlist_sorted_thaw(jml));
+	}
+
+	jmlist_debug(__func__,"passing control to the unordered associative list thaw routine.");
+	return ijmlist_changed(jml,ijmlist_frozen_thaw(jml));
+}
+
+/*
+ * rebuilds the hash index (or the chain of a small list) of a frozen
+ * unordered associative list and frees its perfect hash.
+ */
+jmlist_status
+ijmlist_frozen_thaw(jmlist jml)
+{
+	assoc_frozen *frozen = jml->ass_list.frozen;
+	assoc_entry *pseeker;
+	uint32_t bucket_count = JMLIST_ASS_DEF_BUCKETS;
+
+	jmlist_debug(__func__,"called with jml=%p",jml);
+
+	if( jml->ass_list.usage <= jml->ass_list.small_max )
+	{
+		jml->ass_list.small_chain = 0;
+		for( pseeker = jml->ass_list.phead ; pseeker ; pseeker = pseeker->next )
+			ijmlist_ass_hash_chain_link(jml,&jml->ass_list.small_chain,pseeker,false);
+		ijmlist_ass_small_sync(jml);
+
+		ijmlist_frozen_free(frozen);
+		jml->ass_list.frozen = 0;
+		jmlist_debug(__func__,"list jml=%p is small, thawed without hash index",jml);
+		jmlist_debug(__func__,"returning with success.");
+		return JMLIST_ERROR_SUCCESS;
+	}
+
+	while( bucket_count < jml->ass_list.usage )
+		bucket_count *= 2;
+
+	jml->ass_list.buckets = (assoc_entry**)calloc(bucket_count,sizeof(assoc_entry*));
+	if( !jml->ass_list.buckets )
+	{
+		jmlist_debug(__func__,"calloc failed (size %u)!",bucket_count*sizeof(assoc_entry*));
+		jmlist_errno = JMLIST_ERROR_MALLOC;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+	jml->ass_list.bucket_count = bucket_count;
+
+	/* bucket chains keep the list order */
+	for( pseeker = jml->ass_list.phead ; pseeker ; pseeker = pseeker->next )
+		ijmlist_ass_hash_chain_link(jml,&jml->ass_list.buckets[pseeker->hash & (bucket_count-1)],pseeker,false);
+
+	jmlist_mem.ass_list.total += bucket_count*sizeof(assoc_entry*);
+	jmlist_mem.ass_list.used += bucket_count*sizeof(assoc_entry*);
+	ijmlist_frozen_free(frozen);
+	jml->ass_list.frozen = 0;
+	jmlist_debug(__func__,"new jml_mem.ass_list.total is %u",jmlist_mem.ass_list.total);
+	jmlist_debug(__func__,"new jml_mem.ass_list.used is %u",jmlist_mem.ass_list.used);
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+void
+ijmlist_frozen_free(assoc_frozen *frozen)
+{
+	size_t size = sizeof(assoc_frozen) + frozen->count*sizeof(assoc_frozen_slot) + frozen->bucket_count*sizeof(uint32_t);
+
+	jmlist_mem.ass_list.total -= size;
+	jmlist_mem.ass_list.used -= size;
+	free(frozen);
+}
+
+/*
+ * mutating calls on frozen lists fail.
+ */
+bool
+ijmlist_frozen_reject(jmlist jml,const char *func)
+{
+	if( !jml->ass_list.frozen && !jml->ass_list.sorted )
+		return false;
+
+	jmlist_debug(func,"list jml=%p is frozen, call jmlist_thaw first",jml);
+	jmlist_errno = JMLIST_ERROR_FROZEN_LIST;
+	jmlist_debug(func,"returning with failure.");
+	return true;
+}
+
+/*
+ * associative entries with ttl (timer wheel)
+ */
+
+/*
+ * current time of the list, from the clock callback or the last jmlist_expire.
+ */
+jmlist_time
+ijmlist_ass_now(jmlist jml)
+{
+	if( jml->ass_list.clock )
+		return jml->ass_list.clock();
+
+	return jml->ass_list.wheel ? jml->ass_list.wheel->now : 0;
+}
+
+/*
+ * true if the entry has a ttl and it's already expired, even if it wasn't
+ * removed by jmlist_expire yet.
+ */
+bool
+ijmlist_ass_expired(jmlist jml,assoc_entry *pentry)
+{
+	return pentry->expire_at && (pentry->expire_at <= ijmlist_ass_now(jml));
+}
+
+/*
+ * first entry not expired of the key group pentry starts (the entries of a key
+ * follow each other in the hash chain), 0 if all of them expired.
+ */
+assoc_entry *
+ijmlist_ass_first_live(jmlist jml,assoc_entry *pentry)
+{
+	assoc_entry *pnext;
+
+	while( pentry && ijmlist_ass_expired(jml,pentry) )
+	{
+		pnext = pentry->hnext;
+		pentry = (pnext && ijmlist_ass_same_key(jml,pnext,pentry)) ? pnext : 0;
+	}
+
+	return pentry;
+}
+
+jmlist_status
+ijmlist_ass_wheel_init(jmlist jml)
+{
+	assoc_wheel *wheel;
+
+	jmlist_debug(__func__,"allocating timer wheel for jml=%p",jml);
+
+	wheel = (assoc_wheel*)calloc(1,sizeof(assoc_wheel));
+	if( !wheel )
+	{
+		jmlist_debug(__func__,"calloc failed (size %u)!",sizeof(assoc_wheel));
+		jmlist_errno = JMLIST_ERROR_MALLOC;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	jmlist_mem.ass_list.total += sizeof(assoc_wheel);
+	jmlist_mem.ass_list.used += sizeof(assoc_wheel);
+	jmlist_debug(__func__,"new jml_mem.ass_list.total is %u",jmlist_mem.ass_list.total);
+	jmlist_debug(__func__,"new jml_mem.ass_list.used is %u",jmlist_mem.ass_list.used);
+
+	wheel->now = jml->ass_list.clock ? jml->ass_list.clock() : 0;
+	jml->ass_list.wheel = wheel;
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+ * links an entry in the wheel slot of its expiry time. entries expiring beyond
+ * the range of the top level are kept in its last slot and placed again when
+ * that slot is cascaded.
+ */
+void
+ijmlist_ass_wheel_place(jmlist jml,assoc_entry *pentry)
+{
+	assoc_wheel *wheel = jml->ass_list.wheel;
+	jmlist_time when = (pentry->expire_at > wheel->now) ? pentry->expire_at : wheel->now+1;
+	jmlist_time delta = when - wheel->now;
+	jmlist_index level = 0;
+	jmlist_index slot;
+
+	while( (level < JMLIST_WHEEL_LEVELS-1) && (delta >= ((jmlist_time)1 << (JMLIST_WHEEL_BITS*(level+1)))) )
+		level++;
+
+	if( delta >= ((jmlist_time)1 << (JMLIST_WHEEL_BITS*JMLIST_WHEEL_LEVELS)) )
+		when = wheel->now + ((jmlist_time)1 << (JMLIST_WHEEL_BITS*JMLIST_WHEEL_LEVELS)) - 1;
+
+	slot = (when >> (JMLIST_WHEEL_BITS*level)) & (JMLIST_WHEEL_SLOTS-1);
+
+	pentry->tnext = wheel->slot[level][slot];
+	if( pentry->tnext )
+		pentry->tnext->tpprev = &pentry->tnext;
+	pentry->tpprev = &wheel->slot[level][slot];
+	wheel->slot[level][slot] = pentry;
+	wheel->occupied[level] |= (uint64_t)1 << slot;
+	wheel->count++;
+}
+
+/*
+ * unlinks an entry from the wheel, if it's the last one of its slot the slot
+ * is marked as free.
+ */
+void
+ijmlist_ass_wheel_unlink(jmlist jml,assoc_entry *pentry)
+{
+	assoc_wheel *wheel = jml->ass_list.wheel;
+	assoc_entry **first = &wheel->slot[0][0];
+	jmlist_index index;
+
+	if( !pentry->tpprev )
+		return;
+
+	*pentry->tpprev = pentry->tnext;
+	if( pentry->tnext )
+		pentry->tnext->tpprev = pentry->tpprev;
+
+	if( (pentry->tpprev >= first) && (pentry->tpprev < first + JMLIST_WHEEL_LEVELS*JMLIST_WHEEL_SLOTS) && !*pentry->tpprev )
+	{
+		index = pentry->tpprev - first;
+		wheel->occupied[index / JMLIST_WHEEL_SLOTS] &= ~((uint64_t)1 << (index % JMLIST_WHEEL_SLOTS));
+	}
+
+	pentry->tpprev = 0;
+	pentry->tnext = 0;
+	wheel->count--;
+}
+
+/*
+ * builds the order statistic tree of an unordered associative list in O(N).
+ * entries are added in list order, each one is the rightmost node so it goes
+ * up the right spine of the tree while its priority is higher.
+ */
+jmlist_status
+ijmlist_ass_order_build(jmlist jml)
+{
+	assoc_entry *pseeker;
+	assoc_order *node;
+	assoc_order *last = 0;
+	assoc_order *child;
+
+	jmlist_debug(__func__,"building order statistic tree of jml=%p (usage=%u)",jml,jml->ass_list.usage);
+
+	for( pseeker = jml->ass_list.phead ; pseeker ; pseeker = pseeker->next )
+	{
+		node = (assoc_order*)malloc(sizeof(assoc_order));
+		if( !node )
+		{
+			jmlist_debug(__func__,"malloc failed (size %u)!",sizeof(assoc_order));
+			ijmlist_ass_order_free(jml);
+			jmlist_errno = JMLIST_ERROR_MALLOC;
+			return JMLIST_ERROR_FAILURE;
+		}
+
+		jmlist_mem.ass_list.total += sizeof(assoc_order);
+		jmlist_mem.ass_list.used += sizeof(assoc_order);
+
+		node->entry = pseeker;
+		node->right = 0;
+		node->priority = ijmlist_ass_order_priority(jml);
+		pseeker->order = node;
+
+		for( child = 0 ; last && (last->priority < node->priority) ; last = last->parent )
+			child = last;
+
+		node->left = child;
+		if( child )
+			child->parent = node;
+		node->parent = last;
+		if( last )
+			last->right = node;
+		else
+			jml->ass_list.order_root = node;
+		last = node;
+	}
+
+	ijmlist_ass_order_count(jml->ass_list.order_root);
+
+	jmlist_debug(__func__,"new jml_mem.ass_list.total is %u",jmlist_mem.ass_list.total);
+	jmlist_debug(__func__,"new jml_mem.ass_list.used is %u",jmlist_mem.ass_list.used);
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+ * frees the order statistic tree, the list goes back to not having one.
+ */
+void
+ijmlist_ass_order_free(jmlist jml)
+{
+	assoc_entry *pseeker;
+
+	jmlist_debug(__func__,"freeing order statistic tree of jml=%p",jml);
+
+	for( pseeker = jml->ass_list.phead ; pseeker ; pseeker = pseeker->next )
+	{
+		if( !pseeker->order )
+			continue;
+
+		free(pseeker->order);
+		pseeker->order = 0;
+		jmlist_mem.ass_list.total -= sizeof(assoc_order);
+		jmlist_mem.ass_list.used -= sizeof(assoc_order);
+	}
+
+	jml->ass_list.order_root = 0;
+}
+
+/*
+ * sets the size of the nodes of a subtree, returns the size of its root.
+ */
+jmlist_index
+ijmlist_ass_order_count(assoc_order *node)
+{
+	if( !node )
+		return 0;
+
+	node->size = 1 + ijmlist_ass_order_count(node->left) + ijmlist_ass_order_count(node->right);
+	return node->size;
+}
+
+/*
+ * random priority of a new node (xorshift32).
+ */
+uint32_t
+ijmlist_ass_order_priority(jmlist jml)
+{
+	uint32_t x = jml->ass_list.order_seed;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	jml->ass_list.order_seed = x;
+
+	return x;
+}
+
+/*
+ * rotates node up over its parent, the list order is kept.
+ */
+void
+ijmlist_ass_order_rotate(jmlist jml,assoc_order *node)
+{
+	assoc_order *parent = node->parent;
+	assoc_order *grand = parent->parent;
+
+	if( parent->left == node )
+	{
+		parent->left = node->right;
+		if( parent->left )
+			parent->left->parent = parent;
+		node->right = parent;
+	} else
+	{
+		parent->right = node->left;
+		if( parent->right )
+			parent->right->parent = parent;
+		node->left = parent;
+	}
+
+	parent->parent = node;
+	node->parent = grand;
+	if( !grand )
+		jml->ass_list.order_root = node;
+	else if( grand->left == parent )
+		grand->left = node;
+	else
+		grand->right = node;
+
+	node->size = parent->size;
+	parent->size = 1 + (parent->left ? parent->left->size : 0) + (parent->right ? parent->right->size : 0);
+}
+
+/*
+ * adds the node of an entry that was just linked in the list, it goes right
+ * after the node of the previous entry (or before the next one at the head).
+ */
+void
+ijmlist_ass_order_attach(jmlist jml,assoc_order *node)
+{
+	assoc_entry *pentry = node->entry;
+	assoc_order *parent;
+
+	node->left = 0;
+	node->right = 0;
+	node->size = 1;
+
+	if( pentry->prev )
+	{
+		parent = pentry->prev->order;
+		if( parent->right )
+		{
+			for( parent = parent->right ; parent->left ; parent = parent->left );
+			parent->left = node;
+		} else
+			parent->right = node;
+	} else if( pentry->next )
+	{
+		for( parent = pentry->next->order ; parent->left ; parent = parent->left );
+		parent->left = node;
+	} else
+	{
+		parent = 0;
+		jml->ass_list.order_root = node;
+	}
+
+	node->parent = parent;
+	for( ; parent ; parent = parent->parent )
+		parent->size++;
+
+	while( node->parent && (node->parent->priority < node->priority) )
+		ijmlist_ass_order_rotate(jml,node);
+}
+
+/*
+ * takes a node out of the tree, it's rotated down until it has one child.
+ */
+void
+ijmlist_ass_order_detach(jmlist jml,assoc_order *node)
+{
+	assoc_order *child;
+	assoc_order *parent;
+
+	while( node->left && node->right )
+		ijmlist_ass_order_rotate(jml,(node->left->priority > node->right->priority) ? node->left : node->right);
+
+	child = node->left ? node->left : node->right;
+	parent = node->parent;
+	if( child )
+		child->parent = parent;
+
+	if( !parent )
+		jml->ass_list.order_root = child;
+	else if( parent->left == node )
+		parent->left = child;
+	else
+		parent->right = child;
+
+	for( ; parent ; parent = parent->parent )
+		parent->size--;
+}
+
+/*
+ * adds a new entry to the order statistic tree if the list has one. when the
+ * node can't be allocated the tree is dropped, it's built again when needed.
+ */
+void
+ijmlist_ass_order_link(jmlist jml,assoc_entry *pentry)
+{
+	assoc_order *node;
+
+	if( !jml->ass_list.order_root )
+		return;
+
+	node = (assoc_order*)malloc(sizeof(assoc_order));
+	if( !node )
+	{
+		jmlist_debug(__func__,"malloc failed (size %u), dropping order statistic tree",sizeof(assoc_order));
+		ijmlist_ass_order_free(jml);
+		return;
+	}
+
+	jmlist_mem.ass_list.total += sizeof(assoc_order);
+	jmlist_mem.ass_list.used += sizeof(assoc_order);
+
+	node->entry = pentry;
+	node->priority = ijmlist_ass_order_priority(jml);
+	pentry->order = node;
+	ijmlist_ass_order_attach(jml,node);
+}
+
+/*
+ * removes the node of an entry from the order statistic tree.
+ */
+void
+ijmlist_ass_order_unlink(jmlist jml,assoc_entry *pentry)
+{
+	if( !pentry->order )
+		return;
+
+	ijmlist_ass_order_detach(jml,pentry->order);
+	free(pentry->order);
+	pentry->order = 0;
+
+	jmlist_mem.ass_list.total -= sizeof(assoc_order);
+	jmlist_mem.ass_list.used -= sizeof(assoc_order);
+}
+
+/*
+ * entry in position index of the order statistic tree (index < usage).
+ */
+assoc_entry *
+ijmlist_ass_order_select(jmlist jml,jmlist_index index)
+{
+	assoc_order *node = jml->ass_list.order_root;
+	jmlist_index left;
+
+	while( node )
+	{
+		left = node->left ? node->left->size : 0;
+		if( index == left )
+			return node->entry;
+
+		if( index < left )
+			node = node->left;
+		else
+		{
+			index -= left + 1;
+			node = node->right;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * finds the entry of an unordered associative list by its index in O(log N),
+ * the order statistic tree is built on the first call.
+ */
+jmlist_status
+ijmlist_ass_find_entry(jmlist jml,jmlist_index index,assoc_entry **pentry)
+{
+	if( !jml->ass_list.order_root && (ijmlist_ass_order_build(jml) == JMLIST_ERROR_FAILURE) )
+		return JMLIST_ERROR_FAILURE;
+
+	*pentry = ijmlist_ass_order_select(jml,index);
+	if( !*pentry )
+	{
+		jmlist_debug(__func__,"couldn't find entry with index=%u in the list jml=%p",index,jml);
+		jmlist_errno = JMLIST_ERROR_DAMAGED_LIST;
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	jmlist_debug(__func__,"found entry with index=%u, pentry=%p",index,*pentry);
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+ * unlinks and frees an entry from an unordered associative list, the evict
+ * callback is called first.
+ */
+void
+ijmlist_ass_drop(jmlist jml,assoc_entry *pentry)
+{
+	jmlist_debug(__func__,"dropping entry pentry=%p (ptr=%p) from jml=%p",pentry,pentry->ptr,jml);
+
+	if( jml->ass_list.evict )
+		jml->ass_list.evict(pentry->key_ptr,pentry->key_len,pentry->ptr);
+
+	ijmlist_ass_unlink(jml,pentry);
+}
+
+/*
+ * unlinks and frees an entry from an unordered associative list in O(1), the
+ * order list is doubly linked and the entry is found in its hash chain.
+ */
+void
+ijmlist_ass_unlink(jmlist jml,assoc_entry *pentry)
+{
+	jmlist_debug(__func__,"unlinking entry pentry=%p (prev=%p, next=%p) from jml=%p",pentry,pentry->prev,pentry->next,jml);
+	jml->generation++;
+
+	if( pentry->prev )
+	{
+		ijmlist_snap_node_write(jml,pentry->prev);
+		pentry->prev->next = pentry->next;
+	} else
+		jml->ass_list.phead = pentry->next;
+
+	if( pentry->next )
+		pentry->next->prev = pentry->prev;
+	else
+		jml->ass_list.ptail = pentry->prev;
+
+	ijmlist_ass_hash_unlink(jml,pentry);
+	ijmlist_ass_order_unlink(jml,pentry);
+	if( pentry->expire_at )
+		ijmlist_ass_wheel_unlink(jml,pentry);
+
+	ijmlist_snap_free(jml,pentry);
+	jml->ass_list.usage--;
+
+	if( jml->ass_list.bucket_count && (jml->ass_list.usage <= jml->ass_list.small_max/2) )
+		ijmlist_ass_hash_shrink(jml);
+
+	jmlist_mem.ass_list.total -= sizeof(struct _assoc_entry);
+	jmlist_mem.ass_list.used -= sizeof(struct _assoc_entry);
+	jmlist_debug(__func__,"new jml_mem.ass_list.total is %u",jmlist_mem.ass_list.total);
+	jmlist_debug(__func__,"new jml_mem.ass_list.used is %u",jmlist_mem.ass_list.used);
+}
+
+/*
+ * processes the wheel at time wheel->now, the slots of upper levels starting
+ * at this tick are moved down and the entries of the level 0 slot expire.
+ */
+void
+ijmlist_ass_wheel_tick(jmlist jml)
+{
+	assoc_wheel *wheel = jml->ass_list.wheel;
+	assoc_entry *pentry;
+	assoc_entry *pnext;
+	jmlist_index slot;
+	int level;
+
+	for( level = JMLIST_WHEEL_LEVELS-1 ; level >= 0 ; level-- )
+	{
+		if( level && (wheel->now & (((jmlist_time)1 << (JMLIST_WHEEL_BITS*level))-1)) )
+			continue;
+
+		slot = (wheel->now >> (JMLIST_WHEEL_BITS*level)) & (JMLIST_WHEEL_SLOTS-1);
+		if( !(wheel->occupied[level] & ((uint64_t)1 << slot)) )
+			continue;
+
+		pentry = wheel->slot[level][slot];
+		wheel->slot[level][slot] = 0;
+		wheel->occupied[level] &= ~((uint64_t)1 << slot);
+
+		for( ; pentry ; pentry = pnext )
+		{
+			pnext = pentry->tnext;
+			pentry->tpprev = 0;
+			pentry->tnext = 0;
+			wheel->count--;
+
+			if( pentry->expire_at <= wheel->now )
+				ijmlist_ass_drop(jml,pentry);
+			else
+				ijmlist_ass_wheel_place(jml,pentry);
+		}
+	}
+}
+
+/*
+   jmlist_insert_with_key_ttl
+   inserts an entry in an unordered associative list that expires ttl ticks from
+   now (see jmlist_expire).
+*/
+jmlist_status
+jmlist_insert_with_key_ttl(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,void *ptr,jmlist_time ttl)
+{
+	assoc_entry *pentry;
+
+	jmlist_debug(__func__,"called with jml=%p, key_ptr=%p, key_len=%u, ptr=%p, ttl=%" PRIu64,jml,key_ptr,key_len,ptr,ttl);
+
+	if( ijmlist_shard_reject(jml,__func__) )
+		return JMLIST_ERROR_FAILURE;
+
+	if( !ttl )
+	{
+		jmlist_debug(__func__,"invalid ttl specified (ttl=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !(jml->flags & JMLIST_ASSOCIATIVE) || (jml->flags & JMLIST_ASS_ORDERED) )
+	{
+		jmlist_debug(__func__,"ttl is only supported in unordered associative lists (jml=%p, flags=%u)",jml,jml->flags);
+		jmlist_errno = JMLIST_ERROR_UNSUPPORTED;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( ijmlist_frozen_reject(jml,__func__) )
+		return JMLIST_ERROR_FAILURE;
+
+	if( !jml->ass_list.wheel && (ijmlist_ass_wheel_init(jml) != JMLIST_ERROR_SUCCESS) )
+	{
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( ijmlist_ass_insert(jml,key_ptr,key_len,ptr) != JMLIST_ERROR_SUCCESS )
+	{
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	pentry = (jml->flags & JMLIST_ASS_INSERT_AT_TAIL) ? jml->ass_list.ptail : jml->ass_list.phead;
+	pentry->expire_at = ijmlist_ass_now(jml) + ttl;
+	ijmlist_ass_wheel_place(jml,pentry);
+	jmlist_debug(__func__,"entry pentry=%p expires at %" PRIu64,pentry,pentry->expire_at);
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+   jmlist_expire
+   advances the time of an associative list to now and removes the entries that
+   expired. ticks without expiring entries are skipped, each entry is moved at
+   most JMLIST_WHEEL_LEVELS times before it expires.
+*/
+jmlist_status
+jmlist_expire(jmlist jml,jmlist_time now)
+{
+	assoc_wheel *wheel;
+	jmlist_time next;
+	jmlist_time period;
+	jmlist_index current;
+	jmlist_index distance;
+	jmlist_index level;
+
+	jmlist_debug(__func__,"called with jml=%p, now=%" PRIu64,jml,now);
+
+	if( ijmlist_shard_reject(jml,__func__) )
+		return JMLIST_ERROR_FAILURE;
+
+	if( !(jml->flags & JMLIST_ASSOCIATIVE) || (jml->flags & JMLIST_ASS_ORDERED) )
+	{
+		jmlist_debug(__func__,"ttl is only supported in unordered associative lists (jml=%p, flags=%u)",jml,jml->flags);
+		jmlist_errno = JMLIST_ERROR_UNSUPPORTED;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !jml->ass_list.wheel && (ijmlist_ass_wheel_init(jml) != JMLIST_ERROR_SUCCESS) )
+	{
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	wheel = jml->ass_list.wheel;
+	while( wheel->count && (wheel->now < now) )
+	{
+		/* next tick where an occupied slot is due */
+		next = now;
+		for( level = 0 ; level < JMLIST_WHEEL_LEVELS ; level++ )
+		{
+			if( !wheel->occupied[level] )
+				continue;
+
+			period = wheel->now >> (JMLIST_WHEEL_BITS*level);
+			current = period & (JMLIST_WHEEL_SLOTS-1);
+			for( distance = 1 ; distance <= JMLIST_WHEEL_SLOTS ; distance++ )
+			{
+				if( wheel->occupied[level] & ((uint64_t)1 << ((current + distance) & (JMLIST_WHEEL_SLOTS-1))) )
+					break;
+			}
+
+			if( ((period + distance) << (JMLIST_WHEEL_BITS*level)) < next )
+				next = (period + distance) << (JMLIST_WHEEL_BITS*level);
+		}
+
+		wheel->now = next;
+		ijmlist_ass_wheel_tick(jml);
+	}
+
+	if( wheel->now < now )
+		wheel->now = now;
+
+	jmlist_debug(__func__,"returning with success (%u entries with ttl left).",wheel->count);
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+   jmlist_lru_stats
+   copies the capacity, usage and hit/miss/eviction counters of an lru list.
+*/
+jmlist_status
+jmlist_lru_stats(jmlist jml,jmlist_lru_info_ptr info)
+{
+	jmlist_debug(__func__,"called with jml=%p, info=%p",jml,info);
+
+	if( !info )
+	{
+		jmlist_debug(__func__,"invalid info argument specified (info=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !(jml->flags & JMLIST_ASS_LRU) )
+	{
+		jmlist_debug(__func__,"list jml=%p is not an lru list (flags=%u)",jml,jml->flags);
+		jmlist_errno = JMLIST_ERROR_UNSUPPORTED;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	info->capacity = jml->ass_list.capacity;
+	info->usage = jml->ass_list.usage;
+	info->hits = jml->ass_list.hits;
+	info->misses = jml->ass_list.misses;
+	info->evictions = jml->ass_list.evictions;
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+ * associative list method get by index. the entry is found in the order statistic
+ * tree of the list (the position in the b+tree in ordered lists) in O(log N).
+ */
+jmlist_status
+ijmlist_ass_get_by_index(jmlist jml,jmlist_index index,void **ptr)
+{
+	jmlist_debug(__func__,"called with jml=%p, index=%u",jml,index);
+
+	if( ijmlist_shard_reject(jml,__func__) )
+		return JMLIST_ERROR_FAILURE;
+	
+	if( !ptr )
+	{
+		jmlist_debug(__func__,"invalid ptr specified (ptr=0)");
+		jmlist_debug(__func__,"returning with failure.");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		return JMLIST_ERROR_FAILURE;
+	}
+	
+	if( !jml->ass_list.usage )
+	{
+		jmlist_debug(__func__,"cannot get by index on empty list (ass_list.usage=0)");
+		jmlist_debug(__func__,"returning with failure.");
+		jmlist_errno = JMLIST_ERROR_EMPTY_LIST;
+		return JMLIST_ERROR_FAILURE;
+	}
+	
+	/* check bounds! */
+	if( index >= jml->ass_list.usage )
+	{
+		jmlist_debug(__func__,"index %u is out of bounds with list jml=%p which has %u entries",index,jml,jml->ass_list.usage);
+		jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
+		jmlist_debug(__func__,"returning with failure");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( jml->flags & JMLIST_ASS_ORDERED )
+	{
+		jmlist_debug(__func__,"passing control to the ordered associative list get_by_index routine.");
+		return ijmlist_bpt_get_by_index(jml,index,ptr);
+	}
+	
+	jmlist_debug(__func__,"seeking associative list for indexed item %u",index);
+	
+	assoc_entry *pseeker;
+	if( ijmlist_ass_find_entry(jml,index,&pseeker) == JMLIST_ERROR_FAILURE )
+	{
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	*ptr = pseeker->ptr;
+	
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+jmlist_status
+ijmlist_ass_insert(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,void *ptr)
+{
+	return ijmlist_ass_insert_at(jml,key_ptr,key_len,ptr,(jml->flags & JMLIST_ASS_INSERT_AT_TAIL) ? JMLIST_TAIL : JMLIST_HEAD);
+}
+
+/*
+ * inserts a new entry at the head or at the tail of an associative list, the
+ * position is ignored by ordered lists.
+ */
+jmlist_status
+ijmlist_ass_insert_at(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,void *ptr,jmlist_position pos)
+{
+	jmlist_index usage;
+	bool evict;
+
+	jmlist_debug(__func__,"called with jml=%p, ptr=%p and pos=%u",jml,ptr,pos);
+
+	if( jml->ass_list.shards )
+		return ijmlist_shard_insert(jml,key_ptr,key_len,ptr,pos);
+
+	if( ijmlist_frozen_reject(jml,__func__) )
+		return JMLIST_ERROR_FAILURE;
+
+	/* verify key_ptr */
+	if( !key_ptr )
+	{
+		jmlist_debug(__func__,"invalid key_ptr specified (key_ptr=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+	
+	/* verify key_len */
+	if( !key_len )
+	{
+		jmlist_debug(__func__,"invalid key_len specified (key_len=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	/* verify fixed width and interned keys */
+	if( !ijmlist_ass_key_valid(jml,key_ptr,key_len) )
+	{
+		jmlist_debug(__func__,"invalid key specified (key_ptr=%p, key_len=%u)",key_ptr,key_len);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	/* the filter only grows here when asked for, it walks all the entries */
+	if( jml->ass_list.filter && jml->ass_list.filter_grow && (jml->ass_list.usage >= jml->ass_list.filter->capacity) )
+	{
+		if( ijmlist_ass_filter_rebuild(jml,jml->ass_list.filter->capacity*2) != JMLIST_ERROR_SUCCESS )
+		{
+			jmlist_debug(__func__,"failed to grow the membership filter");
+			jmlist_debug(__func__,"returning with failure.");
+			return JMLIST_ERROR_FAILURE;
+		}
+	}
+
+	if( jml->flags & JMLIST_ASS_ORDERED )
+	{
+		jmlist_debug(__func__,"passing control to the ordered associative list insert routine.");
+		if( ijmlist_bpt_insert(jml,key_ptr,key_len,ptr) != JMLIST_ERROR_SUCCESS )
+			return JMLIST_ERROR_FAILURE;
+
+		if( jml->ass_list.filter )
+			ijmlist_ass_filter_update(jml->ass_list.filter,jml->ass_list.hash(key_ptr,key_len),1);
+		jml->generation++;
+		return JMLIST_ERROR_SUCCESS;
+	}
+
+	/* a full cache drops its least recently used entry, but only once the new
+	   entry and the hash index are allocated, so an insert that fails doesn't
+	   evict anything */
+	evict = (jml->flags & JMLIST_ASS_LRU) && (jml->ass_list.usage >= jml->ass_list.capacity);
+	usage = jml->ass_list.usage - (evict ? 1 : 0);
+
+	jmlist_debug(__func__,"allocating associative entry");
+	assoc_entry *pentry = (assoc_entry*)malloc(sizeof(assoc_entry));
+	if( !pentry ) 
+	{
+		jmlist_debug(__func__,"malloc failed (size %u)!",sizeof(assoc_entry));
+		jmlist_errno = JMLIST_ERROR_MALLOC;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+	jmlist_debug(__func__,"new associative entry pentry=%p allocated",pentry);
+
+	/* grow the hash index when there's more entries than buckets, the old
+	   buckets are migrated in small steps by the next operations. small
+	   lists build it when they get more than small_max entries */
+	if( !jml->ass_list.bucket_count && (usage < jml->ass_list.small_max) )
+	{
+		jmlist_debug(__func__,"list is small (usage=%u, small_max=%u), no hash index",usage,jml->ass_list.small_max);
+	} else if( usage >= jml->ass_list.bucket_count )
+	{
+		if( ijmlist_ass_hash_grow(jml) != JMLIST_ERROR_SUCCESS )
+		{
+			free(pentry);
+			jmlist_debug(__func__,"failed to grow the hash index");
+			jmlist_debug(__func__,"returning with failure.");
+			return JMLIST_ERROR_FAILURE;
+		}
+	} else
+		ijmlist_ass_rehash_step(jml);
+
+	if( evict )
+		ijmlist_ass_lru_evict(jml);
+
+	jmlist_mem.ass_list.total += sizeof(struct _assoc_entry);
+	jmlist_mem.ass_list.used += sizeof(struct _assoc_entry);
+	jmlist_debug(__func__,"new jml_mem.ass_list.total is %u",jmlist_mem.ass_list.total);
+	jmlist_debug(__func__,"new jml_mem.ass_list.used is %u",jmlist_mem.ass_list.used);
+
+	/* initialize entry */
+	pentry->ptr = ptr;
+	pentry->expire_at = 0;
+	pentry->tnext = 0;
+	pentry->tpprev = 0;
+	pentry->order = 0;
+	ijmlist_ass_entry_set_key(jml,pentry,key_ptr,key_len);
+	
+	if( pos == JMLIST_TAIL )
+	{
+		assoc_entry *pseeker = jml->ass_list.ptail;
+		
+		jmlist_debug(__func__,"inserting at tail, tail is at pseeker=%p",pseeker);
+		
+		pentry->next = 0;
+		pentry->prev = pseeker;
+		jmlist_debug(__func__,"initialized new entry successfuly (ptr=%p, next=%p, key=%p, len=%u)",
+					 pentry->ptr,pentry->next,pentry->key_ptr,pentry->key_len);
+		
+		if( pseeker )
+		{
+			ijmlist_snap_node_write(jml,pseeker);
+			pseeker->next = pentry;
+		} else
+			jml->ass_list.phead = pentry;
+		jml->ass_list.ptail = pentry;
+		ijmlist_ass_hash_link(jml,pentry,false);
+		ijmlist_ass_order_link(jml,pentry);
+		
+		jml->ass_list.usage++;
+		jmlist_debug(__func__,"new usage of list is %u",jml->ass_list.usage);
+	} else
+	{
+		pentry->next = jml->ass_list.phead;
+		pentry->prev = 0;
+		jmlist_debug(__func__,"initialized new entry successfuly (ptr=%p, next=%p, key_ptr=%p, key_len=%u)",
+					 pentry->ptr,pentry->next,pentry->key_ptr,pentry->key_len);
+		
+		jmlist_debug(__func__,"inserting pentry in head of list (current head phead=%p, usage=%u)",
+					 jml->ass_list.phead,jml->ass_list.usage);
+		
+		if( jml->ass_list.phead )
+			jml->ass_list.phead->prev = pentry;
+		else
+			jml->ass_list.ptail = pentry;
+		jml->ass_list.phead = pentry;
+		ijmlist_ass_hash_link(jml,pentry,true);
+		ijmlist_ass_order_link(jml,pentry);
+		jml->ass_list.usage++;
+		
+		jmlist_debug(__func__,"now head is phead=%p with phead->next=%p (usage=%u)",
+					 jml->ass_list.phead,pentry->next,jml->ass_list.usage);
+	} // (pos == JMLIST_TAIL)
+	jml->generation++;
+	
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;	
+}
+
+jmlist_status
+ijmlist_ass_remove_by_ptr(jmlist jml,void *ptr)
+{
+	jmlist_debug(__func__,"called with jml=%p and ptr=%p\n",(void*)jml,(void*)ptr);
+
+	if( ijmlist_shard_reject(jml,__func__) )
+		return JMLIST_ERROR_FAILURE;
+
+	if( ijmlist_frozen_reject(jml,__func__) )
+		return JMLIST_ERROR_FAILURE;
+
+	/* trying to pop from empty list? */
+	if( !jml->ass_list.usage )
+	{
+		jmlist_debug(__func__,"trying to remove from empty list");
+		jmlist_debug(__func__,"returning with failure.");
+		jmlist_errno = JMLIST_ERROR_EMPTY_LIST;
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( jml->flags & JMLIST_ASS_ORDERED )
+	{
+		jmlist_debug(__func__,"passing control to the ordered associative list remove_by_ptr routine.");
+		return ijmlist_bpt_remove_by_ptr(jml,ptr);
+	}
+	
+	jmlist_debug(__func__,"seeking ptr=%p in the associative list",ptr);
+	
+	assoc_entry *pseeker;
+	for( pseeker = jml->ass_list.phead ; pseeker ; pseeker = pseeker->next )
+	{
+		if( pseeker->ptr != ptr )
+			continue;
+		
+		jmlist_debug(__func__,"found entry, pseeker=%p pseeker->next=%p",pseeker,pseeker->next);
+		ijmlist_ass_unlink(jml,pseeker);
+		
+		jmlist_debug(__func__,"returning with success.");
+		return JMLIST_ERROR_SUCCESS;
+	}
+	
+	jmlist_debug(__func__,"couldn't find entry with ptr=%p in the list jml=%p",ptr,jml);
+	jmlist_errno = JMLIST_ERROR_ENTRY_NOT_FOUND;
+	jmlist_debug(__func__,"returning with failure.");
+	return JMLIST_ERROR_FAILURE;
+}
+
+jmlist_status
+ijmlist_ass_dump(jmlist jml)
+{
+	jmlist_debug(__func__,"called with jml=%p",jml);
+
+	if( jml->ass_list.shards )
+		return ijmlist_shard_dump(jml);
+
+	if( jml->flags & JMLIST_ASS_ORDERED )
+	{
+		jmlist_debug(__func__,"passing control to the ordered associative list dump routine.");
+		return ijmlist_bpt_dump(jml);
+	}
+	
+	printf("associative list jml=%p has usage=%u and phead=%p\n",
+			(void*)jml,jml->ass_list.usage,(void*)jml->ass_list.phead);
+	
+	assoc_entry *pseeker = jml->ass_list.phead;
+	
+	if( pseeker )
+		printf("list of entries:\n");
+	
+	jmlist_index index = 0;
+	bool printable_key;
+	jmlist_index i;
+	while( pseeker )
+	{
+		if( jml->ass_list.key_width )
+		{
+			printf("  %08X: pentry=%p pentry->next=%p key=%" PRIu64 " ptr=%p\n",index,(void*)pseeker,(void*)pseeker->next,
+					jml->ass_list.key_width == sizeof(uint32_t) ? (uint64_t)pseeker->key_val.u32 : pseeker->key_val.u64,pseeker->ptr);
+			pseeker = pseeker->next;
+			index++;
+			continue;
+		}
+
+		/* if key has only printable chars, dump key as ASCII otherwise just
+		   print the pointer and length. */
+		printable_key = true;
+		for( i = 0 ; i < pseeker->key_len ; i++ )
+		{
+			if( isprint(((unsigned char*)pseeker->key_ptr)[i]) )
+				continue;
+
+			printable_key = false;
+		}
+		
+		if( printable_key )
+		{
+			printf("  %08X: pentry=%p pentry->next=%p key=<",
+					index,(void*)pseeker,(void*)pseeker->next);
+
+			for( i = 0 ; i < pseeker->key_len ; i++ )
+				printf("%c",((char*)pseeker->key_ptr)[i]);
+
+			printf("> key_len=%u ptr=%p\n",pseeker->key_len,pseeker->ptr);
+		} else
+		{
+			printf("  %08X: pentry=%p pentry->next=%p key=%p key_len=%u ptr=%p\n",
+					index,(void*)pseeker,(void*)pseeker->next,(void*)pseeker->key_ptr,pseeker->key_len,pseeker->ptr);
+		}
+		pseeker = pseeker->next;
+		index++;
+	}
+	
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+jmlist_status
+ijmlist_ass_free(jmlist jml)
+{
+	jmlist_debug(__func__,"called with jml=%p",jml);
+
+	if( jml->ass_list.shards )
+		return ijmlist_shard_free(jml);
+
+	if( jml->ass_list.frozen )
+	{
+		jmlist_debug(__func__,"freeing perfect hash %p",jml->ass_list.frozen);
+		ijmlist_frozen_free(jml->ass_list.frozen);
+		jml->ass_list.frozen = 0;
+	}
+
+	if( jml->ass_list.sorted )
+	{
+		jmlist_debug(__func__,"freeing sorted array %p",jml->ass_list.sorted);
+		ijmlist_sorted_free(jml->ass_list.sorted);
+		jml->ass_list.sorted = 0;
+	}
+
+	if( jml->ass_list.filter )
+	{
+		jmlist_debug(__func__,"freeing membership filter %p",jml->ass_list.filter);
+		ijmlist_ass_filter_free(jml->ass_list.filter);
+		jml->ass_list.filter = 0;
+	}
+
+	if( jml->flags & JMLIST_ASS_ORDERED )
+	{
+		jmlist_debug(__func__,"passing control to the ordered associative list free routine.");
+		return ijmlist_bpt_free(jml);
+	}
+	
+	assoc_entry *pseeker = jml->ass_list.phead;
+	assoc_entry *pnext;
+	while( pseeker )
+	{
+		pnext = pseeker->next;
+		jmlist_debug(__func__,"freeing associative entry with p=%p, next is p=%p",pseeker,pnext);
+
+		if( pseeker->order )
+		{
+			free(pseeker->order);
+			jmlist_mem.ass_list.total -= sizeof(assoc_order);
+			jmlist_mem.ass_list.used -= sizeof(assoc_order);
+		}
+		free(pseeker);
+		
+		jmlist_debug(__func__,"freed associative entry sucessfuly with p=%p",pseeker);
+		
+		jmlist_mem.ass_list.total -= sizeof(struct _assoc_entry);
+		jmlist_mem.ass_list.used -= sizeof(struct _assoc_entry);
+		jmlist_debug(__func__,"new jml_mem.ass_list.total is %u",jmlist_mem.ass_list.total);
+		jmlist_debug(__func__,"new jml_mem.ass_list.used is %u",jmlist_mem.ass_list.used);
+		pseeker = pnext;
+	}
+
+	if( jml->ass_list.wheel )
+	{
+		jmlist_debug(__func__,"freeing timer wheel %p",jml->ass_list.wheel);
+		free(jml->ass_list.wheel);
+		jmlist_mem.ass_list.total -= sizeof(assoc_wheel);
+		jmlist_mem.ass_list.used -= sizeof(assoc_wheel);
+	}
+
+	/* release the hash index tables */
+	if( jml->ass_list.old_buckets )
+	{
+		jmlist_debug(__func__,"freeing old hash table with %u buckets",jml->ass_list.old_bucket_count);
+		free(jml->ass_list.old_buckets);
+		jmlist_mem.ass_list.total -= jml->ass_list.old_bucket_count*sizeof(assoc_entry*);
+		jmlist_mem.ass_list.used -= jml->ass_list.old_bucket_count*sizeof(assoc_entry*);
+	}
+
+	if( jml->ass_list.buckets )
+	{
+		jmlist_debug(__func__,"freeing hash table with %u buckets",jml->ass_list.bucket_count);
+		free(jml->ass_list.buckets);
+		jmlist_mem.ass_list.total -= jml->ass_list.bucket_count*sizeof(assoc_entry*);
+		jmlist_mem.ass_list.used -= jml->ass_list.bucket_count*sizeof(assoc_entry*);
+	}
+	
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+jmlist_status
+ijmlist_ass_ptr_exists(jmlist jml,void *ptr,jmlist_lookup_result *result)
+{
+	jmlist_debug(__func__,"called with jml=%p, ptr=%p, result=%p",jml,ptr,result);
+
+	if( ijmlist_shard_reject(jml,__func__) )
+		return JMLIST_ERROR_FAILURE;
+	
+	if( !result )
+	{
+		jmlist_debug(__func__,"invalid result pointer specified (result=0)");
+		jmlist_debug(__func__,"returning with failure.");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		return JMLIST_ERROR_FAILURE;
+	}
+	
+	/* trying ptr_exists on an empty list? */
+	if( !jml->ass_list.usage )
+	{
+		jmlist_debug(__func__,"cannot use this function with an empty list");
+		jmlist_errno = JMLIST_ERROR_EMPTY_LIST;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( jml->flags & JMLIST_ASS_ORDERED )
+	{
+		jmlist_debug(__func__,"passing control to the ordered associative list ptr_exists routine.");
+		return ijmlist_bpt_ptr_exists(jml,ptr,result);
+	}
+	
+	jmlist_debug(__func__,"seeking ptr=%p in the linked list",ptr);
+	
+	assoc_entry *pseeker = jml->ass_list.phead;
+	while( pseeker )
+	{
+		if( pseeker->ptr != ptr )
+		{
+			pseeker = pseeker->next;
+			continue;
+		}
+		
+		/* found entry */
+		jmlist_debug(__func__,"found entry with ptr=%p on pseeker=%p in list jml=%p",ptr,pseeker,jml);
+		*result = jmlist_entry_found;
+		jmlist_debug(__func__,"returning with success.");
+		return JMLIST_ERROR_SUCCESS;
+	}
+	
+	*result = jmlist_entry_not_found;
+	jmlist_debug(__func__,"couldn't find entry with ptr=%p in list jml=%p",ptr,jml);
+	jmlist_errno = JMLIST_ERROR_ENTRY_NOT_FOUND;
+	jmlist_debug(__func__,"returning with failure.");
+	return JMLIST_ERROR_FAILURE;
+}
+
+jmlist_status
+ijmlist_ass_key_exists(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,jmlist_lookup_result *result)
+{
+	jmlist_debug(__func__,"called with jml=%p, key_ptr=%p, key_len=%u, result=%p",jml,key_ptr,key_len,result);
+
+	if( jml->ass_list.shards )
+		return ijmlist_shard_key_exists(jml,key_ptr,key_len,result);
+	
+	DCHECKSTART
+
+	if( !result )
+	{
+		jmlist_debug(__func__,"invalid result pointer specified (result=0)");
+		jmlist_debug(__func__,"returning with failure.");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		return JMLIST_ERROR_FAILURE;
+	}
+	
+	/* verify key_ptr */
+	if( !key_ptr )
+	{
+		jmlist_debug(__func__,"invalid key_ptr specified (key_ptr=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+	
+	/* verify key_len */
+	if( !key_len )
+	{
+		jmlist_debug(__func__,"invalid key_len specified (key_len=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	DCHECKEND
+
+	/* verify fixed width and interned keys */
+	if( !ijmlist_ass_key_valid(jml,key_ptr,key_len) )
+	{
+		jmlist_debug(__func__,"invalid key specified (key_ptr=%p, key_len=%u)",key_ptr,key_len);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+	
+	/* trying ptr_exists on an empty list? */
+	if( !jml->ass_list.usage )
+	{
+		jmlist_debug(__func__,"cannot use this function with an empty list");
+		jmlist_errno = JMLIST_ERROR_EMPTY_LIST;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( ijmlist_ass_filter_reject(jml,key_ptr,key_len) )
+	{
+		*result = jmlist_entry_not_found;
+		jmlist_debug(__func__,"key_ptr=%p key_len=%u rejected by the filter of list jml=%p",key_ptr,key_len,jml);
+		jmlist_errno = JMLIST_ERROR_ENTRY_NOT_FOUND;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( jml->flags & JMLIST_ASS_ORDERED )
+	{
+		jmlist_debug(__func__,"passing control to the ordered associative list key_exists routine.");
+		return ijmlist_bpt_key_exists(jml,key_ptr,key_len,result);
+	}
+	
+	jmlist_debug(__func__,"seeking key_ptr=%p, key_len=%u in the hash index",key_ptr,key_len);
+	
+	assoc_entry *pseeker = jml->ass_list.frozen ? 0 : ijmlist_ass_first_live(jml,ijmlist_ass_hash_find(jml,key_ptr,key_len));
+	if( pseeker || (jml->ass_list.frozen && ijmlist_frozen_lookup(jml,key_ptr,key_len)) )
+	{
+		/* found entry */
+		jmlist_debug(__func__,"found entry of key_ptr %p (length %u) on pseeker=%p in list jml=%p",key_ptr,key_len,pseeker,jml);
+		*result = jmlist_entry_found;
+		jmlist_debug(__func__,"returning with success.");
+		return JMLIST_ERROR_SUCCESS;
+	}
+	
+	*result = jmlist_entry_not_found;
+	jmlist_debug(__func__,"couldn't find entry with key_ptr=%p and key_len=%u in list jml=%p",key_ptr,key_len,jml);
+	jmlist_errno = JMLIST_ERROR_ENTRY_NOT_FOUND;
+	jmlist_debug(__func__,"returning with failure.");
+	return JMLIST_ERROR_FAILURE;
+}
+
+/*
+ * get method for lists that have keys associated.
+ */
+jmlist_status
+jmlist_get_by_key(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,void **ptr)
+{
+	jmlist_debug(__func__,"called with jml=%p, key_ptr=%p, key_len=%u, ptr=%p",jml,key_ptr,key_len,ptr);
+	
+	if( !ptr )
+	{
+		jmlist_debug(__func__,"invalid ptr specified (ptr=0)");
+		jmlist_debug(__func__,"returning with failure.");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	/* verify key_ptr */
+	if( !key_ptr )
+	{
+		jmlist_debug(__func__,"invalid key_ptr specified (key_ptr=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+	
+	/* verify key_len */
+	if( !key_len )
+	{
+		jmlist_debug(__func__,"invalid key_len specified (key_len=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	/* for now this function is only supported in associative lists */	
+	if( jml->flags & JMLIST_ASSOCIATIVE )
+	{
+		jmlist_debug(__func__,"passing control to the associative get by key routine.");
+		return ijmlist_ass_get_by_key(jml,key_ptr,key_len,ptr);
+	}
+
+	jmlist_debug(__func__,"invalid or unsupported list type (jml=%p, flags=%u)",jml,jml->flags);
+	jmlist_debug(__func__,"returning with failure.");
+	jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+	return JMLIST_ERROR_FAILURE;
+}
+
+jmlist_status
+ijmlist_ass_get_by_key(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,void **ptr)
+{
+	jmlist_debug(__func__,"called with jml=%p key_ptr=%p key_len=%u ptr=%p",jml,key_ptr,key_len,ptr);
+
+	if( jml->ass_list.shards )
+		return ijmlist_shard_get_by_key(jml,key_ptr,key_len,ptr);
+
+	/* arguments check, this should be already done by the calling function, tho you
+	   can repeat it here if you want... */
+
+	DCHECKSTART
+	/* verify key_ptr */
+	if( !key_ptr )
+	{
+		jmlist_debug(__func__,"invalid key_ptr specified (key_ptr=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+	
+	/* verify key_len */
+	if( !key_len )
+	{
+		jmlist_debug(__func__,"invalid key_len specified (key_len=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+	DCHECKEND
+
+	/* verify fixed width and interned keys */
+	if( !ijmlist_ass_key_valid(jml,key_ptr,key_len) )
+	{
+		jmlist_debug(__func__,"invalid key specified (key_ptr=%p, key_len=%u)",key_ptr,key_len);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( ijmlist_ass_filter_reject(jml,key_ptr,key_len) )
+	{
+		jmlist_debug(__func__,"key_ptr=%p key_len=%u rejected by the filter of list jml=%p",key_ptr,key_len,jml);
+		jmlist_errno = JMLIST_ERROR_ENTRY_NOT_FOUND;
+		if( jml->flags & JMLIST_ASS_LRU )
+			jml->ass_list.misses++;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( jml->flags & JMLIST_ASS_ORDERED )
+	{
+		jmlist_debug(__func__,"passing control to the ordered associative list get_by_key routine.");
+		return ijmlist_bpt_get_by_key(jml,key_ptr,key_len,ptr);
+	}
+
+	if( jml->ass_list.frozen )
+	{
+		jmlist_debug(__func__,"seeking key_ptr=%p in the perfect hash",key_ptr);
+
+		assoc_frozen_slot *slot = ijmlist_frozen_lookup(jml,key_ptr,key_len);
+		if( slot )
+		{
+			jmlist_debug(__func__,"found entry of key_ptr %p (length %u) on slot=%p in list jml=%p",
+						 key_ptr,key_len,slot,jml);
+			*ptr = slot->ptr;
+			jmlist_debug(__func__,"returning with success.");
+			return JMLIST_ERROR_SUCCESS;
+		}
+
+		jmlist_debug(__func__,"couldn't find entry with key_ptr=%p key_len=%u in list jml=%p",
+					 key_ptr,key_len,jml);
+		jmlist_errno = JMLIST_ERROR_ENTRY_NOT_FOUND;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	jmlist_debug(__func__,"seeking key_ptr=%p in the hash index",key_ptr);
+	
+	assoc_entry *pseeker = ijmlist_ass_first_live(jml,ijmlist_ass_hash_find(jml,key_ptr,key_len));
+	if( pseeker )
+	{
+		/* found entry */
+		jmlist_debug(__func__,"found entry of key_ptr %p (length %u) on pseeker=%p in list jml=%p",
+					 key_ptr,key_len,pseeker,jml);
+		*ptr = pseeker->ptr;
+
+		if( jml->flags & JMLIST_ASS_LRU )
+		{
+			jml->ass_list.hits++;
+			ijmlist_ass_lru_promote(jml,pseeker);
+		}
+		
+		jmlist_debug(__func__,"returning with success.");
+		return JMLIST_ERROR_SUCCESS;
+	}
+	
+	jmlist_debug(__func__,"couldn't find entry with key_ptr=%p key_len=%u in list jml=%p",
+				 key_ptr,key_len,jml);
+	jmlist_errno = JMLIST_ERROR_ENTRY_NOT_FOUND;
+
+	if( jml->flags & JMLIST_ASS_LRU )
+		jml->ass_list.misses++;
+	
+	jmlist_debug(__func__,"returning with failure.");
+	return JMLIST_ERROR_FAILURE;
+}
+
+/*
+ * converts an integer key to the key stored by lists with fixed width keys.
+ */
+jmlist_status
+ijmlist_ikey_to_key(jmlist jml,uint64_t key,jmlist_key_value *key_val)
+{
+	if( !jml )
+	{
+		jmlist_debug(__func__,"invalid jml specified (jml=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !(jml->flags & JMLIST_ASSOCIATIVE) || !jml->ass_list.key_width )
+	{
+		jmlist_debug(__func__,"list jml=%p doesn't have fixed width keys (flags=%u)",jml,jml->flags);
+		jmlist_errno = JMLIST_ERROR_UNSUPPORTED;
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	key_val->u64 = 0;
+	if( jml->ass_list.key_width == sizeof(uint32_t) )
+		key_val->u32 = (uint32_t)key;
+	else
+		key_val->u64 = key;
+
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+   jmlist_insert_with_ikey, jmlist_get_by_ikey, jmlist_remove_by_ikey
+   same as the _key functions for lists with fixed width keys, the key is passed
+   as an integer (pointer keys cast with (uintptr_t)).
+*/
+jmlist_status
+jmlist_insert_with_ikey(jmlist jml,uint64_t key,void *ptr)
+{
+	jmlist_key_value key_val;
+
+	jmlist_debug(__func__,"called with jml=%p, key=%" PRIu64 ", ptr=%p",jml,key,ptr);
+
+	if( ijmlist_ikey_to_key(jml,key,&key_val) != JMLIST_ERROR_SUCCESS )
+	{
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	return ijmlist_ass_insert(jml,&key_val,jml->ass_list.key_width,ptr);
+}
+
+jmlist_status
+jmlist_get_by_ikey(jmlist jml,uint64_t key,void **ptr)
+{
+	jmlist_key_value key_val;
+
+	jmlist_debug(__func__,"called with jml=%p, key=%" PRIu64 ", ptr=%p",jml,key,ptr);
+
+	if( !ptr )
+	{
+		jmlist_debug(__func__,"invalid ptr specified (ptr=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( ijmlist_ikey_to_key(jml,key,&key_val) != JMLIST_ERROR_SUCCESS )
+	{
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	return ijmlist_ass_get_by_key(jml,&key_val,jml->ass_list.key_width,ptr);
+}
+
+jmlist_status
+jmlist_remove_by_ikey(jmlist jml,uint64_t key)
+{
+	jmlist_key_value key_val;
+
+	jmlist_debug(__func__,"called with jml=%p, key=%" PRIu64,jml,key);
+
+	if( ijmlist_ikey_to_key(jml,key,&key_val) != JMLIST_ERROR_SUCCESS )
+	{
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	return ijmlist_ass_remove_by_key(jml,&key_val,jml->ass_list.key_width);
+}
+
+/*
+   jmlist_get_by_keys
+   looks up n keys at once. out_ptrs[i] receives the ptr of keys[i] and out_found[i]
+   tells if it was found (out_ptrs[i] is 0 when not). the call succeeds even if some
+   keys are not found. on unordered associative lists the lookups are interleaved
+   in groups of JMLIST_ASS_BATCH_GROUP keys so their cache misses overlap.
+*/
+jmlist_status
+jmlist_get_by_keys(jmlist jml,jmlist_key *keys,jmlist_key_length *lens,jmlist_index n,
+		void **out_ptrs,bool *out_found)
+{
+	jmlist_index i;
+
+	jmlist_debug(__func__,"called with jml=%p, keys=%p, lens=%p, n=%u, out_ptrs=%p, out_found=%p",
+			jml,keys,lens,n,out_ptrs,out_found);
+
+	if( !jml )
+	{
+		jmlist_debug(__func__,"invalid jml specified (jml=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !keys || !lens || !out_ptrs || !out_found )
+	{
+		jmlist_debug(__func__,"invalid arguments specified (keys=%p, lens=%p, out_ptrs=%p, out_found=%p)",
+				keys,lens,out_ptrs,out_found);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	for( i = 0 ; i < n ; i++ )
+	{
+		if( keys[i] && lens[i] && ijmlist_ass_key_valid(jml,keys[i],lens[i]) )
+			continue;
+
+		jmlist_debug(__func__,"invalid key %u specified (key_ptr=%p, key_len=%u)",i,keys[i],lens[i]);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( jml->flags & JMLIST_ASSOCIATIVE )
+	{
+		jmlist_debug(__func__,"passing control to the associative get by keys routine.");
+		return ijmlist_ass_get_by_keys(jml,keys,lens,n,out_ptrs,out_found);
+	}
+
+	jmlist_debug(__func__,"invalid or unsupported list type (jml=%p, flags=%u)",jml,jml->flags);
+	jmlist_debug(__func__,"returning with failure.");
+	jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+	return JMLIST_ERROR_FAILURE;
+}
+
+/*
+   jmlist_get_all_by_key
+   gets the ptr of every entry with the key (in list order for unordered lists,
+   in insertion order for ordered ones). up to cap of them are stored in out_ptrs
+   and n receives how many there are, so if n > cap the call can be repeated with
+   a larger out_ptrs. entries with the same key are grouped in the index, this is
+   O(number of entries found).
+*/
+jmlist_status
+jmlist_get_all_by_key(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,void **out_ptrs,
+		jmlist_index cap,jmlist_index *n)
+{
+	jmlist_debug(__func__,"called with jml=%p, key_ptr=%p, key_len=%u, out_ptrs=%p, cap=%u, n=%p",
+			jml,key_ptr,key_len,out_ptrs,cap,n);
+
+	if( !key_ptr || !key_len || !n || (cap && !out_ptrs) || !ijmlist_ass_key_valid(jml,key_ptr,key_len) )
+	{
+		jmlist_debug(__func__,"invalid arguments specified (key_ptr=%p, key_len=%u, out_ptrs=%p, n=%p)",
+				key_ptr,key_len,out_ptrs,n);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( jml->flags & JMLIST_ASSOCIATIVE )
+	{
+		jmlist_debug(__func__,"passing control to the associative get all by key routine.");
+		return ijmlist_ass_get_all_by_key(jml,key_ptr,key_len,out_ptrs,cap,n);
+	}
+
+	jmlist_debug(__func__,"invalid or unsupported list type (jml=%p, flags=%u)",jml,jml->flags);
+	jmlist_debug(__func__,"returning with failure.");
+	jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+	return JMLIST_ERROR_FAILURE;
+}
+
+/*
+ * returns the first entry (in list order) of the group of entries with the key
+ * in an unordered list, 0 if there's none. the others follow it in the chain.
+ */
+assoc_entry *
+ijmlist_ass_key_group(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len)
+{
+	assoc_frozen_slot *slot;
+
+	if( ijmlist_ass_filter_reject(jml,key_ptr,key_len) )
+		return 0;
+
+	if( jml->ass_list.frozen )
+	{
+		slot = ijmlist_frozen_lookup(jml,key_ptr,key_len);
+		return slot ? slot->entry : 0;
+	}
+
+	return ijmlist_ass_hash_find(jml,key_ptr,key_len);
+}
+
+jmlist_status
+ijmlist_ass_get_all_by_key(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,void **out_ptrs,
+		jmlist_index cap,jmlist_index *n)
+{
+	assoc_entry *pgroup;
+	assoc_entry *pseeker;
+	bpt_node *leaf;
+	jmlist_index slot;
+	uint64_t pfx;
+
+	jmlist_debug(__func__,"called with jml=%p, key_ptr=%p, key_len=%u",jml,key_ptr,key_len);
+
+	if( jml->ass_list.shards )
+		return ijmlist_shard_get_all_by_key(jml,key_ptr,key_len,out_ptrs,cap,n);
+
+	*n = 0;
+
+	if( jml->flags & JMLIST_ASS_ORDERED )
+	{
+		/* entries with the same key are adjacent in the leaves */
+		if( ijmlist_ass_filter_reject(jml,key_ptr,key_len) || !jml->ass_list.usage )
+		{
+			jmlist_debug(__func__,"returning with success.");
+			return JMLIST_ERROR_SUCCESS;
+		}
+
+		pfx = ijmlist_bpt_prefix(key_ptr,key_len);
+		if( jml->ass_list.sorted )
+		{
+			for( slot = ijmlist_sorted_bound(jml,key_ptr,key_len,false) ; slot < jml->ass_list.sorted->count ; slot++ )
+			{
+				if( ijmlist_sorted_compare(jml,slot,pfx,key_ptr,key_len) )
+					break;
+
+				if( *n < cap )
+					out_ptrs[*n] = jml->ass_list.sorted->ptr[jml->ass_list.sorted->node[slot]];
+				(*n)++;
+			}
+
+			jmlist_debug(__func__,"found %u entries with key_ptr=%p in list jml=%p",*n,key_ptr,jml);
+			jmlist_debug(__func__,"returning with success.");
+			return JMLIST_ERROR_SUCCESS;
+		}
+
+		ijmlist_bpt_lower_bound(jml,key_ptr,key_len,&leaf,&slot);
+		while( leaf )
+		{
+			if( slot >= leaf->count )
+			{
+				leaf = leaf->next;
+				slot = 0;
+				continue;
+			}
+
+			if( ijmlist_bpt_compare(jml,leaf->key_pfx[slot],leaf->key_ptr[slot],leaf->key_len[slot],pfx,key_ptr,key_len) )
+				break;
+
+			if( *n < cap )
+				out_ptrs[*n] = leaf->u.ptr[slot];
+			(*n)++;
+			slot++;
+		}
+
+		jmlist_debug(__func__,"found %u entries with key_ptr=%p in list jml=%p",*n,key_ptr,jml);
+		jmlist_debug(__func__,"returning with success.");
+		return JMLIST_ERROR_SUCCESS;
+	}
+
+	pgroup = ijmlist_ass_key_group(jml,key_ptr,key_len);
+	for( pseeker = pgroup ; pseeker && ijmlist_ass_same_key(jml,pseeker,pgroup) ; pseeker = pseeker->hnext )
+	{
+		if( ijmlist_ass_expired(jml,pseeker) )
+			continue;
+
+		if( *n < cap )
+			out_ptrs[*n] = pseeker->ptr;
+		(*n)++;
+	}
+
+	jmlist_debug(__func__,"found %u entries with key_ptr=%p in list jml=%p",*n,key_ptr,jml);
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+ * the batch is processed in groups, for each group the hashes are computed and
+ * the bucket slots prefetched, then the chain heads are loaded and prefetched,
+ * and only then the chains are walked. by the time a key is resolved its bucket
+ * and first entry should already be in cache.
+ */
+jmlist_status
+ijmlist_ass_get_by_keys(jmlist jml,jmlist_key *keys,jmlist_key_length *lens,jmlist_index n,
+		void **out_ptrs,bool *out_found)
+{
+	uint32_t hash[JMLIST_ASS_BATCH_GROUP];
+	bool rejected[JMLIST_ASS_BATCH_GROUP];
+	assoc_entry *pentry;
+	jmlist_index base;
+	jmlist_index group;
+	jmlist_index i;
+
+	jmlist_debug(__func__,"called with jml=%p, n=%u",jml,n);
+
+	if( jml->ass_list.shards )
+		return ijmlist_shard_get_by_keys(jml,keys,lens,n,out_ptrs,out_found);
+
+	if( jml->ass_list.frozen )
+	{
+		jmlist_debug(__func__,"passing control to the frozen list get_by_keys routine.");
+		return ijmlist_frozen_get_by_keys(jml,keys,lens,n,out_ptrs,out_found);
+	}
+
+	if( (jml->flags & JMLIST_ASS_ORDERED) || !jml->ass_list.bucket_count )
+	{
+		/* the b+tree descent has no independent loads to overlap */
+		jmlist_debug(__func__,"no hash index in list jml=%p, looking up keys one by one",jml);
+		for( i = 0 ; i < n ; i++ )
+		{
+			out_found[i] = false;
+			out_ptrs[i] = 0;
+			if( !jml->ass_list.usage )
+				continue;
+			if( ijmlist_ass_get_by_key(jml,keys[i],lens[i],&out_ptrs[i]) == JMLIST_ERROR_SUCCESS )
+				out_found[i] = true;
+		}
+
+		jmlist_debug(__func__,"returning with success.");
+		return JMLIST_ERROR_SUCCESS;
+	}
+
+	/* migrate once for the whole batch, the tables can't change after the
+	   buckets were prefetched */
+	ijmlist_ass_rehash_step(jml);
+
+	for( base = 0 ; base < n ; base += group )
+	{
+		group = (n - base) < JMLIST_ASS_BATCH_GROUP ? (n - base) : JMLIST_ASS_BATCH_GROUP;
+
+		for( i = 0 ; i < group ; i++ )
+		{
+			hash[i] = jml->ass_list.hash(keys[base+i],lens[base+i]);
+
+			/* keys rejected by the filter don't touch the buckets */
+			rejected[i] = jml->ass_list.filter && !ijmlist_ass_filter_update(jml->ass_list.filter,hash[i],0);
+			if( rejected[i] )
+				continue;
+
+			JMLIST_PREFETCH(ijmlist_ass_hash_bucket(jml,hash[i]));
+		}
+
+		for( i = 0 ; i < group ; i++ )
+		{
+			if( rejected[i] )
+				continue;
+			pentry = *ijmlist_ass_hash_bucket(jml,hash[i]);
+			if( pentry )
+				JMLIST_PREFETCH(pentry);
+		}
+
+		for( i = 0 ; i < group ; i++ )
+		{
+			pentry = rejected[i] ? 0 : ijmlist_ass_first_live(jml,ijmlist_ass_hash_lookup(jml,hash[i],keys[base+i],lens[base+i]));
+			out_found[base+i] = pentry ? true : false;
+			out_ptrs[base+i] = pentry ? pentry->ptr : 0;
+
+			if( !(jml->flags & JMLIST_ASS_LRU) )
+				continue;
+
+			if( pentry )
+			{
+				jml->ass_list.hits++;
+				ijmlist_ass_lru_promote(jml,pentry);
+			} else
+				jml->ass_list.misses++;
+		}
+	}
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+   jmlist_remove_by_key
+   removes an entry from the list using the key for the lists that actually support keys.
+*/
+jmlist_status
+jmlist_remove_by_key(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len)
+{
+	jmlist_debug(__func__,"called with jml=%p key_ptr=%p key_len=%u",jml,key_ptr,key_len);
+	
+	/* verify key_ptr */
+	if( !key_ptr )
+	{
+		jmlist_debug(__func__,"invalid key_ptr specified (key_ptr=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+	
+	/* verify key_len */
+	if( !key_len )
+	{
+		jmlist_debug(__func__,"invalid key_len specified (key_len=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( jml->flags & JMLIST_ASSOCIATIVE )
+	{
+		jmlist_debug(__func__,"passing control to associative list remove by key routine.");
+		return ijmlist_ass_remove_by_key(jml,key_ptr,key_len);
+	}
+
+	jmlist_debug(__func__,"invalid or unsupported list type (jml=%p, flags=%u)",jml,jml->flags);
+	jmlist_debug(__func__,"returning with failure.");
+	jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+	return JMLIST_ERROR_FAILURE;
+}
+
+jmlist_status
+ijmlist_ass_remove_by_key(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len)
+{
+	jmlist_debug(__func__,"called with jml=%p key_ptr=%p key_len=%u\n",(void*)jml,(void*)key_ptr,key_len);
+
+	if( jml->ass_list.shards )
+		return ijmlist_shard_remove_by_key(jml,key_ptr,key_len);
+
+	if( ijmlist_frozen_reject(jml,__func__) )
+		return JMLIST_ERROR_FAILURE;
+
+	/* verify fixed width and interned keys */
+	if( !ijmlist_ass_key_valid(jml,key_ptr,key_len) )
+	{
+		jmlist_debug(__func__,"invalid key specified (key_ptr=%p, key_len=%u)",key_ptr,key_len);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	/* trying to pop from empty list? */
+	if( !jml->ass_list.usage )
+	{
+		jmlist_debug(__func__,"trying to remove from empty list");
+		jmlist_debug(__func__,"returning with failure.");
+		jmlist_errno = JMLIST_ERROR_EMPTY_LIST;
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( jml->flags & JMLIST_ASS_ORDERED )
+	{
+		jmlist_debug(__func__,"passing control to the ordered associative list remove_by_key routine.");
+		return ijmlist_bpt_remove_by_key(jml,key_ptr,key_len);
+	}
+	
+	jmlist_debug(__func__,"seeking key_ptr=%p key_len=%u in the hash index",key_ptr,key_len);
+
+	/* expired entries are skipped as in get_by_key, jmlist_expire removes them */
+	assoc_entry *ptarget = ijmlist_ass_first_live(jml,ijmlist_ass_hash_find(jml,key_ptr,key_len));
+	if( !ptarget )
+	{
+		jmlist_debug(__func__,"couldn't find entry with key_ptr=%p key_len=%u in list jml=%p",key_ptr,key_len,jml);
+		jmlist_errno = JMLIST_ERROR_ENTRY_NOT_FOUND;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	jmlist_debug(__func__,"found entry, ptarget=%p ptarget->next=%p",ptarget,ptarget->next);
+	ijmlist_ass_unlink(jml,ptarget);
+	
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+jmlist_status
+jmlist_entry_count(jmlist jml,jmlist_index *entry_count)
+{
+	jmlist_debug(__func__,"called with jml=%p, entry_count=%p");
+
+	if( !entry_count )
+	{
+		jmlist_debug(__func__,"invalid entry_count argument (entry_count=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( jml->flags & JMLIST_INDEXED )
+	{
+		jmlist_debug(__func__,"updating entry_count to %u",jml->idx_list.usage);
+		*entry_count = jml->idx_list.usage;
+	} else if( jml->flags & JMLIST_LINKED )
+	{
+		jmlist_debug(__func__,"updating entry_count to %u",jml->lnk_list.usage);
+		*entry_count = jml->lnk_list.usage;
+	} else if( jml->flags & JMLIST_ASSOCIATIVE )
+	{
+		*entry_count = jml->ass_list.shards ? ijmlist_shard_usage(jml) : jml->ass_list.usage;
+		jmlist_debug(__func__,"updating entry_count to %u",*entry_count);
+	} else {
+		jmlist_debug(__func__,"unable to determine jmlist type from its flags");
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_INVALID_ARGUMENT;
+	}
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+   jmlist_remove_by_index
+
+   Removes an entry from the list using the entry index.
+*/
+jmlist_status
+jmlist_remove_by_index(jmlist jml,jmlist_index index)
+{
+	jmlist_debug(__func__,"called with jml=%p, index=%u",jml,index);
+	
+	if( jml->flags & JMLIST_INDEXED )
+	{
+		jmlist_debug(__func__,"passing control to indexed list remove_by_index routine.");
+		return ijmlist_changed(jml,ijmlist_idx_remove_by_index(jml,index));
+	} else if( jml->flags & JMLIST_LINKED )
+	{
+		jmlist_debug(__func__,"passing control to linked list remove_by_index routine.");
+		return ijmlist_changed(jml,ijmlist_lnk_remove_by_index(jml,index));
+	}
+	else if( jml->flags & JMLIST_ASSOCIATIVE )
+	{
+		jmlist_debug(__func__,"passing control to the associative list remove_by_index routine.");
+		return ijmlist_changed(jml,ijmlist_ass_remove_by_index(jml,index));
+	}
+	
+	jmlist_debug(__func__,"invalid or unsupported list type (jml=%p, flags=%u)",jml,jml->flags);
+	jmlist_debug(__func__,"returning with failure.");
+	jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+	return JMLIST_ERROR_FAILURE;
+}
+
+jmlist_status
+ijmlist_idx_remove_by_index(jmlist jml,jmlist_index index)
+{
+	jmlist_debug(__func__,"called with jml=%p, index=%u",jml,index);
+
+	if( !jml->idx_list.usage )
+	{
+		jmlist_debug(__func__,"cannot get by index on empty list (lnk_list.usage=0)");
+		jmlist_debug(__func__,"returning with failure.");
+		jmlist_errno = JMLIST_ERROR_EMPTY_LIST;
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	/* shouldn't use get on a fragmented idx list */
+	if( !(jml->flags & JMLIST_IDX_USE_SHIFT) )
+	{
+		/* check for fragmentation */
+		bool fragmented = false;
+		if( jmlist_is_fragmented(jml,false,&fragmented) == JMLIST_ERROR_FAILURE )
+			return JMLIST_ERROR_FAILURE;
+
+		if( fragmented == true )
+		{
+			jmlist_debug(__func__,"cannot use this function with possible fragmented indexed lists, use of JMLIST_IDX_USE_SHIFT is required");
+			jmlist_errno = JMLIST_ERROR_FAILURE;
+			jmlist_debug(__func__,"returning with failure.");
+			return JMLIST_ERROR_FAILURE;
+		}
+	}
+
+	/* check bounds */
+	if( index >= jml->idx_list.usage )
+	{
+		jmlist_debug(__func__,"index %u is out of bounds with list jml=%p which has %u entries",index,jml,jml->idx_list.usage);
+		jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
+		jmlist_debug(__func__,"returning with failure");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	/* remove the entry... */
+	jmlist_debug(__func__,"setting entry ptr (now %p) to NULL from list %p in index %u",jml->idx_list.plist[index],jml,index);
+
+	/* found the entry, clear it */
+	ijmlist_snap_idx_write(jml,index,(jml->flags & JMLIST_IDX_USE_SHIFT) ? jml->idx_list.capacity : index+1);
+	jml->idx_list.plist[index] = JMLIST_EMPTY_PTR;
+	jml->idx_list.usage--;
+
+	jmlist_mem.idx_list.used -= sizeof(void*);
+	jmlist_debug(__func__,"new jml_mem.idx_list.used is %u",jmlist_mem.idx_list.used);
+
+	jmlist_debug(__func__,"entry with index %u removed from list %p, new usage is %u",index,jml,jml->idx_list.usage);
+
+	/* if shift is activated, remove and shift, otherwise just remove */
+	unsigned int i;
+	if( jml->flags & JMLIST_IDX_USE_SHIFT )
+	{
+		jmlist_debug(__func__,"JMLIST_IDX_USE_SHIFT activated, shifting list entries.");
+
+		for( i = index ; i < (jml->idx_list.capacity - 1) ; i++ )
+			jml->idx_list.plist[i] = jml->idx_list.plist[i+1];
+	}
+
+	if( (jml->flags & JMLIST_IDX_USE_FRAG_FLAG) && (jml->idx_list.fragmented == false) )
+	{
+		if( (index < (jml->idx_list.capacity-1)) && (jml->idx_list.plist[index+1] != JMLIST_EMPTY_PTR) )
+			jml->idx_list.fragmented = true;
+
+		/* else we'll keep it in false (not fragmented) */
+	}
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+jmlist_status
+ijmlist_lnk_remove_by_index(jmlist jml,jmlist_index index)
+{
+	jmlist_debug(__func__,"called with jml=%p, index=%u",jml,index);
+
+	if( !jml->lnk_list.usage )
+	{
+		jmlist_debug(__func__,"trying to remove from empty list");
+		jmlist_debug(__func__,"returning with failure.");
+		jmlist_errno = JMLIST_ERROR_EMPTY_LIST;
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	/* check bounds! */
+	if( index >= jml->lnk_list.usage )
+	{
+		jmlist_debug(__func__,"index %u is out of bounds with list jml=%p which has %u entries",index,jml,jml->lnk_list.usage);
+		jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
+		jmlist_debug(__func__,"returning with failure");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	jmlist_debug(__func__,"seeking for index=%u in the linked list",index);
+
+	jmlist_index index_seeker = 0;	
+	linked_entry *pseeker = jml->lnk_list.phead;
+	linked_entry *pprevious = pseeker;
+	while( pseeker )
+	{
+		if( index_seeker != index )
+		{
+			pprevious = pseeker;
+			pseeker = pseeker->next;
+			index_seeker++;
+			continue;
+		}
+
+		jmlist_debug(__func__,"found entry with index=%u, pseeker=%p pseeker->next=%p",index,pseeker,pseeker->next);
+
+		if( pprevious == pseeker )
+		{
+			/* we're at HEAD */
+			jmlist_debug(__func__,"entry is from head, lets pop it instead...");
+			void *junk;
+			return ijmlist_lnk_pop(jml,&junk);
+		}
+
+		jmlist_debug(__func__,"unlinking entry with index=%u",index);
+		ijmlist_snap_node_write(jml,pprevious);
+		pprevious->next = pseeker->next;
+		jml->lnk_list.usage--;
+
+		jmlist_debug(__func__,"unlinked successfuly, new usage is %u, freeing entry structure",jml->lnk_list.usage);
+		ijmlist_snap_free(jml,pseeker);
+
+		jmlist_mem.lnk_list.total -= sizeof(struct _linked_entry);
+		jmlist_mem.lnk_list.used -= sizeof(struct _linked_entry);
+		jmlist_debug(__func__,"new jml_mem.lnk_list.total is %u",jmlist_mem.lnk_list.total);
+		jmlist_debug(__func__,"new jml_mem.lnk_list.used is %u",jmlist_mem.lnk_list.used);
+
+		jmlist_debug(__func__,"returning with success.");
+		return JMLIST_ERROR_SUCCESS;
+	}
+
+	/* this shouldn't happen since the bounds were checked before! damaged list?? */
+	jmlist_debug(__func__,"unexpected error! couldn't find entry with index=%u in list jml=%p",index,jml);
+	jmlist_errno = JMLIST_ERROR_ENTRY_NOT_FOUND;
+	jmlist_debug(__func__,"returning with failure.");
+	return JMLIST_ERROR_FAILURE;
+}
+
+jmlist_status
+ijmlist_ass_remove_by_index(jmlist jml,jmlist_index index)
+{
+	jmlist_debug(__func__,"called with jml=%p, index=%u",jml,index);
+
+	if( ijmlist_shard_reject(jml,__func__) )
+		return JMLIST_ERROR_FAILURE;
+
+	if( ijmlist_frozen_reject(jml,__func__) )
+		return JMLIST_ERROR_FAILURE;
+	
+	if( !jml->ass_list.usage )
+	{
+		jmlist_debug(__func__,"cannot remove on empty list");
+		jmlist_debug(__func__,"returning with failure.");
+		jmlist_errno = JMLIST_ERROR_EMPTY_LIST;
+		return JMLIST_ERROR_FAILURE;
+	}
+	
+	/* check bounds! */
+	if( index >= jml->ass_list.usage )
+	{
+		jmlist_debug(__func__,"index %u is out of bounds with list jml=%p which has %u entries",index,jml,jml->ass_list.usage);
+		jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
+		jmlist_debug(__func__,"returning with failure");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( jml->flags & JMLIST_ASS_ORDERED )
+	{
+		jmlist_debug(__func__,"passing control to the ordered associative list remove_by_index routine.");
+		return ijmlist_bpt_remove_by_index(jml,index);
+	}
+	
+	jmlist_debug(__func__,"seeking associative list for indexed item %u",index);
+	
+	assoc_entry *pseeker;
+	if( ijmlist_ass_find_entry(jml,index,&pseeker) == JMLIST_ERROR_FAILURE )
+	{
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	jmlist_debug(__func__,"found entry with index=%u, pseeker=%p pseeker->next=%p",index,pseeker,pseeker->next);
+	ijmlist_ass_unlink(jml,pseeker);
+	
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+   jmlist_replace_by_index
+
+   In indexed lists, entry is of index=index is cleared and replaced with new_ptr, this is
+   done ignoring the indexed list flags of shifting and fragmented. In the case of linked
+   lists the next pointer of the previous entry is replaced by new_ptr and new_ptr->next
+   is set to old previous->next. Associative lists have equal behaviour of linked ones.
+
+   In all the 3 cases, no memory counters are changed.
+
+   The difference from replace and remove+insert is that the new_ptr will maintain the
+   index specified by the argument in all the 3 types of lists. Also replace is faster
+   because it doesn't do operations associated with insert or remove.
+*/
+jmlist_status
+jmlist_replace_by_index(jmlist jml,jmlist_index index,void *new_ptr)
+{
+	jmlist_debug(__func__,"called with jml=%p, index=%u, new_ptr=%p",jml,index,new_ptr);
+	
+	if( jml->flags & JMLIST_INDEXED )
+	{
+		jmlist_debug(__func__,"passing control to indexed list replace_by_index routine.");
+		return ijmlist_idx_replace_by_index(jml,index,new_ptr);
+	} else if( jml->flags & JMLIST_LINKED )
+	{
+		jmlist_debug(__func__,"passing control to linked list replace_by_index routine.");
+		return ijmlist_lnk_replace_by_index(jml,index,new_ptr);
+	} else if( jml->flags & JMLIST_ASSOCIATIVE )
+	{
+		jmlist_debug(__func__,"passing control to the associative list replace_by_index routine.");
+		return ijmlist_ass_replace_by_index(jml,index,new_ptr);
+	}
+	
+	jmlist_debug(__func__,"invalid or unsupported list type (jml=%p, flags=%u)",jml,jml->flags);
+	jmlist_debug(__func__,"returning with failure.");
+	jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+	return JMLIST_ERROR_FAILURE;
+}
+
+jmlist_status
+ijmlist_idx_replace_by_index(jmlist jml,jmlist_index index,void *new_ptr)
+{
+	jmlist_debug(__func__,"called with jml=%p, index=%u",jml,index);
+
+	if( !jml->idx_list.usage )
+	{
+		jmlist_debug(__func__,"cannot replace by index on empty list (lnk_list.usage=0)");
+		jmlist_debug(__func__,"returning with failure.");
+		jmlist_errno = JMLIST_ERROR_EMPTY_LIST;
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	/* shouldn't use get on a fragmented idx list */
+	if( !(jml->flags & JMLIST_IDX_USE_SHIFT) )
+	{
+		/* check for fragmentation */
+		bool fragmented = false;
+		if( jmlist_is_fragmented(jml,false,&fragmented) == JMLIST_ERROR_FAILURE )
+			return JMLIST_ERROR_FAILURE;
+
+		if( fragmented == true )
+		{
+			jmlist_debug(__func__,"cannot use this function with possible fragmented indexed lists, use of JMLIST_IDX_USE_SHIFT is required");
+			jmlist_errno = JMLIST_ERROR_FAILURE;
+			jmlist_debug(__func__,"returning with failure.");
+			return JMLIST_ERROR_FAILURE;
+		}
+	}
+
+	/* check bounds */
+	if( index >= jml->idx_list.usage )
+	{
+		jmlist_debug(__func__,"index %u is out of bounds with list jml=%p which has %u entries",index,jml,jml->idx_list.usage);
+		jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
+		jmlist_debug(__func__,"returning with failure");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	/* remove the entry... */
+	jmlist_debug(__func__,"setting entry ptr (now %p) to new_ptr=%p from list %p in index %u",jml->idx_list.plist[index],new_ptr,jml,index);
+
+	/* found the entry, replace it */
+	ijmlist_snap_idx_write(jml,index,index+1);
+	jml->idx_list.plist[index] = new_ptr;
+
+	jmlist_debug(__func__,"entry with index %u replaced from list %p successfully, new entry has ptr=%p",index,jml,jml->idx_list.plist[index]);
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+jmlist_status
+ijmlist_lnk_replace_by_index(jmlist jml,jmlist_index index,void *new_ptr)
+{
+	jmlist_debug(__func__,"called with jml=%p, index=%u",jml,index);
+
+	if( !jml->lnk_list.usage )
+	{
+		jmlist_debug(__func__,"trying to replace from empty list");
+		jmlist_debug(__func__,"returning with failure.");
+		jmlist_errno = JMLIST_ERROR_EMPTY_LIST;
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	/* check bounds! */
+	if( index >= jml->lnk_list.usage )
+	{
+		jmlist_debug(__func__,"index %u is out of bounds with list jml=%p which has %u entries",index,jml,jml->lnk_list.usage);
+		jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
+		jmlist_debug(__func__,"returning with failure");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	jmlist_debug(__func__,"seeking for index=%u in the linked list",index);
+
+	jmlist_index index_seeker = 0;	
+	linked_entry *pseeker = jml->lnk_list.phead;
+	linked_entry *pprevious = pseeker;
+	while( pseeker )
+	{
+		if( index_seeker != index )
+		{
+			pprevious = pseeker;
+			pseeker = pseeker->next;
+			index_seeker++;
+			continue;
+		}
+
+		jmlist_debug(__func__,"found entry with index=%u, pseeker=%p pseeker->next=%p",index,pseeker,pseeker->next);
+
+		jmlist_debug(__func__,"replacing old ptr=%p with new_ptr=%p",pseeker->ptr,new_ptr);
+		ijmlist_snap_node_write(jml,pseeker);
+		pseeker->ptr = new_ptr;
+		jmlist_debug(__func__,"new entry ptr of index=%u is ptr=%p",index,pseeker->ptr);
+
+		jmlist_debug(__func__,"returning with success.");
+		return JMLIST_ERROR_SUCCESS;
+	}
+
+	/* this shouldn't happen since the bounds were checked before! damaged list?? */
+	jmlist_debug(__func__,"unexpected error! couldn't find entry with index=%u in list jml=%p",index,jml);
+	jmlist_errno = JMLIST_ERROR_ENTRY_NOT_FOUND;
+	jmlist_debug(__func__,"returning with failure.");
+	return JMLIST_ERROR_FAILURE;
+}
+
+jmlist_status
+ijmlist_ass_replace_by_index(jmlist jml,jmlist_index index,void *new_ptr)
+{
+	jmlist_debug(__func__,"called with jml=%p, index=%u",jml,index);
+
+	if( ijmlist_shard_reject(jml,__func__) )
+		return JMLIST_ERROR_FAILURE;
+
+	if( ijmlist_frozen_reject(jml,__func__) )
+		return JMLIST_ERROR_FAILURE;
+	
+	if( !jml->ass_list.usage )
+	{
+		jmlist_debug(__func__,"cannot remove on empty list");
+		jmlist_debug(__func__,"returning with failure.");
+		jmlist_errno = JMLIST_ERROR_EMPTY_LIST;
+		return JMLIST_ERROR_FAILURE;
+	}
+	
+	/* check bounds! */
+	if( index >= jml->ass_list.usage )
+	{
+		jmlist_debug(__func__,"index %u is out of bounds with list jml=%p which has %u entries",index,jml,jml->ass_list.usage);
+		jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
+		jmlist_debug(__func__,"returning with failure");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( jml->flags & JMLIST_ASS_ORDERED )
+	{
+		jmlist_debug(__func__,"passing control to the ordered associative list replace_by_index routine.");
+		return ijmlist_bpt_replace_by_index(jml,index,new_ptr);
+	}
+	
+	jmlist_debug(__func__,"seeking associative list for indexed item %u",index);
+	
+	assoc_entry *pseeker;
+	if( ijmlist_ass_find_entry(jml,index,&pseeker) == JMLIST_ERROR_FAILURE )
+	{
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	jmlist_debug(__func__,"found entry with index=%u, pseeker=%p pseeker->next=%p",index,pseeker,pseeker->next);
+
+	jmlist_debug(__func__,"replacing old ptr=%p with new_ptr=%p",pseeker->ptr,new_ptr);
+	ijmlist_snap_node_write(jml,pseeker);
+	pseeker->ptr = new_ptr;
+	jmlist_debug(__func__,"new entry ptr of index=%u is ptr=%p",index,pseeker->ptr);
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+   jmlist_seek_start
+
+   Start seeking in a list, the fastest seeking process is different depending on the
+   list type thats why jmlist_seek_* routines were coded. There should be passed a pointer
+   to a seek_handle_t structure memory space which will be used to identify the seeking.
+
+   A seeking finishes by calling the function jmlist_seek_end. The seek state is
+   kept in the handle only, so a list can be seeked with several handles at once
+   (nested loops or several threads reading the list).
+*/
+jmlist_status
+jmlist_seek_start(jmlist jml,jmlist_seek_handle *handle_ptr)
+{
+	jmlist_debug(__func__,"called with jml=%p and handle=%p",jml,handle_ptr);
+
+	if( !jml )
+	{
+		jmlist_debug(__func__,"invalid jml specified (jml=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !handle_ptr ) {
+		jmlist_debug(__func__,"invalid handle pointer specified (handle_ptr=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	/* the seek state is in the handle, the list isn't changed by seeking */
+	handle_ptr->started = true;
+	handle_ptr->ranged = false;
+	handle_ptr->current.valid = false;
+	handle_ptr->current.before = 0;
+	ijmlist_seek_release(handle_ptr);
+	handle_ptr->generation = jml->generation;
+	jmlist_debug(__func__,"seek started at list generation %u",handle_ptr->generation);
+
+	/* clear handle data for the specific list type */
+
+	if( jml->flags & JMLIST_INDEXED )
+	{
+		jmlist_debug(__func__,"passing control to indexed list seek_init routine.");
+		return ijmlist_idx_seek_start(jml,handle_ptr);
+	} else if( jml->flags & JMLIST_LINKED )
+	{
+		jmlist_debug(__func__,"passing control to linked list seek_init routine.");
+		return ijmlist_lnk_seek_start(jml,handle_ptr);
+	} else if( jml->flags & JMLIST_ASSOCIATIVE )
+	{
+		jmlist_debug(__func__,"passing control to the associative list seek_init routine.");
+		return ijmlist_ass_seek_start(jml,handle_ptr);
+	}
+
+	jmlist_debug(__func__,"invalid or unsupported list type (jml=%p, flags=%u)",jml,jml->flags);
+	jmlist_debug(__func__,"returning with failure.");
+	jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+	return JMLIST_ERROR_FAILURE;
+}
+
+jmlist_status
+ijmlist_idx_seek_start(jmlist jml,jmlist_seek_handle *handle_ptr)
+{
+	jmlist_debug(__func__,"called with jml=%p and handle=%p",jml,handle_ptr);
+
+	if( !jml )
+	{
+		jmlist_debug(__func__,"invalid jml specified (jml=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !handle_ptr ) {
+		jmlist_debug(__func__,"invalid handle pointer specified (handle_ptr=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	handle_ptr->pos.next_idx = 0;
+	jmlist_debug(__func__,"handle index set to %u",handle_ptr->pos.next_idx);
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+jmlist_status
+ijmlist_lnk_seek_start(jmlist jml,jmlist_seek_handle *handle_ptr)
+{
+	jmlist_debug(__func__,"called with jml=%p and handle=%p",jml,handle_ptr);
+
+	if( !jml )
+	{
+		jmlist_debug(__func__,"invalid jml specified (jml=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !handle_ptr ) {
+		jmlist_debug(__func__,"invalid handle pointer specified (handle_ptr=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	handle_ptr->pos.next_lnk = jml->lnk_list.phead;
+	jmlist_debug(__func__,"handle next_lnk set to %p",handle_ptr->pos.next_lnk);
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+jmlist_status
+ijmlist_ass_seek_start(jmlist jml,jmlist_seek_handle *handle_ptr)
+{
+	jmlist_debug(__func__,"called with jml=%p and handle=%p",jml,handle_ptr);
+
+	if( !jml )
+	{
+		jmlist_debug(__func__,"invalid jml specified (jml=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( ijmlist_shard_reject(jml,__func__) )
+		return JMLIST_ERROR_FAILURE;
+
+	if( !handle_ptr ) {
+		jmlist_debug(__func__,"invalid handle pointer specified (handle_ptr=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( jml->flags & JMLIST_ASS_ORDERED )
+	{
+		jmlist_debug(__func__,"passing control to the ordered associative list seek_range routine.");
+		return ijmlist_bpt_seek_range(jml,handle_ptr,0,0,0,0);
+	}
+
+	handle_ptr->pos.next_ass = jml->ass_list.phead;
+	handle_ptr->pos.next_key.by_key = false;
+	jmlist_debug(__func__,"handle next_ass set to %p",handle_ptr->pos.next_ass);
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+jmlist_status
+jmlist_seek_end(jmlist jml,jmlist_seek_handle *handle_ptr)
+{
+	jmlist_debug(__func__,"called with jml=%p and handle_ptr=%p",jml,handle_ptr);
+
+	if( !jml ) {
+		jmlist_debug(__func__,"invalid jml specified (jml=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !handle_ptr ) {
+		jmlist_debug(__func__,"invalid handle_ptr specified (handle_ptr=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !handle_ptr->started ) {
+		jmlist_debug(__func__,"cannot stop a seek that was not started (handle_ptr=%p)",handle_ptr);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	ijmlist_seek_release(handle_ptr);
+	handle_ptr->started = false;
+	jmlist_debug(__func__,"seek of handle_ptr=%p ended",handle_ptr);
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+   jmlist_seek_next
+
+   Parse list and obtain the next entry, an argument, handler structure
+   is used to determine where the seeking is at. Each list type have its own
+   handler data.
+*/
+jmlist_status
+jmlist_seek_next(jmlist jml,jmlist_seek_handle *handle_ptr,void **ptr)
+{
+	jmlist_debug(__func__,"called with jml=%p, handle_ptr=%p and ptr=%p",jml,handle_ptr,ptr);
+
+	if( !jml )
+	{
+		jmlist_debug(__func__,"invalid jml specified (jml=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !ptr ) {
+		jmlist_debug(__func__,"invalid ptr specified (ptr=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !handle_ptr ) {
+		jmlist_debug(__func__,"invalid handle_ptr specified (handle_ptr=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !handle_ptr->started ) {
+		jmlist_debug(__func__,"seek should start by calling seek_start routine");
+		jmlist_errno = JMLIST_ERROR_FAILURE;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( (jml->flags & JMLIST_SEEK_CHECKED) && (handle_ptr->generation != jml->generation) ) {
+		jmlist_debug(__func__,"list changed since the seek started (generation %u, list is at %u)",
+				handle_ptr->generation,jml->generation);
+		jmlist_errno = JMLIST_ERROR_STALE_SEEK;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	handle_ptr->current.valid = false;
+
+	if( jml->flags & JMLIST_INDEXED )
+	{
+		jmlist_debug(__func__,"passing control to indexed list seek_next routine.");
+		return ijmlist_idx_seek_next(jml,handle_ptr,ptr);
+	} else if( jml->flags & JMLIST_LINKED )
+	{
+		jmlist_debug(__func__,"passing control to linked list seek_next routine.");
+		return ijmlist_lnk_seek_next(jml,handle_ptr,ptr);
+	} else if( jml->flags & JMLIST_ASSOCIATIVE )
+	{
+		jmlist_debug(__func__,"passing control to the associative list seek_next routine.");
+		return ijmlist_ass_seek_next(jml,handle_ptr,ptr);
+	}
+	
+	jmlist_debug(__func__,"invalid or unsupported list type (jml=%p, flags=%u)",jml,jml->flags);
+	jmlist_debug(__func__,"returning with failure.");
+	jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+	return JMLIST_ERROR_FAILURE;
+}
+
+jmlist_status
+ijmlist_idx_seek_next(jmlist jml,jmlist_seek_handle *handle_ptr,void **ptr)
+{
+	void *ptr_local;
+
+	jmlist_debug(__func__,"called with jml=%p, handle_ptr=%p, ptr=%p",jml,handle_ptr,ptr);
+
+	if( !jml ) {
+		jmlist_debug(__func__,"invalid jml specified (jml=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !handle_ptr ) {
+		jmlist_debug(__func__,"invalid handle_ptr specified (handle_ptr=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !ptr ) {
+		jmlist_debug(__func__,"invalid ptr specified (ptr=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	bool fragmented;
+	jmlist_is_fragmented(jml,false,&fragmented);
+try_again:
+	/* test next index bounds */
+	if( (jml->flags & JMLIST_IDX_USE_SHIFT) || !fragmented )
+	{
+		if( handle_ptr->pos.next_idx >= jml->idx_list.usage ) {
+			jmlist_debug(__func__,"next index (%u) reached the limit of the list entry count (%u)",
+					handle_ptr->pos.next_idx,jml->idx_list.usage);
+			jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
+			jmlist_debug(__func__,"returning with failure.");
+			return JMLIST_ERROR_FAILURE;
+		}
+	} else
+	{
+		if( handle_ptr->pos.next_idx >= jml->idx_list.capacity ) {
+			jmlist_debug(__func__,"next index (%u) reached the limit of the list capacity (%u)",
+					handle_ptr->pos.next_idx,jml->idx_list.capacity);
+			jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
+			jmlist_debug(__func__,"returning with failure.");
+			return JMLIST_ERROR_FAILURE;
+		}
+	}
+
+	jmlist_debug(__func__,"accessing indexed list entry of index %u",handle_ptr->pos.next_idx);
+	ptr_local = jml->idx_list.plist[handle_ptr->pos.next_idx];
+	jmlist_debug(__func__,"indexed list entry of index %u has ptr=%p",handle_ptr->pos.next_idx,ptr_local);
+
+	if(	ptr_local == JMLIST_EMPTY_PTR ) {
+		handle_ptr->pos.next_idx++;
+		jmlist_debug(__func__,"entry is empty, increasing to the next index %u",handle_ptr->pos.next_idx);
+		goto try_again;
+	}
+
+	jmlist_debug(__func__,"storing entry ptr=%p into ptr argument (ptr=%p)",ptr_local,ptr);
+	*ptr = ptr_local;
+	handle_ptr->current.idx = handle_ptr->pos.next_idx;
+	handle_ptr->current.ptr = ptr_local;
+	handle_ptr->current.valid = true;
+
+	/* increase next index */
+	handle_ptr->pos.next_idx++;
+	jmlist_debug(__func__,"increased handle (with ptr=%p) to the next index %u",
+			handle_ptr,handle_ptr->pos.next_idx);
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+	goto try_again;
+}
+
+jmlist_status
+ijmlist_lnk_seek_next(jmlist jml,jmlist_seek_handle *handle_ptr,void **ptr)
+{
+	void *ptr_local;
+
+	jmlist_debug(__func__,"called with jml=%p, handle_ptr=%p and ptr=%p",jml,handle_ptr,ptr);
+
+	if( !jml ) {
+		jmlist_debug(__func__,"invalid jml specified (jml=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !handle_ptr ) {
+		jmlist_debug(__func__,"invalid handle_ptr specified (handle_ptr=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !ptr ) {
+		jmlist_debug(__func__,"invalid ptr specified (ptr=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !handle_ptr->pos.next_lnk ) {
+		jmlist_debug(__func__,"there are no more entries to seek (reached the tail of the list)");
+		jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	jmlist_debug(__func__,"accessing handle_ptr next link structure");
+	ptr_local = handle_ptr->pos.next_lnk->ptr;
+	jmlist_debug(__func__,"storing entry ptr=%p into ptr argument (ptr=%p)",ptr_local,ptr);
+	*ptr = ptr_local;
+	handle_ptr->current.lnk = handle_ptr->pos.next_lnk;
+	handle_ptr->current.prev = handle_ptr->current.before;
+	handle_ptr->current.before = handle_ptr->pos.next_lnk;
+	handle_ptr->current.valid = true;
+
+	handle_ptr->pos.next_lnk = handle_ptr->pos.next_lnk->next;
+	jmlist_debug(__func__,"updated handle to the next entry (new next_lnk=%p)",handle_ptr->pos.next_lnk);
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+jmlist_status
+ijmlist_ass_seek_next(jmlist jml,jmlist_seek_handle *handle_ptr,void **ptr)
+{
+	void *ptr_local;
+
+	jmlist_debug(__func__,"called with jml=%p, handle_ptr=%p and ptr=%p",jml,handle_ptr,ptr);
+
+	if( !jml ) {
+		jmlist_debug(__func__,"invalid jml specified (jml=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !handle_ptr ) {
+		jmlist_debug(__func__,"invalid handle_ptr specified (handle_ptr=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !ptr ) {
+		jmlist_debug(__func__,"invalid ptr specified (ptr=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( jml->flags & JMLIST_ASS_ORDERED )
+	{
+		jmlist_debug(__func__,"passing control to the ordered associative list seek_next routine.");
+		return ijmlist_bpt_seek_next(jml,handle_ptr,ptr);
+	}
+
+	if( handle_ptr->pos.next_key.by_key )
+	{
+		jmlist_debug(__func__,"passing control to the associative list seek_key_next routine.");
+		return ijmlist_ass_seek_key_next(jml,handle_ptr,ptr);
+	}
+
+	if( !handle_ptr->pos.next_ass ) {
+		jmlist_debug(__func__,"there are no more entries to seek (reached the tail of the list)");
+		jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	jmlist_debug(__func__,"accessing handle_ptr next link structure");
+	ptr_local = handle_ptr->pos.next_ass->ptr;
+	jmlist_debug(__func__,"storing entry ptr=%p into ptr argument (ptr=%p)",ptr_local,ptr);
+	*ptr = ptr_local;
+	handle_ptr->current.ass = handle_ptr->pos.next_ass;
+	handle_ptr->current.hash = handle_ptr->pos.next_ass->hash;
+	handle_ptr->current.valid = true;
+
+	handle_ptr->pos.next_ass = handle_ptr->pos.next_ass->next;
+	jmlist_debug(__func__,"updated handle to the next entry (new next_ass=%p)",handle_ptr->pos.next_ass);
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+   jmlist_seek_start_reverse
+
+   Same as jmlist_seek_start but the handle is set after the last entry of the
+   list, jmlist_seek_prev then returns the entries from the last one to the first
+   one. The handle is a position between two entries: jmlist_seek_next returns
+   the entry after it and jmlist_seek_prev the one before it, both can be used on
+   handles started either way (walking back and forth over the list).
+
+   jmlist_seek_prev is O(1) per entry on indexed lists, on associative lists
+   (doubly linked) and on ordered associative lists (linked leaves). Entries of
+   linked lists only have a next link, there the first jmlist_seek_prev walks
+   from the head to the handle once and stacks the entries it passes in the
+   handle, the next ones pop that stack in O(1) (a reverse loop is O(N) with N
+   pointers of memory). The stack is walked again after jmlist_seek_next or when
+   the list changed other than by jmlist_seek_remove_current of this handle, and
+   it's freed by jmlist_seek_end.
+*/
+jmlist_status
+jmlist_seek_start_reverse(jmlist jml,jmlist_seek_handle *handle_ptr)
+{
+	jmlist_debug(__func__,"called with jml=%p and handle=%p",jml,handle_ptr);
+
+	if( !jml )
+	{
+		jmlist_debug(__func__,"invalid jml specified (jml=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !handle_ptr ) {
+		jmlist_debug(__func__,"invalid handle pointer specified (handle_ptr=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( (jml->flags & JMLIST_ASSOCIATIVE) && ijmlist_shard_reject(jml,__func__) )
+		return JMLIST_ERROR_FAILURE;
+
+	handle_ptr->started = true;
+	handle_ptr->ranged = false;
+	handle_ptr->current.valid = false;
+	handle_ptr->current.before = 0;
+	ijmlist_seek_release(handle_ptr);
+	handle_ptr->generation = jml->generation;
+	jmlist_debug(__func__,"seek started at list generation %u",handle_ptr->generation);
+
+	if( jml->flags & JMLIST_INDEXED )
+	{
+		handle_ptr->pos.next_idx = (jml->flags & JMLIST_IDX_USE_SHIFT) ? jml->idx_list.usage : jml->idx_list.capacity;
+		jmlist_debug(__func__,"handle index set to %u",handle_ptr->pos.next_idx);
+	} else if( jml->flags & JMLIST_LINKED )
+	{
+		handle_ptr->pos.next_lnk = 0;
+		jmlist_debug(__func__,"handle next_lnk set after the tail");
+	} else if( (jml->flags & JMLIST_ASSOCIATIVE) && (jml->flags & JMLIST_ASS_ORDERED) )
+	{
+		ijmlist_bpt_seek_range(jml,handle_ptr,0,0,0,0);
+		if( jml->ass_list.sorted )
+		{
+			handle_ptr->pos.next_bpt.slot = jml->ass_list.sorted->count;
+		} else
+		{
+			handle_ptr->pos.next_bpt.leaf = ijmlist_bpt_last_leaf(jml);
+			handle_ptr->pos.next_bpt.slot = handle_ptr->pos.next_bpt.leaf ? handle_ptr->pos.next_bpt.leaf->count : 0;
+		}
+		jmlist_debug(__func__,"handle set to leaf=%p and slot=%u",handle_ptr->pos.next_bpt.leaf,handle_ptr->pos.next_bpt.slot);
+	} else if( jml->flags & JMLIST_ASSOCIATIVE )
+	{
+		handle_ptr->pos.next_ass = 0;
+		handle_ptr->pos.next_key.by_key = false;
+		jmlist_debug(__func__,"handle next_ass set after the tail");
+	} else
+	{
+		handle_ptr->started = false;
+		jmlist_debug(__func__,"invalid or unsupported list type (jml=%p, flags=%u)",jml,jml->flags);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+   jmlist_seek_prev
+
+   Obtains the entry before the handle position and moves the handle back over
+   it. Fails with JMLIST_ERROR_OUT_OF_BOUNDS at the head of the list. Seeks of a
+   key or of a range (jmlist_seek_key, jmlist_seek_range) only go forward.
+*/
+jmlist_status
+jmlist_seek_prev(jmlist jml,jmlist_seek_handle *handle_ptr,void **ptr)
+{
+	jmlist_debug(__func__,"called with jml=%p, handle_ptr=%p and ptr=%p",jml,handle_ptr,ptr);
+
+	if( !jml )
+	{
+		jmlist_debug(__func__,"invalid jml specified (jml=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !ptr || !handle_ptr ) {
+		jmlist_debug(__func__,"invalid arguments specified (handle_ptr=%p, ptr=%p)",handle_ptr,ptr);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !handle_ptr->started ) {
+		jmlist_debug(__func__,"seek should start by calling seek_start routine");
+		jmlist_errno = JMLIST_ERROR_FAILURE;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( handle_ptr->ranged ) {
+		jmlist_debug(__func__,"key and range seeks can't go backwards (handle_ptr=%p)",handle_ptr);
+		jmlist_errno = JMLIST_ERROR_UNSUPPORTED;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( (jml->flags & JMLIST_SEEK_CHECKED) && (handle_ptr->generation != jml->generation) ) {
+		jmlist_debug(__func__,"list changed since the seek started (generation %u, list is at %u)",
+				handle_ptr->generation,jml->generation);
+		jmlist_errno = JMLIST_ERROR_STALE_SEEK;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	handle_ptr->current.valid = false;
+
+	if( jml->flags & JMLIST_INDEXED )
+	{
+		jmlist_debug(__func__,"passing control to indexed list seek_prev routine.");
+		return ijmlist_idx_seek_prev(jml,handle_ptr,ptr);
+	} else if( jml->flags & JMLIST_LINKED )
+	{
+		jmlist_debug(__func__,"passing control to linked list seek_prev routine.");
+		return ijmlist_lnk_seek_prev(jml,handle_ptr,ptr);
+	} else if( jml->flags & JMLIST_ASSOCIATIVE )
+	{
+		jmlist_debug(__func__,"passing control to the associative list seek_prev routine.");
+		return ijmlist_ass_seek_prev(jml,handle_ptr,ptr);
+	}
+
+	jmlist_debug(__func__,"invalid or unsupported list type (jml=%p, flags=%u)",jml,jml->flags);
+	jmlist_debug(__func__,"returning with failure.");
+	jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+	return JMLIST_ERROR_FAILURE;
+}
+
+jmlist_status
+ijmlist_idx_seek_prev(jmlist jml,jmlist_seek_handle *handle_ptr,void **ptr)
+{
+	jmlist_index limit = (jml->flags & JMLIST_IDX_USE_SHIFT) ? jml->idx_list.usage : jml->idx_list.capacity;
+	jmlist_index idx = handle_ptr->pos.next_idx;
+
+	jmlist_debug(__func__,"called with jml=%p, handle_ptr=%p and ptr=%p",jml,handle_ptr,ptr);
+
+	/* the list can be shorter than when the handle was set */
+	if( idx > limit )
+		idx = limit;
+
+	while( idx && (jml->idx_list.plist[idx-1] == JMLIST_EMPTY_PTR) )
+		idx--;
+
+	if( !idx ) {
+		jmlist_debug(__func__,"there are no more entries to seek (reached the head of the list)");
+		jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	handle_ptr->pos.next_idx = idx - 1;
+	*ptr = jml->idx_list.plist[idx-1];
+	handle_ptr->current.idx = idx - 1;
+	handle_ptr->current.ptr = *ptr;
+	handle_ptr->current.valid = true;
+	jmlist_debug(__func__,"indexed list entry of index %u has ptr=%p",idx-1,*ptr);
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+jmlist_status
+ijmlist_lnk_seek_prev(jmlist jml,jmlist_seek_handle *handle_ptr,void **ptr)
+{
+	linked_entry *entry;
+	linked_entry *prev;
+
+	jmlist_debug(__func__,"called with jml=%p, handle_ptr=%p and ptr=%p",jml,handle_ptr,ptr);
+
+	if( !handle_ptr->back.entries || (handle_ptr->back.owner != handle_ptr) ||
+			(handle_ptr->back.generation != jml->generation) ||
+			(handle_ptr->back.next != handle_ptr->pos.next_lnk) )
+	{
+		if( ijmlist_lnk_seek_stack(jml,handle_ptr) == JMLIST_ERROR_FAILURE )
+		{
+			jmlist_debug(__func__,"returning with failure.");
+			return JMLIST_ERROR_FAILURE;
+		}
+	}
+
+	if( !handle_ptr->back.count ) {
+		jmlist_debug(__func__,"there are no more entries to seek (reached the head of the list)");
+		jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	entry = handle_ptr->back.entries[--handle_ptr->back.count];
+	prev = handle_ptr->back.count ? handle_ptr->back.entries[handle_ptr->back.count-1] : 0;
+	handle_ptr->back.next = entry;
+
+	*ptr = entry->ptr;
+	handle_ptr->pos.next_lnk = entry;
+	handle_ptr->current.lnk = entry;
+	handle_ptr->current.prev = prev;
+	handle_ptr->current.before = prev;
+	handle_ptr->current.valid = true;
+	jmlist_debug(__func__,"updated handle to the previous entry (new next_lnk=%p, ptr=%p)",entry,*ptr);
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+ * stacks the entries of a linked list before the handle position, walking
+ * from the head (there's no prev link). fails with JMLIST_ERROR_STALE_SEEK if
+ * the handle entry isn't in the list anymore.
+ */
+jmlist_status
+ijmlist_lnk_seek_stack(jmlist jml,jmlist_seek_handle *handle_ptr)
+{
+	linked_entry *entry = jml->lnk_list.phead;
+	linked_entry **entries;
+
+	jmlist_debug(__func__,"called with jml=%p and handle_ptr=%p",jml,handle_ptr);
+
+	if( handle_ptr->back.owner != handle_ptr )
+		handle_ptr->back.entries = 0;
+
+	if( !handle_ptr->back.entries || (handle_ptr->back.capacity < jml->lnk_list.usage) )
+	{
+		entries = (linked_entry**)realloc(handle_ptr->back.entries,(jml->lnk_list.usage + 1)*sizeof(linked_entry*));
+		if( !entries )
+		{
+			jmlist_debug(__func__,"realloc failed (size %u)!",(jml->lnk_list.usage + 1)*sizeof(linked_entry*));
+			jmlist_errno = JMLIST_ERROR_MALLOC;
+			jmlist_debug(__func__,"returning with failure.");
+			return JMLIST_ERROR_FAILURE;
+		}
+		handle_ptr->back.owner = handle_ptr;
+		handle_ptr->back.entries = entries;
+		handle_ptr->back.capacity = jml->lnk_list.usage + 1;
+	}
+
+	handle_ptr->back.count = 0;
+	while( entry && (entry != handle_ptr->pos.next_lnk) && (handle_ptr->back.count < handle_ptr->back.capacity) )
+	{
+		handle_ptr->back.entries[handle_ptr->back.count++] = entry;
+		entry = entry->next;
+	}
+
+	if( entry != handle_ptr->pos.next_lnk ) {
+		jmlist_debug(__func__,"handle entry next_lnk=%p is not in the list",handle_ptr->pos.next_lnk);
+		ijmlist_seek_release(handle_ptr);
+		jmlist_errno = JMLIST_ERROR_STALE_SEEK;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	handle_ptr->back.next = entry;
+	handle_ptr->back.generation = jml->generation;
+	jmlist_debug(__func__,"stacked %u entries before next_lnk=%p",handle_ptr->back.count,entry);
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+ * frees the linked list stack of a handle, if the handle allocated it. seek
+ * starts call it too, restarting a handle without jmlist_seek_end doesn't leak.
+ */
+void
+ijmlist_seek_release(jmlist_seek_handle *handle_ptr)
+{
+	if( handle_ptr->back.entries && (handle_ptr->back.owner == handle_ptr) )
+	{
+		jmlist_debug(__func__,"freeing the %u entries stack of handle_ptr=%p",handle_ptr->back.capacity,handle_ptr);
+		free(handle_ptr->back.entries);
+	}
+	handle_ptr->back.entries = 0;
+	handle_ptr->back.owner = 0;
+}
+
+jmlist_status
+ijmlist_ass_seek_prev(jmlist jml,jmlist_seek_handle *handle_ptr,void **ptr)
+{
+	assoc_entry *entry;
+
+	jmlist_debug(__func__,"called with jml=%p, handle_ptr=%p and ptr=%p",jml,handle_ptr,ptr);
+
+	if( jml->flags & JMLIST_ASS_ORDERED )
+	{
+		jmlist_debug(__func__,"passing control to the ordered associative list seek_prev routine.");
+		return ijmlist_bpt_seek_prev(jml,handle_ptr,ptr);
+	}
+
+	entry = handle_ptr->pos.next_ass ? handle_ptr->pos.next_ass->prev : jml->ass_list.ptail;
+	if( !entry ) {
+		jmlist_debug(__func__,"there are no more entries to seek (reached the head of the list)");
+		jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	*ptr = entry->ptr;
+	handle_ptr->pos.next_ass = entry;
+	handle_ptr->current.ass = entry;
+	handle_ptr->current.hash = entry->hash;
+	handle_ptr->current.valid = true;
+	jmlist_debug(__func__,"updated handle to the previous entry (new next_ass=%p, ptr=%p)",entry,*ptr);
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+   jmlist_seek_remove_current
+
+   Removes the entry returned by the last jmlist_seek_next or jmlist_seek_prev
+   of the handle, the handle stays valid and the seek goes on with the entry
+   after it (or before it, going backwards). The entry is unlinked in O(1) in
+   linked and unordered associative lists, without the walk from the head of
+   jmlist_remove_by_ptr. Indexed lists get a hole in its slot, lists with
+   JMLIST_IDX_USE_SHIFT have no holes and the entries after it are moved down.
+   With JMLIST_SEEK_CHECKED the handle is kept current, other seeks of the list
+   go stale. Removing twice, or after jmlist_seek_next failed, fails with
+   JMLIST_ERROR_ENTRY_NOT_FOUND, and an entry already removed some other way
+   (another handle, a remove by key or ptr) with JMLIST_ERROR_STALE_SEEK. Key and range seeks and ordered associative
+   lists are not supported.
+
+	jmlist_seek_start(jml,&handle);
+	while( jmlist_seek_next(jml,&handle,&ptr) == JMLIST_ERROR_SUCCESS )
+		if( expired(ptr) )
+			jmlist_seek_remove_current(jml,&handle);
+	jmlist_seek_end(jml,&handle);
+*/
+jmlist_status
+jmlist_seek_remove_current(jmlist jml,jmlist_seek_handle *handle_ptr)
+{
+	jmlist_status status;
+
+	jmlist_debug(__func__,"called with jml=%p and handle_ptr=%p",jml,handle_ptr);
+
+	if( !jml || !handle_ptr ) {
+		jmlist_debug(__func__,"invalid arguments specified (jml=%p, handle_ptr=%p)",jml,handle_ptr);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !handle_ptr->started ) {
+		jmlist_debug(__func__,"seek should start by calling seek_start routine");
+		jmlist_errno = JMLIST_ERROR_FAILURE;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( handle_ptr->ranged || ((jml->flags & JMLIST_ASSOCIATIVE) && (jml->flags & JMLIST_ASS_ORDERED)) ) {
+		jmlist_debug(__func__,"key and range seeks and ordered lists can't remove the current entry (flags=%u)",jml->flags);
+		jmlist_errno = JMLIST_ERROR_UNSUPPORTED;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( (jml->flags & JMLIST_SEEK_CHECKED) && (handle_ptr->generation != jml->generation) ) {
+		jmlist_debug(__func__,"list changed since the seek started (generation %u, list is at %u)",
+				handle_ptr->generation,jml->generation);
+		jmlist_errno = JMLIST_ERROR_STALE_SEEK;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !handle_ptr->current.valid ) {
+		jmlist_debug(__func__,"no current entry in handle_ptr=%p",handle_ptr);
+		jmlist_errno = JMLIST_ERROR_ENTRY_NOT_FOUND;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( jml->flags & JMLIST_INDEXED )
+	{
+		jmlist_debug(__func__,"passing control to indexed list remove_current routine.");
+		status = ijmlist_idx_remove_current(jml,handle_ptr);
+	} else if( jml->flags & JMLIST_LINKED )
+	{
+		jmlist_debug(__func__,"passing control to linked list remove_current routine.");
+		status = ijmlist_lnk_remove_current(jml,handle_ptr);
+	} else if( jml->flags & JMLIST_ASSOCIATIVE )
+	{
+		jmlist_debug(__func__,"passing control to the associative list remove_current routine.");
+		status = ijmlist_ass_remove_current(jml,handle_ptr);
+	} else
+	{
+		jmlist_debug(__func__,"invalid or unsupported list type (jml=%p, flags=%u)",jml,jml->flags);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( status != JMLIST_ERROR_SUCCESS )
+		return status;
+
+	/* the list changed but this seek knows how */
+	jml->generation++;
+	handle_ptr->generation = jml->generation;
+	handle_ptr->current.valid = false;
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+jmlist_status
+ijmlist_idx_remove_current(jmlist jml,jmlist_seek_handle *handle_ptr)
+{
+	jmlist_index i = handle_ptr->current.idx;
+
+	jmlist_debug(__func__,"called with jml=%p, handle_ptr=%p (slot %u)",jml,handle_ptr,i);
+
+	if( (i >= jml->idx_list.capacity) || (jml->idx_list.plist[i] != handle_ptr->current.ptr) ) {
+		jmlist_debug(__func__,"slot %u doesn't hold ptr=%p anymore",i,handle_ptr->current.ptr);
+		jmlist_errno = JMLIST_ERROR_STALE_SEEK;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( jml->flags & JMLIST_IDX_USE_SHIFT )
+	{
+		/* no holes in these lists, the ones after it go one slot down */
+		jmlist_debug(__func__,"JMLIST_IDX_USE_SHIFT activated, shifting %u entries.",jml->idx_list.usage-1-i);
+		ijmlist_snap_idx_write(jml,i,jml->idx_list.usage);
+		memmove(jml->idx_list.plist+i,jml->idx_list.plist+i+1,(jml->idx_list.usage-1-i)*sizeof(void*));
+		jml->idx_list.plist[jml->idx_list.usage-1] = JMLIST_EMPTY_PTR;
+		if( handle_ptr->pos.next_idx > i )
+			handle_ptr->pos.next_idx--;
+	} else
+	{
+		ijmlist_snap_idx_write(jml,i,i+1);
+		jml->idx_list.plist[i] = JMLIST_EMPTY_PTR;
+
+		if( (jml->flags & JMLIST_IDX_USE_FRAG_FLAG) && (i < (jml->idx_list.capacity-1)) &&
+				(jml->idx_list.plist[i+1] != JMLIST_EMPTY_PTR) )
+			jml->idx_list.fragmented = true;
+	}
+	jml->idx_list.usage--;
+
+	jmlist_mem.idx_list.used -= sizeof(void*);
+	jmlist_debug(__func__,"new jml_mem.idx_list.used is %u",jmlist_mem.idx_list.used);
+
+	jmlist_debug(__func__,"entry of slot %u removed, new usage is %u, handle is at %u",i,jml->idx_list.usage,handle_ptr->pos.next_idx);
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+jmlist_status
+ijmlist_lnk_remove_current(jmlist jml,jmlist_seek_handle *handle_ptr)
+{
+	linked_entry *pentry = handle_ptr->current.lnk;
+	linked_entry *pprevious = handle_ptr->current.prev;
+
+	jmlist_debug(__func__,"called with jml=%p, handle_ptr=%p (pentry=%p, pprevious=%p)",jml,handle_ptr,pentry,pprevious);
+
+	if( (pprevious ? pprevious->next : jml->lnk_list.phead) != pentry ) {
+		jmlist_debug(__func__,"entry pentry=%p isn't after pprevious=%p anymore",pentry,pprevious);
+		jmlist_errno = JMLIST_ERROR_STALE_SEEK;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( pprevious )
+	{
+		ijmlist_snap_node_write(jml,pprevious);
+		pprevious->next = pentry->next;
+	} else
+		jml->lnk_list.phead = pentry->next;
+
+	/* going forward the handle is after the entry, going backwards before it */
+	if( handle_ptr->current.before == pentry )
+		handle_ptr->current.before = pprevious;
+	if( handle_ptr->pos.next_lnk == pentry )
+		handle_ptr->pos.next_lnk = pentry->next;
+
+	/* the stacked entries are the ones before pentry, still in the list (the
+	   generation is bumped by jmlist_seek_remove_current) */
+	if( handle_ptr->back.entries && (handle_ptr->back.next == pentry) && (handle_ptr->back.generation == jml->generation) )
+	{
+		handle_ptr->back.next = handle_ptr->pos.next_lnk;
+		handle_ptr->back.generation = jml->generation + 1;
+	}
+
+	jml->lnk_list.usage--;
+	jmlist_mem.lnk_list.total -= sizeof(struct _linked_entry);
+	jmlist_mem.lnk_list.used -= sizeof(struct _linked_entry);
+	jmlist_debug(__func__,"new jml_mem.lnk_list.total is %u",jmlist_mem.lnk_list.total);
+	jmlist_debug(__func__,"new jml_mem.lnk_list.used is %u",jmlist_mem.lnk_list.used);
+
+	jmlist_debug(__func__,"unlinked successfuly, new usage is %u, freeing entry",jml->lnk_list.usage);
+	ijmlist_snap_free(jml,pentry);
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+jmlist_status
+ijmlist_ass_remove_current(jmlist jml,jmlist_seek_handle *handle_ptr)
+{
+	assoc_entry *pentry = handle_ptr->current.ass;
+
+	jmlist_debug(__func__,"called with jml=%p, handle_ptr=%p (pentry=%p)",jml,handle_ptr,pentry);
+
+	if( ijmlist_frozen_reject(jml,__func__) )
+		return JMLIST_ERROR_FAILURE;
+
+	/* another handle or a remove by key may have freed it */
+	if( !ijmlist_ass_hash_contains(jml,handle_ptr->current.hash,pentry) ) {
+		jmlist_debug(__func__,"entry pentry=%p isn't in the list anymore",pentry);
+		jmlist_errno = JMLIST_ERROR_STALE_SEEK;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( handle_ptr->pos.next_ass == pentry )
+		handle_ptr->pos.next_ass = pentry->next;
+	ijmlist_ass_unlink(jml,pentry);
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+   jmlist_seek_next_batch
+
+   Same as jmlist_seek_next but stores up to cap entries in out, count is set to
+   the number of entries stored. The arguments and the handle are checked once per
+   call and the entries are copied by a loop of the list type, without the tracing
+   done for each entry by jmlist_seek_next. When there are no more entries it fails
+   with JMLIST_ERROR_OUT_OF_BOUNDS and count is set to 0. Batches and single
+   jmlist_seek_next calls can be mixed on the same handle.
+*/
+jmlist_status
+jmlist_seek_next_batch(jmlist jml,jmlist_seek_handle *handle_ptr,void **out,jmlist_index cap,jmlist_index *count)
+{
+	jmlist_index n = 0;
+
+	jmlist_debug(__func__,"called with jml=%p, handle_ptr=%p, out=%p, cap=%u and count=%p",jml,handle_ptr,out,cap,count);
+
+	if( !jml )
+	{
+		jmlist_debug(__func__,"invalid jml specified (jml=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !handle_ptr ) {
+		jmlist_debug(__func__,"invalid handle_ptr specified (handle_ptr=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !out || !cap ) {
+		jmlist_debug(__func__,"invalid output buffer specified (out=%p, cap=%u)",out,cap);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !count ) {
+		jmlist_debug(__func__,"invalid count specified (count=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	*count = 0;
+
+	if( !handle_ptr->started ) {
+		jmlist_debug(__func__,"seek should start by calling seek_start routine");
+		jmlist_errno = JMLIST_ERROR_FAILURE;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( (jml->flags & JMLIST_SEEK_CHECKED) && (handle_ptr->generation != jml->generation) ) {
+		jmlist_debug(__func__,"list changed since the seek started (generation %u, list is at %u)",
+				handle_ptr->generation,jml->generation);
+		jmlist_errno = JMLIST_ERROR_STALE_SEEK;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	handle_ptr->current.valid = false;
+
+	if( jml->flags & JMLIST_INDEXED )
+		n = ijmlist_idx_seek_next_batch(jml,handle_ptr,out,cap);
+	else if( jml->flags & JMLIST_LINKED )
+		n = ijmlist_lnk_seek_next_batch(handle_ptr,out,cap);
+	else if( (jml->flags & JMLIST_ASSOCIATIVE) && (jml->flags & JMLIST_ASS_ORDERED) )
+		n = ijmlist_bpt_seek_next_batch(jml,handle_ptr,out,cap);
+	else if( jml->flags & JMLIST_ASSOCIATIVE )
+		n = ijmlist_ass_seek_next_batch(jml,handle_ptr,out,cap);
+	else
+	{
+		jmlist_debug(__func__,"invalid or unsupported list type (jml=%p, flags=%u)",jml,jml->flags);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !n )
+	{
+		jmlist_debug(__func__,"there are no more entries to seek");
+		jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	*count = n;
+	jmlist_debug(__func__,"stored %u entries into out (out=%p)",n,out);
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+ * the batch routines below are only called from jmlist_seek_next_batch with the
+ * arguments checked, they return the number of entries stored in out.
+ */
+jmlist_index
+ijmlist_idx_seek_next_batch(jmlist jml,jmlist_seek_handle *handle_ptr,void **out,jmlist_index cap)
+{
+	void **plist = jml->idx_list.plist;
+	jmlist_index idx = handle_ptr->pos.next_idx;
+	jmlist_index limit, n = 0;
+	bool fragmented;
+
+	/* same bound as ijmlist_idx_seek_next, but taken once per batch */
+	jmlist_is_fragmented(jml,false,&fragmented);
+	if( (jml->flags & JMLIST_IDX_USE_SHIFT) || !fragmented )
+		limit = jml->idx_list.usage;
+	else
+		limit = jml->idx_list.capacity;
+
+	for( ; (idx < limit) && (n < cap) ; idx++ )
+	{
+		if( plist[idx] != JMLIST_EMPTY_PTR )
+			out[n++] = plist[idx];
+	}
+
+	handle_ptr->pos.next_idx = idx;
+	return n;
+}
+
+jmlist_index
+ijmlist_lnk_seek_next_batch(jmlist_seek_handle *handle_ptr,void **out,jmlist_index cap)
+{
+	linked_entry *pentry = handle_ptr->pos.next_lnk;
+	jmlist_index n = 0;
+
+	while( pentry && (n < cap) )
+	{
+		out[n++] = pentry->ptr;
+		handle_ptr->current.before = pentry;
+		pentry = pentry->next;
+	}
+
+	handle_ptr->pos.next_lnk = pentry;
+	return n;
+}
+
+jmlist_index
+ijmlist_ass_seek_next_batch(jmlist jml,jmlist_seek_handle *handle_ptr,void **out,jmlist_index cap)
+{
+	assoc_entry *pentry, *pnext;
+	jmlist_index n = 0;
+
+	if( handle_ptr->pos.next_key.by_key )
+	{
+		/* same walk as ijmlist_ass_seek_key_next */
+		pentry = handle_ptr->pos.next_key.entry;
+		while( pentry && (n < cap) )
+		{
+			if( !ijmlist_ass_expired(jml,pentry) )
+				out[n++] = pentry->ptr;
+			pnext = pentry->hnext;
+			pentry = (pnext && ijmlist_ass_same_key(jml,pnext,pentry)) ? pnext : 0;
+		}
+		handle_ptr->pos.next_key.entry = pentry;
+		return n;
+	}
+
+	pentry = handle_ptr->pos.next_ass;
+	while( pentry && (n < cap) )
+	{
+		out[n++] = pentry->ptr;
+		pentry = pentry->next;
+	}
+
+	handle_ptr->pos.next_ass = pentry;
+	return n;
+}
+
+jmlist_index
+ijmlist_bpt_seek_next_batch(jmlist jml,jmlist_seek_handle *handle_ptr,void **out,jmlist_index cap)
+{
+	jmlist_key hi_ptr = handle_ptr->pos.next_bpt.hi_ptr;
+	jmlist_key_length hi_len = handle_ptr->pos.next_bpt.hi_len;
+	int hi_stop = handle_ptr->pos.next_bpt.hi_incl ? 1 : 0;
+	uint64_t hi_pfx = hi_ptr ? ijmlist_bpt_prefix(hi_ptr,hi_len) : 0;
+	bpt_node *leaf = handle_ptr->pos.next_bpt.leaf;
+	jmlist_index slot = handle_ptr->pos.next_bpt.slot;
+	jmlist_index n = 0;
+
+	if( jml->ass_list.sorted )
+	{
+		assoc_sorted *sorted = jml->ass_list.sorted;
+
+		while( (slot < sorted->count) && (n < cap) )
+		{
+			if( hi_ptr && (ijmlist_sorted_compare(jml,slot,hi_pfx,hi_ptr,hi_len) >= hi_stop) )
+				break;
+			out[n++] = sorted->ptr[sorted->node[slot]];
+			slot++;
+		}
+
+		handle_ptr->pos.next_bpt.slot = slot;
+		return n;
+	}
+
+	while( leaf && (n < cap) )
+	{
+		if( slot >= leaf->count )
+		{
+			/* stay on the last leaf at the end, as ijmlist_bpt_seek_next does */
+			if( !leaf->next )
+				break;
+			leaf = leaf->next;
+			slot = 0;
+			continue;
+		}
+
+		if( hi_ptr && (ijmlist_bpt_compare(jml,leaf->key_pfx[slot],leaf->key_ptr[slot],leaf->key_len[slot],
+				hi_pfx,hi_ptr,hi_len) >= hi_stop) )
+			break;
+
+		out[n++] = leaf->u.ptr[slot];
+		slot++;
+	}
+
+	handle_ptr->pos.next_bpt.leaf = leaf;
+	handle_ptr->pos.next_bpt.slot = slot;
+	return n;
+}
+
+/*
+   jmlist_find
+
+   Parse all entries from the list, calling the callback function for each of them,
+   when this callback returns result=jmlist_entry_found the seeking stops and this
+   function returns the corresponding entry ptr in ptr argument. Concurrent lists
+   are searched shard by shard holding the lock of a shard, same as in jmlist_parse.
+*/
+jmlist_status
+jmlist_find(jmlist jml,JMLISTFINDCALLBACK callback,void *param,jmlist_lookup_result *result,void **ptr)
+{
+	jmlist_lookup_result result_local;
+	jmlist_status jmls;
+	jmlist_index entry_count;
+	jmlist_seek_handle shandle;
+	void *ptr_seek;
+
+	jmlist_debug(__func__,"called with jml=%p, callback=%p, param=%p, result=%p and ptr=%p",
+			jml,callback,param,result,ptr);
+
+	if( !jml ) {
+		jmlist_debug(__func__,"invalid jml specified (jml=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !callback ) {
+		jmlist_debug(__func__,"invalid callback specified (callback=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !result ) {
+		jmlist_debug(__func__,"invalid result pointer specified (result=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	/* shards are searched one at a time while holding their lock */
+	if( (jml->flags & JMLIST_ASSOCIATIVE) && jml->ass_list.shards )
+		return ijmlist_shard_find(jml,callback,param,result,ptr);
+
+	/* start seeking the list */
+
+	jmls = jmlist_entry_count(jml,&entry_count);
+	if( jmls != JMLIST_ERROR_SUCCESS ) {
+		jmlist_debug(__func__,"unable to get entry count from list");
+		jmlist_errno = JMLIST_ERROR_FAILURE;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	jmlist_debug(__func__,"seeking throughtout %u entries of the list",entry_count);
+
+	jmls = jmlist_seek_start(jml,&shandle);
+	if( jmls == JMLIST_ERROR_FAILURE ) {
+		jmlist_debug(__func__,"unable to seek the list");
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	while(entry_count)
+	{
+		jmls = jmlist_seek_next(jml,&shandle,&ptr_seek);
+		if( jmls != JMLIST_ERROR_SUCCESS ) {
+			jmlist_debug(__func__,"seek_next returned failure, unexpected list seeking failure");
+			jmlist_debug(__func__,"returning with failure.");
+			return JMLIST_ERROR_FAILURE;
+		}
+
+		jmlist_debug(__func__,"got entry with ptr=%p, calling callback=%p",ptr_seek,callback);
+		callback(ptr_seek,param,&result_local);
+		jmlist_debug(__func__,"callback returned with result=%d",result_local);
+
+		if( result_local == jmlist_entry_found )
+		{
+			jmlist_debug(__func__,"finished search, entry was found");
+			if( ptr ) {
+				jmlist_debug(__func__,"writing ptr=%p into ptr argument",ptr_seek);
+				*ptr = ptr_seek;
+			}
+
+			jmlist_debug(__func__,"updating result argument");
+			*result = result_local;
+
+			jmls = jmlist_seek_end(jml,&shandle);
+			if( jmls != JMLIST_ERROR_SUCCESS ) {
+				jmlist_debug(__func__,"unable to end seek, jmlist_seek_end failed");
+				jmlist_debug(__func__,"returning with failure.");
+				return JMLIST_ERROR_FAILURE;
+			}
+			
+			jmlist_debug(__func__,"returning with success.");
+			return JMLIST_ERROR_SUCCESS;
+		}
+		entry_count--;
+	}
+
+	jmlist_debug(__func__,"seeking was ended, calling seek_end");
+	jmls = jmlist_seek_end(jml,&shandle);
+	if( jmls != JMLIST_ERROR_SUCCESS ) {
+		jmlist_debug(__func__,"unable to end seek, jmlist_seek_end failed");
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	jmlist_debug(__func__,"entry was not found, updating result argument");
+	*result = jmlist_entry_not_found;
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+   jmlist_find_parallel
+
+   Same as jmlist_find but the entries are passed to the callback by nthreads
+   threads (0 for one thread per online cpu), split the same way as in
+   jmlist_parse_parallel. Once a match is found the threads stop passing the
+   entries that can't change the result: with JMLIST_FIND_ANY that's all of
+   them and ptr is set to whichever match was found first, with
+   JMLIST_FIND_FIRST the entries after the match and ptr is set to the first
+   matching entry in list order (the one jmlist_find returns). The callback can
+   be called for entries after the match before the threads see it, and from
+   several threads at once, so it must be thread safe.
+*/
+jmlist_status
+jmlist_find_parallel(jmlist jml,JMLISTFINDCALLBACK callback,void *param,jmlist_find_mode mode,
+		unsigned int nthreads,jmlist_lookup_result *result,void **ptr)
+{
+	parse_job job;
+
+	jmlist_debug(__func__,"called with jml=%p, callback=%p, param=%p, mode=%d, nthreads=%u, result=%p and ptr=%p",
+			jml,callback,param,mode,nthreads,result,ptr);
+
+	if( !jml ) {
+		jmlist_debug(__func__,"invalid jml specified (jml=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !callback ) {
+		jmlist_debug(__func__,"invalid callback specified (callback=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !result ) {
+		jmlist_debug(__func__,"invalid result pointer specified (result=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( (mode != JMLIST_FIND_FIRST) && (mode != JMLIST_FIND_ANY) ) {
+		jmlist_debug(__func__,"invalid find mode specified (mode=%d)",mode);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	memset(&job,0,sizeof(job));
+	job.find = callback;
+	job.mode = mode;
+	job.param = param;
+
+	if( ijmlist_parse_job(jml,&job,nthreads) != JMLIST_ERROR_SUCCESS )
+	{
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( job.found < job.chunk_count )
+	{
+		jmlist_debug(__func__,"finished search, entry was found (ptr=%p)",job.match);
+		if( ptr )
+			*ptr = job.match;
+		*result = jmlist_entry_found;
+	} else
+	{
+		jmlist_debug(__func__,"entry was not found, updating result argument");
+		*result = jmlist_entry_not_found;
+	}
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/* one entry against a jmlist_find_builtin predicate */
+static inline bool
+ijmlist_pred_match(jmlist_predicate pred,void *ptr,uintptr_t a,uintptr_t b)
+{
+	uintptr_t u = (uintptr_t)ptr;
+	intptr_t s = (intptr_t)u;
+
+	switch( pred )
+	{
+		case JMLIST_PRED_PTR_EQ:
+		case JMLIST_PRED_INT_EQ:
+			return u == a;
+		case JMLIST_PRED_PTR_RANGE:
+			return (u >= a) && (u < b);
+		case JMLIST_PRED_INT_LT:
+			return s < (intptr_t)a;
+		case JMLIST_PRED_INT_GT:
+			return s > (intptr_t)a;
+		default:
+			return (s >= (intptr_t)a) && (s < (intptr_t)b);
+	}
+}
+
+/* JMLIST_VEC_LANES entries from plist against a predicate, bit k of the
+   result is set when plist[k] matches (holes never match) */
+static inline unsigned int
+ijmlist_pred_block(jmlist_predicate pred,void **plist,bool holes,uintptr_t a,uintptr_t b)
+{
+	unsigned int bits = 0;
+	int k;
+#ifdef JMLIST_VECTORS
+	jmlist_uvec v;
+	jmlist_svec s,m;
+
+	memcpy(&v,plist,sizeof(v));
+	s = (jmlist_svec)v;
+
+	switch( pred )
+	{
+		case JMLIST_PRED_PTR_EQ:
+		case JMLIST_PRED_INT_EQ:
+			m = (v == a);
+			break;
+		case JMLIST_PRED_PTR_RANGE:
+			m = (v >= a) & (v < b);
+			break;
+		case JMLIST_PRED_INT_LT:
+			m = (s < (intptr_t)a);
+			break;
+		case JMLIST_PRED_INT_GT:
+			m = (s > (intptr_t)a);
+			break;
+		default:
+			m = (s >= (intptr_t)a) & (s < (intptr_t)b);
+			break;
+	}
+
+	if( holes )
+		m &= (v != (uintptr_t)JMLIST_EMPTY_PTR);
+
+	for( k = 0 ; k < JMLIST_VEC_LANES ; k++ )
+		bits |= (unsigned int)(m[k] & 1) << k;
+#else
+	for( k = 0 ; k < JMLIST_VEC_LANES ; k++ )
+	{
+		if( holes && (plist[k] == JMLIST_EMPTY_PTR) )
+			continue;
+		if( ijmlist_pred_match(pred,plist[k],a,b) )
+			bits |= 1u << k;
+	}
+#endif
+
+	return bits;
+}
+
+/*
+   Scans the slots of an indexed list a block of JMLIST_VEC_LANES at a time,
+   blocks without matches cost one vector compare. Returns the number of
+   matches (0 or 1 for JMLIST_MATCH_FIRST), up to cap of their indexes are
+   stored in indexes.
+*/
+jmlist_index
+ijmlist_idx_find_builtin(jmlist jml,jmlist_predicate pred,uintptr_t a,uintptr_t b,
+		jmlist_match_output output,jmlist_index *indexes,jmlist_index cap)
+{
+	void **plist = jml->idx_list.plist;
+	bool holes = !(jml->flags & JMLIST_IDX_USE_SHIFT);
+	jmlist_index slots = holes ? jml->idx_list.capacity : jml->idx_list.usage;
+	jmlist_index found = 0;
+	jmlist_index i;
+	unsigned int bits;
+
+	for( i = 0 ; i + JMLIST_VEC_LANES <= slots ; i += JMLIST_VEC_LANES )
+	{
+		bits = ijmlist_pred_block(pred,plist + i,holes,a,b);
+		if( !bits )
+			continue;
+
+		if( output == JMLIST_MATCH_FIRST )
+		{
+			indexes[0] = i + JMLIST_CTZ(bits);
+			return 1;
+		}
+
+		for( ; bits ; bits &= bits - 1 )
+		{
+			if( (output == JMLIST_MATCH_ALL) && (found < cap) )
+				indexes[found] = i + JMLIST_CTZ(bits);
+			found++;
+		}
+	}
+
+	/* last slots, less than a block */
+	for( ; i < slots ; i++ )
+	{
+		if( holes && (plist[i] == JMLIST_EMPTY_PTR) )
+			continue;
+		if( !ijmlist_pred_match(pred,plist[i],a,b) )
+			continue;
+
+		if( output == JMLIST_MATCH_FIRST )
+		{
+			indexes[0] = i;
+			return 1;
+		}
+
+		if( (output == JMLIST_MATCH_ALL) && (found < cap) )
+			indexes[found] = i;
+		found++;
+	}
+
+	return found;
+}
+
+/*
+   jmlist_find_builtin
+
+   Same as jmlist_find with one of the common predicates instead of a
+   callback, so the entries can be compared several at once with simd
+   instructions. Only indexed lists are supported. The entries are compared
+   to a (and b for the ranges), the indexes are the ones of
+   jmlist_get_by_index/jmlist_remove_by_index:
+   - JMLIST_MATCH_FIRST stores the index of the first match in indexes[0],
+   - JMLIST_MATCH_ALL stores the indexes of the first cap matches,
+   - JMLIST_MATCH_COUNT only counts them (indexes can be 0).
+   count is set to the number of matches, 0 if there are none, which can be
+   more than cap with JMLIST_MATCH_ALL.
+*/
+jmlist_status
+jmlist_find_builtin(jmlist jml,jmlist_predicate pred,intptr_t a,intptr_t b,
+		jmlist_match_output output,jmlist_index *indexes,jmlist_index cap,jmlist_index *count)
+{
+	jmlist_debug(__func__,"called with jml=%p, pred=%d, a=%" PRIdPTR ", b=%" PRIdPTR ", output=%d, indexes=%p, cap=%u and count=%p",
+			jml,pred,a,b,output,indexes,cap,count);
+
+	if( !jml ) {
+		jmlist_debug(__func__,"invalid jml specified (jml=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !count ) {
+		jmlist_debug(__func__,"invalid count pointer specified (count=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( (pred < JMLIST_PRED_PTR_EQ) || (pred > JMLIST_PRED_INT_RANGE) ) {
+		jmlist_debug(__func__,"invalid predicate specified (pred=%d)",pred);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( (output < JMLIST_MATCH_FIRST) || (output > JMLIST_MATCH_COUNT) ) {
+		jmlist_debug(__func__,"invalid output specified (output=%d)",output);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( (output != JMLIST_MATCH_COUNT) && (!indexes || !cap) ) {
+		jmlist_debug(__func__,"invalid indexes specified (indexes=%p, cap=%u)",indexes,cap);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !(jml->flags & JMLIST_INDEXED) )
+	{
+		jmlist_debug(__func__,"builtin predicates are only supported in indexed lists (jml=%p, flags=%u)",jml,jml->flags);
+		jmlist_errno = JMLIST_ERROR_UNSUPPORTED;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	*count = ijmlist_idx_find_builtin(jml,pred,(uintptr_t)a,(uintptr_t)b,output,indexes,cap);
+	jmlist_debug(__func__,"found %u matching entries",*count);
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+   jmlist_parse
+
+   This function will parse all the jmlist entries and call the callback
+   for each entry. Its possible to pass a specific param to the callback
+   also.
+*/
+jmlist_status
+jmlist_parse(jmlist jml,JMLISTPARSERCALLBACK callback,void *param)
+{
+	jmlist_status jmls;
+	jmlist_index entry_count;
+	jmlist_seek_handle shandle;
+	void *ptr_seek;
+
+	jmlist_debug(__func__,"called with jml=%p, callback=%p, param=%p",
+			jml,callback,param);
+
+	if( !jml ) {
+		jmlist_debug(__func__,"invalid jml specified (jml=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !callback ) {
+		jmlist_debug(__func__,"invalid callback specified (callback=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	/* shards are parsed one at a time while holding their lock */
+	if( (jml->flags & JMLIST_ASSOCIATIVE) && jml->ass_list.shards )
+		return ijmlist_shard_parse(jml,callback,param);
+
+	/* start seeking the list */
+
+	jmls = jmlist_entry_count(jml,&entry_count);
+	if( jmls != JMLIST_ERROR_SUCCESS ) {
+		jmlist_debug(__func__,"unable to get entry count from list");
+		jmlist_errno = JMLIST_ERROR_FAILURE;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	jmlist_debug(__func__,"seeking throughtout %u entries of the list",entry_count);
+
+	jmls = jmlist_seek_start(jml,&shandle);
+	if( jmls == JMLIST_ERROR_FAILURE ) {
+		jmlist_debug(__func__,"unable to seek the list");
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	while(entry_count)
+	{
+		jmls = jmlist_seek_next(jml,&shandle,&ptr_seek);
+		if( jmls != JMLIST_ERROR_SUCCESS ) {
+			jmlist_debug(__func__,"seek_next returned failure, unexpected list seeking failure");
+			jmlist_debug(__func__,"returning with failure.");
+			return JMLIST_ERROR_FAILURE;
+		}
+
+		jmlist_debug(__func__,"got entry with ptr=%p, calling callback=%p",ptr_seek,callback);
+		callback(ptr_seek,param);
+		jmlist_debug(__func__,"callback returned");
+
+		entry_count--;
+	}
+
+	jmlist_debug(__func__,"seeking was ended, calling seek_end");
+	jmls = jmlist_seek_end(jml,&shandle);
+	if( jmls != JMLIST_ERROR_SUCCESS ) {
+		jmlist_debug(__func__,"unable to end seek, jmlist_seek_end failed");
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+   jmlist_parse_parallel
+
+   Same as jmlist_parse but the callback is called by nthreads threads at once
+   (0 for one thread per online cpu), the calling thread being one of them. The
+   entries are split in chunks, ranges of slots in indexed lists and split points
+   found in one walk of the other lists, each thread starts with its share of
+   consecutive chunks and then takes the chunks the others didn't get to yet, so
+   callbacks of uneven cost don't leave threads idle. The threads are kept in a
+   pool for the next calls, until jmlist_cleanup.
+
+   The callback is called once for each entry. The entries of a chunk are passed
+   in list order by one thread, but there's no order between chunks: calls for
+   different entries run at the same time and in any order, the callback must be
+   safe to call concurrently. The function returns after all the calls returned
+   and what they wrote is visible to the caller then. The list must not change
+   during the parse. Concurrent lists are split by shard and the lock of a shard
+   is held while its entries are passed, same as in jmlist_parse. Calls made from
+   the callback, with nthreads 1 or with lists too small to split run in the
+   calling thread only, calls from several threads run one at a time.
+*/
+jmlist_status
+jmlist_parse_parallel(jmlist jml,JMLISTPARSERCALLBACK callback,void *param,unsigned int nthreads)
+{
+	parse_job job;
+
+	jmlist_debug(__func__,"called with jml=%p, callback=%p, param=%p and nthreads=%u",
+			jml,callback,param,nthreads);
+
+	if( !jml ) {
+		jmlist_debug(__func__,"invalid jml specified (jml=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !callback ) {
+		jmlist_debug(__func__,"invalid callback specified (callback=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	memset(&job,0,sizeof(job));
+	job.callback = callback;
+	job.param = param;
+
+	return ijmlist_parse_job(jml,&job,nthreads);
+}
+
+/*
+   jmlist_pipeline_init
+
+   Starts a pipeline over the entries of jml, filter and map stages are added
+   with jmlist_pipeline_filter and jmlist_pipeline_map and the pipeline is run
+   with jmlist_pipeline_run or jmlist_pipeline_reduce:
+
+	jmlist_pipeline_init(jml,&pipe);
+	jmlist_pipeline_filter(&pipe,is_odd,0);
+	jmlist_pipeline_map(&pipe,square,0);
+	jmlist_pipeline_reduce(&pipe,add,add_sums,&sum,sizeof(sum),0,8);
+
+   All the stages run on an entry before the next entry is taken, so the list
+   is seeked once and there are no lists in between stages. The pipeline is a
+   structure of the caller, nothing is allocated until it runs.
+*/
+jmlist_status
+jmlist_pipeline_init(jmlist jml,jmlist_pipeline *pipe)
+{
+	jmlist_debug(__func__,"called with jml=%p and pipe=%p",jml,pipe);
+
+	if( !jml || !pipe ) {
+		jmlist_debug(__func__,"invalid arguments specified (jml=%p, pipe=%p)",jml,pipe);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	memset(pipe,0,sizeof(jmlist_pipeline));
+	pipe->jml = jml;
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+ * checks a pipeline passed to one of the jmlist_pipeline_* functions.
+ */
+jmlist_status
+ijmlist_pipeline_check(jmlist_pipeline *pipe,const char *func)
+{
+	if( !pipe || !pipe->jml ) {
+		jmlist_debug(func,"invalid pipeline specified (pipe=%p), it must be set by jmlist_pipeline_init",pipe);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(func,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+   jmlist_pipeline_filter
+
+   Adds a stage that drops the entries for which filter returns false.
+*/
+jmlist_status
+jmlist_pipeline_filter(jmlist_pipeline *pipe,JMLISTFILTERCALLBACK filter,void *param)
+{
+	jmlist_debug(__func__,"called with pipe=%p, filter=%p and param=%p",pipe,filter,param);
+
+	if( ijmlist_pipeline_check(pipe,__func__) != JMLIST_ERROR_SUCCESS )
+		return JMLIST_ERROR_FAILURE;
+
+	if( !filter ) {
+		jmlist_debug(__func__,"invalid filter specified (filter=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( pipe->stage_count >= JMLIST_PIPELINE_MAX_STAGES ) {
+		jmlist_debug(__func__,"pipeline has the most stages already (%u)",pipe->stage_count);
+		jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	pipe->stage[pipe->stage_count].filter = filter;
+	pipe->stage[pipe->stage_count].map = 0;
+	pipe->stage[pipe->stage_count].param = param;
+	pipe->stage_count++;
+	jmlist_debug(__func__,"pipeline has %u stages",pipe->stage_count);
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+   jmlist_pipeline_map
+
+   Adds a stage that replaces each entry by the pointer map returns for it, the
+   list isn't changed.
+*/
+jmlist_status
+jmlist_pipeline_map(jmlist_pipeline *pipe,JMLISTMAPCALLBACK map,void *param)
+{
+	jmlist_debug(__func__,"called with pipe=%p, map=%p and param=%p",pipe,map,param);
+
+	if( ijmlist_pipeline_check(pipe,__func__) != JMLIST_ERROR_SUCCESS )
+		return JMLIST_ERROR_FAILURE;
+
+	if( !map ) {
+		jmlist_debug(__func__,"invalid map specified (map=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( pipe->stage_count >= JMLIST_PIPELINE_MAX_STAGES ) {
+		jmlist_debug(__func__,"pipeline has the most stages already (%u)",pipe->stage_count);
+		jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	pipe->stage[pipe->stage_count].filter = 0;
+	pipe->stage[pipe->stage_count].map = map;
+	pipe->stage[pipe->stage_count].param = param;
+	pipe->stage_count++;
+	jmlist_debug(__func__,"pipeline has %u stages",pipe->stage_count);
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+ * runs the stages of a pipeline on an entry, the entries that pass them all
+ * are reduced into acc or passed to the sink.
+ */
+void
+ijmlist_pipeline_entry(jmlist_pipeline *pipe,void *acc,void *ptr)
+{
+	pipeline_stage *stage = pipe->stage;
+	pipeline_stage *end = pipe->stage + pipe->stage_count;
+
+	for( ; stage < end ; stage++ )
+	{
+		if( stage->map )
+			ptr = stage->map(ptr,stage->param);
+		else if( !stage->filter(ptr,stage->param) )
+			return;
+	}
+
+	if( pipe->reduce )
+		pipe->reduce(acc,ptr,pipe->param);
+	else
+		pipe->sink(ptr,pipe->param);
+}
+
+/*
+   jmlist_pipeline_run
+
+   Runs the pipeline, the entries that pass all the stages are passed to sink.
+   With nthreads other than 1 the pass is split in chunks run by the threads of
+   jmlist_parse_parallel (0 for one thread per online cpu), then the stages and
+   the sink are called from several threads at once and must be thread safe.
+*/
+jmlist_status
+jmlist_pipeline_run(jmlist_pipeline *pipe,JMLISTPARSERCALLBACK sink,void *param,unsigned int nthreads)
+{
+	parse_job job;
+
+	jmlist_debug(__func__,"called with pipe=%p, sink=%p, param=%p and nthreads=%u",pipe,sink,param,nthreads);
+
+	if( ijmlist_pipeline_check(pipe,__func__) != JMLIST_ERROR_SUCCESS )
+		return JMLIST_ERROR_FAILURE;
+
+	if( !sink ) {
+		jmlist_debug(__func__,"invalid sink specified (sink=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	pipe->sink = sink;
+	pipe->reduce = 0;
+	pipe->combine = 0;
+	pipe->param = param;
+
+	memset(&job,0,sizeof(job));
+	job.pipe = pipe;
+
+	return ijmlist_parse_job(pipe->jml,&job,nthreads);
+}
+
+/*
+   jmlist_pipeline_reduce
+
+   Runs the pipeline and reduces the entries that pass all the stages into the
+   acc_size bytes at acc, calling reduce(acc,ptr,param) for each of them. With
+   combine set the pass can be split in chunks run by nthreads threads (0 for
+   one thread per online cpu): each chunk is reduced into its own copy of acc,
+   and the copies are then combined into acc in list order by
+   combine(acc,part,param). acc must hold the identity of the reduction when it
+   is called (0 for a sum) since every copy starts from it. Without combine the
+   entries are reduced in list order by the calling thread.
+*/
+jmlist_status
+jmlist_pipeline_reduce(jmlist_pipeline *pipe,JMLISTREDUCECALLBACK reduce,JMLISTCOMBINECALLBACK combine,
+		void *acc,size_t acc_size,void *param,unsigned int nthreads)
+{
+	parse_job job;
+
+	jmlist_debug(__func__,"called with pipe=%p, reduce=%p, combine=%p, acc=%p, acc_size=%u, param=%p and nthreads=%u",
+			pipe,reduce,combine,acc,(unsigned int)acc_size,param,nthreads);
+
+	if( ijmlist_pipeline_check(pipe,__func__) != JMLIST_ERROR_SUCCESS )
+		return JMLIST_ERROR_FAILURE;
+
+	if( !reduce || !acc || !acc_size || (acc_size > SIZE_MAX - 63) ) {
+		jmlist_debug(__func__,"invalid arguments specified (reduce=%p, acc=%p, acc_size=%u)",reduce,acc,(unsigned int)acc_size);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	pipe->sink = 0;
+	pipe->reduce = reduce;
+	pipe->combine = combine;
+	pipe->acc = acc;
+	pipe->acc_size = acc_size;
+	pipe->param = param;
+
+	memset(&job,0,sizeof(job));
+	job.pipe = pipe;
+	if( combine )
+		job.acc_stride = (acc_size + 63) & ~(size_t)63;
+	else
+		nthreads = 1;
+
+	return ijmlist_parse_job(pipe->jml,&job,nthreads);
+}
+
+/*
+ * runs a parallel parse, find or pipeline job (job->callback, job->find or
+ * job->pipe set) on the entries of the list, see jmlist_parse_parallel.
+ */
+jmlist_status
+ijmlist_parse_job(jmlist jml,parse_job *job,unsigned int nthreads)
+{
+	jmlist_index entry_count;
+	jmlist_index chunk_count;
+	unsigned int i;
+	long cpus;
+
+	jmlist_debug(__func__,"called with jml=%p, job=%p and nthreads=%u",jml,job,nthreads);
+
+	if( !nthreads )
+	{
+		cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		nthreads = (cpus > 0) ? (unsigned int)cpus : 1;
+		jmlist_debug(__func__,"using one thread per online cpu (%u threads)",nthreads);
+	}
+	if( nthreads > JMLIST_POOL_MAX_THREADS )
+		nthreads = JMLIST_POOL_MAX_THREADS;
+
+	/* callbacks can parse lists, but in their own thread */
+	if( jmlist_parse_worker )
+		nthreads = 1;
+
+	if( (jml->flags & JMLIST_ASSOCIATIVE) && jml->ass_list.shards )
+	{
+		entry_count = ijmlist_shard_usage(jml);
+		chunk_count = jml->ass_list.shard_count;
+	} else
+	{
+		if( jmlist_entry_count(jml,&entry_count) != JMLIST_ERROR_SUCCESS ) {
+			jmlist_debug(__func__,"unable to get entry count from list");
+			jmlist_debug(__func__,"returning with failure.");
+			return JMLIST_ERROR_FAILURE;
+		}
+
+		if( !entry_count ) {
+			jmlist_debug(__func__,"list is empty, there's nothing to parse");
+			jmlist_debug(__func__,"returning with success.");
+			return JMLIST_ERROR_SUCCESS;
+		}
+
+		chunk_count = entry_count / JMLIST_PARSE_MIN_CHUNK;
+		if( chunk_count > nthreads*JMLIST_PARSE_THREAD_CHUNKS )
+			chunk_count = nthreads*JMLIST_PARSE_THREAD_CHUNKS;
+		if( !chunk_count )
+			chunk_count = 1;
+	}
+	if( nthreads > chunk_count )
+		nthreads = chunk_count;
+
+	/* the accumulators of a pipeline reduce follow the chunks, starting at a
+	   cache line and a cache line apart so threads don't write to the same line */
+	if( job->acc_stride > (SIZE_MAX - 64)/chunk_count - sizeof(parse_chunk) ) {
+		jmlist_debug(__func__,"%u accumulators of %u bytes don't fit in memory",chunk_count,(unsigned int)job->acc_stride);
+		jmlist_errno = JMLIST_ERROR_MALLOC;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+	job->chunks = (parse_chunk*)malloc(chunk_count*(sizeof(parse_chunk) + job->acc_stride) + (job->acc_stride ? 64 : 0));
+	if( !job->chunks ) {
+		jmlist_debug(__func__,"failed to allocate %u chunks",chunk_count);
+		jmlist_errno = JMLIST_ERROR_MALLOC;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+	if( job->acc_stride )
+	{
+		job->accs = (char*)(((uintptr_t)(job->chunks + chunk_count) + 63) & ~(uintptr_t)63);
+		for( i = 0 ; i < chunk_count ; i++ )
+			memcpy(job->accs + i*job->acc_stride,job->pipe->acc,job->pipe->acc_size);
+	}
+	ijmlist_parse_split(jml,job->chunks,chunk_count,entry_count);
+	job->jml = jml;
+	job->chunk_count = chunk_count;
+	job->found = chunk_count;
+
+	if( nthreads <= 1 )
+	{
+		jmlist_debug(__func__,"parsing %u entries in the calling thread",entry_count);
+		for( i = 0 ; (i < chunk_count) && (job->found == chunk_count) ; i++ )
+			ijmlist_parse_chunk(job,i);
+		ijmlist_parse_done(job);
+
+		jmlist_debug(__func__,"returning with success.");
+		return JMLIST_ERROR_SUCCESS;
+	}
+
+	pthread_mutex_lock(&jmlist_pool.lock);
+
+	/* a thread that can't be created just leaves its chunks to the others */
+	nthreads = ijmlist_pool_grow(nthreads-1) + 1;
+	jmlist_debug(__func__,"parsing %u entries in %u chunks with %u threads",entry_count,chunk_count,nthreads);
+
+	job->workers = nthreads;
+	job->active = nthreads-1;
+	for( i = 0 ; i < nthreads ; i++ )
+	{
+		job->queue[i].next = (jmlist_index)((uint64_t)i*chunk_count/nthreads);
+		job->queue[i].end = (jmlist_index)((uint64_t)(i+1)*chunk_count/nthreads);
+	}
+
+	pthread_mutex_lock(&jmlist_pool.work_lock);
+	jmlist_pool.job = job;
+	jmlist_pool.workers = nthreads;
+	jmlist_pool.round++;
+	pthread_cond_broadcast(&jmlist_pool.work_cond);
+	pthread_mutex_unlock(&jmlist_pool.work_lock);
+
+	jmlist_parse_worker = true;
+	ijmlist_parse_run(job,0);
+	jmlist_parse_worker = false;
+
+	pthread_mutex_lock(&jmlist_pool.work_lock);
+	while( job->active )
+		pthread_cond_wait(&jmlist_pool.done_cond,&jmlist_pool.work_lock);
+	jmlist_pool.job = 0;
+	jmlist_pool.workers = 0;
+	pthread_mutex_unlock(&jmlist_pool.work_lock);
+
+	pthread_mutex_unlock(&jmlist_pool.lock);
+	ijmlist_parse_done(job);
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+ * keeps the match of a find job (the one of the first chunk with a match),
+ * combines the accumulators of a pipeline job in chunk order and frees the
+ * chunks.
+ */
+void
+ijmlist_parse_done(parse_job *job)
+{
+	jmlist_index i;
+
+	if( job->find && (job->found < job->chunk_count) )
+		job->match = job->chunks[job->found].match;
+	if( job->accs )
+	{
+		for( i = 0 ; i < job->chunk_count ; i++ )
+			job->pipe->combine(job->pipe->acc,job->accs + i*job->acc_stride,job->pipe->param);
+		job->accs = 0;
+	}
+	free(job->chunks);
+	job->chunks = 0;
+}
+
+/*
+ * splits the entries of the list in chunk_count chunks of about the same
+ * number of entries (of the same number of slots in indexed lists).
+ */
+void
+ijmlist_parse_split(jmlist jml,parse_chunk *chunks,jmlist_index chunk_count,jmlist_index entry_count)
+{
+	jmlist_index slots, begin, end, c, i;
+	linked_entry *plnk;
+	assoc_entry *pass;
+	bpt_node *leaf;
+	jmlist_index slot, left, step;
+
+	if( (jml->flags & JMLIST_ASSOCIATIVE) && jml->ass_list.shards )
+	{
+		for( c = 0 ; c < chunk_count ; c++ )
+		{
+			chunks[c].start = &jml->ass_list.shards[c];
+			chunks[c].slot = 0;
+			chunks[c].count = 0;
+		}
+		return;
+	}
+
+	if( (jml->flags & JMLIST_INDEXED) || ((jml->flags & JMLIST_ASSOCIATIVE) && jml->ass_list.sorted) )
+	{
+		if( jml->flags & JMLIST_INDEXED )
+			slots = (jml->flags & JMLIST_IDX_USE_SHIFT) ? jml->idx_list.usage : jml->idx_list.capacity;
+		else
+			slots = jml->ass_list.sorted->count;
+
+		for( c = 0 ; c < chunk_count ; c++ )
+		{
+			begin = (jmlist_index)((uint64_t)c*slots/chunk_count);
+			end = (jmlist_index)((uint64_t)(c+1)*slots/chunk_count);
+			chunks[c].start = 0;
+			chunks[c].slot = begin;
+			chunks[c].count = end - begin;
+		}
+		return;
+	}
+
+	plnk = (jml->flags & JMLIST_LINKED) ? jml->lnk_list.phead : 0;
+	pass = (jml->flags & JMLIST_ASSOCIATIVE) ? jml->ass_list.phead : 0;
+	leaf = (jml->flags & JMLIST_ASS_ORDERED) ? ijmlist_bpt_first_leaf(jml) : 0;
+	slot = 0;
+
+	for( c = 0 ; c < chunk_count ; c++ )
+	{
+		begin = (jmlist_index)((uint64_t)c*entry_count/chunk_count);
+		end = (jmlist_index)((uint64_t)(c+1)*entry_count/chunk_count);
+		chunks[c].slot = 0;
+		chunks[c].count = end - begin;
+
+		if( jml->flags & JMLIST_LINKED )
+		{
+			chunks[c].start = plnk;
+			for( i = begin ; i < end ; i++ )
+				plnk = plnk->next;
+		} else if( jml->flags & JMLIST_ASS_ORDERED )
+		{
+			while( leaf && (slot >= leaf->count) )
+			{
+				leaf = leaf->next;
+				slot = 0;
+			}
+			chunks[c].start = leaf;
+			chunks[c].slot = slot;
+			for( left = end - begin ; left ; left -= step )
+			{
+				if( slot >= leaf->count )
+				{
+					leaf = leaf->next;
+					slot = 0;
+				}
+				step = leaf->count - slot;
+				if( step > left )
+					step = left;
+				slot += step;
+			}
+		} else
+		{
+			chunks[c].start = pass;
+			for( i = begin ; i < end ; i++ )
+				pass = pass->next;
+		}
+	}
+}
+
+/*
+ * passes an entry of chunk to the callback of the job, returns false when the
+ * rest of the chunk doesn't need to be passed (a find job is done with it).
+ */
+bool
+ijmlist_parse_entry(parse_job *job,jmlist_index chunk,void *ptr)
+{
+	jmlist_lookup_result result = jmlist_entry_not_found;
+	jmlist_index found;
+
+	if( job->pipe )
+	{
+		ijmlist_pipeline_entry(job->pipe,job->accs ? job->accs + chunk*job->acc_stride : job->pipe->acc,ptr);
+		return true;
+	}
+
+	if( !job->find )
+	{
+		job->callback(ptr,job->param);
+		return true;
+	}
+
+	/* any match ends a JMLIST_FIND_ANY job, a match in an earlier chunk ends
+	   this chunk in a JMLIST_FIND_FIRST job */
+	found = JMLIST_LOAD(&job->found);
+	if( found < ((job->mode == JMLIST_FIND_ANY) ? job->chunk_count : chunk) )
+		return false;
+
+	job->find(ptr,job->param,&result);
+	if( result != jmlist_entry_found )
+		return true;
+
+	/* the first match of the chunk, found keeps the lowest chunk with one */
+	job->chunks[chunk].match = ptr;
+	while( (chunk < found) && !JMLIST_CAS(&job->found,&found,chunk) );
+	return false;
+}
+
+/*
+ * passes the entries of a chunk to the job.
+ */
+void
+ijmlist_parse_chunk(parse_job *job,jmlist_index chunk_index)
+{
+	parse_chunk *chunk = &job->chunks[chunk_index];
+	jmlist jml = job->jml;
+	jmlist_index i;
+
+	if( (jml->flags & JMLIST_ASSOCIATIVE) && jml->ass_list.shards )
+	{
+		assoc_shard *shard = (assoc_shard*)chunk->start;
+		assoc_entry *pseeker;
+
+		pthread_mutex_lock(&shard->lock);
+		for( pseeker = shard->list.ass_list.phead ; pseeker ; pseeker = pseeker->next )
+			if( !ijmlist_parse_entry(job,chunk_index,pseeker->ptr) )
+				break;
+		pthread_mutex_unlock(&shard->lock);
+	} else if( jml->flags & JMLIST_INDEXED )
+	{
+		void **plist = jml->idx_list.plist;
+
+		for( i = chunk->slot ; i < chunk->slot + chunk->count ; i++ )
+		{
+			if( (plist[i] != JMLIST_EMPTY_PTR) && !ijmlist_parse_entry(job,chunk_index,plist[i]) )
+				break;
+		}
+	} else if( jml->flags & JMLIST_LINKED )
+	{
+		linked_entry *pentry = (linked_entry*)chunk->start;
+
+		for( i = 0 ; i < chunk->count ; i++, pentry = pentry->next )
+			if( !ijmlist_parse_entry(job,chunk_index,pentry->ptr) )
+				break;
+	} else if( !(jml->flags & JMLIST_ASS_ORDERED) )
+	{
+		assoc_entry *pentry = (assoc_entry*)chunk->start;
+
+		for( i = 0 ; i < chunk->count ; i++, pentry = pentry->next )
+			if( !ijmlist_parse_entry(job,chunk_index,pentry->ptr) )
+				break;
+	} else if( jml->ass_list.sorted )
+	{
+		assoc_sorted *sorted = jml->ass_list.sorted;
+
+		for( i = chunk->slot ; i < chunk->slot + chunk->count ; i++ )
+			if( !ijmlist_parse_entry(job,chunk_index,sorted->ptr[sorted->node[i]]) )
+				break;
+	} else
+	{
+		bpt_node *leaf = (bpt_node*)chunk->start;
+		jmlist_index slot = chunk->slot;
+
+		for( i = 0 ; i < chunk->count ; i++ )
+		{
+			if( slot >= leaf->count )
+			{
+				leaf = leaf->next;
+				slot = 0;
+			}
+			if( !ijmlist_parse_entry(job,chunk_index,leaf->u.ptr[slot++]) )
+				break;
+		}
+	}
+}
+
+/*
+ * worker of a parallel parse, takes the chunks of its own queue and then the
+ * ones left in the queues of the other workers.
+ */
+void
+ijmlist_parse_run(parse_job *job,unsigned int worker)
+{
+	parse_queue *queue;
+	jmlist_index chunk;
+	unsigned int i;
+
+	for( i = 0 ; i < job->workers ; i++ )
+	{
+		queue = &job->queue[(worker + i) % job->workers];
+		while( (chunk = JMLIST_FETCH_INC(&queue->next)) < queue->end )
+			ijmlist_parse_chunk(job,chunk);
+	}
+}
+
+/*
+ * thread of the parse pool, runs its part of each new job until the pool is
+ * stopped.
+ */
+void *
+ijmlist_pool_thread(void *arg)
+{
+	unsigned int worker = (unsigned int)(uintptr_t)arg;
+	parse_job *job;
+	uint32_t seen;
+
+	jmlist_parse_worker = true;
+
+	pthread_mutex_lock(&jmlist_pool.work_lock);
+	/* threads are created before the round of their first job is started, if
+	   this one started later it sees that round as new anyway */
+	seen = jmlist_pool.round - 1;
+	for(;;)
+	{
+		while( !jmlist_pool.stop && (jmlist_pool.round == seen) )
+			pthread_cond_wait(&jmlist_pool.work_cond,&jmlist_pool.work_lock);
+		if( jmlist_pool.stop )
+			break;
+
+		seen = jmlist_pool.round;
+		job = jmlist_pool.job;
+		if( !job || (worker >= jmlist_pool.workers) )
+			continue;
+
+		pthread_mutex_unlock(&jmlist_pool.work_lock);
+		ijmlist_parse_run(job,worker);
+		pthread_mutex_lock(&jmlist_pool.work_lock);
+
+		if( --job->active == 0 )
+			pthread_cond_signal(&jmlist_pool.done_cond);
+	}
+	pthread_mutex_unlock(&jmlist_pool.work_lock);
+
+	return 0;
+}
+
+/*
+ * starts pool threads until there are count of them, returns how many there
+ * are (up to count). called with the pool lock held.
+ */
+unsigned int
+ijmlist_pool_grow(unsigned int count)
+{
+	while( jmlist_pool.thread_count < count )
+	{
+		if( pthread_create(&jmlist_pool.threads[jmlist_pool.thread_count],0,ijmlist_pool_thread,
+				(void*)(uintptr_t)(jmlist_pool.thread_count+1)) )
+		{
+			jmlist_debug(__func__,"unable to start pool thread %u",jmlist_pool.thread_count+1);
+			break;
+		}
+		jmlist_pool.thread_count++;
+	}
+
+	return (jmlist_pool.thread_count < count) ? jmlist_pool.thread_count : count;
+}
+
+/*
+ * stops and joins the threads of the parse pool.
+ */
+void
+ijmlist_pool_stop(void)
+{
+	unsigned int i;
+
+	pthread_mutex_lock(&jmlist_pool.lock);
+
+	pthread_mutex_lock(&jmlist_pool.work_lock);
+	jmlist_pool.stop = true;
+	pthread_cond_broadcast(&jmlist_pool.work_cond);
+	pthread_mutex_unlock(&jmlist_pool.work_lock);
+
+	for( i = 0 ; i < jmlist_pool.thread_count ; i++ )
+		pthread_join(jmlist_pool.threads[i],0);
+	jmlist_debug(__func__,"stopped %u pool threads",jmlist_pool.thread_count);
+
+	jmlist_pool.thread_count = 0;
+	jmlist_pool.stop = false;
+
+	pthread_mutex_unlock(&jmlist_pool.lock);
+}
+
+/*
+   jmlist_snapshot
+
+   Takes a snapshot of the list: the entries it had when the snapshot was taken
+   are returned by jmlist_snapshot_seek_next and jmlist_snapshot_parse in the
+   order jmlist_seek_next returns them, whatever is done to the list after that.
+   Nothing is copied when the snapshot is taken. Indexed lists copy a page of
+   JMLIST_SNAPSHOT_PAGE slots for the open snapshots before the first change to
+   it, linked and unordered associative lists record the old next and ptr of a
+   node before the first change to it and keep removed nodes until the last
+   snapshot is freed. Writers only pay for that while a snapshot is open and
+   only for the pages or nodes they change.
+
+   The snapshot can be read from other threads while the list is changed, each
+   step of the reader takes the snapshot lock of the list for a moment, and so
+   do the writers when they change something a snapshot still sees. Taking and
+   freeing snapshots are writes, they must be done by the thread changing the
+   list (or while nothing changes it). If a copy can't be allocated the
+   snapshot goes stale and reading it fails with JMLIST_ERROR_STALE_SEEK, the
+   write itself goes on. The snapshot lock is shared by the list and its
+   snapshots and freed by the last of them, so jmlist_free can be called while
+   other threads read a snapshot: it goes stale and reading it fails the same
+   way from then on. Ordered associative lists and concurrent lists are not
+   supported.
+*/
+jmlist_status
+jmlist_snapshot(jmlist jml,jmlist_snap *snap_ptr)
+{
+	jmlist_snap snap;
+
+	jmlist_debug(__func__,"called with jml=%p and snap_ptr=%p",jml,snap_ptr);
+
+	if( !jml || !snap_ptr ) {
+		jmlist_debug(__func__,"invalid arguments specified (jml=%p, snap_ptr=%p)",jml,snap_ptr);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( (jml->flags & JMLIST_ASSOCIATIVE) && ((jml->flags & JMLIST_ASS_ORDERED) || jml->ass_list.shards) ) {
+		jmlist_debug(__func__,"snapshots of ordered and concurrent associative lists are not supported (flags=%u)",jml->flags);
+		jmlist_errno = JMLIST_ERROR_UNSUPPORTED;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	snap = (jmlist_snap)calloc(1,sizeof(struct _jmlist_snapshot));
+	if( !snap ) {
+		jmlist_debug(__func__,"malloc failed (size %u)!",(unsigned int)sizeof(struct _jmlist_snapshot));
+		jmlist_errno = JMLIST_ERROR_MALLOC;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+	snap->jml = jml;
+	snap->flags = jml->flags;
+
+	if( jml->flags & JMLIST_INDEXED )
+	{
+		snap->count = jml->idx_list.usage;
+		snap->slots = (jml->flags & JMLIST_IDX_USE_SHIFT) ? jml->idx_list.usage : jml->idx_list.capacity;
+		snap->page_count = (snap->slots + JMLIST_SNAPSHOT_PAGE - 1) / JMLIST_SNAPSHOT_PAGE;
+		if( snap->page_count )
+		{
+			snap->pages = (void***)calloc(snap->page_count,sizeof(void**));
+			if( !snap->pages ) {
+				jmlist_debug(__func__,"malloc failed (%u pages)!",snap->page_count);
+				free(snap);
+				jmlist_errno = JMLIST_ERROR_MALLOC;
+				jmlist_debug(__func__,"returning with failure.");
+				return JMLIST_ERROR_FAILURE;
+			}
+		}
+	} else if( jml->flags & JMLIST_LINKED )
+	{
+		snap->count = jml->lnk_list.usage;
+		snap->head = jml->lnk_list.phead;
+	} else
+	{
+		snap->count = jml->ass_list.usage;
+		snap->head = jml->ass_list.phead;
+	}
+
+	if( !jml->snap.lock )
+	{
+		jml->snap.lock = (snapshot_lock*)malloc(sizeof(snapshot_lock));
+		if( !jml->snap.lock ) {
+			jmlist_debug(__func__,"malloc failed (size %u)!",(unsigned int)sizeof(snapshot_lock));
+			free(snap->pages);
+			free(snap);
+			jmlist_errno = JMLIST_ERROR_MALLOC;
+			jmlist_debug(__func__,"returning with failure.");
+			return JMLIST_ERROR_FAILURE;
+		}
+		pthread_mutex_init(&jml->snap.lock->mutex,0);
+		jml->snap.lock->refs = 1;
+	}
+	snap->lock = jml->snap.lock;
+
+	pthread_mutex_lock(&snap->lock->mutex);
+	snap->lock->refs++;
+	snap->next = jml->snap.list;
+	jml->snap.list = snap;
+	pthread_mutex_unlock(&snap->lock->mutex);
+
+	jmlist_debug(__func__,"snapshot snap=%p of jml=%p has %u entries",snap,jml,snap->count);
+	*snap_ptr = snap;
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+   jmlist_snapshot_seek_start
+
+   starts a seek of the entries of a snapshot, the handle is then passed to
+   jmlist_snapshot_seek_next. the same snapshot can have several seeks going on
+   at once, from any threads.
+*/
+jmlist_status
+jmlist_snapshot_seek_start(jmlist_snap snap,jmlist_seek_handle *handle_ptr)
+{
+	jmlist_debug(__func__,"called with snap=%p and handle_ptr=%p",snap,handle_ptr);
+
+	if( !snap || !handle_ptr ) {
+		jmlist_debug(__func__,"invalid arguments specified (snap=%p, handle_ptr=%p)",snap,handle_ptr);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	ijmlist_seek_release(handle_ptr);
+	memset(handle_ptr,0,sizeof(jmlist_seek_handle));
+	if( snap->flags & JMLIST_LINKED )
+		handle_ptr->pos.next_lnk = (linked_entry*)snap->head;
+	else if( !(snap->flags & JMLIST_INDEXED) )
+		handle_ptr->pos.next_ass = (assoc_entry*)snap->head;
+	handle_ptr->started = true;
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+   jmlist_snapshot_seek_next
+
+   returns the next entry of the snapshot in ptr. fails with
+   JMLIST_ERROR_ENTRY_NOT_FOUND after the last entry and with
+   JMLIST_ERROR_STALE_SEEK if the snapshot went stale (see jmlist_snapshot).
+*/
+jmlist_status
+jmlist_snapshot_seek_next(jmlist_snap snap,jmlist_seek_handle *handle_ptr,void **ptr)
+{
+	jmlist_index count;
+
+	jmlist_debug(__func__,"called with snap=%p, handle_ptr=%p and ptr=%p",snap,handle_ptr,ptr);
+
+	if( !snap || !handle_ptr || !ptr || !handle_ptr->started ) {
+		jmlist_debug(__func__,"invalid arguments specified (snap=%p, handle_ptr=%p, ptr=%p)",snap,handle_ptr,ptr);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	/* stale is set when the list is freed, under the same lock */
+	pthread_mutex_lock(&snap->lock->mutex);
+	if( snap->stale ) {
+		pthread_mutex_unlock(&snap->lock->mutex);
+		jmlist_debug(__func__,"snap=%p is stale",snap);
+		jmlist_errno = JMLIST_ERROR_STALE_SEEK;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+	count = ijmlist_snap_next_batch(snap,handle_ptr,ptr,1);
+	pthread_mutex_unlock(&snap->lock->mutex);
+
+	if( !count ) {
+		jmlist_debug(__func__,"no more entries in snap=%p",snap);
+		jmlist_errno = JMLIST_ERROR_ENTRY_NOT_FOUND;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+   jmlist_snapshot_parse
+
+   calls callback for each entry of the snapshot, same as jmlist_parse. the
+   entries are taken a few at a time and the snapshot lock of the list is not
+   held while the callback runs, so the callback can change the list itself.
+*/
+jmlist_status
+jmlist_snapshot_parse(jmlist_snap snap,JMLISTPARSERCALLBACK callback,void *param)
+{
+	jmlist_seek_handle handle;
+	void *batch[JMLIST_PARSE_MIN_CHUNK];
+	jmlist_index count;
+	jmlist_index i;
+
+	jmlist_debug(__func__,"called with snap=%p, callback=%p and param=%p",snap,callback,param);
+
+	if( !callback ) {
+		jmlist_debug(__func__,"invalid callback specified (callback=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( jmlist_snapshot_seek_start(snap,&handle) == JMLIST_ERROR_FAILURE )
+		return JMLIST_ERROR_FAILURE;
+
+	do
+	{
+		pthread_mutex_lock(&snap->lock->mutex);
+		if( snap->stale ) {
+			pthread_mutex_unlock(&snap->lock->mutex);
+			jmlist_debug(__func__,"snap=%p is stale",snap);
+			jmlist_errno = JMLIST_ERROR_STALE_SEEK;
+			jmlist_debug(__func__,"returning with failure.");
+			return JMLIST_ERROR_FAILURE;
+		}
+		count = ijmlist_snap_next_batch(snap,&handle,batch,JMLIST_PARSE_MIN_CHUNK);
+		pthread_mutex_unlock(&snap->lock->mutex);
+
+		for( i = 0 ; i < count ; i++ )
+			callback(batch[i],param);
+	} while( count == JMLIST_PARSE_MIN_CHUNK );
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+   jmlist_snapshot_free
+
+   frees a snapshot, when it's the last one of the list the nodes removed while
+   it was open are freed too. must be called by the thread changing the list,
+   and no seek of the snapshot can be going on.
+*/
+jmlist_status
+jmlist_snapshot_free(jmlist_snap snap)
+{
+	jmlist_snap *pseeker;
+	jmlist jml;
+	jmlist_index i;
+
+	jmlist_debug(__func__,"called with snap=%p",snap);
+
+	if( !snap ) {
+		jmlist_debug(__func__,"invalid snap specified (snap=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	/* jml is 0 when the list was freed first */
+	pthread_mutex_lock(&snap->lock->mutex);
+	jml = snap->jml;
+	if( jml )
+	{
+		for( pseeker = &jml->snap.list ; *pseeker != snap ; pseeker = &(*pseeker)->next );
+		*pseeker = snap->next;
+
+		if( !jml->snap.list )
+		{
+			jmlist_debug(__func__,"last snapshot of jml=%p, freeing %u retired nodes",jml,jml->snap.retired_count);
+			for( i = 0 ; i < jml->snap.retired_count ; i++ )
+				free(jml->snap.retired[i]);
+			jml->snap.retired_count = 0;
+		}
+	}
+	pthread_mutex_unlock(&snap->lock->mutex);
+	ijmlist_snap_lock_release(snap->lock);
+
+	for( i = 0 ; i < snap->page_count ; i++ )
+		free(snap->pages[i]);
+	free(snap->pages);
+	free(snap->nodes);
+	free(snap);
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+ * copies the pages of the open snapshots that hold slots first to last-1
+ * before they are written, the whole buffer before it's reallocated or freed.
+ */
+void
+ijmlist_snap_idx_write(jmlist jml,jmlist_index first,jmlist_index last)
+{
+	jmlist_snap snap;
+	jmlist_index page;
+	jmlist_index slot;
+	jmlist_index end;
+	jmlist_index n;
+
+	if( !jml->snap.list )
+		return;
+
+	pthread_mutex_lock(&jml->snap.lock->mutex);
+	for( snap = jml->snap.list ; snap ; snap = snap->next )
+	{
+		end = (last < snap->slots) ? last : snap->slots;
+		for( page = first / JMLIST_SNAPSHOT_PAGE ; !snap->stale && (page*JMLIST_SNAPSHOT_PAGE < end) ; page++ )
+		{
+			if( snap->pages[page] )
+				continue;
+
+			slot = page*JMLIST_SNAPSHOT_PAGE;
+			n = (snap->slots - slot < JMLIST_SNAPSHOT_PAGE) ? snap->slots - slot : JMLIST_SNAPSHOT_PAGE;
+			snap->pages[page] = (void**)malloc(n*sizeof(void*));
+			if( !snap->pages[page] )
+			{
+				jmlist_debug(__func__,"malloc failed (%u slots), snap=%p is stale now",n,snap);
+				snap->stale = true;
+				break;
+			}
+			memcpy(snap->pages[page],jml->idx_list.plist+slot,n*sizeof(void*));
+			jmlist_debug(__func__,"copied page %u of snap=%p (%u slots)",page,snap,n);
+		}
+	}
+	pthread_mutex_unlock(&jml->snap.lock->mutex);
+}
+
+/*
+ * slot of node in the table of recorded nodes of a snapshot, or the empty slot
+ * where it goes. the table has a power of two size and is never full.
+ */
+snapshot_node *
+ijmlist_snap_node_slot(jmlist_snap snap,void *node)
+{
+	jmlist_index mask = snap->node_capacity - 1;
+	jmlist_index i = (jmlist_index)(((uintptr_t)node >> 4) * 0x9e3779b1u) & mask;
+
+	while( snap->nodes[i].node && (snap->nodes[i].node != node) )
+		i = (i + 1) & mask;
+	return &snap->nodes[i];
+}
+
+/*
+ * doubles the table of recorded nodes of a snapshot (the first one has
+ * JMLIST_SNAPSHOT_DEF_NODES slots).
+ */
+jmlist_status
+ijmlist_snap_node_grow(jmlist_snap snap)
+{
+	snapshot_node *old = snap->nodes;
+	jmlist_index old_capacity = snap->node_capacity;
+	jmlist_index capacity = old_capacity ? old_capacity*2 : JMLIST_SNAPSHOT_DEF_NODES;
+	jmlist_index i;
+
+	snap->nodes = (snapshot_node*)calloc(capacity,sizeof(snapshot_node));
+	if( !snap->nodes )
+	{
+		jmlist_debug(__func__,"malloc failed (%u nodes)!",capacity);
+		snap->nodes = old;
+		jmlist_errno = JMLIST_ERROR_MALLOC;
+		return JMLIST_ERROR_FAILURE;
+	}
+	snap->node_capacity = capacity;
+
+	for( i = 0 ; i < old_capacity ; i++ )
+		if( old[i].node )
+			*ijmlist_snap_node_slot(snap,old[i].node) = old[i];
+	free(old);
+
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+ * records next and ptr of a node of a linked or unordered associative list
+ * before one of them is changed, in the open snapshots that don't have it yet.
+ */
+void
+ijmlist_snap_node_write(jmlist jml,void *node)
+{
+	jmlist_snap snap;
+	snapshot_node *slot;
+
+	if( !jml->snap.list )
+		return;
+
+	pthread_mutex_lock(&jml->snap.lock->mutex);
+	for( snap = jml->snap.list ; snap ; snap = snap->next )
+	{
+		if( snap->stale )
+			continue;
+
+		if( snap->node_capacity && ijmlist_snap_node_slot(snap,node)->node )
+			continue;
+
+		if( ((snap->node_count+1)*4 > snap->node_capacity*3) &&
+				(ijmlist_snap_node_grow(snap) == JMLIST_ERROR_FAILURE) )
+		{
+			jmlist_debug(__func__,"couldn't record node=%p, snap=%p is stale now",node,snap);
+			snap->stale = true;
+			continue;
+		}
+
+		slot = ijmlist_snap_node_slot(snap,node);
+		slot->node = node;
+		if( jml->flags & JMLIST_LINKED )
+		{
+			slot->next = ((linked_entry*)node)->next;
+			slot->ptr = ((linked_entry*)node)->ptr;
+		} else
+		{
+			slot->next = ((assoc_entry*)node)->next;
+			slot->ptr = ((assoc_entry*)node)->ptr;
+		}
+		snap->node_count++;
+	}
+	pthread_mutex_unlock(&jml->snap.lock->mutex);
+}
+
+/*
+ * frees a node removed from a linked or unordered associative list, while
+ * snapshots are open it's kept for them until the last one is freed.
+ */
+void
+ijmlist_snap_free(jmlist jml,void *node)
+{
+	jmlist_snap snap;
+	void **retired;
+	jmlist_index capacity;
+
+	if( !jml->snap.list )
+	{
+		free(node);
+		return;
+	}
+
+	if( jml->snap.retired_count == jml->snap.retired_capacity )
+	{
+		capacity = jml->snap.retired_capacity ? jml->snap.retired_capacity*2 : JMLIST_SNAPSHOT_DEF_NODES;
+		retired = (void**)realloc(jml->snap.retired,capacity*sizeof(void*));
+		if( !retired )
+		{
+			/* the node can't be kept, no snapshot can go through it anymore */
+			jmlist_debug(__func__,"malloc failed (%u nodes), snapshots of jml=%p are stale now",capacity,jml);
+			pthread_mutex_lock(&jml->snap.lock->mutex);
+			for( snap = jml->snap.list ; snap ; snap = snap->next )
+				snap->stale = true;
+			pthread_mutex_unlock(&jml->snap.lock->mutex);
+			free(node);
+			return;
+		}
+		jml->snap.retired = retired;
+		jml->snap.retired_capacity = capacity;
+	}
+
+	jml->snap.retired[jml->snap.retired_count++] = node;
+}
+
+/*
+ * copies up to cap entries of a snapshot from the handle position to out,
+ * returns how many were copied. called with the snapshot lock held.
+ */
+jmlist_index
+ijmlist_snap_next_batch(jmlist_snap snap,jmlist_seek_handle *handle_ptr,void **out,jmlist_index cap)
+{
+	jmlist_index count = 0;
+	jmlist_index slot;
+	void **page;
+	void *node;
+	void *next;
+	void *ptr;
+	snapshot_node *rec;
+
+	if( snap->flags & JMLIST_INDEXED )
+	{
+		for( slot = handle_ptr->pos.next_idx ; (slot < snap->slots) && (count < cap) ; slot++ )
+		{
+			page = snap->pages[slot / JMLIST_SNAPSHOT_PAGE];
+			ptr = page ? page[slot % JMLIST_SNAPSHOT_PAGE] : snap->jml->idx_list.plist[slot];
+			if( ptr != JMLIST_EMPTY_PTR )
+				out[count++] = ptr;
+		}
+		handle_ptr->pos.next_idx = slot;
+		return count;
+	}
+
+	node = (snap->flags & JMLIST_LINKED) ? (void*)handle_ptr->pos.next_lnk : (void*)handle_ptr->pos.next_ass;
+	while( node && (count < cap) )
+	{
+		rec = snap->node_capacity ? ijmlist_snap_node_slot(snap,node) : 0;
+		if( rec && rec->node )
+		{
+			next = rec->next;
+			ptr = rec->ptr;
+		} else if( snap->flags & JMLIST_LINKED )
+		{
+			next = ((linked_entry*)node)->next;
+			ptr = ((linked_entry*)node)->ptr;
+		} else
+		{
+			next = ((assoc_entry*)node)->next;
+			ptr = ((assoc_entry*)node)->ptr;
+		}
+		out[count++] = ptr;
+		node = next;
+	}
+
+	if( snap->flags & JMLIST_LINKED )
+		handle_ptr->pos.next_lnk = (linked_entry*)node;
+	else
+		handle_ptr->pos.next_ass = (assoc_entry*)node;
+	return count;
+}
+
+/*
+ * called by jmlist_free, the open snapshots of the list go stale and the nodes
+ * kept for them are freed.
+ */
+void
+ijmlist_snap_close(jmlist jml)
+{
+	jmlist_snap snap;
+	jmlist_index i;
+
+	pthread_mutex_lock(&jml->snap.lock->mutex);
+	for( snap = jml->snap.list ; snap ; snap = snap->next )
+	{
+		jmlist_debug(__func__,"snap=%p of jml=%p is still open, it's stale now",snap,jml);
+		snap->stale = true;
+		snap->jml = 0;
+	}
+	jml->snap.list = 0;
+	pthread_mutex_unlock(&jml->snap.lock->mutex);
+
+	for( i = 0 ; i < jml->snap.retired_count ; i++ )
+		free(jml->snap.retired[i]);
+	free(jml->snap.retired);
+	jml->snap.retired = 0;
+	jml->snap.retired_count = 0;
+	jml->snap.retired_capacity = 0;
+
+	ijmlist_snap_lock_release(jml->snap.lock);
+	jml->snap.lock = 0;
+}
+
+/*
+ * lets go of the snapshot lock for the list or one of its snapshots, the last
+ * one frees it.
+ */
+void
+ijmlist_snap_lock_release(snapshot_lock *lock)
+{
+	jmlist_index refs;
+
+	pthread_mutex_lock(&lock->mutex);
+	refs = --lock->refs;
+	pthread_mutex_unlock(&lock->mutex);
+
+	if( !refs )
+	{
+		jmlist_debug(__func__,"freeing snapshot lock=%p",lock);
+		pthread_mutex_destroy(&lock->mutex);
+		free(lock);
+	}
+}
+
+/*
+ * jmlist_internal_count
+ *
+ * This function is used to get the number of entries in the internal list.
+ * The internal list contains the list of created jmlist objects. So one can
+ * use it to verify if all the created lists were correctly freed.
+ */
+jmlist_status jmlist_internal_count(jmlist_index *entry_count)
+{
+	if( jmlist_ilist == 0 ) {
+		jmlist_debug(__func__,"internal list is not active, cannot use this function");
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	return jmlist_entry_count(jmlist_ilist,entry_count);
+}
+
+jmlist_status jmlist_key_exists(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,jmlist_lookup_result *result)
+{
+	jmlist_debug(__func__,"called with jml=%p, key_ptr=%p, key_len=%u, result=%p",jml,key_ptr,key_len,result);
+	
+	if( !result )
+	{
+		jmlist_debug(__func__,"invalid result pointer specified (result=0)");
+		jmlist_debug(__func__,"returning with failure.");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	/* verify key_ptr */
+	if( !key_ptr )
+	{
+		jmlist_debug(__func__,"invalid key_ptr specified (key_ptr=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+	
+	/* verify key_len */
+	if( !key_len )
+	{
+		jmlist_debug(__func__,"invalid key_len specified (key_len=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	/* for now this function is only supported in associative lists */	
+	if( !(jml->flags & JMLIST_ASSOCIATIVE) )
+	{
+		jmlist_debug(__func__,"invalid or unsupported list type (jml=%p, flags=%u)",jml,jml->flags);
+		jmlist_debug(__func__,"returning with failure.");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	return ijmlist_ass_key_exists(jml,key_ptr,key_len,result);
+}
+
+/*
+   ordered associative lists
+
+   When JMLIST_ASS_ORDERED is set the associative list entries are kept in a
+   b+tree sorted by key instead of the assoc_entry chain. Entries with
+   duplicate keys are kept in insertion order, get_by_key and remove_by_key
+   work with the first of them. Index access walks the leaf pages, skipping
+   entire leaves using their count.
+*/
+
+/*
+ * first 8 bytes of the key in big endian (zero padded), comparing two of these
+ * gives the same result as the lexicographic comparison of the keys unless
+ * they're equal.
+ */
+uint64_t
+ijmlist_bpt_prefix(jmlist_key key_ptr,jmlist_key_length key_len)
+{
+	uint64_t pfx = 0;
+	jmlist_index i;
+
+	for( i = 0 ; i < 8 ; i++ )
+	{
+		pfx <<= 8;
+		if( i < key_len )
+			pfx |= ((unsigned char*)key_ptr)[i];
+	}
+
+	return pfx;
+}
+
+int
+ijmlist_bpt_compare(jmlist jml,uint64_t pfx1,jmlist_key key1_ptr,jmlist_key_length key1_len,
+		uint64_t pfx2,jmlist_key key2_ptr,jmlist_key_length key2_len)
+{
+	int r;
+
+	if( jml->ass_list.compare )
+		return jml->ass_list.compare(key1_ptr,key1_len,key2_ptr,key2_len);
+
+	/* default lexicographic comparator, prefixes decide most of the comparisons */
+	if( pfx1 != pfx2 )
+		return (pfx1 < pfx2) ? -1 : 1;
+
+	if( (key1_len > 8) && (key2_len > 8) )
+	{
+		r = memcmp((unsigned char*)key1_ptr+8,(unsigned char*)key2_ptr+8,
+				((key1_len < key2_len) ? key1_len : key2_len) - 8);
+		if( r )
+			return r;
+	}
+
+	/* one of the keys is prefix of the other */
+	if( key1_len != key2_len )
+		return (key1_len < key2_len) ? -1 : 1;
+
+	return 0;
+}
+
+/*
+ * returns the number of keys of the node that are lower than the key, or lower
+ * or equal when upper is true.
+ */
+jmlist_index
+ijmlist_bpt_node_search(jmlist jml,bpt_node *node,uint64_t pfx,jmlist_key key_ptr,jmlist_key_length key_len,bool upper)
+{
+	jmlist_index lo = 0;
+	jmlist_index hi = node->count;
+	jmlist_index mid;
+	int r;
+
+	while( lo < hi )
+	{
+		mid = (lo + hi) / 2;
+		r = ijmlist_bpt_compare(jml,node->key_pfx[mid],node->key_ptr[mid],node->key_len[mid],pfx,key_ptr,key_len);
+		if( (r < 0) || (upper && (r == 0)) )
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+bpt_node *
+ijmlist_bpt_find_leaf(jmlist jml,uint64_t pfx,jmlist_key key_ptr,jmlist_key_length key_len,bool upper)
+{
+	bpt_node *node = jml->ass_list.root;
+
+	while( node && !node->leaf )
+		node = node->u.child[ijmlist_bpt_node_search(jml,node,pfx,key_ptr,key_len,upper)];
+
+	return node;
+}
+
+bpt_node *
+ijmlist_bpt_first_leaf(jmlist jml)
+{
+	bpt_node *node = jml->ass_list.root;
+
+	while( node && !node->leaf )
+		node = node->u.child[0];
+
+	return node;
+}
+
+bpt_node *
+ijmlist_bpt_last_leaf(jmlist jml)
+{
+	bpt_node *node = jml->ass_list.root;
+
+	while( node && !node->leaf )
+		node = node->u.child[node->count];
+
+	return node;
+}
+
+/*
+ * position of the first entry with key greater or equal than key_ptr, leaf is
+ * set to 0 when there's no such entry.
+ */
+void
+ijmlist_bpt_lower_bound(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,bpt_node **leaf,jmlist_index *slot)
+{
+	uint64_t pfx = ijmlist_bpt_prefix(key_ptr,key_len);
+	bpt_node *node = ijmlist_bpt_find_leaf(jml,pfx,key_ptr,key_len,false);
+	jmlist_index i = 0;
+
+	if( node )
+	{
+		i = ijmlist_bpt_node_search(jml,node,pfx,key_ptr,key_len,false);
+		if( i == node->count )
 		{
-			jmlist_debug(__func__,"malloc failed (size %u)!",sizeof(assoc_entry));
-			jmlist_errno = JMLIST_ERROR_MALLOC;
-			jmlist_debug(__func__,"returning with failure.");
-			return JMLIST_ERROR_FAILURE;
+			node = node->next;
+			i = 0;
 		}
-		jmlist_debug(__func__,"new associative entry pentry=%p allocated",pentry);
-		
-		jmlist_mem.ass_list.total += sizeof(struct _assoc_entry);
-		jmlist_mem.ass_list.used += sizeof(struct _assoc_entry);
-		jmlist_debug(__func__,"new jml_mem.ass_list.total is %u",jmlist_mem.ass_list.total);
-		jmlist_debug(__func__,"new jml_mem.ass_list.used is %u",jmlist_mem.ass_list.used);
-		
-		/* initialize entry */
-		pentry->ptr = ptr;
-		pentry->next = jml->ass_list.phead;
-		pentry->key_ptr = key_ptr;
-		pentry->key_len = key_len;
-		jmlist_debug(__func__,"initialized new entry successfuly (ptr=%p, next=%p, key_ptr=%p, key_len=%u)",
-					 pentry->ptr,pentry->next,pentry->key_ptr,pentry->key_len);
-		
-		jmlist_debug(__func__,"inserting pentry in head of list (current head phead=%p, usage=%u)",
-					 jml->ass_list.phead,jml->ass_list.usage);
-		
-		jml->ass_list.phead = pentry;
-		jml->ass_list.usage++;
-		
-		jmlist_debug(__func__,"now head is phead=%p with phead->next=%p (usage=%u)",
-					 jml->ass_list.phead,pentry->next,jml->ass_list.usage);
-	} // (jml->flags & JMLIST_ASS_INSERT_AT_TAIL)
-	
-	jmlist_debug(__func__,"returning with success.");
-	return JMLIST_ERROR_SUCCESS;	
+	}
+
+	*leaf = node;
+	*slot = i;
 }
 
 jmlist_status
-ijmlist_ass_remove_by_ptr(jmlist jml,void *ptr)
+ijmlist_bpt_node_alloc(bool leaf,bpt_node **node)
 {
-	jmlist_debug(__func__,"called with jml=%p and ptr=%p\n",(void*)jml,(void*)ptr);
-
-	/* trying to pop from empty list? */
-	if( !jml->ass_list.usage )
+	*node = (bpt_node*)malloc(sizeof(bpt_node));
+	if( !*node )
 	{
-		jmlist_debug(__func__,"trying to remove from empty list");
-		jmlist_debug(__func__,"returning with failure.");
-		jmlist_errno = JMLIST_ERROR_EMPTY_LIST;
+		jmlist_debug(__func__,"malloc failed (size %u)!",sizeof(bpt_node));
+		jmlist_errno = JMLIST_ERROR_MALLOC;
 		return JMLIST_ERROR_FAILURE;
 	}
-	
-	jmlist_debug(__func__,"seeking ptr=%p in the associative list",ptr);
-	
-	assoc_entry *pseeker = jml->ass_list.phead;
-	assoc_entry *pprevious = pseeker;
-	while( pseeker )
+
+	memset(*node,0,sizeof(bpt_node));
+	(*node)->leaf = leaf;
+
+	jmlist_mem.ass_list.total += sizeof(bpt_node);
+	jmlist_mem.ass_list.used += sizeof(bpt_node);
+	jmlist_debug(__func__,"new jml_mem.ass_list.total is %u",jmlist_mem.ass_list.total);
+	jmlist_debug(__func__,"new jml_mem.ass_list.used is %u",jmlist_mem.ass_list.used);
+
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+ * frees a single node, separator keys of internal nodes are owned by the node.
+ */
+void
+ijmlist_bpt_node_free(bpt_node *node)
+{
+	jmlist_index i;
+
+	if( !node->leaf )
 	{
-		if( pseeker->ptr != ptr )
+		for( i = 0 ; i < node->count ; i++ )
 		{
-			pprevious = pseeker;
-			pseeker = pseeker->next;
-			continue;
+			jmlist_mem.ass_list.total -= node->key_len[i];
+			jmlist_mem.ass_list.used -= node->key_len[i];
+			free(node->key_ptr[i]);
 		}
-		
-		jmlist_debug(__func__,"found entry, pseeker=%p pseeker->next=%p",pseeker,pseeker->next);
-		
-		if( pprevious == pseeker )
+	}
+
+	free(node);
+
+	jmlist_mem.ass_list.total -= sizeof(bpt_node);
+	jmlist_mem.ass_list.used -= sizeof(bpt_node);
+}
+
+/*
+ * number of entries under a node, from the sizes of its children.
+ */
+jmlist_index
+ijmlist_bpt_node_size(bpt_node *node)
+{
+	jmlist_index size = 0;
+	jmlist_index i;
+
+	if( node->leaf )
+		return node->count;
+
+	for( i = 0 ; i <= node->count ; i++ )
+		size += node->u.child[i]->size;
+
+	return size;
+}
+
+/*
+ * adds delta to the size of a node and of all its ancestors.
+ */
+void
+ijmlist_bpt_size_add(bpt_node *node,int delta)
+{
+	for( ; node ; node = node->parent )
+		node->size += delta;
+}
+
+jmlist_key
+ijmlist_bpt_key_copy(jmlist_key key_ptr,jmlist_key_length key_len)
+{
+	jmlist_key key_copy = malloc(key_len);
+	if( !key_copy )
+	{
+		jmlist_debug(__func__,"malloc failed (size %u)!",key_len);
+		jmlist_errno = JMLIST_ERROR_MALLOC;
+		return 0;
+	}
+
+	memcpy(key_copy,key_ptr,key_len);
+	jmlist_mem.ass_list.total += key_len;
+	jmlist_mem.ass_list.used += key_len;
+
+	return key_copy;
+}
+
+jmlist_index
+ijmlist_bpt_child_index(bpt_node *parent,bpt_node *child)
+{
+	jmlist_index i = 0;
+
+	while( parent->u.child[i] != child ) i++;
+
+	return i;
+}
+
+/*
+ * links right node (split from left) into the parent of left using the
+ * separator key, splitting the parents as needed. spare holds the nodes
+ * that were allocated in advance for the parent splits and new root.
+ */
+void
+ijmlist_bpt_insert_parent(jmlist jml,bpt_node *left,bpt_node *right,uint64_t sep_pfx,jmlist_key sep_ptr,
+		jmlist_key_length sep_len,bpt_node **spare)
+{
+	uint64_t pfx[JMLIST_BPT_ORDER+1];
+	jmlist_key key[JMLIST_BPT_ORDER+1];
+	jmlist_key_length len[JMLIST_BPT_ORDER+1];
+	bpt_node *child[JMLIST_BPT_ORDER+2];
+	bpt_node *parent;
+	bpt_node *node;
+	jmlist_index idx;
+	jmlist_index i,j;
+
+	while( 1 )
+	{
+		parent = left->parent;
+
+		if( !parent )
 		{
-			jmlist_debug(__func__,"entry is from head, lets pop it instead...");
+			node = *spare++;
+			jmlist_debug(__func__,"growing tree height, new root is %p",node);
+			node->count = 1;
+			node->key_pfx[0] = sep_pfx;
+			node->key_ptr[0] = sep_ptr;
+			node->key_len[0] = sep_len;
+			node->u.child[0] = left;
+			node->u.child[1] = right;
+			node->size = left->size + right->size;
+			left->parent = node;
+			right->parent = node;
+			jml->ass_list.root = node;
+			return;
+		}
 
-			assoc_entry *pentry;
-			pentry = jml->ass_list.phead;
-			
-			jmlist_debug(__func__,"entry poped from head is jml=%p",pentry);
+		idx = ijmlist_bpt_child_index(parent,left);
 
-			jml->ass_list.phead = pentry->next;
+		if( parent->count < JMLIST_BPT_ORDER )
+		{
+			for( i = parent->count ; i > idx ; i-- )
+			{
+				parent->key_pfx[i] = parent->key_pfx[i-1];
+				parent->key_ptr[i] = parent->key_ptr[i-1];
+				parent->key_len[i] = parent->key_len[i-1];
+				parent->u.child[i+1] = parent->u.child[i];
+			}
+			parent->key_pfx[idx] = sep_pfx;
+			parent->key_ptr[idx] = sep_ptr;
+			parent->key_len[idx] = sep_len;
+			parent->u.child[idx+1] = right;
+			parent->count++;
+			right->parent = parent;
+			ijmlist_bpt_size_add(parent,1);
+			return;
+		}
 
-			jmlist_debug(__func__,"new list head is phead=%p",pentry->next);
-			jmlist_debug(__func__,"freeing pentry=%p",pentry);
-			
-			free(pentry);
-			
-			jml->ass_list.usage--;
-			jmlist_debug(__func__,"decreased usage to %u",jml->ass_list.usage);
-			
-			jmlist_mem.ass_list.total -= sizeof(struct _assoc_entry);
-			jmlist_mem.ass_list.used -= sizeof(struct _assoc_entry);
-			jmlist_debug(__func__,"new jml_mem.ass_list.total is %u",jmlist_mem.ass_list.total);
-			jmlist_debug(__func__,"new jml_mem.ass_list.used is %u",jmlist_mem.ass_list.used);
-			
-			jmlist_debug(__func__,"returning with success.");
-			return JMLIST_ERROR_SUCCESS;
+		/* parent is full, split it and promote its middle separator */
+		for( i = 0, j = 0 ; i <= JMLIST_BPT_ORDER ; i++ )
+		{
+			if( i == idx )
+			{
+				pfx[i] = sep_pfx;
+				key[i] = sep_ptr;
+				len[i] = sep_len;
+				continue;
+			}
+			pfx[i] = parent->key_pfx[j];
+			key[i] = parent->key_ptr[j];
+			len[i] = parent->key_len[j];
+			j++;
 		}
-		
-		/* we're not at HEAD, remove entry normally... */
-		jmlist_debug(__func__,"unlinking entry");
-		pprevious->next = pseeker->next;
-		jml->ass_list.usage--;
-		
-		jmlist_mem.ass_list.total -= sizeof(struct _assoc_entry);
-		jmlist_mem.ass_list.used -= sizeof(struct _assoc_entry);
-		jmlist_debug(__func__,"new jml_mem.ass_list.total is %u",jmlist_mem.ass_list.total);
-		jmlist_debug(__func__,"new jml_mem.ass_list.used is %u",jmlist_mem.ass_list.used);
-		
-		
-		jmlist_debug(__func__,"unlinked successfuly, new usage is %u, freeing entry",jml->ass_list.usage);
-		free(pseeker);
-		
+		for( i = 0, j = 0 ; i <= JMLIST_BPT_ORDER+1 ; i++ )
+		{
+			if( i == idx+1 )
+			{
+				child[i] = right;
+				continue;
+			}
+			child[i] = parent->u.child[j++];
+		}
+
+		node = *spare++;
+		jmlist_debug(__func__,"splitting internal node %p, new node is %p",parent,node);
+
+		parent->count = JMLIST_BPT_MIN;
+		for( i = 0 ; i < JMLIST_BPT_MIN ; i++ )
+		{
+			parent->key_pfx[i] = pfx[i];
+			parent->key_ptr[i] = key[i];
+			parent->key_len[i] = len[i];
+		}
+		for( i = 0 ; i <= JMLIST_BPT_MIN ; i++ )
+		{
+			parent->u.child[i] = child[i];
+			child[i]->parent = parent;
+		}
+
+		node->count = JMLIST_BPT_ORDER - JMLIST_BPT_MIN;
+		for( i = 0 ; i < node->count ; i++ )
+		{
+			node->key_pfx[i] = pfx[JMLIST_BPT_MIN+1+i];
+			node->key_ptr[i] = key[JMLIST_BPT_MIN+1+i];
+			node->key_len[i] = len[JMLIST_BPT_MIN+1+i];
+		}
+		for( i = 0 ; i <= node->count ; i++ )
+		{
+			node->u.child[i] = child[JMLIST_BPT_MIN+1+i];
+			child[JMLIST_BPT_MIN+1+i]->parent = node;
+		}
+
+		parent->size = ijmlist_bpt_node_size(parent);
+		node->size = ijmlist_bpt_node_size(node);
+
+		left = parent;
+		right = node;
+		sep_pfx = pfx[JMLIST_BPT_MIN];
+		sep_ptr = key[JMLIST_BPT_MIN];
+		sep_len = len[JMLIST_BPT_MIN];
+	}
+}
+
+jmlist_status
+ijmlist_bpt_insert(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,void *ptr)
+{
+	uint64_t pfx[JMLIST_BPT_ORDER+1];
+	jmlist_key key[JMLIST_BPT_ORDER+1];
+	jmlist_key_length len[JMLIST_BPT_ORDER+1];
+	void *value[JMLIST_BPT_ORDER+1];
+	bpt_node *spare[JMLIST_BPT_MAX_HEIGHT];
+	bpt_node *leaf;
+	bpt_node *right;
+	bpt_node *node;
+	jmlist_key sep_ptr;
+	jmlist_key_length sep_len;
+	jmlist_index needed;
+	jmlist_index mid;
+	jmlist_index i,j;
+	uint64_t key_pfx;
+
+	jmlist_debug(__func__,"called with jml=%p, key_ptr=%p, key_len=%u and ptr=%p",jml,key_ptr,key_len,ptr);
+
+	key_pfx = ijmlist_bpt_prefix(key_ptr,key_len);
+
+	if( !jml->ass_list.root )
+	{
+		jmlist_debug(__func__,"list is empty, allocating root leaf");
+		if( ijmlist_bpt_node_alloc(true,&jml->ass_list.root) == JMLIST_ERROR_FAILURE )
+		{
+			jmlist_debug(__func__,"returning with failure.");
+			return JMLIST_ERROR_FAILURE;
+		}
+	}
+
+	/* insert after the entries with equal keys, keeping duplicates in insertion order */
+	leaf = ijmlist_bpt_find_leaf(jml,key_pfx,key_ptr,key_len,true);
+	i = ijmlist_bpt_node_search(jml,leaf,key_pfx,key_ptr,key_len,true);
+	jmlist_debug(__func__,"inserting in leaf %p at slot %u (leaf count is %u)",leaf,i,leaf->count);
+
+	if( leaf->count < JMLIST_BPT_ORDER )
+	{
+		for( j = leaf->count ; j > i ; j-- )
+		{
+			leaf->key_pfx[j] = leaf->key_pfx[j-1];
+			leaf->key_ptr[j] = leaf->key_ptr[j-1];
+			leaf->key_len[j] = leaf->key_len[j-1];
+			leaf->u.ptr[j] = leaf->u.ptr[j-1];
+		}
+		leaf->key_pfx[i] = key_pfx;
+		leaf->key_ptr[i] = key_ptr;
+		leaf->key_len[i] = key_len;
+		leaf->u.ptr[i] = ptr;
+		leaf->count++;
+		ijmlist_bpt_size_add(leaf,1);
+		jml->ass_list.usage++;
+
 		jmlist_debug(__func__,"returning with success.");
 		return JMLIST_ERROR_SUCCESS;
 	}
-	
-	jmlist_debug(__func__,"couldn't find entry with ptr=%p in the list jml=%p",ptr,jml);
-	jmlist_errno = JMLIST_ERROR_ENTRY_NOT_FOUND;
-	jmlist_debug(__func__,"returning with failure.");
-	return JMLIST_ERROR_FAILURE;
+
+	/* leaf is full, allocate everything the split needs before touching the tree:
+	   the new leaf, one node per full ancestor, the new root (if all of them are
+	   full) and the separator key copy. */
+	needed = 0;
+	for( node = leaf->parent ; node && (node->count == JMLIST_BPT_ORDER) ; node = node->parent )
+		needed++;
+	if( !node )
+		needed++;
+	jmlist_debug(__func__,"leaf %p is full, split requires %u internal nodes",leaf,needed);
+
+	for( j = 0 ; j < needed ; j++ )
+	{
+		if( ijmlist_bpt_node_alloc(false,&spare[j]) == JMLIST_ERROR_FAILURE )
+		{
+			/* only the first j spares were allocated */
+			while( j-- )
+				ijmlist_bpt_node_free(spare[j]);
+
+			jmlist_errno = JMLIST_ERROR_MALLOC;
+			jmlist_debug(__func__,"returning with failure.");
+			return JMLIST_ERROR_FAILURE;
+		}
+	}
+
+	/* the separator is the first key of the new leaf, which is the entry in
+	   position (ORDER+1)/2 once the new entry is merged with the leaf ones */
+	mid = (JMLIST_BPT_ORDER+1) / 2;
+	sep_len = (mid == i) ? key_len : leaf->key_len[mid - (mid > i)];
+	sep_ptr = ijmlist_bpt_key_copy((mid == i) ? key_ptr : leaf->key_ptr[mid - (mid > i)],sep_len);
+
+	right = 0;
+	if( !sep_ptr || (ijmlist_bpt_node_alloc(true,&right) == JMLIST_ERROR_FAILURE) )
+	{
+		for( j = 0 ; j < needed ; j++ )
+			ijmlist_bpt_node_free(spare[j]);
+
+		if( sep_ptr )
+		{
+			free(sep_ptr);
+			jmlist_mem.ass_list.total -= sep_len;
+			jmlist_mem.ass_list.used -= sep_len;
+		}
+
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	/* merge the new entry with the full leaf and split the result */
+	for( j = 0 ; j <= JMLIST_BPT_ORDER ; j++ )
+	{
+		if( j == i )
+		{
+			pfx[j] = key_pfx;
+			key[j] = key_ptr;
+			len[j] = key_len;
+			value[j] = ptr;
+			continue;
+		}
+		pfx[j] = leaf->key_pfx[j - (j > i)];
+		key[j] = leaf->key_ptr[j - (j > i)];
+		len[j] = leaf->key_len[j - (j > i)];
+		value[j] = leaf->u.ptr[j - (j > i)];
+	}
+
+	leaf->count = mid;
+	right->count = JMLIST_BPT_ORDER + 1 - mid;
+	for( j = 0 ; j <= JMLIST_BPT_ORDER ; j++ )
+	{
+		node = (j < mid) ? leaf : right;
+		i = (j < mid) ? j : j - mid;
+		node->key_pfx[i] = pfx[j];
+		node->key_ptr[i] = key[j];
+		node->key_len[i] = len[j];
+		node->u.ptr[i] = value[j];
+	}
+
+	right->next = leaf->next;
+	if( right->next )
+		right->next->prev = right;
+	right->prev = leaf;
+	leaf->next = right;
+	leaf->size = leaf->count;
+	right->size = right->count;
+	jml->ass_list.usage++;
+
+	jmlist_debug(__func__,"split leaf %p, new leaf is %p with %u entries",leaf,right,right->count);
+	ijmlist_bpt_insert_parent(jml,leaf,right,right->key_pfx[0],sep_ptr,sep_len,spare);
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
 }
 
-jmlist_status
-ijmlist_ass_dump(jmlist jml)
+/*
+ * fixes a node that got less than JMLIST_BPT_MIN keys after a removal by
+ * borrowing a key from a sibling or merging with it. merges remove one
+ * separator from the parent so it is rebalanced next.
+ */
+void
+ijmlist_bpt_rebalance(jmlist jml,bpt_node *node)
 {
-	jmlist_debug(__func__,"called with jml=%p",jml);
-	
-	printf("associative list jml=%p has usage=%u and phead=%p\n",
-			(void*)jml,jml->ass_list.usage,(void*)jml->ass_list.phead);
-	
-	assoc_entry *pseeker = jml->ass_list.phead;
-	
-	if( pseeker )
-		printf("list of entries:\n");
-	
-	jmlist_index index = 0;
-	bool printable_key;
+	bpt_node *parent;
+	bpt_node *left;
+	bpt_node *right;
+	jmlist_key sep_ptr;
+	jmlist_index idx;
 	jmlist_index i;
-	while( pseeker )
+
+	while( 1 )
 	{
-		/* if key has only printable chars, dump key as ASCII otherwise just
-		   print the pointer and length. */
-		printable_key = true;
-		for( i = 0 ; i < pseeker->key_len ; i++ )
+		parent = node->parent;
+
+		if( !parent )
+		{
+			/* root node can have less keys, shrink the tree when it gets empty */
+			if( node->count )
+				return;
+
+			jml->ass_list.root = node->leaf ? 0 : node->u.child[0];
+			if( jml->ass_list.root )
+				jml->ass_list.root->parent = 0;
+
+			jmlist_debug(__func__,"root %p is empty, new root is %p",node,jml->ass_list.root);
+			ijmlist_bpt_node_free(node);
+			return;
+		}
+
+		if( node->count >= JMLIST_BPT_MIN )
+			return;
+
+		idx = ijmlist_bpt_child_index(parent,node);
+		left = (idx > 0) ? parent->u.child[idx-1] : 0;
+		right = (idx < parent->count) ? parent->u.child[idx+1] : 0;
+
+		if( left && (left->count > JMLIST_BPT_MIN) )
 		{
-			if( isprint(((unsigned char*)pseeker->key_ptr)[i]) )
-				continue;
+			jmlist_debug(__func__,"node %p borrowing from left sibling %p",node,left);
+
+			if( node->leaf )
+			{
+				/* the borrowed entry becomes the new separator */
+				sep_ptr = ijmlist_bpt_key_copy(left->key_ptr[left->count-1],left->key_len[left->count-1]);
+				if( !sep_ptr )
+				{
+					jmlist_debug(__func__,"unable to copy separator, leaving node %p with %u keys",node,node->count);
+					return;
+				}
+
+				for( i = node->count ; i > 0 ; i-- )
+				{
+					node->key_pfx[i] = node->key_pfx[i-1];
+					node->key_ptr[i] = node->key_ptr[i-1];
+					node->key_len[i] = node->key_len[i-1];
+					node->u.ptr[i] = node->u.ptr[i-1];
+				}
+				left->count--;
+				node->key_pfx[0] = left->key_pfx[left->count];
+				node->key_ptr[0] = left->key_ptr[left->count];
+				node->key_len[0] = left->key_len[left->count];
+				node->u.ptr[0] = left->u.ptr[left->count];
+				node->count++;
+				left->size--;
+				node->size++;
+
+				jmlist_mem.ass_list.total -= parent->key_len[idx-1];
+				jmlist_mem.ass_list.used -= parent->key_len[idx-1];
+				free(parent->key_ptr[idx-1]);
+				parent->key_pfx[idx-1] = node->key_pfx[0];
+				parent->key_ptr[idx-1] = sep_ptr;
+				parent->key_len[idx-1] = node->key_len[0];
+				return;
+			}
 
-			printable_key = false;
+			/* rotate through the parent separator */
+			node->u.child[node->count+1] = node->u.child[node->count];
+			for( i = node->count ; i > 0 ; i-- )
+			{
+				node->key_pfx[i] = node->key_pfx[i-1];
+				node->key_ptr[i] = node->key_ptr[i-1];
+				node->key_len[i] = node->key_len[i-1];
+				node->u.child[i] = node->u.child[i-1];
+			}
+			node->key_pfx[0] = parent->key_pfx[idx-1];
+			node->key_ptr[0] = parent->key_ptr[idx-1];
+			node->key_len[0] = parent->key_len[idx-1];
+			node->u.child[0] = left->u.child[left->count];
+			node->u.child[0]->parent = node;
+			node->count++;
+			node->size += node->u.child[0]->size;
+			left->size -= node->u.child[0]->size;
+
+			left->count--;
+			parent->key_pfx[idx-1] = left->key_pfx[left->count];
+			parent->key_ptr[idx-1] = left->key_ptr[left->count];
+			parent->key_len[idx-1] = left->key_len[left->count];
+			return;
 		}
-		
-		if( printable_key )
+
+		if( right && (right->count > JMLIST_BPT_MIN) )
 		{
-			printf("  %08X: pentry=%p pentry->next=%p key=<",
-					index,(void*)pseeker,(void*)pseeker->next);
+			jmlist_debug(__func__,"node %p borrowing from right sibling %p",node,right);
+
+			if( node->leaf )
+			{
+				/* the new first entry of the right sibling becomes the separator */
+				sep_ptr = ijmlist_bpt_key_copy(right->key_ptr[1],right->key_len[1]);
+				if( !sep_ptr )
+				{
+					jmlist_debug(__func__,"unable to copy separator, leaving node %p with %u keys",node,node->count);
+					return;
+				}
+
+				node->key_pfx[node->count] = right->key_pfx[0];
+				node->key_ptr[node->count] = right->key_ptr[0];
+				node->key_len[node->count] = right->key_len[0];
+				node->u.ptr[node->count] = right->u.ptr[0];
+				node->count++;
+				right->size--;
+				node->size++;
+
+				right->count--;
+				for( i = 0 ; i < right->count ; i++ )
+				{
+					right->key_pfx[i] = right->key_pfx[i+1];
+					right->key_ptr[i] = right->key_ptr[i+1];
+					right->key_len[i] = right->key_len[i+1];
+					right->u.ptr[i] = right->u.ptr[i+1];
+				}
+
+				jmlist_mem.ass_list.total -= parent->key_len[idx];
+				jmlist_mem.ass_list.used -= parent->key_len[idx];
+				free(parent->key_ptr[idx]);
+				parent->key_pfx[idx] = right->key_pfx[0];
+				parent->key_ptr[idx] = sep_ptr;
+				parent->key_len[idx] = right->key_len[0];
+				return;
+			}
 
-			for( i = 0 ; i < pseeker->key_len ; i++ )
-				printf("%c",((char*)pseeker->key_ptr)[i]);
+			node->key_pfx[node->count] = parent->key_pfx[idx];
+			node->key_ptr[node->count] = parent->key_ptr[idx];
+			node->key_len[node->count] = parent->key_len[idx];
+			node->u.child[node->count+1] = right->u.child[0];
+			node->u.child[node->count+1]->parent = node;
+			node->count++;
+			node->size += right->u.child[0]->size;
+			right->size -= right->u.child[0]->size;
+
+			parent->key_pfx[idx] = right->key_pfx[0];
+			parent->key_ptr[idx] = right->key_ptr[0];
+			parent->key_len[idx] = right->key_len[0];
+
+			right->count--;
+			for( i = 0 ; i < right->count ; i++ )
+			{
+				right->key_pfx[i] = right->key_pfx[i+1];
+				right->key_ptr[i] = right->key_ptr[i+1];
+				right->key_len[i] = right->key_len[i+1];
+				right->u.child[i] = right->u.child[i+1];
+			}
+			right->u.child[right->count] = right->u.child[right->count+1];
+			return;
+		}
 
-			printf("> key_len=%u ptr=%p\n",pseeker->key_len,pseeker->ptr);
+		/* siblings can't lend keys, merge with one of them into the left node */
+		if( left )
+		{
+			right = node;
+			idx--;
 		} else
 		{
-			printf("  %08X: pentry=%p pentry->next=%p key=%p key_len=%u ptr=%p\n",
-					index,(void*)pseeker,(void*)pseeker->next,(void*)pseeker->key_ptr,pseeker->key_len,pseeker->ptr);
+			left = node;
 		}
-		pseeker = pseeker->next;
-		index++;
+		jmlist_debug(__func__,"merging node %p into its left sibling %p",right,left);
+		left->size += right->size;
+
+		if( left->leaf )
+		{
+			for( i = 0 ; i < right->count ; i++ )
+			{
+				left->key_pfx[left->count+i] = right->key_pfx[i];
+				left->key_ptr[left->count+i] = right->key_ptr[i];
+				left->key_len[left->count+i] = right->key_len[i];
+				left->u.ptr[left->count+i] = right->u.ptr[i];
+			}
+			left->count += right->count;
+
+			left->next = right->next;
+			if( left->next )
+				left->next->prev = left;
+
+			/* separator is no longer needed */
+			jmlist_mem.ass_list.total -= parent->key_len[idx];
+			jmlist_mem.ass_list.used -= parent->key_len[idx];
+			free(parent->key_ptr[idx]);
+		} else
+		{
+			/* separator moves down into the merged node */
+			left->key_pfx[left->count] = parent->key_pfx[idx];
+			left->key_ptr[left->count] = parent->key_ptr[idx];
+			left->key_len[left->count] = parent->key_len[idx];
+			left->count++;
+
+			for( i = 0 ; i < right->count ; i++ )
+			{
+				left->key_pfx[left->count+i] = right->key_pfx[i];
+				left->key_ptr[left->count+i] = right->key_ptr[i];
+				left->key_len[left->count+i] = right->key_len[i];
+			}
+			for( i = 0 ; i <= right->count ; i++ )
+			{
+				left->u.child[left->count+i] = right->u.child[i];
+				left->u.child[left->count+i]->parent = left;
+			}
+			left->count += right->count;
+
+			/* keys were moved to the left node, don't free them with right */
+			right->count = 0;
+		}
+
+		for( i = idx ; i < parent->count-1 ; i++ )
+		{
+			parent->key_pfx[i] = parent->key_pfx[i+1];
+			parent->key_ptr[i] = parent->key_ptr[i+1];
+			parent->key_len[i] = parent->key_len[i+1];
+			parent->u.child[i+1] = parent->u.child[i+2];
+		}
+		parent->count--;
+
+		right->leaf = true;
+		ijmlist_bpt_node_free(right);
+
+		node = parent;
 	}
-	
-	jmlist_debug(__func__,"returning with success.");
-	return JMLIST_ERROR_SUCCESS;
 }
 
 jmlist_status
-ijmlist_ass_free(jmlist jml)
+ijmlist_bpt_remove_at(jmlist jml,bpt_node *leaf,jmlist_index slot)
 {
-	jmlist_debug(__func__,"called with jml=%p",jml);
-	
-	assoc_entry *pseeker = jml->ass_list.phead;
-	assoc_entry *pnext;
-	while( pseeker )
-	{
-		pnext = pseeker->next;
-		jmlist_debug(__func__,"freeing associative entry with p=%p, next is p=%p",pseeker,pnext);
+	jmlist_index i;
 
-		free(pseeker);
-		
-		jmlist_debug(__func__,"freed associative entry sucessfuly with p=%p",pseeker);
-		
-		jmlist_mem.ass_list.total -= sizeof(struct _assoc_entry);
-		jmlist_mem.ass_list.used -= sizeof(struct _assoc_entry);
-		jmlist_debug(__func__,"new jml_mem.ass_list.total is %u",jmlist_mem.ass_list.total);
-		jmlist_debug(__func__,"new jml_mem.ass_list.used is %u",jmlist_mem.ass_list.used);
-		pseeker = pnext;
+	jmlist_debug(__func__,"removing slot %u of leaf %p (key_ptr=%p, ptr=%p)",slot,leaf,leaf->key_ptr[slot],leaf->u.ptr[slot]);
+	jml->generation++;
+
+	if( jml->ass_list.filter )
+		ijmlist_ass_filter_update(jml->ass_list.filter,jml->ass_list.hash(leaf->key_ptr[slot],leaf->key_len[slot]),-1);
+
+	leaf->count--;
+	for( i = slot ; i < leaf->count ; i++ )
+	{
+		leaf->key_pfx[i] = leaf->key_pfx[i+1];
+		leaf->key_ptr[i] = leaf->key_ptr[i+1];
+		leaf->key_len[i] = leaf->key_len[i+1];
+		leaf->u.ptr[i] = leaf->u.ptr[i+1];
 	}
-	
+	ijmlist_bpt_size_add(leaf,-1);
+	jml->ass_list.usage--;
+
+	ijmlist_bpt_rebalance(jml,leaf);
+
 	jmlist_debug(__func__,"returning with success.");
 	return JMLIST_ERROR_SUCCESS;
 }
 
+/*
+ * finds the leaf and slot of an entry by its index, going down from the root
+ * through the child that has it (by the sizes of the children) in O(log N).
+ * in frozen lists leaf is set to 0 and slot is the index.
+ */
 jmlist_status
-ijmlist_ass_ptr_exists(jmlist jml,void *ptr,jmlist_lookup_result *result)
+ijmlist_bpt_find_index(jmlist jml,jmlist_index index,bpt_node **leaf,jmlist_index *slot)
 {
-	jmlist_debug(__func__,"called with jml=%p, ptr=%p, result=%p",jml,ptr,result);
-	
-	if( !result )
-	{
-		jmlist_debug(__func__,"invalid result pointer specified (result=0)");
-		jmlist_debug(__func__,"returning with failure.");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-		return JMLIST_ERROR_FAILURE;
-	}
-	
-	/* trying ptr_exists on an empty list? */
-	if( !jml->ass_list.usage )
+	bpt_node *node;
+	jmlist_index i;
+
+	if( index >= jml->ass_list.usage )
 	{
-		jmlist_debug(__func__,"cannot use this function with an empty list");
-		jmlist_errno = JMLIST_ERROR_EMPTY_LIST;
-		jmlist_debug(__func__,"returning with failure.");
+		jmlist_debug(__func__,"index %u is out of bounds with list jml=%p which has %u entries",index,jml,jml->ass_list.usage);
+		jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
 		return JMLIST_ERROR_FAILURE;
 	}
-	
-	jmlist_debug(__func__,"seeking ptr=%p in the linked list",ptr);
-	
-	assoc_entry *pseeker = jml->ass_list.phead;
-	while( pseeker )
+
+	if( jml->ass_list.sorted )
 	{
-		if( pseeker->ptr != ptr )
-		{
-			pseeker = pseeker->next;
-			continue;
-		}
-		
-		/* found entry */
-		jmlist_debug(__func__,"found entry with ptr=%p on pseeker=%p in list jml=%p",ptr,pseeker,jml);
-		*result = jmlist_entry_found;
-		jmlist_debug(__func__,"returning with success.");
+		*leaf = 0;
+		*slot = index;
 		return JMLIST_ERROR_SUCCESS;
 	}
-	
-	*result = jmlist_entry_not_found;
-	jmlist_debug(__func__,"couldn't find entry with ptr=%p in list jml=%p",ptr,jml);
-	jmlist_errno = JMLIST_ERROR_ENTRY_NOT_FOUND;
-	jmlist_debug(__func__,"returning with failure.");
-	return JMLIST_ERROR_FAILURE;
-}
-
-jmlist_status
-ijmlist_ass_key_exists(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,jmlist_lookup_result *result)
-{
-	jmlist_debug(__func__,"called with jml=%p, key_ptr=%p, key_len=%u, result=%p",jml,key_ptr,key_len,result);
-	
-	DCHECKSTART
 
-	if( !result )
+	for( node = jml->ass_list.root ; node && !node->leaf ; node = node->u.child[i] )
 	{
-		jmlist_debug(__func__,"invalid result pointer specified (result=0)");
-		jmlist_debug(__func__,"returning with failure.");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-		return JMLIST_ERROR_FAILURE;
+		for( i = 0 ; (i < node->count) && (index >= node->u.child[i]->size) ; i++ )
+			index -= node->u.child[i]->size;
 	}
-	
-	/* verify key_ptr */
-	if( !key_ptr )
+
+	if( !node || (index >= node->count) )
 	{
-		jmlist_debug(__func__,"invalid key_ptr specified (key_ptr=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-		jmlist_debug(__func__,"returning with failure.");
+		jmlist_debug(__func__,"index is past the entries of the tree, damaged list?");
+		jmlist_errno = JMLIST_ERROR_DAMAGED_LIST;
 		return JMLIST_ERROR_FAILURE;
 	}
-	
-	/* verify key_len */
-	if( !key_len )
+
+	*leaf = node;
+	*slot = index;
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+ * finds the leaf and slot of the first entry with the key.
+ */
+jmlist_status
+ijmlist_bpt_find_key(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,bpt_node **leaf,jmlist_index *slot)
+{
+	ijmlist_bpt_lower_bound(jml,key_ptr,key_len,leaf,slot);
+
+	if( !*leaf || ijmlist_bpt_compare(jml,(*leaf)->key_pfx[*slot],(*leaf)->key_ptr[*slot],(*leaf)->key_len[*slot],
+				ijmlist_bpt_prefix(key_ptr,key_len),key_ptr,key_len) )
 	{
-		jmlist_debug(__func__,"invalid key_len specified (key_len=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-		jmlist_debug(__func__,"returning with failure.");
+		jmlist_debug(__func__,"couldn't find entry with key_ptr=%p key_len=%u in list jml=%p",key_ptr,key_len,jml);
+		jmlist_errno = JMLIST_ERROR_ENTRY_NOT_FOUND;
 		return JMLIST_ERROR_FAILURE;
 	}
 
-	DCHECKEND
-	
-	/* trying ptr_exists on an empty list? */
-	if( !jml->ass_list.usage )
+	jmlist_debug(__func__,"found key_ptr=%p key_len=%u in leaf %p slot %u",key_ptr,key_len,*leaf,*slot);
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+ * finds the leaf and slot of the first entry with the ptr, O(N). in frozen
+ * lists leaf is set to 0 and slot is the sorted position.
+ */
+jmlist_status
+ijmlist_bpt_find_ptr(jmlist jml,void *ptr,bpt_node **leaf,jmlist_index *slot)
+{
+	bpt_node *node;
+	jmlist_index i;
+
+	if( jml->ass_list.sorted )
 	{
-		jmlist_debug(__func__,"cannot use this function with an empty list");
-		jmlist_errno = JMLIST_ERROR_EMPTY_LIST;
-		jmlist_debug(__func__,"returning with failure.");
-		return JMLIST_ERROR_FAILURE;
+		for( i = 0 ; i < jml->ass_list.sorted->count ; i++ )
+		{
+			if( jml->ass_list.sorted->ptr[jml->ass_list.sorted->node[i]] != ptr )
+				continue;
+
+			*leaf = 0;
+			*slot = i;
+			return JMLIST_ERROR_SUCCESS;
+		}
 	}
-	
-	jmlist_debug(__func__,"seeking key_ptr=%p, key_len=%u in the linked list",key_ptr,key_len);
-	
-	assoc_entry *pseeker = jml->ass_list.phead;
-	while( pseeker )
+
+	for( node = ijmlist_bpt_first_leaf(jml) ; node ; node = node->next )
 	{
-		if( (pseeker->key_len != key_len) || memcmp(pseeker->key_ptr,key_ptr,key_len) )
+		for( i = 0 ; i < node->count ; i++ )
 		{
-			pseeker = pseeker->next;
-			continue;
+			if( node->u.ptr[i] != ptr )
+				continue;
+
+			*leaf = node;
+			*slot = i;
+			return JMLIST_ERROR_SUCCESS;
 		}
-		
-		/* found entry */
-		jmlist_debug(__func__,"found entry of key_ptr %p (length %u) on pseeker=%p in list jml=%p",key_ptr,key_len,pseeker,jml);
-		*result = jmlist_entry_found;
-		jmlist_debug(__func__,"returning with success.");
-		return JMLIST_ERROR_SUCCESS;
 	}
-	
-	*result = jmlist_entry_not_found;
-	jmlist_debug(__func__,"couldn't find entry with key_ptr=%p and key_len=%u in list jml=%p",key_ptr,key_len,jml);
+
+	jmlist_debug(__func__,"couldn't find entry with ptr=%p in list jml=%p",ptr,jml);
 	jmlist_errno = JMLIST_ERROR_ENTRY_NOT_FOUND;
-	jmlist_debug(__func__,"returning with failure.");
 	return JMLIST_ERROR_FAILURE;
 }
 
-/*
- * get method for lists that have keys associated.
- */
 jmlist_status
-jmlist_get_by_key(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,void **ptr)
+ijmlist_bpt_get_by_key(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,void **ptr)
 {
-	jmlist_debug(__func__,"called with jml=%p, key_ptr=%p, key_len=%u, ptr=%p",jml,key_ptr,key_len,ptr);
-	
-	if( !ptr )
+	bpt_node *leaf;
+	jmlist_index slot;
+
+	jmlist_debug(__func__,"called with jml=%p key_ptr=%p key_len=%u ptr=%p",jml,key_ptr,key_len,ptr);
+
+	if( jml->ass_list.sorted )
 	{
-		jmlist_debug(__func__,"invalid ptr specified (ptr=0)");
-		jmlist_debug(__func__,"returning with failure.");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-		return JMLIST_ERROR_FAILURE;
+		if( ijmlist_sorted_find_key(jml,key_ptr,key_len,&slot) == JMLIST_ERROR_FAILURE )
+		{
+			jmlist_debug(__func__,"returning with failure.");
+			return JMLIST_ERROR_FAILURE;
+		}
+
+		*ptr = jml->ass_list.sorted->ptr[slot];
+		jmlist_debug(__func__,"returning with success.");
+		return JMLIST_ERROR_SUCCESS;
 	}
 
-	/* verify key_ptr */
-	if( !key_ptr )
+	if( ijmlist_bpt_find_key(jml,key_ptr,key_len,&leaf,&slot) == JMLIST_ERROR_FAILURE )
 	{
-		jmlist_debug(__func__,"invalid key_ptr specified (key_ptr=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
 		jmlist_debug(__func__,"returning with failure.");
 		return JMLIST_ERROR_FAILURE;
 	}
-	
-	/* verify key_len */
-	if( !key_len )
+
+	*ptr = leaf->u.ptr[slot];
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+jmlist_status
+ijmlist_bpt_key_exists(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,jmlist_lookup_result *result)
+{
+	bpt_node *leaf;
+	jmlist_index slot;
+
+	jmlist_debug(__func__,"called with jml=%p key_ptr=%p key_len=%u result=%p",jml,key_ptr,key_len,result);
+
+	if( (jml->ass_list.sorted ? ijmlist_sorted_find_key(jml,key_ptr,key_len,&slot) :
+				ijmlist_bpt_find_key(jml,key_ptr,key_len,&leaf,&slot)) == JMLIST_ERROR_FAILURE )
 	{
-		jmlist_debug(__func__,"invalid key_len specified (key_len=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		*result = jmlist_entry_not_found;
 		jmlist_debug(__func__,"returning with failure.");
 		return JMLIST_ERROR_FAILURE;
 	}
 
-	/* for now this function is only supported in associative lists */	
-	if( jml->flags & JMLIST_ASSOCIATIVE )
-	{
-		jmlist_debug(__func__,"passing control to the associative get by key routine.");
-		return ijmlist_ass_get_by_key(jml,key_ptr,key_len,ptr);
-	}
+	*result = jmlist_entry_found;
 
-	jmlist_debug(__func__,"invalid or unsupported list type (jml=%p, flags=%u)",jml,jml->flags);
-	jmlist_debug(__func__,"returning with failure.");
-	jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-	return JMLIST_ERROR_FAILURE;
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+jmlist_status
+ijmlist_bpt_remove_by_key(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len)
+{
+	bpt_node *leaf;
+	jmlist_index slot;
+
+	jmlist_debug(__func__,"called with jml=%p key_ptr=%p key_len=%u",jml,key_ptr,key_len);
+
+	if( ijmlist_bpt_find_key(jml,key_ptr,key_len,&leaf,&slot) == JMLIST_ERROR_FAILURE )
+	{
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	return ijmlist_bpt_remove_at(jml,leaf,slot);
 }
 
 jmlist_status
-ijmlist_ass_get_by_key(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,void **ptr)
+ijmlist_bpt_remove_by_ptr(jmlist jml,void *ptr)
 {
-	jmlist_debug(__func__,"called with jml=%p key_ptr=%p key_len=%u ptr=%p",jml,key_ptr,key_len,ptr);
+	bpt_node *leaf;
+	jmlist_index slot;
 
-	/* arguments check, this should be already done by the calling function, tho you
-	   can repeat it here if you want... */
+	jmlist_debug(__func__,"called with jml=%p ptr=%p",jml,ptr);
 
-	DCHECKSTART
-	/* verify key_ptr */
-	if( !key_ptr )
+	if( ijmlist_bpt_find_ptr(jml,ptr,&leaf,&slot) == JMLIST_ERROR_FAILURE )
 	{
-		jmlist_debug(__func__,"invalid key_ptr specified (key_ptr=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
 		jmlist_debug(__func__,"returning with failure.");
 		return JMLIST_ERROR_FAILURE;
 	}
-	
-	/* verify key_len */
-	if( !key_len )
+
+	return ijmlist_bpt_remove_at(jml,leaf,slot);
+}
+
+jmlist_status
+ijmlist_bpt_ptr_exists(jmlist jml,void *ptr,jmlist_lookup_result *result)
+{
+	bpt_node *leaf;
+	jmlist_index slot;
+
+	jmlist_debug(__func__,"called with jml=%p ptr=%p result=%p",jml,ptr,result);
+
+	if( ijmlist_bpt_find_ptr(jml,ptr,&leaf,&slot) == JMLIST_ERROR_FAILURE )
 	{
-		jmlist_debug(__func__,"invalid key_len specified (key_len=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		*result = jmlist_entry_not_found;
 		jmlist_debug(__func__,"returning with failure.");
 		return JMLIST_ERROR_FAILURE;
 	}
-	DCHECKEND
 
-	jmlist_debug(__func__,"seeking key_ptr=%p in the linked list",key_ptr);
-	
-	assoc_entry *pseeker = jml->ass_list.phead;
-	while( pseeker )
-	{
-		if( (pseeker->key_len != key_len) || memcmp(pseeker->key_ptr,key_ptr,key_len) )
-		{
-			pseeker = pseeker->next;
-			continue;
-		}
-		
-		/* found entry */
-		jmlist_debug(__func__,"found entry of key_ptr %p (length %u) on pseeker=%p in list jml=%p",
-					 key_ptr,key_len,pseeker,jml);
-		*ptr = pseeker->ptr;
-		
-		jmlist_debug(__func__,"returning with success.");
-		return JMLIST_ERROR_SUCCESS;
-	}
-	
-	jmlist_debug(__func__,"couldn't find entry with key_ptr=%p key_len=%u in list jml=%p",
-				 key_ptr,key_len,jml);
-	jmlist_errno = JMLIST_ERROR_ENTRY_NOT_FOUND;
-	
-	jmlist_debug(__func__,"returning with failure.");
-	return JMLIST_ERROR_FAILURE;
+	*result = jmlist_entry_found;
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
 }
 
-/*
-   jmlist_remove_by_key
-   removes an entry from the list using the key for the lists that actually support keys.
-*/
 jmlist_status
-jmlist_remove_by_key(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len)
+ijmlist_bpt_get_by_index(jmlist jml,jmlist_index index,void **ptr)
 {
-	jmlist_debug(__func__,"called with jml=%p key_ptr=%p key_len=%u",jml,key_ptr,key_len);
-	
-	/* verify key_ptr */
-	if( !key_ptr )
+	bpt_node *leaf;
+	jmlist_index slot;
+
+	jmlist_debug(__func__,"called with jml=%p index=%u ptr=%p",jml,index,ptr);
+
+	if( ijmlist_bpt_find_index(jml,index,&leaf,&slot) == JMLIST_ERROR_FAILURE )
 	{
-		jmlist_debug(__func__,"invalid key_ptr specified (key_ptr=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
 		jmlist_debug(__func__,"returning with failure.");
 		return JMLIST_ERROR_FAILURE;
 	}
-	
-	/* verify key_len */
-	if( !key_len )
+
+	*ptr = leaf ? leaf->u.ptr[slot] : jml->ass_list.sorted->ptr[jml->ass_list.sorted->node[slot]];
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+jmlist_status
+ijmlist_bpt_remove_by_index(jmlist jml,jmlist_index index)
+{
+	bpt_node *leaf;
+	jmlist_index slot;
+
+	jmlist_debug(__func__,"called with jml=%p index=%u",jml,index);
+
+	if( ijmlist_bpt_find_index(jml,index,&leaf,&slot) == JMLIST_ERROR_FAILURE )
 	{
-		jmlist_debug(__func__,"invalid key_len specified (key_len=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
 		jmlist_debug(__func__,"returning with failure.");
 		return JMLIST_ERROR_FAILURE;
 	}
 
-	if( jml->flags & JMLIST_ASSOCIATIVE )
-	{
-		jmlist_debug(__func__,"passing control to associative list remove by key routine.");
-		return ijmlist_ass_remove_by_key(jml,key_ptr,key_len);
-	}
-
-	jmlist_debug(__func__,"invalid or unsupported list type (jml=%p, flags=%u)",jml,jml->flags);
-	jmlist_debug(__func__,"returning with failure.");
-	jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-	return JMLIST_ERROR_FAILURE;
+	return ijmlist_bpt_remove_at(jml,leaf,slot);
 }
 
 jmlist_status
-ijmlist_ass_remove_by_key(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len)
+ijmlist_bpt_replace_by_index(jmlist jml,jmlist_index index,void *new_ptr)
 {
-	jmlist_debug(__func__,"called with jml=%p key_ptr=%p key_len=%u\n",(void*)jml,(void*)key_ptr,key_len);
+	bpt_node *leaf;
+	jmlist_index slot;
 
-	/* trying to pop from empty list? */
-	if( !jml->ass_list.usage )
+	jmlist_debug(__func__,"called with jml=%p index=%u new_ptr=%p",jml,index,new_ptr);
+
+	if( ijmlist_bpt_find_index(jml,index,&leaf,&slot) == JMLIST_ERROR_FAILURE )
 	{
-		jmlist_debug(__func__,"trying to remove from empty list");
 		jmlist_debug(__func__,"returning with failure.");
-		jmlist_errno = JMLIST_ERROR_EMPTY_LIST;
 		return JMLIST_ERROR_FAILURE;
 	}
-	
-	jmlist_debug(__func__,"seeking key_ptr=%p key_len=%u in the associative list",key_ptr,key_len);
-	
-	assoc_entry *pseeker = jml->ass_list.phead;
-	assoc_entry *pprevious = pseeker;
-	while( pseeker )
-	{
-		if( (pseeker->key_len != key_len) || (memcmp(pseeker->key_ptr,key_ptr,key_len)) )
-		{
-			pprevious = pseeker;
-			pseeker = pseeker->next;
-			continue;
-		}
-		
-		jmlist_debug(__func__,"found entry, pseeker=%p pseeker->next=%p",pseeker,pseeker->next);
-		
-		if( pprevious == pseeker )
-		{
-			jmlist_debug(__func__,"entry is from head, lets pop it instead...");
 
-			assoc_entry *pentry;
-			pentry = jml->ass_list.phead;
-			
-			jmlist_debug(__func__,"entry poped from head is jml=%p",pentry);
+	jmlist_debug(__func__,"replacing old ptr=%p with new_ptr=%p",leaf->u.ptr[slot],new_ptr);
+	leaf->u.ptr[slot] = new_ptr;
 
-			jml->ass_list.phead = pentry->next;
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
 
-			jmlist_debug(__func__,"new list head is phead=%p",pentry->next);
-			jmlist_debug(__func__,"freeing pentry=%p",pentry);
-			
-			free(pentry);
-			
-			jml->ass_list.usage--;
-			jmlist_debug(__func__,"decreased usage to %u",jml->ass_list.usage);
-			
-			jmlist_mem.ass_list.total -= sizeof(struct _assoc_entry);
-			jmlist_mem.ass_list.used -= sizeof(struct _assoc_entry);
-			jmlist_debug(__func__,"new jml_mem.ass_list.total is %u",jmlist_mem.ass_list.total);
-			jmlist_debug(__func__,"new jml_mem.ass_list.used is %u",jmlist_mem.ass_list.used);
-			
-			jmlist_debug(__func__,"returning with success.");
-			return JMLIST_ERROR_SUCCESS;
-		}
-		
-		/* we're not at HEAD, remove entry normally... */
-		jmlist_debug(__func__,"unlinking entry");
-		pprevious->next = pseeker->next;
-		jml->ass_list.usage--;
-		
-		jmlist_mem.ass_list.total -= sizeof(struct _assoc_entry);
-		jmlist_mem.ass_list.used -= sizeof(struct _assoc_entry);
-		jmlist_debug(__func__,"new jml_mem.ass_list.total is %u",jmlist_mem.ass_list.total);
-		jmlist_debug(__func__,"new jml_mem.ass_list.used is %u",jmlist_mem.ass_list.used);
-		
-		
-		jmlist_debug(__func__,"unlinked successfuly, new usage is %u, freeing entry",jml->ass_list.usage);
-		free(pseeker);
-		
-		jmlist_debug(__func__,"returning with success.");
-		return JMLIST_ERROR_SUCCESS;
+void
+ijmlist_bpt_free_node(bpt_node *node)
+{
+	jmlist_index i;
+
+	if( !node->leaf )
+	{
+		for( i = 0 ; i <= node->count ; i++ )
+			ijmlist_bpt_free_node(node->u.child[i]);
 	}
-	
-	jmlist_debug(__func__,"couldn't find entry with key_ptr=%p key_len=%u in list jml=%p",key_ptr,key_len,jml);
-	jmlist_errno = JMLIST_ERROR_ENTRY_NOT_FOUND;
-	jmlist_debug(__func__,"returning with failure.");
-	return JMLIST_ERROR_FAILURE;
+
+	ijmlist_bpt_node_free(node);
 }
 
 jmlist_status
-jmlist_entry_count(jmlist jml,jmlist_index *entry_count)
+ijmlist_bpt_free(jmlist jml)
 {
-	jmlist_debug(__func__,"called with jml=%p, entry_count=%p");
+	jmlist_debug(__func__,"called with jml=%p",jml);
 
-	if( !entry_count )
+	if( jml->ass_list.root )
+		ijmlist_bpt_free_node(jml->ass_list.root);
+
+	jml->ass_list.root = 0;
+	jml->ass_list.usage = 0;
+
+	jmlist_debug(__func__,"new jml_mem.ass_list.total is %u",jmlist_mem.ass_list.total);
+	jmlist_debug(__func__,"new jml_mem.ass_list.used is %u",jmlist_mem.ass_list.used);
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+jmlist_status
+ijmlist_bpt_dump(jmlist jml)
+{
+	bpt_node *leaf;
+	jmlist_index index = 0;
+	jmlist_index i,k;
+	bool printable_key;
+
+	jmlist_debug(__func__,"called with jml=%p",jml);
+
+	printf("ordered associative list jml=%p has usage=%u and root=%p\n",
+			(void*)jml,jml->ass_list.usage,(void*)jml->ass_list.root);
+
+	if( jml->ass_list.usage )
+		printf("list of entries:\n");
+
+	if( jml->ass_list.sorted )
 	{
-		jmlist_debug(__func__,"invalid entry_count argument (entry_count=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-		jmlist_debug(__func__,"returning with failure.");
-		return JMLIST_ERROR_FAILURE;
+		printf("list is frozen, entries are in sorted array %p\n",(void*)jml->ass_list.sorted);
+		for( i = 0 ; i < jml->ass_list.sorted->count ; i++ )
+		{
+			k = jml->ass_list.sorted->node[i];
+			printf("  %08X: node=%u key=%p key_len=%u ptr=%p\n",i,k,(void*)jml->ass_list.sorted->key_ptr[k],
+					jml->ass_list.sorted->key_len[k],jml->ass_list.sorted->ptr[k]);
+		}
 	}
 
-	if( jml->flags & JMLIST_INDEXED )
-	{
-		jmlist_debug(__func__,"updating entry_count to %u",jml->idx_list.usage);
-		*entry_count = jml->idx_list.usage;
-	} else if( jml->flags & JMLIST_LINKED )
-	{
-		jmlist_debug(__func__,"updating entry_count to %u",jml->lnk_list.usage);
-		*entry_count = jml->lnk_list.usage;
-	} else if( jml->flags & JMLIST_ASSOCIATIVE )
+	for( leaf = ijmlist_bpt_first_leaf(jml) ; leaf ; leaf = leaf->next )
 	{
-		jmlist_debug(__func__,"updating entry_count to %u",jml->ass_list.usage);
-		*entry_count = jml->ass_list.usage;
-	} else {
-		jmlist_debug(__func__,"unable to determine jmlist type from its flags");
-		jmlist_debug(__func__,"returning with failure.");
-		return JMLIST_ERROR_INVALID_ARGUMENT;
+		for( i = 0 ; i < leaf->count ; i++, index++ )
+		{
+			printable_key = true;
+			for( k = 0 ; k < leaf->key_len[i] ; k++ )
+			{
+				if( !isprint(((unsigned char*)leaf->key_ptr[i])[k]) )
+					printable_key = false;
+			}
+
+			if( printable_key )
+			{
+				printf("  %08X: leaf=%p slot=%u key=<",index,(void*)leaf,i);
+				for( k = 0 ; k < leaf->key_len[i] ; k++ )
+					printf("%c",((char*)leaf->key_ptr[i])[k]);
+				printf("> key_len=%u ptr=%p\n",leaf->key_len[i],leaf->u.ptr[i]);
+			} else
+			{
+				printf("  %08X: leaf=%p slot=%u key=%p key_len=%u ptr=%p\n",
+						index,(void*)leaf,i,(void*)leaf->key_ptr[i],leaf->key_len[i],leaf->u.ptr[i]);
+			}
+		}
 	}
 
 	jmlist_debug(__func__,"returning with success.");
 	return JMLIST_ERROR_SUCCESS;
 }
 
-/*
-   jmlist_remove_by_index
-
-   Removes an entry from the list using the entry index.
-*/
 jmlist_status
-jmlist_remove_by_index(jmlist jml,jmlist_index index)
+ijmlist_bpt_seek_range(jmlist jml,jmlist_seek_handle *handle_ptr,jmlist_key lo_ptr,jmlist_key_length lo_len,
+		jmlist_key hi_ptr,jmlist_key_length hi_len)
 {
-	jmlist_debug(__func__,"called with jml=%p, index=%u",jml,index);
-	
-	if( jml->flags & JMLIST_INDEXED )
+	jmlist_debug(__func__,"called with jml=%p, handle_ptr=%p, lo_ptr=%p, lo_len=%u, hi_ptr=%p, hi_len=%u",
+			jml,handle_ptr,lo_ptr,lo_len,hi_ptr,hi_len);
+
+	if( jml->ass_list.sorted )
 	{
-		jmlist_debug(__func__,"passing control to indexed list remove_by_index routine.");
-		return ijmlist_idx_remove_by_index(jml,index);
-	} else if( jml->flags & JMLIST_LINKED )
+		handle_ptr->pos.next_bpt.leaf = 0;
+		handle_ptr->pos.next_bpt.slot = lo_ptr ? ijmlist_sorted_bound(jml,lo_ptr,lo_len,false) : 0;
+	} else if( lo_ptr )
 	{
-		jmlist_debug(__func__,"passing control to linked list remove_by_index routine.");
-		return ijmlist_lnk_remove_by_index(jml,index);
-	}
-	else if( jml->flags & JMLIST_ASSOCIATIVE )
+		ijmlist_bpt_lower_bound(jml,lo_ptr,lo_len,&handle_ptr->pos.next_bpt.leaf,&handle_ptr->pos.next_bpt.slot);
+	} else
 	{
-		jmlist_debug(__func__,"passing control to the associative list remove_by_index routine.");
-		return ijmlist_ass_remove_by_index(jml,index);
+		handle_ptr->pos.next_bpt.leaf = ijmlist_bpt_first_leaf(jml);
+		handle_ptr->pos.next_bpt.slot = 0;
 	}
-	
-	jmlist_debug(__func__,"invalid or unsupported list type (jml=%p, flags=%u)",jml,jml->flags);
-	jmlist_debug(__func__,"returning with failure.");
-	jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-	return JMLIST_ERROR_FAILURE;
+
+	handle_ptr->pos.next_bpt.hi_ptr = hi_ptr;
+	handle_ptr->pos.next_bpt.hi_len = hi_len;
+	handle_ptr->pos.next_bpt.hi_incl = false;
+	jmlist_debug(__func__,"handle set to leaf=%p and slot=%u",handle_ptr->pos.next_bpt.leaf,handle_ptr->pos.next_bpt.slot);
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
 }
 
 jmlist_status
-ijmlist_idx_remove_by_index(jmlist jml,jmlist_index index)
+ijmlist_bpt_seek_next(jmlist jml,jmlist_seek_handle *handle_ptr,void **ptr)
 {
-	jmlist_debug(__func__,"called with jml=%p, index=%u",jml,index);
+	bpt_node *leaf = handle_ptr->pos.next_bpt.leaf;
+	jmlist_index slot = handle_ptr->pos.next_bpt.slot;
 
-	if( !jml->idx_list.usage )
-	{
-		jmlist_debug(__func__,"cannot get by index on empty list (lnk_list.usage=0)");
-		jmlist_debug(__func__,"returning with failure.");
-		jmlist_errno = JMLIST_ERROR_EMPTY_LIST;
-		return JMLIST_ERROR_FAILURE;
-	}
+	jmlist_debug(__func__,"called with jml=%p, handle_ptr=%p and ptr=%p",jml,handle_ptr,ptr);
 
-	/* shouldn't use get on a fragmented idx list */
-	if( !(jml->flags & JMLIST_IDX_USE_SHIFT) )
+	if( jml->ass_list.sorted )
 	{
-		/* check for fragmentation */
-		bool fragmented = false;
-		if( jmlist_is_fragmented(jml,false,&fragmented) == JMLIST_ERROR_FAILURE )
-			return JMLIST_ERROR_FAILURE;
-
-		if( fragmented == true )
+		if( (slot >= jml->ass_list.sorted->count) || (handle_ptr->pos.next_bpt.hi_ptr &&
+				(ijmlist_sorted_compare(jml,slot,ijmlist_bpt_prefix(handle_ptr->pos.next_bpt.hi_ptr,handle_ptr->pos.next_bpt.hi_len),
+					handle_ptr->pos.next_bpt.hi_ptr,handle_ptr->pos.next_bpt.hi_len) >= (handle_ptr->pos.next_bpt.hi_incl ? 1 : 0))) )
 		{
-			jmlist_debug(__func__,"cannot use this function with possible fragmented indexed lists, use of JMLIST_IDX_USE_SHIFT is required");
-			jmlist_errno = JMLIST_ERROR_FAILURE;
+			jmlist_debug(__func__,"there are no more entries to seek (reached the end of the range)");
+			jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
 			jmlist_debug(__func__,"returning with failure.");
 			return JMLIST_ERROR_FAILURE;
 		}
+
+		*ptr = jml->ass_list.sorted->ptr[jml->ass_list.sorted->node[slot]];
+		jmlist_debug(__func__,"sorted position %u has ptr=%p",slot,*ptr);
+		handle_ptr->pos.next_bpt.slot = slot + 1;
+
+		jmlist_debug(__func__,"returning with success.");
+		return JMLIST_ERROR_SUCCESS;
 	}
 
-	/* check bounds */
-	if( index >= jml->idx_list.usage )
+	if( leaf && (slot >= leaf->count) )
 	{
-		jmlist_debug(__func__,"index %u is out of bounds with list jml=%p which has %u entries",index,jml,jml->idx_list.usage);
+		leaf = leaf->next;
+		slot = 0;
+	}
+
+	if( !leaf )
+	{
+		jmlist_debug(__func__,"there are no more entries to seek (reached the last leaf)");
 		jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
-		jmlist_debug(__func__,"returning with failure");
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( handle_ptr->pos.next_bpt.hi_ptr &&
+			(ijmlist_bpt_compare(jml,leaf->key_pfx[slot],leaf->key_ptr[slot],leaf->key_len[slot],
+				ijmlist_bpt_prefix(handle_ptr->pos.next_bpt.hi_ptr,handle_ptr->pos.next_bpt.hi_len),
+				handle_ptr->pos.next_bpt.hi_ptr,handle_ptr->pos.next_bpt.hi_len) >= (handle_ptr->pos.next_bpt.hi_incl ? 1 : 0)) )
+	{
+		jmlist_debug(__func__,"there are no more entries to seek (reached the end of the range)");
+		jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
+		jmlist_debug(__func__,"returning with failure.");
 		return JMLIST_ERROR_FAILURE;
 	}
 
-	/* remove the entry... */
-	jmlist_debug(__func__,"setting entry ptr (now %p) to NULL from list %p in index %u",jml->idx_list.plist[index],jml,index);
+	*ptr = leaf->u.ptr[slot];
+	jmlist_debug(__func__,"leaf %p slot %u has ptr=%p",leaf,slot,*ptr);
 
-	/* found the entry, clear it */
-	jml->idx_list.plist[index] = JMLIST_EMPTY_PTR;
-	jml->idx_list.usage--;
+	handle_ptr->pos.next_bpt.leaf = leaf;
+	handle_ptr->pos.next_bpt.slot = slot + 1;
 
-	jmlist_mem.idx_list.used -= sizeof(void*);
-	jmlist_debug(__func__,"new jml_mem.idx_list.used is %u",jmlist_mem.idx_list.used);
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
 
-	jmlist_debug(__func__,"entry with index %u removed from list %p, new usage is %u",index,jml,jml->idx_list.usage);
+jmlist_status
+ijmlist_bpt_seek_prev(jmlist jml,jmlist_seek_handle *handle_ptr,void **ptr)
+{
+	bpt_node *leaf = handle_ptr->pos.next_bpt.leaf;
+	jmlist_index slot = handle_ptr->pos.next_bpt.slot;
 
-	/* if shift is activated, remove and shift, otherwise just remove */
-	unsigned int i;
-	if( jml->flags & JMLIST_IDX_USE_SHIFT )
+	jmlist_debug(__func__,"called with jml=%p, handle_ptr=%p and ptr=%p",jml,handle_ptr,ptr);
+
+	if( jml->ass_list.sorted )
 	{
-		jmlist_debug(__func__,"JMLIST_IDX_USE_SHIFT activated, shifting list entries.");
+		if( slot > jml->ass_list.sorted->count )
+			slot = jml->ass_list.sorted->count;
+		if( !slot )
+		{
+			jmlist_debug(__func__,"there are no more entries to seek (reached the first sorted position)");
+			jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
+			jmlist_debug(__func__,"returning with failure.");
+			return JMLIST_ERROR_FAILURE;
+		}
 
-		for( i = index ; i < (jml->idx_list.capacity - 1) ; i++ )
-			jml->idx_list.plist[i] = jml->idx_list.plist[i+1];
+		*ptr = jml->ass_list.sorted->ptr[jml->ass_list.sorted->node[slot-1]];
+		jmlist_debug(__func__,"sorted position %u has ptr=%p",slot-1,*ptr);
+		handle_ptr->pos.next_bpt.slot = slot - 1;
+
+		jmlist_debug(__func__,"returning with success.");
+		return JMLIST_ERROR_SUCCESS;
 	}
 
-	if( (jml->flags & JMLIST_IDX_USE_FRAG_FLAG) && (jml->idx_list.fragmented == false) )
+	while( leaf && !slot )
 	{
-		if( (index < (jml->idx_list.capacity-1)) && (jml->idx_list.plist[index+1] != JMLIST_EMPTY_PTR) )
-			jml->idx_list.fragmented = true;
+		leaf = leaf->prev;
+		slot = leaf ? leaf->count : 0;
+	}
 
-		/* else we'll keep it in false (not fragmented) */
+	if( !leaf )
+	{
+		jmlist_debug(__func__,"there are no more entries to seek (reached the first leaf)");
+		jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
 	}
 
+	*ptr = leaf->u.ptr[slot-1];
+	jmlist_debug(__func__,"leaf %p slot %u has ptr=%p",leaf,slot-1,*ptr);
+
+	handle_ptr->pos.next_bpt.leaf = leaf;
+	handle_ptr->pos.next_bpt.slot = slot - 1;
+
 	jmlist_debug(__func__,"returning with success.");
 	return JMLIST_ERROR_SUCCESS;
 }
 
+/*
+   jmlist_seek_key
+
+   Starts seeking the entries of an associative list with the given key, in the
+   same order jmlist_get_all_by_key returns them. Entries are obtained with
+   jmlist_seek_next and the seeking must be finished with jmlist_seek_end. Only the
+   entries with the key are visited.
+*/
 jmlist_status
-ijmlist_lnk_remove_by_index(jmlist jml,jmlist_index index)
+jmlist_seek_key(jmlist jml,jmlist_seek_handle *handle_ptr,jmlist_key key_ptr,jmlist_key_length key_len)
 {
-	jmlist_debug(__func__,"called with jml=%p, index=%u",jml,index);
+	jmlist_debug(__func__,"called with jml=%p, handle_ptr=%p, key_ptr=%p, key_len=%u",
+			jml,handle_ptr,key_ptr,key_len);
 
-	if( !jml->lnk_list.usage )
+	if( !jml )
 	{
-		jmlist_debug(__func__,"trying to remove from empty list");
+		jmlist_debug(__func__,"invalid jml specified (jml=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
 		jmlist_debug(__func__,"returning with failure.");
-		jmlist_errno = JMLIST_ERROR_EMPTY_LIST;
 		return JMLIST_ERROR_FAILURE;
 	}
 
-	/* check bounds! */
-	if( index >= jml->lnk_list.usage )
+	if( ijmlist_shard_reject(jml,__func__) )
+		return JMLIST_ERROR_FAILURE;
+
+	if( !handle_ptr || !key_ptr || !key_len || !ijmlist_ass_key_valid(jml,key_ptr,key_len) ) {
+		jmlist_debug(__func__,"invalid arguments specified (handle_ptr=%p, key_ptr=%p, key_len=%u)",handle_ptr,key_ptr,key_len);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( !(jml->flags & JMLIST_ASSOCIATIVE) )
 	{
-		jmlist_debug(__func__,"index %u is out of bounds with list jml=%p which has %u entries",index,jml,jml->lnk_list.usage);
-		jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
-		jmlist_debug(__func__,"returning with failure");
+		jmlist_debug(__func__,"key seeking is only supported in associative lists (jml=%p, flags=%u)",jml,jml->flags);
+		jmlist_errno = JMLIST_ERROR_UNSUPPORTED;
+		jmlist_debug(__func__,"returning with failure.");
 		return JMLIST_ERROR_FAILURE;
 	}
 
-	jmlist_debug(__func__,"seeking for index=%u in the linked list",index);
+	handle_ptr->started = true;
+	handle_ptr->ranged = true;
+	handle_ptr->current.valid = false;
+	ijmlist_seek_release(handle_ptr);
+	handle_ptr->generation = jml->generation;
+	jmlist_debug(__func__,"seek started at list generation %u",handle_ptr->generation);
 
-	jmlist_index index_seeker = 0;	
-	linked_entry *pseeker = jml->lnk_list.phead;
-	linked_entry *pprevious = pseeker;
-	while( pseeker )
+	if( jml->flags & JMLIST_ASS_ORDERED )
 	{
-		if( index_seeker != index )
-		{
-			pprevious = pseeker;
-			pseeker = pseeker->next;
-			index_seeker++;
-			continue;
-		}
-
-		jmlist_debug(__func__,"found entry with index=%u, pseeker=%p pseeker->next=%p",index,pseeker,pseeker->next);
+		ijmlist_bpt_seek_range(jml,handle_ptr,key_ptr,key_len,key_ptr,key_len);
+		handle_ptr->pos.next_bpt.hi_incl = true;
+		jmlist_debug(__func__,"returning with success.");
+		return JMLIST_ERROR_SUCCESS;
+	}
 
-		if( pprevious == pseeker )
-		{
-			/* we're at HEAD */
-			jmlist_debug(__func__,"entry is from head, lets pop it instead...");
-			void *junk;
-			return ijmlist_lnk_pop(jml,&junk);
-		}
+	handle_ptr->pos.next_key.entry = jml->ass_list.usage ? ijmlist_ass_key_group(jml,key_ptr,key_len) : 0;
+	handle_ptr->pos.next_key.by_key = true;
+	jmlist_debug(__func__,"handle set to entry=%p",handle_ptr->pos.next_key.entry);
 
-		jmlist_debug(__func__,"unlinking entry with index=%u",index);
-		pprevious->next = pseeker->next;
-		jml->lnk_list.usage--;
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
 
-		jmlist_debug(__func__,"unlinked successfuly, new usage is %u, freeing entry structure",jml->lnk_list.usage);
-		free(pseeker);
+/*
+ * next entry of a key seek on an unordered list, entries of the key follow
+ * each other in the hash chain.
+ */
+jmlist_status
+ijmlist_ass_seek_key_next(jmlist jml,jmlist_seek_handle *handle_ptr,void **ptr)
+{
+	assoc_entry *pentry = handle_ptr->pos.next_key.entry;
+	assoc_entry *pnext;
 
-		jmlist_mem.lnk_list.total -= sizeof(struct _linked_entry);
-		jmlist_mem.lnk_list.used -= sizeof(struct _linked_entry);
-		jmlist_debug(__func__,"new jml_mem.lnk_list.total is %u",jmlist_mem.lnk_list.total);
-		jmlist_debug(__func__,"new jml_mem.lnk_list.used is %u",jmlist_mem.lnk_list.used);
+	jmlist_debug(__func__,"called with jml=%p, handle_ptr=%p and ptr=%p",jml,handle_ptr,ptr);
 
-		jmlist_debug(__func__,"returning with success.");
-		return JMLIST_ERROR_SUCCESS;
+	pentry = ijmlist_ass_first_live(jml,pentry);
+	if( !pentry )
+	{
+		jmlist_debug(__func__,"there are no more entries to seek (reached the last entry of the key)");
+		handle_ptr->pos.next_key.entry = 0;
+		jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
 	}
 
-	/* this shouldn't happen since the bounds were checked before! damaged list?? */
-	jmlist_debug(__func__,"unexpected error! couldn't find entry with index=%u in list jml=%p",index,jml);
-	jmlist_errno = JMLIST_ERROR_ENTRY_NOT_FOUND;
-	jmlist_debug(__func__,"returning with failure.");
-	return JMLIST_ERROR_FAILURE;
+	*ptr = pentry->ptr;
+	pnext = pentry->hnext;
+	handle_ptr->pos.next_key.entry = (pnext && ijmlist_ass_same_key(jml,pnext,pentry)) ? pnext : 0;
+	jmlist_debug(__func__,"updated handle to the next entry (new entry=%p)",handle_ptr->pos.next_key.entry);
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
 }
 
+/*
+   jmlist_seek_range
+
+   Starts seeking an ordered associative list (JMLIST_ASS_ORDERED) from the first
+   entry with key greater or equal than lo up to the last entry with key lower than
+   hi. If lo_ptr is 0 the seeking starts at the first entry, if hi_ptr is 0 it goes
+   up to the last. Entries are obtained with jmlist_seek_next and the seeking must
+   be finished with jmlist_seek_end, same as when it's started with jmlist_seek_start.
+*/
 jmlist_status
-ijmlist_ass_remove_by_index(jmlist jml,jmlist_index index)
+jmlist_seek_range(jmlist jml,jmlist_seek_handle *handle_ptr,jmlist_key lo_ptr,jmlist_key_length lo_len,
+		jmlist_key hi_ptr,jmlist_key_length hi_len)
 {
-	jmlist_debug(__func__,"called with jml=%p, index=%u",jml,index);
-	
-	if( !jml->ass_list.usage )
+	jmlist_debug(__func__,"called with jml=%p, handle_ptr=%p, lo_ptr=%p, lo_len=%u, hi_ptr=%p, hi_len=%u",
+			jml,handle_ptr,lo_ptr,lo_len,hi_ptr,hi_len);
+
+	if( !jml )
 	{
-		jmlist_debug(__func__,"cannot remove on empty list");
+		jmlist_debug(__func__,"invalid jml specified (jml=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
 		jmlist_debug(__func__,"returning with failure.");
-		jmlist_errno = JMLIST_ERROR_EMPTY_LIST;
 		return JMLIST_ERROR_FAILURE;
 	}
-	
-	/* check bounds! */
-	if( index >= jml->ass_list.usage )
-	{
-		jmlist_debug(__func__,"index %u is out of bounds with list jml=%p which has %u entries",index,jml,jml->ass_list.usage);
-		jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
-		jmlist_debug(__func__,"returning with failure");
+
+	if( ijmlist_shard_reject(jml,__func__) )
+		return JMLIST_ERROR_FAILURE;
+
+	if( !handle_ptr ) {
+		jmlist_debug(__func__,"invalid handle pointer specified (handle_ptr=0)");
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
 		return JMLIST_ERROR_FAILURE;
 	}
-	
-	jmlist_debug(__func__,"seeking associative list for indexed item %u",index);
-	
-	jmlist_index index_seeker = 0;
-	assoc_entry *pseeker = jml->ass_list.phead;
-	assoc_entry *pprevious = pseeker;
-	while( pseeker )
+
+	if( !(jml->flags & JMLIST_ASSOCIATIVE) || !(jml->flags & JMLIST_ASS_ORDERED) )
 	{
-		if( index_seeker != index )
-		{
-			pprevious = pseeker;
-			pseeker = pseeker->next;
-			index_seeker++;
-			continue;
-		}
-		
-		jmlist_debug(__func__,"found entry with index=%u, pseeker=%p pseeker->next=%p",index,pseeker,pseeker->next);
-		
-		if( pprevious == pseeker )
-		{
-			jmlist_debug(__func__,"entry is from head, lets pop it instead...");
-			
-			assoc_entry *pentry;
-			pentry = jml->ass_list.phead;
-			
-			jmlist_debug(__func__,"entry poped from head is jml=%p",pentry);
-			
-			jml->ass_list.phead = pentry->next;
-			
-			jmlist_debug(__func__,"new list head is phead=%p",pentry->next);
-			jmlist_debug(__func__,"freeing pentry=%p structure from memory",pentry);
-			
-			free(pentry);
-			
-			jml->ass_list.usage--;
-			jmlist_debug(__func__,"decreased usage to %u",jml->ass_list.usage);
-			
-			jmlist_mem.ass_list.total -= sizeof(struct _assoc_entry);
-			jmlist_mem.ass_list.used -= sizeof(struct _assoc_entry);
-			jmlist_debug(__func__,"new jml_mem.ass_list.total is %u",jmlist_mem.ass_list.total);
-			jmlist_debug(__func__,"new jml_mem.ass_list.used is %u",jmlist_mem.ass_list.used);
-			
-			jmlist_debug(__func__,"returning with success.");
-			return JMLIST_ERROR_SUCCESS;
-		}
-		
-		/* we're not at HEAD, remove entry normally... */
-		jmlist_debug(__func__,"unlinking entry");
-		pprevious->next = pseeker->next;
-		jml->ass_list.usage--;
-		
-		jmlist_mem.ass_list.total -= sizeof(struct _assoc_entry);
-		jmlist_mem.ass_list.used -= sizeof(struct _assoc_entry);
-		jmlist_debug(__func__,"new jml_mem.ass_list.total is %u",jmlist_mem.ass_list.total);
-		jmlist_debug(__func__,"new jml_mem.ass_list.used is %u",jmlist_mem.ass_list.used);
-		
-		jmlist_debug(__func__,"unlinked successfuly, new usage is %u, freeing entry",jml->ass_list.usage);
-		free(pseeker);
-		
-		jmlist_debug(__func__,"returning with success.");
-		return JMLIST_ERROR_SUCCESS;
+		jmlist_debug(__func__,"range seeking is only supported in ordered associative lists (jml=%p, flags=%u)",jml,jml->flags);
+		jmlist_errno = JMLIST_ERROR_UNSUPPORTED;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
 	}
-	
-	jmlist_debug(__func__,"couldn't find entry with index=%u in the list jml=%p",index,jml);
-	jmlist_errno = JMLIST_ERROR_ENTRY_NOT_FOUND;
-	jmlist_debug(__func__,"returning with failure.");
-	return JMLIST_ERROR_FAILURE;
+
+	handle_ptr->started = true;
+	handle_ptr->ranged = true;
+	handle_ptr->current.valid = false;
+	ijmlist_seek_release(handle_ptr);
+	handle_ptr->generation = jml->generation;
+	jmlist_debug(__func__,"seek started at list generation %u",handle_ptr->generation);
+
+	return ijmlist_bpt_seek_range(jml,handle_ptr,lo_ptr,lo_len,hi_ptr,hi_len);
 }
 
 /*
-   jmlist_replace_by_index
+   frozen ordered associative lists
 
-   In indexed lists, entry is of index=index is cleared and replaced with new_ptr, this is
-   done ignoring the indexed list flags of shifting and fragmented. In the case of linked
-   lists the next pointer of the previous entry is replaced by new_ptr and new_ptr->next
-   is set to old previous->next. Associative lists have equal behaviour of linked ones.
+   jmlist_freeze replaces the b+tree of an ordered list by one sorted array of
+   its entries (assoc_sorted). key searches descend an implicit binary tree in
+   eytzinger order over the key prefixes: node k is compared and the search
+   goes to 2k or 2k+1 without branching on the result, the subtree a few
+   levels below is prefetched while the current level is compared.
+*/
 
-   In all the 3 cases, no memory counters are changed.
+/*
+ * compares the entry at sorted position rank with the key.
+ */
+int
+ijmlist_sorted_compare(jmlist jml,jmlist_index rank,uint64_t pfx,jmlist_key key_ptr,jmlist_key_length key_len)
+{
+	assoc_sorted *sorted = jml->ass_list.sorted;
+	uint32_t k = sorted->node[rank];
 
-   The difference from replace and remove+insert is that the new_ptr will maintain the
-   index specified by the argument in all the 3 types of lists. Also replace is faster
-   because it doesn't do operations associated with insert or remove.
-*/
-jmlist_status
-jmlist_replace_by_index(jmlist jml,jmlist_index index,void *new_ptr)
+	return ijmlist_bpt_compare(jml,sorted->pfx[k],sorted->key_ptr[k],sorted->key_len[k],pfx,key_ptr,key_len);
+}
+
+/*
+ * returns the node of the first entry with key greater or equal than the key,
+ * or greater when upper is true, 0 when there's no such entry.
+ */
+uint32_t
+ijmlist_sorted_search(jmlist jml,uint64_t pfx,jmlist_key key_ptr,jmlist_key_length key_len,bool upper)
 {
-	jmlist_debug(__func__,"called with jml=%p, index=%u, new_ptr=%p",jml,index,new_ptr);
-	
-	if( jml->flags & JMLIST_INDEXED )
-	{
-		jmlist_debug(__func__,"passing control to indexed list replace_by_index routine.");
-		return ijmlist_idx_replace_by_index(jml,index,new_ptr);
-	} else if( jml->flags & JMLIST_LINKED )
+	assoc_sorted *sorted = jml->ass_list.sorted;
+	bool custom = (jml->ass_list.compare != 0);
+	uint64_t k = 1;
+	int r;
+
+	while( k <= sorted->count )
 	{
-		jmlist_debug(__func__,"passing control to linked list replace_by_index routine.");
-		return ijmlist_lnk_replace_by_index(jml,index,new_ptr);
-	} else if( jml->flags & JMLIST_ASSOCIATIVE )
+		if( (k << JMLIST_SORTED_PREFETCH_LEVELS) <= sorted->count )
+			JMLIST_PREFETCH(&sorted->pfx[k << JMLIST_SORTED_PREFETCH_LEVELS]);
+
+		if( custom || (sorted->pfx[k] == pfx) )
+			r = ijmlist_bpt_compare(jml,sorted->pfx[k],sorted->key_ptr[k],sorted->key_len[k],pfx,key_ptr,key_len);
+		else
+			r = (sorted->pfx[k] < pfx) ? -1 : 1;
+
+		k = 2*k + ((r < 0) || (upper && (r == 0)));
+	}
+
+	/* the bound is the last node where the search went to the left child,
+	   the right turns taken after it are the trailing 1 bits of k */
+	while( k & 1 )
+		k >>= 1;
+
+	return (uint32_t)(k >> 1);
+}
+
+/*
+ * returns the number of entries with key lower than the key, or lower or
+ * equal when upper is true (the sorted position of the first entry after them).
+ */
+jmlist_index
+ijmlist_sorted_bound(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,bool upper)
+{
+	uint32_t k = ijmlist_sorted_search(jml,ijmlist_bpt_prefix(key_ptr,key_len),key_ptr,key_len,upper);
+
+	return k ? jml->ass_list.sorted->rank[k] : jml->ass_list.sorted->count;
+}
+
+/*
+ * finds the node of the first entry with the key.
+ */
+jmlist_status
+ijmlist_sorted_find_key(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,jmlist_index *node)
+{
+	assoc_sorted *sorted = jml->ass_list.sorted;
+	uint64_t pfx = ijmlist_bpt_prefix(key_ptr,key_len);
+
+	*node = ijmlist_sorted_search(jml,pfx,key_ptr,key_len,false);
+
+	if( !*node || ijmlist_bpt_compare(jml,sorted->pfx[*node],sorted->key_ptr[*node],sorted->key_len[*node],pfx,key_ptr,key_len) )
 	{
-		jmlist_debug(__func__,"passing control to the associative list replace_by_index routine.");
-		return ijmlist_ass_replace_by_index(jml,index,new_ptr);
+		jmlist_debug(__func__,"couldn't find entry with key_ptr=%p key_len=%u in list jml=%p",key_ptr,key_len,jml);
+		jmlist_errno = JMLIST_ERROR_ENTRY_NOT_FOUND;
+		return JMLIST_ERROR_FAILURE;
 	}
-	
-	jmlist_debug(__func__,"invalid or unsupported list type (jml=%p, flags=%u)",jml,jml->flags);
-	jmlist_debug(__func__,"returning with failure.");
-	jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-	return JMLIST_ERROR_FAILURE;
+
+	jmlist_debug(__func__,"found key_ptr=%p key_len=%u in node %u",key_ptr,key_len,*node);
+	return JMLIST_ERROR_SUCCESS;
 }
 
 jmlist_status
-ijmlist_idx_replace_by_index(jmlist jml,jmlist_index index,void *new_ptr)
+ijmlist_sorted_freeze(jmlist jml)
 {
-	jmlist_debug(__func__,"called with jml=%p, index=%u",jml,index);
+	assoc_sorted *sorted;
+	bpt_node *leaf;
+	jmlist_index count = jml->ass_list.usage;
+	jmlist_index i,j;
+	uint64_t k;
+	size_t size;
 
-	if( !jml->idx_list.usage )
+	jmlist_debug(__func__,"called with jml=%p",jml);
+
+	/* one block, pfx is aligned to a cache line so the 8 nodes prefetched
+	   together (8k to 8k+7) are in the same line */
+	size = sizeof(assoc_sorted) + 64 + (count+1)*(sizeof(uint64_t) + sizeof(jmlist_key) + sizeof(void*) +
+			sizeof(jmlist_key_length) + sizeof(uint32_t)) + count*sizeof(uint32_t);
+	sorted = (assoc_sorted*)malloc(size);
+	if( !sorted )
 	{
-		jmlist_debug(__func__,"cannot replace by index on empty list (lnk_list.usage=0)");
+		jmlist_debug(__func__,"malloc failed (size %u)!",size);
+		jmlist_errno = JMLIST_ERROR_MALLOC;
 		jmlist_debug(__func__,"returning with failure.");
-		jmlist_errno = JMLIST_ERROR_EMPTY_LIST;
 		return JMLIST_ERROR_FAILURE;
 	}
 
-	/* shouldn't use get on a fragmented idx list */
-	if( !(jml->flags & JMLIST_IDX_USE_SHIFT) )
+	sorted->count = count;
+	sorted->size = size;
+	sorted->pfx = (uint64_t*)(((uintptr_t)(sorted + 1) + 63) & ~(uintptr_t)63);
+	sorted->key_ptr = (jmlist_key*)(sorted->pfx + count + 1);
+	sorted->ptr = (void**)(sorted->key_ptr + count + 1);
+	sorted->key_len = (jmlist_key_length*)(sorted->ptr + count + 1);
+	sorted->rank = (uint32_t*)(sorted->key_len + count + 1);
+	sorted->node = sorted->rank + count + 1;
+
+	/* an in-order walk of the implicit tree visits the nodes in sorted
+	   order, it starts at the leftmost node */
+	for( k = 1 ; 2*k <= count ; k *= 2 );
+	for( i = 0 ; i < count ; i++ )
 	{
-		/* check for fragmentation */
-		bool fragmented = false;
-		if( jmlist_is_fragmented(jml,false,&fragmented) == JMLIST_ERROR_FAILURE )
-			return JMLIST_ERROR_FAILURE;
+		sorted->node[i] = (uint32_t)k;
+		sorted->rank[k] = i;
 
-		if( fragmented == true )
+		if( 2*k+1 <= count )
 		{
-			jmlist_debug(__func__,"cannot use this function with possible fragmented indexed lists, use of JMLIST_IDX_USE_SHIFT is required");
-			jmlist_errno = JMLIST_ERROR_FAILURE;
-			jmlist_debug(__func__,"returning with failure.");
-			return JMLIST_ERROR_FAILURE;
+			for( k = 2*k+1 ; 2*k <= count ; k *= 2 );
+		} else
+		{
+			while( k & 1 )
+				k >>= 1;
+			k >>= 1;
 		}
 	}
 
-	/* check bounds */
-	if( index >= jml->idx_list.usage )
+	/* the leaves have the entries in order, duplicates in insertion order */
+	i = 0;
+	for( leaf = ijmlist_bpt_first_leaf(jml) ; leaf ; leaf = leaf->next )
 	{
-		jmlist_debug(__func__,"index %u is out of bounds with list jml=%p which has %u entries",index,jml,jml->idx_list.usage);
-		jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
-		jmlist_debug(__func__,"returning with failure");
+		for( j = 0 ; (j < leaf->count) && (i < count) ; j++, i++ )
+		{
+			k = sorted->node[i];
+			sorted->pfx[k] = leaf->key_pfx[j];
+			sorted->key_ptr[k] = leaf->key_ptr[j];
+			sorted->key_len[k] = leaf->key_len[j];
+			sorted->ptr[k] = leaf->u.ptr[j];
+		}
+	}
+
+	if( i != count )
+	{
+		jmlist_debug(__func__,"b+tree has %u entries but usage is %u, damaged list?",i,count);
+		free(sorted);
+		jmlist_errno = JMLIST_ERROR_DAMAGED_LIST;
+		jmlist_debug(__func__,"returning with failure.");
 		return JMLIST_ERROR_FAILURE;
 	}
 
-	/* remove the entry... */
-	jmlist_debug(__func__,"setting entry ptr (now %p) to new_ptr=%p from list %p in index %u",jml->idx_list.plist[index],new_ptr,jml,index);
+	/* the entries are in the sorted array, the b+tree isn't needed anymore */
+	if( jml->ass_list.root )
+		ijmlist_bpt_free_node(jml->ass_list.root);
+	jml->ass_list.root = 0;
 
-	/* found the entry, replace it */
-	jml->idx_list.plist[index] = new_ptr;
+	jmlist_mem.ass_list.total += size;
+	jmlist_mem.ass_list.used += size;
+	jmlist_debug(__func__,"new jml_mem.ass_list.total is %u",jmlist_mem.ass_list.total);
+	jmlist_debug(__func__,"new jml_mem.ass_list.used is %u",jmlist_mem.ass_list.used);
+
+	jml->ass_list.sorted = sorted;
+	jmlist_debug(__func__,"list jml=%p frozen with %u entries in sorted array %p",jml,count,sorted);
 
-	jmlist_debug(__func__,"entry with index %u replaced from list %p successfully, new entry has ptr=%p",index,jml,jml->idx_list.plist[index]);
 	jmlist_debug(__func__,"returning with success.");
 	return JMLIST_ERROR_SUCCESS;
 }
 
+/*
+ * rebuilds the b+tree of a frozen ordered list, inserting the entries in
+ * order keeps the duplicates in the same order.
+ */
 jmlist_status
-ijmlist_lnk_replace_by_index(jmlist jml,jmlist_index index,void *new_ptr)
+ijmlist_sorted_thaw(jmlist jml)
 {
-	jmlist_debug(__func__,"called with jml=%p, index=%u",jml,index);
+	assoc_sorted *sorted = jml->ass_list.sorted;
+	jmlist_index i;
+	uint32_t k;
 
-	if( !jml->lnk_list.usage )
+	jmlist_debug(__func__,"called with jml=%p",jml);
+
+	jml->ass_list.usage = 0;
+	for( i = 0 ; i < sorted->count ; i++ )
 	{
-		jmlist_debug(__func__,"trying to replace from empty list");
-		jmlist_debug(__func__,"returning with failure.");
-		jmlist_errno = JMLIST_ERROR_EMPTY_LIST;
-		return JMLIST_ERROR_FAILURE;
+		k = sorted->node[i];
+		if( ijmlist_bpt_insert(jml,sorted->key_ptr[k],sorted->key_len[k],sorted->ptr[k]) == JMLIST_ERROR_FAILURE )
+			break;
 	}
 
-	/* check bounds! */
-	if( index >= jml->lnk_list.usage )
+	if( i < sorted->count )
 	{
-		jmlist_debug(__func__,"index %u is out of bounds with list jml=%p which has %u entries",index,jml,jml->lnk_list.usage);
-		jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
-		jmlist_debug(__func__,"returning with failure");
+		jmlist_debug(__func__,"failed to insert entry %u in the new b+tree, list stays frozen",i);
+		if( jml->ass_list.root )
+			ijmlist_bpt_free_node(jml->ass_list.root);
+		jml->ass_list.root = 0;
+		jml->ass_list.usage = sorted->count;
+		jmlist_debug(__func__,"returning with failure.");
 		return JMLIST_ERROR_FAILURE;
 	}
 
-	jmlist_debug(__func__,"seeking for index=%u in the linked list",index);
+	ijmlist_sorted_free(sorted);
+	jml->ass_list.sorted = 0;
+	jmlist_debug(__func__,"new jml_mem.ass_list.total is %u",jmlist_mem.ass_list.total);
+	jmlist_debug(__func__,"new jml_mem.ass_list.used is %u",jmlist_mem.ass_list.used);
 
-	jmlist_index index_seeker = 0;	
-	linked_entry *pseeker = jml->lnk_list.phead;
-	linked_entry *pprevious = pseeker;
-	while( pseeker )
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+void
+ijmlist_sorted_free(assoc_sorted *sorted)
+{
+	jmlist_mem.ass_list.total -= sorted->size;
+	jmlist_mem.ass_list.used -= sorted->size;
+	free(sorted);
+}
+
+/*
+ * finds the entry with the nearest key below (or above) the key, also the
+ * entry with the key when inclusive is true. the first entry of a duplicate
+ * key is returned, same as jmlist_get_by_key.
+ */
+jmlist_status
+ijmlist_ass_get_nearest(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,bool below,bool inclusive,
+		jmlist_key *found_ptr,jmlist_key_length *found_len,void **ptr)
+{
+	assoc_sorted *sorted = jml->ass_list.sorted;
+	uint64_t pfx = ijmlist_bpt_prefix(key_ptr,key_len);
+	bool upper = (below == inclusive);
+	bpt_node *leaf = 0;
+	jmlist_index slot;
+	uint32_t k;
+
+	jmlist_debug(__func__,"called with jml=%p, key_ptr=%p, key_len=%u, below=%u, inclusive=%u",
+			jml,key_ptr,key_len,below,inclusive);
+
+	if( sorted )
 	{
-		if( index_seeker != index )
+		slot = ijmlist_sorted_bound(jml,key_ptr,key_len,upper);
+		if( below && slot )
 		{
-			pprevious = pseeker;
-			pseeker = pseeker->next;
-			index_seeker++;
-			continue;
+			k = sorted->node[slot-1];
+			k = ijmlist_sorted_search(jml,sorted->pfx[k],sorted->key_ptr[k],sorted->key_len[k],false);
+		} else
+		{
+			k = (below || (slot == sorted->count)) ? 0 : sorted->node[slot];
 		}
 
-		jmlist_debug(__func__,"found entry with index=%u, pseeker=%p pseeker->next=%p",index,pseeker,pseeker->next);
+		if( !k )
+		{
+			jmlist_debug(__func__,"there's no entry %s the key in list jml=%p",below ? "below" : "above",jml);
+			jmlist_errno = JMLIST_ERROR_ENTRY_NOT_FOUND;
+			jmlist_debug(__func__,"returning with failure.");
+			return JMLIST_ERROR_FAILURE;
+		}
 
-		jmlist_debug(__func__,"replacing old ptr=%p with new_ptr=%p",pseeker->ptr,new_ptr);
-		pseeker->ptr = new_ptr;
-		jmlist_debug(__func__,"new entry ptr of index=%u is ptr=%p",index,pseeker->ptr);
+		if( found_ptr )
+			*found_ptr = sorted->key_ptr[k];
+		if( found_len )
+			*found_len = sorted->key_len[k];
+		*ptr = sorted->ptr[k];
 
+		jmlist_debug(__func__,"found entry in node %u with ptr=%p",k,*ptr);
 		jmlist_debug(__func__,"returning with success.");
 		return JMLIST_ERROR_SUCCESS;
 	}
 
-	/* this shouldn't happen since the bounds were checked before! damaged list?? */
-	jmlist_debug(__func__,"unexpected error! couldn't find entry with index=%u in list jml=%p",index,jml);
-	jmlist_errno = JMLIST_ERROR_ENTRY_NOT_FOUND;
-	jmlist_debug(__func__,"returning with failure.");
-	return JMLIST_ERROR_FAILURE;
+	if( jml->ass_list.root )
+	{
+		leaf = ijmlist_bpt_find_leaf(jml,pfx,key_ptr,key_len,upper);
+		slot = ijmlist_bpt_node_search(jml,leaf,pfx,key_ptr,key_len,upper);
+
+		if( below )
+		{
+			/* step back to the entry before the bound, then to the first
+			   entry with its key */
+			if( !slot )
+			{
+				leaf = leaf->prev;
+				slot = leaf ? leaf->count : 0;
+			}
+			if( leaf )
+				ijmlist_bpt_lower_bound(jml,leaf->key_ptr[slot-1],leaf->key_len[slot-1],&leaf,&slot);
+		} else if( slot >= leaf->count )
+		{
+			leaf = leaf->next;
+			slot = 0;
+		}
+	}
+
+	if( !leaf )
+	{
+		jmlist_debug(__func__,"there's no entry %s the key in list jml=%p",below ? "below" : "above",jml);
+		jmlist_errno = JMLIST_ERROR_ENTRY_NOT_FOUND;
+		jmlist_debug(__func__,"returning with failure.");
+		return JMLIST_ERROR_FAILURE;
+	}
+
+	if( found_ptr )
+		*found_ptr = leaf->key_ptr[slot];
+	if( found_len )
+		*found_len = leaf->key_len[slot];
+	*ptr = leaf->u.ptr[slot];
+
+	jmlist_debug(__func__,"found entry in leaf %p slot %u with ptr=%p",leaf,slot,*ptr);
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
 }
 
+/*
+   jmlist_get_floor
+
+   Obtains the entry of an ordered associative list (JMLIST_ASS_ORDERED) with
+   the greatest key lower than the key (the predecessor), or lower or equal when
+   inclusive is true. found_ptr and found_len, when not 0, are set to the key
+   of the entry. Fails with JMLIST_ERROR_ENTRY_NOT_FOUND when there's none.
+*/
 jmlist_status
-ijmlist_ass_replace_by_index(jmlist jml,jmlist_index index,void *new_ptr)
+jmlist_get_floor(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,bool inclusive,
+		jmlist_key *found_ptr,jmlist_key_length *found_len,void **ptr)
 {
-	jmlist_debug(__func__,"called with jml=%p, index=%u",jml,index);
-	
-	if( !jml->ass_list.usage )
+	jmlist_debug(__func__,"called with jml=%p, key_ptr=%p, key_len=%u, inclusive=%u, ptr=%p",
+			jml,key_ptr,key_len,inclusive,ptr);
+
+	if( !jml || !key_ptr || !key_len || !ptr )
 	{
-		jmlist_debug(__func__,"cannot remove on empty list");
+		jmlist_debug(__func__,"invalid arguments specified (jml=%p, key_ptr=%p, key_len=%u, ptr=%p)",jml,key_ptr,key_len,ptr);
+		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
 		jmlist_debug(__func__,"returning with failure.");
-		jmlist_errno = JMLIST_ERROR_EMPTY_LIST;
 		return JMLIST_ERROR_FAILURE;
 	}
-	
-	/* check bounds! */
-	if( index >= jml->ass_list.usage )
+
+	if( !(jml->flags & JMLIST_ASSOCIATIVE) || !(jml->flags & JMLIST_ASS_ORDERED) )
 	{
-		jmlist_debug(__func__,"index %u is out of bounds with list jml=%p which has %u entries",index,jml,jml->ass_list.usage);
-		jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
-		jmlist_debug(__func__,"returning with failure");
+		jmlist_debug(__func__,"floor lookups are only supported in ordered associative lists (jml=%p, flags=%u)",jml,jml->flags);
+		jmlist_errno = JMLIST_ERROR_UNSUPPORTED;
+		jmlist_debug(__func__,"returning with failure.");
 		return JMLIST_ERROR_FAILURE;
 	}
-	
-	jmlist_debug(__func__,"seeking associative list for indexed item %u",index);
-	
-	jmlist_index index_seeker = 0;
-	assoc_entry *pseeker = jml->ass_list.phead;
-	assoc_entry *pprevious = pseeker;
-	while( pseeker )
-	{
-		if( index_seeker != index )
-		{
-			pprevious = pseeker;
-			pseeker = pseeker->next;
-			index_seeker++;
-			continue;
-		}
-		
-		jmlist_debug(__func__,"found entry with index=%u, pseeker=%p pseeker->next=%p",index,pseeker,pseeker->next);
-
-		jmlist_debug(__func__,"replacing old ptr=%p with new_ptr=%p",pseeker->ptr,new_ptr);
-		pseeker->ptr = new_ptr;
-		jmlist_debug(__func__,"new entry ptr of index=%u is ptr=%p",index,pseeker->ptr);
 
-		jmlist_debug(__func__,"returning with success.");
-		return JMLIST_ERROR_SUCCESS;
-	}
-	
-	jmlist_debug(__func__,"couldn't find entry with index=%u in the list jml=%p",index,jml);
-	jmlist_errno = JMLIST_ERROR_ENTRY_NOT_FOUND;
-	jmlist_debug(__func__,"returning with failure.");
-	return JMLIST_ERROR_FAILURE;
+	return ijmlist_ass_get_nearest(jml,key_ptr,key_len,true,inclusive,found_ptr,found_len,ptr);
 }
 
 /*
-   jmlist_seek_start
-
-   Start seeking in a list, the fastest seeking process is different depending on the
-   list type thats why jmlist_seek_* routines were coded. There should be passed a pointer
-   to a seek_handle_t structure memory space which will be used to identify the seeking.
+   jmlist_get_ceiling
 
-   Only single-seeking is supported at the time, a seeking finishes by calling the
-   function jmlist_seek_end. That will allow other seeks to be done.
+   Obtains the entry of an ordered associative list (JMLIST_ASS_ORDERED) with
+   the lowest key greater than the key (the successor), or greater or equal when
+   inclusive is true. found_ptr and found_len, when not 0, are set to the key
+   of the entry. Fails with JMLIST_ERROR_ENTRY_NOT_FOUND when there's none.
 */
 jmlist_status
-jmlist_seek_start(jmlist jml,jmlist_seek_handle *handle_ptr)
+jmlist_get_ceiling(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,bool inclusive,
+		jmlist_key *found_ptr,jmlist_key_length *found_len,void **ptr)
 {
-	jmlist_debug(__func__,"called with jml=%p and handle=%p",jml,handle_ptr);
+	jmlist_debug(__func__,"called with jml=%p, key_ptr=%p, key_len=%u, inclusive=%u, ptr=%p",
+			jml,key_ptr,key_len,inclusive,ptr);
 
-	if( !jml )
+	if( !jml || !key_ptr || !key_len || !ptr )
 	{
-		jmlist_debug(__func__,"invalid jml specified (jml=0)");
+		jmlist_debug(__func__,"invalid arguments specified (jml=%p, key_ptr=%p, key_len=%u, ptr=%p)",jml,key_ptr,key_len,ptr);
 		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
 		jmlist_debug(__func__,"returning with failure.");
 		return JMLIST_ERROR_FAILURE;
 	}
 
-	if( !handle_ptr ) {
-		jmlist_debug(__func__,"invalid handle pointer specified (handle_ptr=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+	if( !(jml->flags & JMLIST_ASSOCIATIVE) || !(jml->flags & JMLIST_ASS_ORDERED) )
+	{
+		jmlist_debug(__func__,"ceiling lookups are only supported in ordered associative lists (jml=%p, flags=%u)",jml,jml->flags);
+		jmlist_errno = JMLIST_ERROR_UNSUPPORTED;
 		jmlist_debug(__func__,"returning with failure.");
 		return JMLIST_ERROR_FAILURE;
 	}
 
-	if( jml->seeking == true ) {
-		jmlist_debug(__func__,"multiple concorrent seeks are not supported yet");
-		jmlist_errno = JMLIST_ERROR_UNSUPPORTED;
+	return ijmlist_ass_get_nearest(jml,key_ptr,key_len,false,inclusive,found_ptr,found_len,ptr);
+}
+
+/*
+   concurrent associative lists
+
+   When JMLIST_ASS_CONCURRENT is set the list doesn't hold entries itself, the
+   keys are spread over shard_count unordered associative lists (the shards)
+   by the high bits of their hash, the hash index of each shard uses the low
+   bits. every call takes the lock of the shard of the key and runs the usual
+   associative routine on it. while the lock is held the memory counters of
+   the thread point to the ones of the shard, so jmlist_mem is never updated
+   by two threads at once and each shard accounts its own memory.
+*/
+
+/*
+ * creates the shards of a new concurrent list.
+ */
+jmlist_status
+ijmlist_shard_init(jmlist jml,jmlist_params *params)
+{
+	struct _jmlist_memory_info *prev;
+	jmlist_params shard_params;
+	jmlist_status status;
+	uint32_t shard_count;
+	uint32_t i;
+
+	jmlist_debug(__func__,"called with jml=%p, params=%p",jml,params);
+
+	shard_count = params->ass_list.shards ? params->ass_list.shards : JMLIST_ASS_DEF_SHARDS;
+
+	/* the list itself only needs the key width and hash of the shards */
+	shard_params = *params;
+	shard_params.flags &= ~(JMLIST_ASS_CONCURRENT | JMLIST_ASS_FILTER);
+	ijmlist_ass_init(jml,&shard_params);
+
+	jml->ass_list.shards = (assoc_shard*)calloc(shard_count,sizeof(assoc_shard));
+	if( !jml->ass_list.shards )
+	{
+		jmlist_debug(__func__,"calloc failed (size %u)!",shard_count*sizeof(assoc_shard));
+		jmlist_errno = JMLIST_ERROR_MALLOC;
 		jmlist_debug(__func__,"returning with failure.");
 		return JMLIST_ERROR_FAILURE;
 	}
 
-	/* set seeking flag */
-	jml->seeking = true;
-	jmlist_debug(__func__,"seek flag was set to %u",jml->seeking);
+	jmlist_mem.ass_list.total += shard_count*sizeof(assoc_shard);
+	jmlist_mem.ass_list.used += shard_count*sizeof(assoc_shard);
+	jmlist_debug(__func__,"new jml_mem.ass_list.total is %u",jmlist_mem.ass_list.total);
+	jmlist_debug(__func__,"new jml_mem.ass_list.used is %u",jmlist_mem.ass_list.used);
 
-	/* clear handle data for the specific list type */
+	jml->ass_list.shard_count = shard_count;
 
-	if( jml->flags & JMLIST_INDEXED )
-	{
-		jmlist_debug(__func__,"passing control to indexed list seek_init routine.");
-		return ijmlist_idx_seek_start(jml,handle_ptr);
-	} else if( jml->flags & JMLIST_LINKED )
-	{
-		jmlist_debug(__func__,"passing control to linked list seek_init routine.");
-		return ijmlist_lnk_seek_start(jml,handle_ptr);
-	} else if( jml->flags & JMLIST_ASSOCIATIVE )
+	shard_params.flags = params->flags & ~JMLIST_ASS_CONCURRENT;
+	for( i = 0 ; i < shard_count ; i++ )
 	{
-		jmlist_debug(__func__,"passing control to the associative list seek_init routine.");
-		return ijmlist_ass_seek_start(jml,handle_ptr);
+		pthread_mutex_init(&jml->ass_list.shards[i].lock,0);
+		jml->ass_list.shards[i].list.flags = shard_params.flags;
+
+		prev = jmlist_mem_cur;
+		jmlist_mem_cur = &jml->ass_list.shards[i].mem;
+		status = ijmlist_ass_init(&jml->ass_list.shards[i].list,&shard_params);
+		jmlist_mem_cur = prev;
+
+		if( status == JMLIST_ERROR_FAILURE )
+		{
+			/* only the filters of the shards before this one were allocated */
+			pthread_mutex_destroy(&jml->ass_list.shards[i].lock);
+			while( i-- )
+			{
+				if( jml->ass_list.shards[i].list.ass_list.filter )
+					free(jml->ass_list.shards[i].list.ass_list.filter);
+				pthread_mutex_destroy(&jml->ass_list.shards[i].lock);
+			}
+			free(jml->ass_list.shards);
+			jml->ass_list.shards = 0;
+			jmlist_mem.ass_list.total -= shard_count*sizeof(assoc_shard);
+			jmlist_mem.ass_list.used -= shard_count*sizeof(assoc_shard);
+
+			jmlist_debug(__func__,"returning with failure.");
+			return JMLIST_ERROR_FAILURE;
+		}
 	}
 
-	jmlist_debug(__func__,"invalid or unsupported list type (jml=%p, flags=%u)",jml,jml->flags);
-	jmlist_debug(__func__,"returning with failure.");
-	jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-	return JMLIST_ERROR_FAILURE;
+	jmlist_debug(__func__,"list jml=%p has %u shards",jml,shard_count);
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
 }
 
-jmlist_status
-ijmlist_idx_seek_start(jmlist jml,jmlist_seek_handle *handle_ptr)
+/*
+ * returns the shard of a key. invalid keys go to the first shard, its
+ * routine reports the error.
+ */
+assoc_shard *
+ijmlist_shard_of(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len)
 {
-	jmlist_debug(__func__,"called with jml=%p and handle=%p",jml,handle_ptr);
+	uint32_t hash;
 
-	if( !jml )
-	{
-		jmlist_debug(__func__,"invalid jml specified (jml=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-		jmlist_debug(__func__,"returning with failure.");
-		return JMLIST_ERROR_FAILURE;
-	}
+	if( !key_ptr || !key_len || !ijmlist_ass_key_valid(jml,key_ptr,key_len) )
+		return &jml->ass_list.shards[0];
 
-	if( !handle_ptr ) {
-		jmlist_debug(__func__,"invalid handle pointer specified (handle_ptr=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-		jmlist_debug(__func__,"returning with failure.");
-		return JMLIST_ERROR_FAILURE;
-	}
+	hash = jml->ass_list.hash(key_ptr,key_len);
+	return &jml->ass_list.shards[((uint64_t)hash*jml->ass_list.shard_count) >> 32];
+}
+
+/*
+ * locks a shard and makes the calling thread account memory in it, returns
+ * the memory counters to restore with ijmlist_shard_leave.
+ */
+struct _jmlist_memory_info *
+ijmlist_shard_enter(assoc_shard *shard)
+{
+	struct _jmlist_memory_info *prev;
+
+	pthread_mutex_lock(&shard->lock);
+	prev = jmlist_mem_cur;
+	jmlist_mem_cur = &shard->mem;
+	return prev;
+}
+
+void
+ijmlist_shard_leave(assoc_shard *shard,struct _jmlist_memory_info *prev)
+{
+	jmlist_mem_cur = prev;
+	pthread_mutex_unlock(&shard->lock);
+}
+
+/*
+ * calls that need the whole list (positions, seeking, ptr lookups) fail on
+ * concurrent lists.
+ */
+bool
+ijmlist_shard_reject(jmlist jml,const char *func)
+{
+	if( !(jml->flags & JMLIST_ASSOCIATIVE) || !jml->ass_list.shards )
+		return false;
+
+	jmlist_debug(func,"unsupported call for concurrent list jml=%p",jml);
+	jmlist_errno = JMLIST_ERROR_UNSUPPORTED;
+	jmlist_debug(func,"returning with failure.");
+	return true;
+}
+
+jmlist_status
+ijmlist_shard_insert(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,void *ptr,jmlist_position pos)
+{
+	struct _jmlist_memory_info *prev;
+	assoc_shard *shard = ijmlist_shard_of(jml,key_ptr,key_len);
+	jmlist_status jmls;
 
-	handle_ptr->next_idx = 0;
-	jmlist_debug(__func__,"handle index set to %u",handle_ptr->next_idx);
+	prev = ijmlist_shard_enter(shard);
+	jmls = ijmlist_ass_insert_at(&shard->list,key_ptr,key_len,ptr,pos);
+	ijmlist_shard_leave(shard,prev);
 
-	jmlist_debug(__func__,"returning with success.");
-	return JMLIST_ERROR_SUCCESS;
+	return jmls;
 }
 
 jmlist_status
-ijmlist_lnk_seek_start(jmlist jml,jmlist_seek_handle *handle_ptr)
+ijmlist_shard_get_by_key(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,void **ptr)
 {
-	jmlist_debug(__func__,"called with jml=%p and handle=%p",jml,handle_ptr);
-
-	if( !jml )
-	{
-		jmlist_debug(__func__,"invalid jml specified (jml=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-		jmlist_debug(__func__,"returning with failure.");
-		return JMLIST_ERROR_FAILURE;
-	}
+	struct _jmlist_memory_info *prev;
+	assoc_shard *shard = ijmlist_shard_of(jml,key_ptr,key_len);
+	jmlist_status jmls;
 
-	if( !handle_ptr ) {
-		jmlist_debug(__func__,"invalid handle pointer specified (handle_ptr=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-		jmlist_debug(__func__,"returning with failure.");
-		return JMLIST_ERROR_FAILURE;
-	}
+	prev = ijmlist_shard_enter(shard);
+	jmls = ijmlist_ass_get_by_key(&shard->list,key_ptr,key_len,ptr);
+	ijmlist_shard_leave(shard,prev);
 
-	handle_ptr->next_lnk = jml->lnk_list.phead;
-	jmlist_debug(__func__,"handle next_lnk set to %p",handle_ptr->next_lnk);
+	/* an empty shard doesn't mean an empty list */
+	if( (jmls == JMLIST_ERROR_FAILURE) && (jmlist_errno == JMLIST_ERROR_EMPTY_LIST) )
+		jmlist_errno = JMLIST_ERROR_ENTRY_NOT_FOUND;
 
-	jmlist_debug(__func__,"returning with success.");
-	return JMLIST_ERROR_SUCCESS;
+	return jmls;
 }
 
 jmlist_status
-ijmlist_ass_seek_start(jmlist jml,jmlist_seek_handle *handle_ptr)
+ijmlist_shard_key_exists(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,jmlist_lookup_result *result)
 {
-	jmlist_debug(__func__,"called with jml=%p and handle=%p",jml,handle_ptr);
+	struct _jmlist_memory_info *prev;
+	assoc_shard *shard = ijmlist_shard_of(jml,key_ptr,key_len);
+	jmlist_status jmls;
 
-	if( !jml )
+	prev = ijmlist_shard_enter(shard);
+	jmls = ijmlist_ass_key_exists(&shard->list,key_ptr,key_len,result);
+	ijmlist_shard_leave(shard,prev);
+
+	/* an empty shard doesn't mean an empty list */
+	if( (jmls == JMLIST_ERROR_FAILURE) && (jmlist_errno == JMLIST_ERROR_EMPTY_LIST) )
 	{
-		jmlist_debug(__func__,"invalid jml specified (jml=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-		jmlist_debug(__func__,"returning with failure.");
-		return JMLIST_ERROR_FAILURE;
+		*result = jmlist_entry_not_found;
+		jmlist_errno = JMLIST_ERROR_ENTRY_NOT_FOUND;
 	}
 
-	if( !handle_ptr ) {
-		jmlist_debug(__func__,"invalid handle pointer specified (handle_ptr=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-		jmlist_debug(__func__,"returning with failure.");
-		return JMLIST_ERROR_FAILURE;
-	}
+	return jmls;
+}
+
+jmlist_status
+ijmlist_shard_get_all_by_key(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,void **out_ptrs,
+		jmlist_index cap,jmlist_index *n)
+{
+	struct _jmlist_memory_info *prev;
+	assoc_shard *shard = ijmlist_shard_of(jml,key_ptr,key_len);
+	jmlist_status jmls;
 
-	handle_ptr->next_ass = jml->ass_list.phead;
-	jmlist_debug(__func__,"handle next_ass set to %p",handle_ptr->next_ass);
+	prev = ijmlist_shard_enter(shard);
+	jmls = ijmlist_ass_get_all_by_key(&shard->list,key_ptr,key_len,out_ptrs,cap,n);
+	ijmlist_shard_leave(shard,prev);
 
-	jmlist_debug(__func__,"returning with success.");
-	return JMLIST_ERROR_SUCCESS;
+	return jmls;
 }
 
+/*
+ * the keys of a batch are in different shards, each one is looked up holding
+ * only the lock of its own shard.
+ */
 jmlist_status
-jmlist_seek_end(jmlist jml,jmlist_seek_handle *handle_ptr)
+ijmlist_shard_get_by_keys(jmlist jml,jmlist_key *keys,jmlist_key_length *lens,jmlist_index n,
+		void **out_ptrs,bool *out_found)
 {
-	jmlist_debug(__func__,"called with jml=%p and handle_ptr=%p",jml,handle_ptr);
-
-	if( !jml ) {
-		jmlist_debug(__func__,"invalid jml specified (jml=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-		jmlist_debug(__func__,"returning with failure.");
-		return JMLIST_ERROR_FAILURE;
-	}
+	jmlist_index i;
 
-	if( !handle_ptr ) {
-		jmlist_debug(__func__,"invalid handle_ptr specified (handle_ptr=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-		jmlist_debug(__func__,"returning with failure.");
-		return JMLIST_ERROR_FAILURE;
-	}
+	jmlist_debug(__func__,"called with jml=%p, n=%u",jml,n);
 
-	if( !jml->seeking ) {
-		jmlist_debug(__func__,"cannot stop seeking on a list that is not being seeked");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-		jmlist_debug(__func__,"returning with failure.");
-		return JMLIST_ERROR_FAILURE;
+	for( i = 0 ; i < n ; i++ )
+	{
+		out_ptrs[i] = 0;
+		out_found[i] = ijmlist_shard_get_by_key(jml,keys[i],lens[i],&out_ptrs[i]) == JMLIST_ERROR_SUCCESS;
 	}
 
-	jml->seeking = false;
-	jmlist_debug(__func__,"seek flag set to %u",jml->seeking);
-
 	jmlist_debug(__func__,"returning with success.");
 	return JMLIST_ERROR_SUCCESS;
 }
 
-/*
-   jmlist_seek_next
-
-   Parse list and obtain the next entry, an argument, handler structure
-   is used to determine where the seeking is at. Each list type have its own
-   handler data.
-*/
 jmlist_status
-jmlist_seek_next(jmlist jml,jmlist_seek_handle *handle_ptr,void **ptr)
+ijmlist_shard_remove_by_key(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len)
 {
-	jmlist_debug(__func__,"called with jml=%p, handle_ptr=%p and ptr=%p",jml,handle_ptr,ptr);
+	struct _jmlist_memory_info *prev;
+	assoc_shard *shard = ijmlist_shard_of(jml,key_ptr,key_len);
+	jmlist_status jmls;
 
-	if( !jml )
-	{
-		jmlist_debug(__func__,"invalid jml specified (jml=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-		jmlist_debug(__func__,"returning with failure.");
-		return JMLIST_ERROR_FAILURE;
-	}
+	prev = ijmlist_shard_enter(shard);
+	jmls = ijmlist_ass_remove_by_key(&shard->list,key_ptr,key_len);
+	ijmlist_shard_leave(shard,prev);
 
-	if( !ptr ) {
-		jmlist_debug(__func__,"invalid ptr specified (ptr=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-		jmlist_debug(__func__,"returning with failure.");
-		return JMLIST_ERROR_FAILURE;
-	}
+	if( (jmls == JMLIST_ERROR_FAILURE) && (jmlist_errno == JMLIST_ERROR_EMPTY_LIST) )
+		jmlist_errno = JMLIST_ERROR_ENTRY_NOT_FOUND;
 
-	if( !handle_ptr ) {
-		jmlist_debug(__func__,"invalid handle_ptr specified (handle_ptr=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-		jmlist_debug(__func__,"returning with failure.");
-		return JMLIST_ERROR_FAILURE;
-	}
+	return jmls;
+}
 
-	if( jml->seeking != true ) {
-		jmlist_debug(__func__,"seek should start by calling seek_start routine");
-		jmlist_errno = JMLIST_ERROR_FAILURE;
-		jmlist_debug(__func__,"returning with failure.");
-		return JMLIST_ERROR_FAILURE;
-	}
+/*
+ * number of entries of all the shards, shards are counted one after the
+ * other so entries inserted or removed meanwhile may or may not be counted.
+ */
+jmlist_index
+ijmlist_shard_usage(jmlist jml)
+{
+	jmlist_index usage = 0;
+	uint32_t i;
 
-	if( jml->flags & JMLIST_INDEXED )
-	{
-		jmlist_debug(__func__,"passing control to indexed list seek_next routine.");
-		return ijmlist_idx_seek_next(jml,handle_ptr,ptr);
-	} else if( jml->flags & JMLIST_LINKED )
-	{
-		jmlist_debug(__func__,"passing control to linked list seek_next routine.");
-		return ijmlist_lnk_seek_next(jml,handle_ptr,ptr);
-	} else if( jml->flags & JMLIST_ASSOCIATIVE )
+	for( i = 0 ; i < jml->ass_list.shard_count ; i++ )
 	{
-		jmlist_debug(__func__,"passing control to the associative list seek_next routine.");
-		return ijmlist_ass_seek_next(jml,handle_ptr,ptr);
+		pthread_mutex_lock(&jml->ass_list.shards[i].lock);
+		usage += jml->ass_list.shards[i].list.ass_list.usage;
+		pthread_mutex_unlock(&jml->ass_list.shards[i].lock);
 	}
-	
-	jmlist_debug(__func__,"invalid or unsupported list type (jml=%p, flags=%u)",jml,jml->flags);
-	jmlist_debug(__func__,"returning with failure.");
-	jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-	return JMLIST_ERROR_FAILURE;
+
+	return usage;
 }
 
+/*
+ * calls callback for the entries of each shard holding its lock, the callback
+ * can't use the list.
+ */
 jmlist_status
-ijmlist_idx_seek_next(jmlist jml,jmlist_seek_handle *handle_ptr,void **ptr)
+ijmlist_shard_parse(jmlist jml,JMLISTPARSERCALLBACK callback,void *param)
 {
-	void *ptr_local;
+	assoc_shard *shard;
+	assoc_entry *pseeker;
+	uint32_t i;
 
-	jmlist_debug(__func__,"called with jml=%p, handle_ptr=%p, ptr=%p",jml,handle_ptr,ptr);
+	jmlist_debug(__func__,"called with jml=%p, callback=%p, param=%p",jml,callback,param);
 
-	if( !jml ) {
-		jmlist_debug(__func__,"invalid jml specified (jml=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-		jmlist_debug(__func__,"returning with failure.");
-		return JMLIST_ERROR_FAILURE;
+	for( i = 0 ; i < jml->ass_list.shard_count ; i++ )
+	{
+		shard = &jml->ass_list.shards[i];
+		pthread_mutex_lock(&shard->lock);
+		for( pseeker = shard->list.ass_list.phead ; pseeker ; pseeker = pseeker->next )
+			callback(pseeker->ptr,param);
+		pthread_mutex_unlock(&shard->lock);
 	}
 
-	if( !handle_ptr ) {
-		jmlist_debug(__func__,"invalid handle_ptr specified (handle_ptr=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-		jmlist_debug(__func__,"returning with failure.");
-		return JMLIST_ERROR_FAILURE;
-	}
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
 
-	if( !ptr ) {
-		jmlist_debug(__func__,"invalid ptr specified (ptr=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-		jmlist_debug(__func__,"returning with failure.");
-		return JMLIST_ERROR_FAILURE;
-	}
+/*
+ * same as ijmlist_shard_parse for jmlist_find, stops at the first entry the
+ * callback finds (shards are searched in order, not the list insert order).
+ */
+jmlist_status
+ijmlist_shard_find(jmlist jml,JMLISTFINDCALLBACK callback,void *param,jmlist_lookup_result *result,void **ptr)
+{
+	jmlist_lookup_result result_local;
+	assoc_shard *shard;
+	assoc_entry *pseeker;
+	uint32_t i;
 
-	bool fragmented;
-	jmlist_is_fragmented(jml,false,&fragmented);
-try_again:
-	/* test next index bounds */
-	if( (jml->flags & JMLIST_IDX_USE_SHIFT) || !fragmented )
+	jmlist_debug(__func__,"called with jml=%p, callback=%p, param=%p, result=%p and ptr=%p",
+			jml,callback,param,result,ptr);
+
+	*result = jmlist_entry_not_found;
+	for( i = 0 ; i < jml->ass_list.shard_count ; i++ )
 	{
-		if( handle_ptr->next_idx >= jml->idx_list.usage ) {
-			jmlist_debug(__func__,"next index (%u) reached the limit of the list entry count (%u)",
-					handle_ptr->next_idx,jml->idx_list.usage);
-			jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
-			jmlist_debug(__func__,"returning with failure.");
-			return JMLIST_ERROR_FAILURE;
+		shard = &jml->ass_list.shards[i];
+		pthread_mutex_lock(&shard->lock);
+		for( pseeker = shard->list.ass_list.phead ; pseeker ; pseeker = pseeker->next )
+		{
+			result_local = jmlist_entry_not_found;
+			callback(pseeker->ptr,param,&result_local);
+			if( result_local == jmlist_entry_found )
+				break;
 		}
-	} else
-	{
-		if( handle_ptr->next_idx >= jml->idx_list.capacity ) {
-			jmlist_debug(__func__,"next index (%u) reached the limit of the list capacity (%u)",
-					handle_ptr->next_idx,jml->idx_list.capacity);
-			jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
-			jmlist_debug(__func__,"returning with failure.");
-			return JMLIST_ERROR_FAILURE;
+		pthread_mutex_unlock(&shard->lock);
+
+		if( pseeker )
+		{
+			jmlist_debug(__func__,"finished search, entry was found in shard %u (ptr=%p)",i,pseeker->ptr);
+			if( ptr )
+				*ptr = pseeker->ptr;
+			*result = jmlist_entry_found;
+			break;
 		}
 	}
 
-	jmlist_debug(__func__,"accessing indexed list entry of index %u",handle_ptr->next_idx);
-	ptr_local = jml->idx_list.plist[handle_ptr->next_idx];
-	jmlist_debug(__func__,"indexed list entry of index %u has ptr=%p",handle_ptr->next_idx,ptr_local);
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
 
-	if(	ptr_local == JMLIST_EMPTY_PTR ) {
-		handle_ptr->next_idx++;
-		jmlist_debug(__func__,"entry is empty, increasing to the next index %u",handle_ptr->next_idx);
-		goto try_again;
-	}
+jmlist_status
+ijmlist_shard_dump(jmlist jml)
+{
+	struct _jmlist_memory_info *prev;
+	assoc_shard *shard;
+	uint32_t i;
 
-	jmlist_debug(__func__,"storing entry ptr=%p into ptr argument (ptr=%p)",ptr_local,ptr);
-	*ptr = ptr_local;
+	jmlist_debug(__func__,"called with jml=%p",jml);
 
-	/* increase next index */
-	handle_ptr->next_idx++;
-	jmlist_debug(__func__,"increased handle (with ptr=%p) to the next index %u",
-			handle_ptr,handle_ptr->next_idx);
+	printf("concurrent list jml=%p has %u shards\n",(void*)jml,jml->ass_list.shard_count);
+
+	for( i = 0 ; i < jml->ass_list.shard_count ; i++ )
+	{
+		shard = &jml->ass_list.shards[i];
+		prev = ijmlist_shard_enter(shard);
+		printf("shard %u:\n",i);
+		ijmlist_ass_dump(&shard->list);
+		ijmlist_shard_leave(shard,prev);
+	}
 
 	jmlist_debug(__func__,"returning with success.");
 	return JMLIST_ERROR_SUCCESS;
-	goto try_again;
 }
 
+/*
+ * frees the shards, no other thread can be using the list.
+ */
 jmlist_status
-ijmlist_lnk_seek_next(jmlist jml,jmlist_seek_handle *handle_ptr,void **ptr)
+ijmlist_shard_free(jmlist jml)
 {
-	void *ptr_local;
+	struct _jmlist_memory_info *prev;
+	assoc_shard *shard;
+	uint32_t i;
 
-	jmlist_debug(__func__,"called with jml=%p, handle_ptr=%p and ptr=%p",jml,handle_ptr,ptr);
+	jmlist_debug(__func__,"called with jml=%p",jml);
 
-	if( !jml ) {
-		jmlist_debug(__func__,"invalid jml specified (jml=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-		jmlist_debug(__func__,"returning with failure.");
-		return JMLIST_ERROR_FAILURE;
+	for( i = 0 ; i < jml->ass_list.shard_count ; i++ )
+	{
+		shard = &jml->ass_list.shards[i];
+		prev = ijmlist_shard_enter(shard);
+		ijmlist_ass_free(&shard->list);
+		ijmlist_shard_leave(shard,prev);
+		pthread_mutex_destroy(&shard->lock);
 	}
 
-	if( !handle_ptr ) {
-		jmlist_debug(__func__,"invalid handle_ptr specified (handle_ptr=0)");
+	free(jml->ass_list.shards);
+	jmlist_mem.ass_list.total -= jml->ass_list.shard_count*sizeof(assoc_shard);
+	jmlist_mem.ass_list.used -= jml->ass_list.shard_count*sizeof(assoc_shard);
+	jmlist_debug(__func__,"new jml_mem.ass_list.total is %u",jmlist_mem.ass_list.total);
+	jmlist_debug(__func__,"new jml_mem.ass_list.used is %u",jmlist_mem.ass_list.used);
+
+	jml->ass_list.shards = 0;
+	jml->ass_list.shard_count = 0;
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+   jmlist_shard_stats
+   gets the shard count of a concurrent list, the number of entries of a shard
+   and the memory used by it (which is not included in jmlist_memory_stats).
+*/
+jmlist_status
+jmlist_shard_stats(jmlist jml,jmlist_index shard,jmlist_shard_info_ptr info)
+{
+	jmlist_debug(__func__,"called with jml=%p, shard=%u, info=%p",jml,shard,info);
+
+	if( !info )
+	{
+		jmlist_debug(__func__,"invalid info pointer specified (info=0)");
 		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
 		jmlist_debug(__func__,"returning with failure.");
 		return JMLIST_ERROR_FAILURE;
 	}
 
-	if( !ptr ) {
-		jmlist_debug(__func__,"invalid ptr specified (ptr=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+	if( !(jml->flags & JMLIST_ASSOCIATIVE) || !jml->ass_list.shards )
+	{
+		jmlist_debug(__func__,"list jml=%p is not a concurrent list (flags=%u)",jml,jml->flags);
+		jmlist_errno = JMLIST_ERROR_UNSUPPORTED;
 		jmlist_debug(__func__,"returning with failure.");
 		return JMLIST_ERROR_FAILURE;
 	}
 
-	if( !handle_ptr->next_lnk ) {
-		jmlist_debug(__func__,"there are no more entries to seek (reached the tail of the list)");
+	if( shard >= jml->ass_list.shard_count )
+	{
+		jmlist_debug(__func__,"shard %u out of bounds (shard_count=%u)",shard,jml->ass_list.shard_count);
 		jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
 		jmlist_debug(__func__,"returning with failure.");
 		return JMLIST_ERROR_FAILURE;
 	}
 
-	jmlist_debug(__func__,"accessing handle_ptr next link structure");
-	ptr_local = handle_ptr->next_lnk->ptr;
-	jmlist_debug(__func__,"storing entry ptr=%p into ptr argument (ptr=%p)",ptr_local,ptr);
-	*ptr = ptr_local;
-
-	handle_ptr->next_lnk = handle_ptr->next_lnk->next;
-	jmlist_debug(__func__,"updated handle to the next entry (new next_lnk=%p)",handle_ptr->next_lnk);
+	pthread_mutex_lock(&jml->ass_list.shards[shard].lock);
+	info->shard_count = jml->ass_list.shard_count;
+	info->usage = jml->ass_list.shards[shard].list.ass_list.usage;
+	info->mem = jml->ass_list.shards[shard].mem;
+	pthread_mutex_unlock(&jml->ass_list.shards[shard].lock);
 
 	jmlist_debug(__func__,"returning with success.");
 	return JMLIST_ERROR_SUCCESS;
 }
 
-jmlist_status
-ijmlist_ass_seek_next(jmlist jml,jmlist_seek_handle *handle_ptr,void **ptr)
-{
-	void *ptr_local;
-
-	jmlist_debug(__func__,"called with jml=%p, handle_ptr=%p and ptr=%p",jml,handle_ptr,ptr);
-
-	if( !jml ) {
-		jmlist_debug(__func__,"invalid jml specified (jml=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-		jmlist_debug(__func__,"returning with failure.");
-		return JMLIST_ERROR_FAILURE;
-	}
+/*
+   key interning
+
+   A jmlist_intern_table keeps one copy of each distinct key in an arena of
+   JMLIST_INTERN_CHUNK_SIZE chunks (keys are never moved or freed until the
+   table is freed, so an interned key stays valid) and gives it an id. Lists
+   created with JMLIST_ASS_INTERNED take the hash from the key header and
+   compare ids instead of key bytes. The table isn't locked, interning from
+   several threads must be serialised by the caller.
+*/
 
-	if( !handle_ptr ) {
-		jmlist_debug(__func__,"invalid handle_ptr specified (handle_ptr=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-		jmlist_debug(__func__,"returning with failure.");
-		return JMLIST_ERROR_FAILURE;
-	}
+jmlist_status
+jmlist_intern_create(jmlist_intern_table *new_table)
+{
+	jmlist_intern_table table;
 
-	if( !ptr ) {
-		jmlist_debug(__func__,"invalid ptr specified (ptr=0)");
+	jmlist_debug(__func__,"called with new_table=%p",new_table);
+
+	if( !new_table )
+	{
+		jmlist_debug(__func__,"invalid new_table pointer specified (new_table=0)");
 		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
 		jmlist_debug(__func__,"returning with failure.");
 		return JMLIST_ERROR_FAILURE;
 	}
 
-	if( !handle_ptr->next_ass ) {
-		jmlist_debug(__func__,"there are no more entries to seek (reached the tail of the list)");
-		jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
+	table = (jmlist_intern_table)calloc(1,sizeof(struct _jmlist_intern_table));
+	if( table )
+		table->slots = (intern_key**)calloc(JMLIST_INTERN_DEF_SLOTS,sizeof(intern_key*));
+
+	if( !table || !table->slots )
+	{
+		jmlist_debug(__func__,"calloc failed (size %u)!",JMLIST_INTERN_DEF_SLOTS*sizeof(intern_key*));
+		free(table);
+		jmlist_errno = JMLIST_ERROR_MALLOC;
 		jmlist_debug(__func__,"returning with failure.");
 		return JMLIST_ERROR_FAILURE;
 	}
 
-	jmlist_debug(__func__,"accessing handle_ptr next link structure");
-	ptr_local = handle_ptr->next_ass->ptr;
-	jmlist_debug(__func__,"storing entry ptr=%p into ptr argument (ptr=%p)",ptr_local,ptr);
-	*ptr = ptr_local;
+	table->slot_count = JMLIST_INTERN_DEF_SLOTS;
+
+	jmlist_mem.total += sizeof(struct _jmlist_intern_table) + table->slot_count*sizeof(intern_key*);
+	jmlist_mem.used += sizeof(struct _jmlist_intern_table) + table->slot_count*sizeof(intern_key*);
+	jmlist_debug(__func__,"new jml_mem.total is %u",jmlist_mem.total);
+	jmlist_debug(__func__,"new jml_mem.used is %u",jmlist_mem.used);
 
-	handle_ptr->next_ass = handle_ptr->next_ass->next;
-	jmlist_debug(__func__,"updated handle to the next entry (new next_ass=%p)",handle_ptr->next_ass);
+	*new_table = table;
 
 	jmlist_debug(__func__,"returning with success.");
 	return JMLIST_ERROR_SUCCESS;
 }
 
 /*
-   jmlist_find
-
-   Parse all entries from the list, calling the callback function for each of them,
-   when this callback returns result=jmlist_entry_found the seeking stops and this
-   function returns the corresponding entry ptr in ptr argument.
-*/
+ * frees the table and its keys, lists using them must be freed first.
+ */
 jmlist_status
-jmlist_find(jmlist jml,JMLISTFINDCALLBACK callback,void *param,jmlist_lookup_result *result,void **ptr)
+jmlist_intern_free(jmlist_intern_table table)
 {
-	jmlist_lookup_result result_local;
-	jmlist_status jmls;
-	jmlist_index entry_count;
-	jmlist_seek_handle shandle;
-	void *ptr_seek;
+	intern_chunk *chunk;
+	intern_chunk *next;
 
-	jmlist_debug(__func__,"called with jml=%p, callback=%p, param=%p, result=%p and ptr=%p",
-			jml,callback,param,result,ptr);
+	jmlist_debug(__func__,"called with table=%p",table);
 
-	if( !jml ) {
-		jmlist_debug(__func__,"invalid jml specified (jml=0)");
+	if( !table )
+	{
+		jmlist_debug(__func__,"invalid table specified (table=0)");
 		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
 		jmlist_debug(__func__,"returning with failure.");
 		return JMLIST_ERROR_FAILURE;
 	}
 
-	if( !callback ) {
-		jmlist_debug(__func__,"invalid callback specified (callback=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-		jmlist_debug(__func__,"returning with failure.");
-		return JMLIST_ERROR_FAILURE;
+	for( chunk = table->chunks ; chunk ; chunk = next )
+	{
+		next = chunk->next;
+		jmlist_mem.total -= sizeof(intern_chunk) + chunk->size;
+		jmlist_mem.used -= sizeof(intern_chunk) + chunk->size;
+		free(chunk);
 	}
 
-	if( !result ) {
-		jmlist_debug(__func__,"invalid result pointer specified (result=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-		jmlist_debug(__func__,"returning with failure.");
-		return JMLIST_ERROR_FAILURE;
-	}
+	jmlist_mem.total -= sizeof(struct _jmlist_intern_table) + table->slot_count*sizeof(intern_key*) +
+			table->key_capacity*sizeof(intern_key*);
+	jmlist_mem.used -= sizeof(struct _jmlist_intern_table) + table->slot_count*sizeof(intern_key*) +
+			table->key_capacity*sizeof(intern_key*);
+	jmlist_debug(__func__,"new jml_mem.total is %u",jmlist_mem.total);
+	jmlist_debug(__func__,"new jml_mem.used is %u",jmlist_mem.used);
 
-	/* start seeking the list */
+	free(table->keys);
+	free(table->slots);
+	free(table);
 
-	jmls = jmlist_entry_count(jml,&entry_count);
-	if( jmls != JMLIST_ERROR_SUCCESS ) {
-		jmlist_debug(__func__,"unable to get entry count from list");
-		jmlist_errno = JMLIST_ERROR_FAILURE;
-		jmlist_debug(__func__,"returning with failure.");
-		return JMLIST_ERROR_FAILURE;
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+ * returns the slot of the key, or the empty slot where it would go.
+ */
+intern_key **
+ijmlist_intern_slot(jmlist_intern_table table,uint32_t hash,jmlist_key key_ptr,jmlist_key_length key_len)
+{
+	uint32_t mask = table->slot_count - 1;
+	uint32_t i = hash & mask;
+	intern_key *pkey;
+
+	while( (pkey = table->slots[i]) )
+	{
+		if( (pkey->hash == hash) && (pkey->len == key_len) && !memcmp(pkey->key,key_ptr,key_len) )
+			break;
+		i = (i + 1) & mask;
 	}
 
-	jmlist_debug(__func__,"seeking throughtout %u entries of the list",entry_count);
+	return &table->slots[i];
+}
 
-	jmls = jmlist_seek_start(jml,&shandle);
-	if( jmls == JMLIST_ERROR_FAILURE ) {
-		jmlist_debug(__func__,"unable to seek the list");
-		jmlist_debug(__func__,"returning with failure.");
+/*
+ * doubles the slots of the table, done when it's 3/4 full.
+ */
+jmlist_status
+ijmlist_intern_grow(jmlist_intern_table table)
+{
+	intern_key **slots;
+	uint32_t slot_count = table->slot_count*2;
+	uint32_t mask = slot_count - 1;
+	uint32_t i;
+	uint32_t j;
+
+	slots = (intern_key**)calloc(slot_count,sizeof(intern_key*));
+	if( !slots )
+	{
+		jmlist_debug(__func__,"calloc failed (size %u)!",slot_count*sizeof(intern_key*));
+		jmlist_errno = JMLIST_ERROR_MALLOC;
 		return JMLIST_ERROR_FAILURE;
 	}
 
-	while(entry_count)
+	for( i = 0 ; i < table->slot_count ; i++ )
 	{
-		jmls = jmlist_seek_next(jml,&shandle,&ptr_seek);
-		if( jmls != JMLIST_ERROR_SUCCESS ) {
-			jmlist_debug(__func__,"seek_next returned failure, unexpected list seeking failure");
-			jmlist_debug(__func__,"returning with failure.");
-			return JMLIST_ERROR_FAILURE;
-		}
+		if( !table->slots[i] )
+			continue;
 
-		jmlist_debug(__func__,"got entry with ptr=%p, calling callback=%p",ptr_seek,callback);
-		callback(ptr_seek,param,&result_local);
-		jmlist_debug(__func__,"callback returned with result=%d",result_local);
+		for( j = table->slots[i]->hash & mask ; slots[j] ; j = (j + 1) & mask );
+		slots[j] = table->slots[i];
+	}
 
-		if( result_local == jmlist_entry_found )
-		{
-			jmlist_debug(__func__,"finished search, entry was found");
-			if( ptr ) {
-				jmlist_debug(__func__,"writing ptr=%p into ptr argument",ptr_seek);
-				*ptr = ptr_seek;
-			}
+	jmlist_mem.total += (slot_count - table->slot_count)*sizeof(intern_key*);
+	jmlist_mem.used += (slot_count - table->slot_count)*sizeof(intern_key*);
 
-			jmlist_debug(__func__,"updating result argument");
-			*result = result_local;
+	free(table->slots);
+	table->slots = slots;
+	table->slot_count = slot_count;
+	return JMLIST_ERROR_SUCCESS;
+}
 
-			jmls = jmlist_seek_end(jml,&shandle);
-			if( jmls != JMLIST_ERROR_SUCCESS ) {
-				jmlist_debug(__func__,"unable to end seek, jmlist_seek_end failed");
-				jmlist_debug(__func__,"returning with failure.");
-				return JMLIST_ERROR_FAILURE;
-			}
-			
-			jmlist_debug(__func__,"returning with success.");
-			return JMLIST_ERROR_SUCCESS;
-		}
-		entry_count--;
-	}
+/*
+ * true if the header in front of key_ptr is in the arena of the table (it can
+ * be read, but key_ptr may still be in the middle of a key). pointers out of
+ * the arena aren't dereferenced, the chunks are searched newest first.
+ */
+bool
+ijmlist_intern_owns(jmlist_intern_table table,jmlist_key key_ptr)
+{
+	uintptr_t addr = (uintptr_t)key_ptr - offsetof(intern_key,key);
+	intern_chunk *chunk;
 
-	jmlist_debug(__func__,"seeking was ended, calling seek_end");
-	jmls = jmlist_seek_end(jml,&shandle);
-	if( jmls != JMLIST_ERROR_SUCCESS ) {
-		jmlist_debug(__func__,"unable to end seek, jmlist_seek_end failed");
-		jmlist_debug(__func__,"returning with failure.");
-		return JMLIST_ERROR_FAILURE;
-	}
+	if( addr & 3 )
+		return false;
 
-	jmlist_debug(__func__,"entry was not found, updating result argument");
-	*result = jmlist_entry_not_found;
+	for( chunk = table->chunks ; chunk ; chunk = chunk->next )
+	{
+		if( (addr >= (uintptr_t)chunk->data) && ((uintptr_t)key_ptr < (uintptr_t)chunk->data + chunk->used) )
+			return true;
+	}
 
-	jmlist_debug(__func__,"returning with success.");
-	return JMLIST_ERROR_SUCCESS;
+	return false;
 }
 
 /*
-   jmlist_parse
+ * copies a new key to the arena, keys are 4 byte aligned for their header.
+ */
+intern_key *
+ijmlist_intern_alloc(jmlist_intern_table table,jmlist_key_length key_len)
+{
+	size_t size = (offsetof(intern_key,key) + key_len + 1 + 3) & ~(size_t)3;
+	intern_chunk *chunk = table->chunks;
+	intern_key *pkey;
+	size_t chunk_size;
 
-   This function will parse all the jmlist entries and call the callback
-   for each entry. Its possible to pass a specific param to the callback
-   also.
+	if( !chunk || (chunk->used + size > chunk->size) )
+	{
+		chunk_size = size > JMLIST_INTERN_CHUNK_SIZE ? size : JMLIST_INTERN_CHUNK_SIZE;
+		chunk = (intern_chunk*)malloc(sizeof(intern_chunk) + chunk_size);
+		if( !chunk )
+		{
+			jmlist_debug(__func__,"malloc failed (size %u)!",sizeof(intern_chunk) + chunk_size);
+			jmlist_errno = JMLIST_ERROR_MALLOC;
+			return 0;
+		}
+
+		jmlist_mem.total += sizeof(intern_chunk) + chunk_size;
+		jmlist_mem.used += sizeof(intern_chunk) + chunk_size;
+
+		chunk->size = chunk_size;
+		chunk->used = 0;
+		chunk->next = table->chunks;
+		table->chunks = chunk;
+	}
+
+	pkey = (intern_key*)(chunk->data + chunk->used);
+	chunk->used += size;
+	return pkey;
+}
+
+/*
+   jmlist_intern_key
+   interns a key, the key stored in the table is returned in interned (with a
+   terminating 0 after its key_len bytes) and its id in id, both optional.
+   interning a key already in the table returns the same key and id.
 */
 jmlist_status
-jmlist_parse(jmlist jml,JMLISTPARSERCALLBACK callback,void *param)
+jmlist_intern_key(jmlist_intern_table table,jmlist_key key_ptr,jmlist_key_length key_len,
+		jmlist_key *interned,uint32_t *id)
 {
-	jmlist_status jmls;
-	jmlist_index entry_count;
-	jmlist_seek_handle shandle;
-	void *ptr_seek;
-
-	jmlist_debug(__func__,"called with jml=%p, callback=%p, param=%p",
-			jml,callback,param);
+	intern_key **pslot;
+	intern_key *pkey;
+	uint32_t hash;
 
-	if( !jml ) {
-		jmlist_debug(__func__,"invalid jml specified (jml=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
-		jmlist_debug(__func__,"returning with failure.");
-		return JMLIST_ERROR_FAILURE;
-	}
+	jmlist_debug(__func__,"called with table=%p, key_ptr=%p, key_len=%u",table,key_ptr,key_len);
 
-	if( !callback ) {
-		jmlist_debug(__func__,"invalid callback specified (callback=0)");
+	if( !table || !key_ptr || !key_len )
+	{
+		jmlist_debug(__func__,"invalid arguments specified (table=%p, key_ptr=%p, key_len=%u)",table,key_ptr,key_len);
 		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
 		jmlist_debug(__func__,"returning with failure.");
 		return JMLIST_ERROR_FAILURE;
 	}
 
-	/* start seeking the list */
+	hash = ijmlist_ass_hash(key_ptr,key_len);
+	pslot = ijmlist_intern_slot(table,hash,key_ptr,key_len);
 
-	jmls = jmlist_entry_count(jml,&entry_count);
-	if( jmls != JMLIST_ERROR_SUCCESS ) {
-		jmlist_debug(__func__,"unable to get entry count from list");
-		jmlist_errno = JMLIST_ERROR_FAILURE;
-		jmlist_debug(__func__,"returning with failure.");
-		return JMLIST_ERROR_FAILURE;
-	}
+	if( !*pslot )
+	{
+		if( (table->count + 1)*4 > table->slot_count*3 )
+		{
+			if( ijmlist_intern_grow(table) == JMLIST_ERROR_FAILURE )
+			{
+				jmlist_debug(__func__,"returning with failure.");
+				return JMLIST_ERROR_FAILURE;
+			}
+			pslot = ijmlist_intern_slot(table,hash,key_ptr,key_len);
+		}
 
-	jmlist_debug(__func__,"seeking throughtout %u entries of the list",entry_count);
+		if( table->count == table->key_capacity )
+		{
+			uint32_t key_capacity = table->key_capacity ? table->key_capacity*2 : JMLIST_INTERN_DEF_SLOTS;
+			intern_key **keys = (intern_key**)realloc(table->keys,key_capacity*sizeof(intern_key*));
+			if( !keys )
+			{
+				jmlist_debug(__func__,"realloc failed (size %u)!",key_capacity*sizeof(intern_key*));
+				jmlist_errno = JMLIST_ERROR_MALLOC;
+				jmlist_debug(__func__,"returning with failure.");
+				return JMLIST_ERROR_FAILURE;
+			}
 
-	jmls = jmlist_seek_start(jml,&shandle);
-	if( jmls == JMLIST_ERROR_FAILURE ) {
-		jmlist_debug(__func__,"unable to seek the list");
-		jmlist_debug(__func__,"returning with failure.");
-		return JMLIST_ERROR_FAILURE;
-	}
+			jmlist_mem.total += (key_capacity - table->key_capacity)*sizeof(intern_key*);
+			jmlist_mem.used += (key_capacity - table->key_capacity)*sizeof(intern_key*);
+			table->keys = keys;
+			table->key_capacity = key_capacity;
+		}
 
-	while(entry_count)
-	{
-		jmls = jmlist_seek_next(jml,&shandle,&ptr_seek);
-		if( jmls != JMLIST_ERROR_SUCCESS ) {
-			jmlist_debug(__func__,"seek_next returned failure, unexpected list seeking failure");
+		pkey = ijmlist_intern_alloc(table,key_len);
+		if( !pkey )
+		{
 			jmlist_debug(__func__,"returning with failure.");
 			return JMLIST_ERROR_FAILURE;
 		}
 
-		jmlist_debug(__func__,"got entry with ptr=%p, calling callback=%p",ptr_seek,callback);
-		callback(ptr_seek,param);
-		jmlist_debug(__func__,"callback returned");
+		pkey->id = table->count;
+		pkey->hash = hash;
+		pkey->len = key_len;
+		memcpy(pkey->key,key_ptr,key_len);
+		pkey->key[key_len] = 0;
 
-		entry_count--;
+		table->keys[table->count++] = pkey;
+		*pslot = pkey;
+		jmlist_debug(__func__,"new key interned with id %u",pkey->id);
 	}
 
-	jmlist_debug(__func__,"seeking was ended, calling seek_end");
-	jmls = jmlist_seek_end(jml,&shandle);
-	if( jmls != JMLIST_ERROR_SUCCESS ) {
-		jmlist_debug(__func__,"unable to end seek, jmlist_seek_end failed");
-		jmlist_debug(__func__,"returning with failure.");
-		return JMLIST_ERROR_FAILURE;
-	}
+	if( interned )
+		*interned = (*pslot)->key;
+	if( id )
+		*id = (*pslot)->id;
 
 	jmlist_debug(__func__,"returning with success.");
 	return JMLIST_ERROR_SUCCESS;
 }
 
 /*
- * jmlist_internal_count
- *
- * This function is used to get the number of entries in the internal list.
- * The internal list contains the list of created jmlist objects. So one can
- * use it to verify if all the created lists were correctly freed.
- */
-jmlist_status jmlist_internal_count(jmlist_index *entry_count)
+   jmlist_intern_find
+   same as jmlist_intern_key but keys not in the table are not added, it fails
+   with JMLIST_ERROR_ENTRY_NOT_FOUND (the key can't be in an interned list).
+*/
+jmlist_status
+jmlist_intern_find(jmlist_intern_table table,jmlist_key key_ptr,jmlist_key_length key_len,
+		jmlist_key *interned,uint32_t *id)
 {
-	if( jmlist_ilist == 0 ) {
-		jmlist_debug(__func__,"internal list is not active, cannot use this function");
-		jmlist_debug(__func__,"returning with failure.");
-		return JMLIST_ERROR_FAILURE;
-	}
+	intern_key *pkey;
 
-	return jmlist_entry_count(jmlist_ilist,entry_count);
-}
+	jmlist_debug(__func__,"called with table=%p, key_ptr=%p, key_len=%u",table,key_ptr,key_len);
 
-jmlist_status jmlist_key_exists(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,jmlist_lookup_result *result)
-{
-	jmlist_debug(__func__,"called with jml=%p, key_ptr=%p, key_len=%u, result=%p",jml,key_ptr,key_len,result);
-	
-	if( !result )
+	if( !table || !key_ptr || !key_len )
 	{
-		jmlist_debug(__func__,"invalid result pointer specified (result=0)");
-		jmlist_debug(__func__,"returning with failure.");
+		jmlist_debug(__func__,"invalid arguments specified (table=%p, key_ptr=%p, key_len=%u)",table,key_ptr,key_len);
 		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"returning with failure.");
 		return JMLIST_ERROR_FAILURE;
 	}
 
-	/* verify key_ptr */
-	if( !key_ptr )
+	pkey = *ijmlist_intern_slot(table,ijmlist_ass_hash(key_ptr,key_len),key_ptr,key_len);
+	if( !pkey )
 	{
-		jmlist_debug(__func__,"invalid key_ptr specified (key_ptr=0)");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
+		jmlist_debug(__func__,"key_ptr=%p key_len=%u is not interned in table=%p",key_ptr,key_len,table);
+		jmlist_errno = JMLIST_ERROR_ENTRY_NOT_FOUND;
 		jmlist_debug(__func__,"returning with failure.");
 		return JMLIST_ERROR_FAILURE;
 	}
-	
-	/* verify key_len */
-	if( !key_len )
+
+	if( interned )
+		*interned = pkey->key;
+	if( id )
+		*id = pkey->id;
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/*
+   jmlist_intern_get_by_id
+   gets the interned key with an id.
+*/
+jmlist_status
+jmlist_intern_get_by_id(jmlist_intern_table table,uint32_t id,jmlist_key *key_ptr,jmlist_key_length *key_len)
+{
+	jmlist_debug(__func__,"called with table=%p, id=%u",table,id);
+
+	if( !table || !key_ptr )
 	{
-		jmlist_debug(__func__,"invalid key_len specified (key_len=0)");
+		jmlist_debug(__func__,"invalid arguments specified (table=%p, key_ptr=%p)",table,key_ptr);
 		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
 		jmlist_debug(__func__,"returning with failure.");
 		return JMLIST_ERROR_FAILURE;
 	}
 
-	/* for now this function is only supported in associative lists */	
-	if( jml->flags != JMLIST_ASSOCIATIVE )
+	if( id >= table->count )
 	{
-		jmlist_debug(__func__,"invalid or unsupported list type (jml=%p, flags=%u)",jml,jml->flags);
+		jmlist_debug(__func__,"id %u out of bounds (count=%u)",id,table->count);
+		jmlist_errno = JMLIST_ERROR_OUT_OF_BOUNDS;
 		jmlist_debug(__func__,"returning with failure.");
-		jmlist_errno = JMLIST_ERROR_INVALID_ARGUMENT;
 		return JMLIST_ERROR_FAILURE;
 	}
 
-	return ijmlist_ass_key_exists(jml,key_ptr,key_len,result);
+	*key_ptr = table->keys[id]->key;
+	if( key_len )
+		*key_len = table->keys[id]->len;
+
+	jmlist_debug(__func__,"returning with success.");
+	return JMLIST_ERROR_SUCCESS;
 }
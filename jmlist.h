@@ -29,6 +29,7 @@
 #include <stdbool.h>
 #include <inttypes.h>
 #include <stdio.h>
+#include <pthread.h>
 
 #define JMLIST_IDXLIST_DEF_MALLOC_INC 64
 #define JMLIST_EMPTY_PTR (void*)(-1)
@@ -36,6 +37,74 @@
 typedef unsigned int jmlist_index;
 typedef void (*JMLISTPARSERCALLBACK) (void *ptr,void *param);
 
+/* number of keys held by each b+tree node of ordered associative lists */
+#define JMLIST_BPT_ORDER 32
+#define JMLIST_BPT_MIN (JMLIST_BPT_ORDER/2)
+#define JMLIST_BPT_MAX_HEIGHT 16
+
+/* hash index of unordered associative lists, initial bucket count (must be
+   a power of 2) and number of old buckets migrated on each operation while
+   the table is growing */
+#define JMLIST_ASS_DEF_BUCKETS 16
+#define JMLIST_ASS_REHASH_STEP 4
+
+/* small unordered associative lists have no hash index, the hashes of their
+   entries are kept in an array inside the list and compared all at once.
+   capacity of that array and default number of entries that make the list
+   build its hash index (it's dropped when half of them remain) */
+#define JMLIST_ASS_SMALL_MAX 16
+#define JMLIST_ASS_DEF_SMALL 8
+
+/* number of keys whose lookups are interleaved by jmlist_get_by_keys */
+#define JMLIST_ASS_BATCH_GROUP 16
+
+/* timer wheel of associative entries with ttl, JMLIST_WHEEL_LEVELS levels of
+   JMLIST_WHEEL_SLOTS slots, level l slots are JMLIST_WHEEL_SLOTS^l ticks wide */
+#define JMLIST_WHEEL_BITS 6
+#define JMLIST_WHEEL_SLOTS (1 << JMLIST_WHEEL_BITS)
+#define JMLIST_WHEEL_LEVELS 4
+
+/* membership filter of associative lists, default false positive rate and
+   expected number of keys, counters per block (a block is one cache line of
+   4-bit counters) */
+#define JMLIST_ASS_FILTER_DEF_FPR 0.01
+#define JMLIST_ASS_FILTER_DEF_CAPACITY 1024
+#define JMLIST_ASS_FILTER_BLOCK_COUNTERS 128
+
+/* frozen associative lists, average keys per pilot bucket of the perfect hash,
+   pilots tried for a bucket before the build restarts with another seed and
+   seeds tried before jmlist_freeze gives up */
+#define JMLIST_FROZEN_BUCKET_KEYS 4
+#define JMLIST_FROZEN_MAX_PILOT (1u<<24)
+#define JMLIST_FROZEN_MAX_SEEDS 8
+
+/* frozen ordered associative lists, levels of the eytzinger layout below the
+   node being compared that are prefetched (8 prefixes, one cache line) */
+#define JMLIST_SORTED_PREFETCH_LEVELS 3
+
+/* default number of shards of concurrent associative lists */
+#define JMLIST_ASS_DEF_SHARDS 64
+
+/* key interning tables, size of the arena chunks where keys are stored and
+   initial number of slots of the table (must be a power of 2) */
+#define JMLIST_INTERN_CHUNK_SIZE 65536
+#define JMLIST_INTERN_DEF_SLOTS 64
+
+/* parallel parse, most threads of the pool, chunks made for each thread (a
+   thread that is done with its chunks takes chunks of the others) and least
+   entries of a chunk */
+#define JMLIST_POOL_MAX_THREADS 64
+#define JMLIST_PARSE_THREAD_CHUNKS 16
+#define JMLIST_PARSE_MIN_CHUNK 64
+
+/* filter and map stages of a pipeline */
+#define JMLIST_PIPELINE_MAX_STAGES 16
+
+/* slots of an indexed list copied at once for a snapshot, and first size of
+   the table of nodes recorded for a snapshot of the other lists */
+#define JMLIST_SNAPSHOT_PAGE 512
+#define JMLIST_SNAPSHOT_DEF_NODES 64
+
 typedef enum _jmlist_status
 {
 	JMLIST_ERROR_SUCCESS = 0,
@@ -47,7 +116,9 @@ typedef enum _jmlist_status
 	JMLIST_ERROR_DAMAGED_LIST,
 	JMLIST_ERROR_EMPTY_LIST,
 	JMLIST_ERROR_ENTRY_NOT_FOUND,
-	JMLIST_ERROR_UNSUPPORTED
+	JMLIST_ERROR_UNSUPPORTED,
+	JMLIST_ERROR_FROZEN_LIST,
+	JMLIST_ERROR_STALE_SEEK
 } jmlist_status;
 
 /* flags of jmlist engine */
@@ -77,6 +148,80 @@ typedef enum _jmlist_init_flags
  * reliable than O(k), because in the use of frag flag all holes must be
  * detected with conditionals (the programmer must know all the possible
  * cases where holes can be caused).
+ *
+ * JMLIST_ASS_ORDERED
+ * associative list entries are kept sorted by key in a b+tree instead of
+ * insertion order. key lookups are O(log N), jmlist_seek_next walks the
+ * keys in order and jmlist_seek_range can be used to seek a range of keys.
+ * jmlist_get_floor and jmlist_get_ceiling find the entry with the nearest key
+ * below or above a key (or equal to it when inclusive is true).
+ * keys are compared with params.ass_list.compare or, when it is not set,
+ * lexicographically (shorter key first when one is prefix of the other).
+ *
+ * JMLIST_ASS_KEY_U32, JMLIST_ASS_KEY_U64, JMLIST_ASS_KEY_PTR
+ * associative list keys are 4 byte integers, 8 byte integers or pointers.
+ * keys are copied by value into the entry (the key memory passed to insert
+ * doesn't need to stay valid), hashed with an integer hash and compared with
+ * a single integer comparison. key_len must be the width of the key type.
+ * jmlist_*_ikey functions take the key as an integer. only one of them can be
+ * set and they can't be used together with JMLIST_ASS_ORDERED.
+ *
+ * JMLIST_ASS_LRU
+ * associative list is a cache bounded to params.ass_list.capacity entries.
+ * the list is kept in recency order (head is the most recently used entry),
+ * jmlist_get_by_key moves the entry found to the head and inserting into a
+ * full list evicts the tail entry, both in O(1). params.ass_list.evict is
+ * called with the key and ptr of each evicted entry. hit, miss and eviction
+ * counters are read with jmlist_lru_stats. entries are always inserted at
+ * head, can't be used with JMLIST_ASS_INSERT_AT_TAIL or JMLIST_ASS_ORDERED.
+ *
+ * entries of unordered associative lists can be inserted with a ttl using
+ * jmlist_insert_with_key_ttl, they're removed by jmlist_expire(jml,now) once
+ * now reaches their expiry time (params.ass_list.evict is called for each).
+ * the list time is params.ass_list.clock() when set, otherwise the last time
+ * given to jmlist_expire. lookups don't return entries already expired even
+ * if jmlist_expire wasn't called yet.
+ *
+ * JMLIST_ASS_FILTER
+ * associative list keeps a counting bloom filter of its keys, key lookups
+ * check it first so most lookups of missing keys are answered by reading a
+ * single cache line. params.ass_list.filter_fpr sets the false positive rate
+ * and params.ass_list.filter_capacity the expected number of keys. the filter
+ * keeps its size, past filter_capacity keys its false positive rate goes up
+ * (it never misses a key that is in the list). jmlist_filter_rebuild resizes
+ * it for the keys in the list when the caller chooses, it walks all of them.
+ * with params.ass_list.filter_grow set the insert that outgrows the filter
+ * rebuilds it with twice the capacity, that one insert is O(N). ordered lists
+ * can only use it with the default comparator.
+ *
+ * unordered associative lists with up to params.ass_list.small_max entries
+ * (JMLIST_ASS_DEF_SMALL when 0, at most JMLIST_ASS_SMALL_MAX) don't allocate a
+ * hash index, key lookups compare the key hash with the hashes of all the
+ * entries kept in the list structure. the hash index is built when the list
+ * grows over small_max entries and dropped when it shrinks to small_max/2.
+ *
+ * unordered associative lists can be frozen with jmlist_freeze, the hash
+ * index is replaced by a minimal perfect hash of the distinct keys so a key
+ * lookup is one hash, one slot and one key comparison. inserts and removes
+ * fail with JMLIST_ERROR_FROZEN_LIST until jmlist_thaw rebuilds the hash index.
+ * ordered lists can be frozen too, the b+tree is replaced by a sorted array
+ * searched through an eytzinger layout of the key prefixes.
+ *
+ * JMLIST_ASS_CONCURRENT
+ * unordered associative list that can be used by several threads at once. keys
+ * are spread by hash over params.ass_list.shards shards (JMLIST_ASS_DEF_SHARDS
+ * when 0), each one an associative list with its own lock, so threads using
+ * keys of different shards don't wait for each other. only the key functions,
+ * jmlist_entry_count, jmlist_parse, jmlist_dump and jmlist_free can be used,
+ * the others fail with JMLIST_ERROR_UNSUPPORTED. memory used by the shards is
+ * accounted per shard and read with jmlist_shard_stats. can't be used with
+ * JMLIST_ASS_ORDERED or JMLIST_ASS_LRU.
+ *
+ * JMLIST_SEEK_CHECKED
+ * the list counts its changes (inserts, removes, lru moves, freeze and thaw)
+ * and jmlist_seek_next fails with JMLIST_ERROR_STALE_SEEK on a handle started
+ * before the last change, instead of following entries that may be gone.
+ * without it seeking a list that changed is up to the caller, as before.
  * 
  */
 typedef enum _jmlist_flags
@@ -88,7 +233,16 @@ typedef enum _jmlist_flags
 	JMLIST_ASS_INSERT_AT_TAIL = 8,
 	JMLIST_IDX_USE_FRAG_FLAG = 16,
 	JMLIST_LNK_INTERNAL = 32,
-	JMLIST_ASSOCIATIVE = 64
+	JMLIST_ASSOCIATIVE = 64,
+	JMLIST_ASS_ORDERED = 128,
+	JMLIST_ASS_KEY_U32 = 256,
+	JMLIST_ASS_KEY_U64 = 512,
+	JMLIST_ASS_KEY_PTR = 1024,
+	JMLIST_ASS_LRU = 2048,
+	JMLIST_ASS_FILTER = 4096,
+	JMLIST_ASS_CONCURRENT = 8192,
+	JMLIST_ASS_INTERNED = 16384,
+	JMLIST_SEEK_CHECKED = 32768
 } jmlist_flags;
 #define JMLIST_FLAGS 2
 
@@ -98,9 +252,105 @@ typedef enum _jmlist_lookup_result
 	jmlist_entry_found
 } jmlist_lookup_result;
 
+/* match returned by jmlist_find_parallel, the first one in list order or the
+   first one any thread finds */
+typedef enum _jmlist_find_mode
+{
+	JMLIST_FIND_FIRST,
+	JMLIST_FIND_ANY
+} jmlist_find_mode;
+
+/* predicates of jmlist_find_builtin on the entry pointers, with arguments a and
+   b. PTR_* compare them as addresses, INT_* as signed integers (for lists of
+   integers cast to void*) */
+typedef enum _jmlist_predicate
+{
+	JMLIST_PRED_PTR_EQ,	/* ptr == a */
+	JMLIST_PRED_PTR_RANGE,	/* a <= ptr < b */
+	JMLIST_PRED_INT_EQ,	/* ptr == a */
+	JMLIST_PRED_INT_LT,	/* ptr < a */
+	JMLIST_PRED_INT_GT,	/* ptr > a */
+	JMLIST_PRED_INT_RANGE	/* a <= ptr < b */
+} jmlist_predicate;
+
+/* what jmlist_find_builtin returns: the index of the first match, the indexes
+   of all the matches or only how many there are */
+typedef enum _jmlist_match_output
+{
+	JMLIST_MATCH_FIRST,
+	JMLIST_MATCH_ALL,
+	JMLIST_MATCH_COUNT
+} jmlist_match_output;
+
+typedef enum _jmlist_position
+{
+	JMLIST_HEAD,
+	JMLIST_TAIL
+} jmlist_position;
+
 typedef jmlist_status (*JMLISTFINDCALLBACK) (void *ptr,void *param,jmlist_lookup_result *result);
+typedef bool (*JMLISTFILTERCALLBACK) (void *ptr,void *param);
+typedef void* (*JMLISTMAPCALLBACK) (void *ptr,void *param);
+typedef void (*JMLISTREDUCECALLBACK) (void *acc,void *ptr,void *param);
+typedef void (*JMLISTCOMBINECALLBACK) (void *acc,void *part,void *param);
 typedef jmlist_status (*JMLISTDUMPCALLBACK) (void *ptr,int options);
 
+typedef void* jmlist_key;
+typedef uint32_t jmlist_key_length;
+
+/* key stored by value in lists with fixed width keys */
+typedef union _jmlist_key_value
+{
+	uint64_t u64;
+	uint32_t u32;
+	void *ptr;
+} jmlist_key_value;
+
+typedef uint32_t (*JMLISTHASHCALLBACK) (jmlist_key key_ptr,jmlist_key_length key_len);
+
+/* time of entries with ttl, in ticks of the user's choice */
+typedef uint64_t jmlist_time;
+typedef jmlist_time (*JMLISTCLOCKCALLBACK) (void);
+
+/* called with each entry evicted from a JMLIST_ASS_LRU list or expired */
+typedef void (*JMLISTEVICTCALLBACK) (jmlist_key key_ptr,jmlist_key_length key_len,void *ptr);
+
+/*
+ key interning table. each distinct key is copied once to an arena, after an
+ intern_key header with its id (ids are given in order from 0) and hash, the
+ pointer to the key bytes is the interned key. slots is an open addressing
+ table of the keys by hash and keys has them by id.
+ */
+typedef struct _intern_key
+{
+	uint32_t id;
+	uint32_t hash;
+	jmlist_key_length len;
+	char key[];
+} intern_key;
+
+typedef struct _intern_chunk
+{
+	struct _intern_chunk *next;
+	size_t size;
+	size_t used;
+	char data[];
+} intern_chunk;
+
+typedef struct _jmlist_intern_table
+{
+	intern_key **slots;
+	uint32_t slot_count;
+	uint32_t count;
+	intern_key **keys;
+	uint32_t key_capacity;
+	intern_chunk *chunks;
+} *jmlist_intern_table;
+
+/* returns <0, 0 or >0 if key1 is lower, equal or greater than key2 */
+typedef int (*JMLISTCOMPARECALLBACK) (jmlist_key key1_ptr,jmlist_key_length key1_len,
+		jmlist_key key2_ptr,jmlist_key_length key2_len);
+
 typedef struct _jmlist_params
 {
 	struct {
@@ -109,6 +359,18 @@ typedef struct _jmlist_params
 	struct {
 		jmlist_index init_size;
 	} lnk_list;
+	struct {
+		JMLISTCOMPARECALLBACK compare;
+		jmlist_index capacity;
+		JMLISTEVICTCALLBACK evict;
+		JMLISTCLOCKCALLBACK clock;
+		double filter_fpr;
+		jmlist_index filter_capacity;
+		bool filter_grow;
+		jmlist_index shards;
+		jmlist_intern_table intern;
+		jmlist_index small_max;
+	} ass_list;
 	char tag[16];
 	jmlist_flags flags;
 } jmlist_params, *jmlist_params_ptr;
@@ -123,21 +385,157 @@ typedef struct _linked_entry
 		void *ptr;
 } linked_entry;
 
-typedef void* jmlist_key;
-typedef uint32_t jmlist_key_length;
-
 typedef struct _assoc_entry
 {
 		struct _assoc_entry *next;
+		struct _assoc_entry *prev;
+		struct _assoc_entry *hnext;
+		uint32_t hash;
 		jmlist_key key_ptr;
 		jmlist_key_length key_len;
+		jmlist_key_value key_val;
 		void *ptr;
+		jmlist_time expire_at;
+		struct _assoc_entry *tnext;
+		struct _assoc_entry **tpprev;
+		struct _assoc_order *order;
 } assoc_entry;
 
+/*
+ order statistic tree of an unordered associative list, a treap of the entries
+ in list order where size is the number of entries under the node, used to
+ find an entry by its index in O(log N). it's built on the first access by
+ index and kept up to date by the inserts and removes after that, lists that
+ are never accessed by index don't have it.
+ */
+typedef struct _assoc_order
+{
+	struct _assoc_order *left;
+	struct _assoc_order *right;
+	struct _assoc_order *parent;
+	assoc_entry *entry;
+	jmlist_index size;
+	uint32_t priority;
+} assoc_order;
+
+/*
+ hierarchical timer wheel of the entries inserted with a ttl. an entry expiring
+ in less than JMLIST_WHEEL_SLOTS^(l+1) ticks is in level l, when time reaches
+ the start of a slot of level l>0 its entries are moved to the lower levels.
+ occupied has a bit set for each slot that has entries so the ticks without
+ work are skipped.
+ */
+typedef struct _assoc_wheel
+{
+	jmlist_time now;
+	jmlist_index count;
+	uint64_t occupied[JMLIST_WHEEL_LEVELS];
+	assoc_entry *slot[JMLIST_WHEEL_LEVELS][JMLIST_WHEEL_SLOTS];
+} assoc_wheel;
+
+/*
+ b+tree node used by ordered associative lists. leaves hold the entries
+ (keys are not copied, same as in assoc_entry) and are chained with next/prev
+ so in-order seeks walk leaf pages sequentially. internal nodes hold copies
+ of the separator keys, child[i] has keys lower or equal than key[i] and
+ child[i+1] has keys greater or equal than key[i]. key_pfx has the first 8
+ bytes of each key in big endian so most comparisons done with the default
+ comparator don't need to touch the key memory. size is the number of entries
+ under the node, an entry is found by its index going down from the root.
+ */
+typedef struct _bpt_node
+{
+	struct _bpt_node *parent;
+	struct _bpt_node *next;
+	struct _bpt_node *prev;
+	jmlist_index count;
+	jmlist_index size;
+	bool leaf;
+	uint64_t key_pfx[JMLIST_BPT_ORDER];
+	jmlist_key key_ptr[JMLIST_BPT_ORDER];
+	jmlist_key_length key_len[JMLIST_BPT_ORDER];
+	union {
+		void *ptr[JMLIST_BPT_ORDER];
+		struct _bpt_node *child[JMLIST_BPT_ORDER+1];
+	} u;
+} bpt_node;
+
+/*
+ counting bloom filter of associative lists. the counters of a key are all in
+ the same block (64 bytes of 4-bit counters), counters that reach 15 stay there
+ so they are never decremented to a false negative.
+ */
+typedef struct _assoc_filter
+{
+	uint32_t blocks;
+	uint32_t k;
+	jmlist_index capacity;
+	double fpr;
+	uint8_t counters[];
+} assoc_filter;
+
+/*
+ minimal perfect hash of a frozen associative list. a key goes to the pilot
+ bucket given by its 64-bit hash and the pilot of that bucket mixed with the
+ hash gives its slot, pilots were searched so that every distinct key of the
+ list has its own slot. slots keep the 64-bit hash, the key and the ptr of the
+ entry so a lookup doesn't touch the entries, only the first entry (in list
+ order) of duplicate keys has a slot (the others follow it in its hash chain).
+ */
+typedef struct _assoc_frozen_slot
+{
+	uint64_t hash;
+	jmlist_key key_ptr;
+	jmlist_key_length key_len;
+	void *ptr;
+	assoc_entry *entry;
+} assoc_frozen_slot;
+
+typedef struct _assoc_frozen
+{
+	uint64_t seed;
+	uint32_t count;
+	uint32_t bucket_count;
+	uint32_t *pilots;
+	assoc_frozen_slot *slots;
+} assoc_frozen;
+
+/*
+ frozen ordered associative list. the entries are laid out in eytzinger order
+ (1-based, node k has children 2k and 2k+1 so the levels of the implicit search
+ tree follow each other): pfx has the prefixes of their keys, key_ptr, key_len
+ and ptr the entries. rank has the sorted position of each node and node the
+ node of each sorted position (duplicate keys in insertion order). a search
+ only reads pfx until two prefixes are equal, the nodes
+ JMLIST_SORTED_PREFETCH_LEVELS levels below k are in one cache line of pfx.
+ */
+typedef struct _assoc_sorted
+{
+	jmlist_index count;
+	size_t size;
+	uint64_t *pfx;
+	jmlist_key *key_ptr;
+	void **ptr;
+	jmlist_key_length *key_len;
+	uint32_t *rank;
+	uint32_t *node;
+} assoc_sorted;
+
+/*
+ lock of the snapshots of a list, shared by the list and each of its
+ snapshots. refs counts them, the last one to let go of it frees it, so the
+ readers of a snapshot can still take it after the list was freed.
+ */
+typedef struct _snapshot_lock
+{
+	pthread_mutex_t mutex;
+	jmlist_index refs;
+} snapshot_lock;
+
 typedef struct _jmlist
 {
 	jmlist_flags flags;
-	bool seeking;
+	uint32_t generation;
 	struct {
 		void **plist;
 		jmlist_index capacity;
@@ -151,11 +549,86 @@ typedef struct _jmlist
 	} lnk_list;
 	struct {
 		assoc_entry *phead;
+		assoc_entry *ptail;
 		jmlist_index usage;
+		bpt_node *root;
+		JMLISTCOMPARECALLBACK compare;
+		JMLISTHASHCALLBACK hash;
+		jmlist_key_length key_width;
+		assoc_entry **buckets;
+		uint32_t bucket_count;
+		assoc_entry **old_buckets;
+		uint32_t old_bucket_count;
+		uint32_t rehash_pos;
+		jmlist_index capacity;
+		JMLISTEVICTCALLBACK evict;
+		uint64_t hits;
+		uint64_t misses;
+		uint64_t evictions;
+		assoc_wheel *wheel;
+		JMLISTCLOCKCALLBACK clock;
+		assoc_filter *filter;
+		bool filter_grow;
+		assoc_frozen *frozen;
+		assoc_sorted *sorted;
+		struct _assoc_shard *shards;
+		uint32_t shard_count;
+		jmlist_intern_table intern;
+		jmlist_index small_max;
+		jmlist_index small_count;
+		assoc_entry *small_chain;
+		uint32_t small_hash[JMLIST_ASS_SMALL_MAX];
+		assoc_entry *small_entry[JMLIST_ASS_SMALL_MAX];
+		assoc_order *order_root;
+		uint32_t order_seed;
 	} ass_list;
+	struct {
+		struct _jmlist_snapshot *list;
+		snapshot_lock *lock;
+		void **retired;
+		jmlist_index retired_count;
+		jmlist_index retired_capacity;
+	} snap;
 	char tag[16];
 } *jmlist;
 
+/*
+ node of a linked or unordered associative list changed while a snapshot was
+ open, next and ptr are the ones it had when the snapshot was taken.
+ */
+typedef struct _snapshot_node
+{
+	void *node;
+	void *next;
+	void *ptr;
+} snapshot_node;
+
+/*
+ copy-on-write snapshot of a list (see jmlist_snapshot). pages[p] is the copy
+ of slots p*JMLIST_SNAPSHOT_PAGE and up of an indexed list, made before the
+ first write to them, and 0 while they are unchanged. nodes is an open
+ addressing table, by address, of the nodes of the other lists changed since
+ the snapshot was taken. stale is set when a copy couldn't be allocated or the
+ list was freed (jml is 0 then). snapshots of a list are linked through next,
+ all of it is under lock, the snap.lock of the list.
+ */
+typedef struct _jmlist_snapshot
+{
+	jmlist jml;
+	snapshot_lock *lock;
+	struct _jmlist_snapshot *next;
+	jmlist_flags flags;
+	jmlist_index count;
+	jmlist_index slots;
+	void ***pages;
+	jmlist_index page_count;
+	void *head;
+	snapshot_node *nodes;
+	jmlist_index node_capacity;
+	jmlist_index node_count;
+	bool stale;
+} *jmlist_snap;
+
 typedef struct _dlinked_entry
 {
 	struct _dlinked_entry *next;
@@ -181,10 +654,187 @@ typedef struct _jmlist_memory_info
 	uint32_t used;
 } jmlist_memory_info, *jmlist_memory_info_ptr;
 
-typedef union _jmlist_seek_handle {
-	jmlist_index next_idx;
-	linked_entry *next_lnk;
-	assoc_entry *next_ass;
+/*
+ shard of a concurrent associative list, the list of the keys whose hash maps
+ to the shard, the lock held while it's used and the memory used by it.
+ */
+typedef struct _assoc_shard
+{
+	pthread_mutex_t lock;
+	struct _jmlist list;
+	jmlist_memory_info mem;
+} assoc_shard;
+
+typedef struct _jmlist_shard_info
+{
+	jmlist_index shard_count;
+	jmlist_index usage;
+	jmlist_memory_info mem;
+} jmlist_shard_info, *jmlist_shard_info_ptr;
+
+typedef struct _jmlist_lru_info
+{
+	jmlist_index capacity;
+	jmlist_index usage;
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+} jmlist_lru_info, *jmlist_lru_info_ptr;
+
+/*
+ chunk of a parallel parse: a range of slots of indexed lists (and of sorted
+ positions of frozen ordered lists), the first entry and the entry count of
+ linked and unordered associative lists, the first leaf, slot and entry count
+ of ordered lists or a shard of concurrent lists. match is the first entry of
+ the chunk matched by a parallel find.
+ */
+typedef struct _parse_chunk
+{
+	void *start;
+	jmlist_index slot;
+	jmlist_index count;
+	void *match;
+} parse_chunk;
+
+/*
+ chunks next to end-1 of a thread of a parallel parse, they are taken one at a
+ time by the thread and by the threads that are done with their own. pad keeps
+ each queue in its own cache line.
+ */
+typedef struct _parse_queue
+{
+	jmlist_index next;
+	jmlist_index end;
+	char pad[64 - 2*sizeof(jmlist_index)];
+} parse_queue;
+
+/*
+ stage of a pipeline, entries for which filter returns false are dropped and
+ map replaces each entry by the pointer it returns.
+ */
+typedef struct _pipeline_stage
+{
+	JMLISTFILTERCALLBACK filter;
+	JMLISTMAPCALLBACK map;
+	void *param;
+} pipeline_stage;
+
+/*
+ filter and map stages run on each entry of jml in a single pass, the entries
+ that reach the end go to sink or are reduced into acc (see jmlist_pipeline_run
+ and jmlist_pipeline_reduce). the pipeline is kept by the caller and can be
+ run any number of times.
+ */
+typedef struct _jmlist_pipeline
+{
+	jmlist jml;
+	pipeline_stage stage[JMLIST_PIPELINE_MAX_STAGES];
+	unsigned int stage_count;
+	JMLISTPARSERCALLBACK sink;
+	JMLISTREDUCECALLBACK reduce;
+	JMLISTCOMBINECALLBACK combine;
+	void *acc;
+	size_t acc_size;
+	void *param;
+} jmlist_pipeline;
+
+/*
+ parallel parse or find of a list (find set), found is the lowest chunk with a
+ match (chunk_count while there's none) and match the entry of that chunk. a
+ pipeline job (pipe set) reduces each chunk in its own copy of the accumulator
+ in accs, acc_stride bytes apart.
+ */
+typedef struct _parse_job
+{
+	jmlist jml;
+	JMLISTPARSERCALLBACK callback;
+	JMLISTFINDCALLBACK find;
+	jmlist_find_mode mode;
+	void *param;
+	parse_chunk *chunks;
+	jmlist_index chunk_count;
+	jmlist_index found;
+	void *match;
+	jmlist_pipeline *pipe;
+	char *accs;
+	size_t acc_stride;
+	parse_queue queue[JMLIST_POOL_MAX_THREADS];
+	unsigned int workers;
+	unsigned int active;
+} parse_job;
+
+/*
+ threads of jmlist_parse_parallel, created when first needed and kept until
+ jmlist_cleanup. lock is held by the thread running a parse, the others wait
+ in work_cond for a new round. the calling thread is worker 0 of the job,
+ thread i of the pool is worker i+1 and only the first job->workers take part.
+ */
+typedef struct _parse_pool
+{
+	pthread_mutex_t lock;
+	pthread_mutex_t work_lock;
+	pthread_cond_t work_cond;
+	pthread_cond_t done_cond;
+	pthread_t threads[JMLIST_POOL_MAX_THREADS-1];
+	unsigned int thread_count;
+	uint32_t round;
+	parse_job *job;
+	unsigned int workers;
+	bool stop;
+} parse_pool;
+
+/*
+ seek state, all of it is in the handle so a list can have any number of
+ seeks going on at once (nested or from several threads reading the list).
+ generation is the one of the list when the seek started, ranged is set by
+ jmlist_seek_key and jmlist_seek_range (those seeks can't go backwards).
+ current is the entry returned by the last jmlist_seek_next or jmlist_seek_prev
+ (valid set), the one jmlist_seek_remove_current removes. linked lists also
+ keep the entry before it (prev) and the entry before the handle position
+ (before) to unlink it without walking from the head.
+ */
+typedef struct _jmlist_seek_handle {
+	union {
+		jmlist_index next_idx;
+		linked_entry *next_lnk;
+		assoc_entry *next_ass;
+		struct {
+			assoc_entry *entry;
+			bool by_key;
+		} next_key;
+		struct {
+			bpt_node *leaf;		/* 0 in frozen lists, slot is the sorted position */
+			jmlist_index slot;
+			jmlist_key hi_ptr;
+			jmlist_key_length hi_len;
+			bool hi_incl;
+		} next_bpt;
+	} pos;
+	struct {
+		jmlist_index idx;
+		void *ptr;
+		linked_entry *lnk;
+		linked_entry *prev;
+		linked_entry *before;
+		assoc_entry *ass;
+		uint32_t hash;
+		bool valid;
+	} current;
+	/* entries before the handle on linked lists, stacked by jmlist_seek_prev and
+	   freed by jmlist_seek_end or the next seek start, valid while next is the
+	   handle position. owner is the handle that allocated entries, so a fresh
+	   (uninitialized) or copied handle never frees a stack it doesn't own */
+	struct {
+		struct _jmlist_seek_handle *owner;
+		linked_entry **entries;
+		jmlist_index count;
+		jmlist_index capacity;
+		linked_entry *next;
+		uint32_t generation;
+	} back;
+	uint32_t generation;
+	bool started;
+	bool ranged;
 } jmlist_seek_handle;
 
 #define DEBUGSTART if(jmlist_cfg.flags & JMLIST_FLAG_DEBUG) {
@@ -210,6 +860,7 @@ typedef union _jmlist_seek_handle {
 jmlist_status jmlist_set_internal_flags(jmlist_init_flags flags);
 jmlist_status jmlist_enable_debug(void);
 jmlist_status jmlist_disable_debug(void);
+jmlist_status jmlist_get_errno(void);
 jmlist_status jmlist_cleanup(void);
 jmlist_status jmlist_create(jmlist *new_jml,jmlist_params *params);
 jmlist_status jmlist_ptr_exists(jmlist jml,void *ptr,jmlist_lookup_result *result);
@@ -228,19 +879,68 @@ jmlist_status jmlist_is_fragmented(jmlist jml,bool force_seeker,bool *fragmented
 jmlist_status jmlist_memory_stats(jmlist_memory_info_ptr jml_mem);
 jmlist_status jmlist_free_all(void);
 jmlist_status jmlist_parse(jmlist jml,JMLISTPARSERCALLBACK callback,void *param);
+jmlist_status jmlist_parse_parallel(jmlist jml,JMLISTPARSERCALLBACK callback,void *param,unsigned int nthreads);
 jmlist_status jmlist_find(jmlist jml,JMLISTFINDCALLBACK callback,void *param,jmlist_lookup_result *result,void **ptr);
+jmlist_status jmlist_find_parallel(jmlist jml,JMLISTFINDCALLBACK callback,void *param,jmlist_find_mode mode,
+		unsigned int nthreads,jmlist_lookup_result *result,void **ptr);
+jmlist_status jmlist_pipeline_init(jmlist jml,jmlist_pipeline *pipe);
+jmlist_status jmlist_pipeline_filter(jmlist_pipeline *pipe,JMLISTFILTERCALLBACK filter,void *param);
+jmlist_status jmlist_pipeline_map(jmlist_pipeline *pipe,JMLISTMAPCALLBACK map,void *param);
+jmlist_status jmlist_pipeline_run(jmlist_pipeline *pipe,JMLISTPARSERCALLBACK sink,void *param,unsigned int nthreads);
+jmlist_status jmlist_pipeline_reduce(jmlist_pipeline *pipe,JMLISTREDUCECALLBACK reduce,JMLISTCOMBINECALLBACK combine,
+		void *acc,size_t acc_size,void *param,unsigned int nthreads);
+jmlist_status jmlist_find_builtin(jmlist jml,jmlist_predicate pred,intptr_t a,intptr_t b,
+		jmlist_match_output output,jmlist_index *indexes,jmlist_index cap,jmlist_index *count);
 jmlist_status jmlist_seek_start(jmlist jml,jmlist_seek_handle *handle_ptr);
 jmlist_status jmlist_seek_next(jmlist jml,jmlist_seek_handle *handle_ptr,void **ptr);
+jmlist_status jmlist_seek_start_reverse(jmlist jml,jmlist_seek_handle *handle_ptr);
+jmlist_status jmlist_seek_prev(jmlist jml,jmlist_seek_handle *handle_ptr,void **ptr);
+jmlist_status jmlist_seek_remove_current(jmlist jml,jmlist_seek_handle *handle_ptr);
+jmlist_status jmlist_seek_next_batch(jmlist jml,jmlist_seek_handle *handle_ptr,void **out,jmlist_index cap,jmlist_index *count);
 jmlist_status jmlist_seek_end(jmlist jml,jmlist_seek_handle *handle_ptr);
+jmlist_status jmlist_snapshot(jmlist jml,jmlist_snap *snap_ptr);
+jmlist_status jmlist_snapshot_seek_start(jmlist_snap snap,jmlist_seek_handle *handle_ptr);
+jmlist_status jmlist_snapshot_seek_next(jmlist_snap snap,jmlist_seek_handle *handle_ptr,void **ptr);
+jmlist_status jmlist_snapshot_parse(jmlist_snap snap,JMLISTPARSERCALLBACK callback,void *param);
+jmlist_status jmlist_snapshot_free(jmlist_snap snap);
 jmlist_status jmlist_entry_count(jmlist jml,jmlist_index *entry_count);
 jmlist_status jmlist_remove_by_index(jmlist jml,jmlist_index index);
 jmlist_status jmlist_replace_by_index(jmlist jml,jmlist_index index,void *new_ptr);
 jmlist_status jmlist_internal_count(jmlist_index *entry_count);
 
 jmlist_status jmlist_insert_with_key(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,void *ptr);
+jmlist_status jmlist_insert_with_key_at(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,void *ptr,jmlist_position pos);
 jmlist_status jmlist_get_by_key(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,void **ptr);
+jmlist_status jmlist_get_by_keys(jmlist jml,jmlist_key *keys,jmlist_key_length *lens,jmlist_index n,
+		void **out_ptrs,bool *out_found);
+jmlist_status jmlist_get_all_by_key(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,void **out_ptrs,
+		jmlist_index cap,jmlist_index *n);
 jmlist_status jmlist_key_exists(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,jmlist_lookup_result *result);
 jmlist_status jmlist_remove_by_key(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len);
+jmlist_status jmlist_insert_with_ikey(jmlist jml,uint64_t key,void *ptr);
+jmlist_status jmlist_get_by_ikey(jmlist jml,uint64_t key,void **ptr);
+jmlist_status jmlist_remove_by_ikey(jmlist jml,uint64_t key);
+jmlist_status jmlist_lru_stats(jmlist jml,jmlist_lru_info_ptr info);
+jmlist_status jmlist_insert_with_key_ttl(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,void *ptr,jmlist_time ttl);
+jmlist_status jmlist_expire(jmlist jml,jmlist_time now);
+jmlist_status jmlist_freeze(jmlist jml);
+jmlist_status jmlist_thaw(jmlist jml);
+jmlist_status jmlist_filter_rebuild(jmlist jml);
+jmlist_status jmlist_get_floor(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,bool inclusive,
+		jmlist_key *found_ptr,jmlist_key_length *found_len,void **ptr);
+jmlist_status jmlist_get_ceiling(jmlist jml,jmlist_key key_ptr,jmlist_key_length key_len,bool inclusive,
+		jmlist_key *found_ptr,jmlist_key_length *found_len,void **ptr);
+jmlist_status jmlist_seek_range(jmlist jml,jmlist_seek_handle *handle_ptr,jmlist_key lo_ptr,jmlist_key_length lo_len,
+		jmlist_key hi_ptr,jmlist_key_length hi_len);
+jmlist_status jmlist_seek_key(jmlist jml,jmlist_seek_handle *handle_ptr,jmlist_key key_ptr,jmlist_key_length key_len);
+jmlist_status jmlist_shard_stats(jmlist jml,jmlist_index shard,jmlist_shard_info_ptr info);
+jmlist_status jmlist_intern_create(jmlist_intern_table *new_table);
+jmlist_status jmlist_intern_free(jmlist_intern_table table);
+jmlist_status jmlist_intern_key(jmlist_intern_table table,jmlist_key key_ptr,jmlist_key_length key_len,
+		jmlist_key *interned,uint32_t *id);
+jmlist_status jmlist_intern_find(jmlist_intern_table table,jmlist_key key_ptr,jmlist_key_length key_len,
+		jmlist_key *interned,uint32_t *id);
+jmlist_status jmlist_intern_get_by_id(jmlist_intern_table table,uint32_t id,jmlist_key *key_ptr,jmlist_key_length *key_len);
 
 /* TODO
 
@@ -26,15 +26,55 @@
 #include <time.h>
 #include <sys/time.h>
 #include <assert.h>
+#include <pthread.h>
 
 #include "jmlist.h"
+#include "jmlist_inline.h"
 
 void jmlist_benchmark_print_status(char *func,jmlist_status status);
 int jmlist_benchmark(int argc,char *argv[]);
+double jmlist_benchmark_elapsed(struct timespec *ts_s,struct timespec *ts_e);
+int jmlist_benchmark_compare_time(const void *t1,const void *t2);
+void *jmlist_benchmark_concurrent_routine(void *param);
+void jmlist_benchmark_parse_routine(void *ptr,void *param);
 
 #define INDEXED_SIZE 10000
 #define INDEXED_SIZE_FLOAT (double)INDEXED_SIZE
 
+/* number of keys used to measure the worst case latency of associative list
+   operations while the hash index grows */
+#define LATENCY_SIZE (1024*1024)
+
+/* number of keys looked up by each jmlist_get_by_keys call */
+#define BATCH_SIZE 256
+
+/* keys of the concurrent list, lookups done by each thread and the largest
+   number of threads */
+#define CONCURRENT_SIZE (1024*1024)
+#define CONCURRENT_LOOKUPS (512*1024)
+#define CONCURRENT_MAX_THREADS 8
+
+/* entries of the indexed list parsed by 1 to CONCURRENT_MAX_THREADS threads
+   (kept small, inserts in indexed lists are O(N)) and rounds of work done by
+   the callback for each entry */
+#define PARSE_SIZE (64*1024)
+#define PARSE_WORK 256
+
+/* searches for the last entry of that list by jmlist_find_builtin (jmlist_find
+   checks the fragmentation of indexed lists for each entry, it's done once) */
+#define FIND_ROUNDS 100
+
+/* entries of the linked list half of which are removed while seeking it, by
+   jmlist_seek_remove_current or by jmlist_remove_by_ptr in a second pass
+   (kept small, each jmlist_remove_by_ptr looks for the entry from the head) */
+#define REMOVE_SIZE (32*1024)
+
+struct jmlist_benchmark_concurrent_arg
+{
+	jmlist jml;
+	unsigned int seed;
+};
+
 int main(int argc,char *argv[])
 {
 	return jmlist_benchmark(argc,argv);
@@ -48,6 +88,96 @@ void jmlist_benchmark_print_status(char *func,jmlist_status status)
 	printf("%s() = %s\n",func,status_str);
 }
 
+double jmlist_benchmark_elapsed(struct timespec *ts_s,struct timespec *ts_e)
+{
+	return (double)(ts_e->tv_sec - ts_s->tv_sec) + (ts_e->tv_nsec - ts_s->tv_nsec)*1e-9;
+}
+
+int jmlist_benchmark_compare_time(const void *t1,const void *t2)
+{
+	double d1 = *(const double*)t1;
+	double d2 = *(const double*)t2;
+	return (d1 > d2) - (d1 < d2);
+}
+
+/* cpu bound callback of the parallel parse, the result is kept per entry */
+void jmlist_benchmark_parse_routine(void *ptr,void *param)
+{
+	uint64_t *out = (uint64_t*)param;
+	uint64_t x = (uintptr_t)ptr;
+	unsigned int i;
+
+	for( i = 0 ; i < PARSE_WORK ; i++ ) {
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+	}
+	out[(uintptr_t)ptr - 1] = x;
+}
+
+/* jmlist_find callback matching the entry equal to param */
+jmlist_status jmlist_benchmark_find_routine(void *ptr,void *param,jmlist_lookup_result *result)
+{
+	*result = (ptr == param) ? jmlist_entry_found : jmlist_entry_not_found;
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/* stages of the pipeline benchmark, even entries are squared and summed. the
+   three pass version keeps the entries left by each pass in a linked list */
+bool jmlist_benchmark_even(void *ptr,void *param)
+{
+	return !((uintptr_t)ptr & 1);
+}
+
+void *jmlist_benchmark_square(void *ptr,void *param)
+{
+	return (void*)((uintptr_t)ptr * (uintptr_t)ptr);
+}
+
+void jmlist_benchmark_add(void *acc,void *ptr,void *param)
+{
+	*(uint64_t*)acc += (uintptr_t)ptr;
+}
+
+void jmlist_benchmark_add_sums(void *acc,void *part,void *param)
+{
+	*(uint64_t*)acc += *(uint64_t*)part;
+}
+
+void jmlist_benchmark_filter_pass(void *ptr,void *param)
+{
+	if( jmlist_benchmark_even(ptr,0) )
+		jmlist_insert((jmlist)param,ptr);
+}
+
+void jmlist_benchmark_map_pass(void *ptr,void *param)
+{
+	jmlist_insert((jmlist)param,jmlist_benchmark_square(ptr,0));
+}
+
+void jmlist_benchmark_reduce_pass(void *ptr,void *param)
+{
+	jmlist_benchmark_add(param,ptr,0);
+}
+
+/* random lookups of a concurrent list by one of the threads */
+void *jmlist_benchmark_concurrent_routine(void *param)
+{
+	struct jmlist_benchmark_concurrent_arg *arg = (struct jmlist_benchmark_concurrent_arg*)param;
+	jmlist_status s;
+	uint64_t key;
+	void *ptr;
+	unsigned int i;
+
+	for( i = 0 ; i < CONCURRENT_LOOKUPS ; i++ ) {
+		key = rand_r(&arg->seed) % CONCURRENT_SIZE;
+		s = jmlist_get_by_ikey(arg->jml,key,&ptr);
+		assert((s == JMLIST_ERROR_SUCCESS) && ((uintptr_t)ptr == key));
+	}
+
+	return 0;
+}
+
 int jmlist_benchmark(int argc,char *argv[])
 {
 	jmlist_status status;
@@ -58,6 +188,65 @@ int jmlist_benchmark(int argc,char *argv[])
 	double idx_access_time = 0.0;
 	double lnk_access_time = 0.0;
 	double ass_access_time = 0.0;
+	double ass_index_time[2] = {0.0,0.0};
+	struct timespec ts_s,ts_e;
+	double *op_time;
+	double lat_insert_avg = 0.0;
+	double lat_remove_avg = 0.0;
+	double lat_remove_p999;
+	double lat_remove_max;
+	double lat_insert_p999 = 0.0;
+	double lat_insert_max = 0.0;
+	double lat_access_avg = 0.0;
+	double lat_access_p999 = 0.0;
+	double lat_access_max = 0.0;
+	double single_lookup_time = 0.0;
+	double frozen_lookup_time = 0.0;
+	double frozen_batch_time = 0.0;
+	double interned_lookup_time = 0.0;
+	double interned_batch_time = 0.0;
+	double ordered_lookup_time[2] = {0.0,0.0};
+	double ordered_floor_time[2] = {0.0,0.0};
+	double sorted_freeze_time = 0.0;
+	double small_lookup_time[2] = {0.0,0.0};
+	double seek_time[2][3] = {{0.0,0.0,0.0},{0.0,0.0,0.0}};
+	jmlist_seek_handle seek_handle;
+	jmlist_index seek_n;
+	unsigned int seek_count;
+	unsigned int ordered;
+	unsigned int batched;
+	void *seek_ptr;
+	unsigned int small;
+	unsigned int frozen;
+	jmlist_intern_table intern_table;
+	jmlist_key *ikey_list;
+	unsigned int batch_idx[BATCH_SIZE];
+	double freeze_time;
+	double batch_lookup_time = 0.0;
+	jmlist_key batch_keys[BATCH_SIZE];
+	jmlist_key_length batch_lens[BATCH_SIZE];
+	void *batch_ptrs[BATCH_SIZE];
+	bool batch_found[BATCH_SIZE];
+	pthread_t threads[CONCURRENT_MAX_THREADS];
+	struct jmlist_benchmark_concurrent_arg thread_args[CONCURRENT_MAX_THREADS];
+	double concurrent_time[CONCURRENT_MAX_THREADS+1];
+	double parse_time[CONCURRENT_MAX_THREADS+1];
+	uint64_t *parse_out;
+	double find_time[2];
+	jmlist_lookup_result find_result;
+	jmlist_index find_index,find_count;
+	double pipeline_time[3];
+	jmlist_pipeline pipe;
+	jmlist pass_list[2];
+	uint64_t pipe_sum[3];
+	double snapshot_time[2][2];
+	jmlist_snap snap;
+	double remove_time[2];
+	jmlist_seek_handle remove_handle;
+	void **remove_list;
+	jmlist_index remove_count;
+	unsigned int thread_count;
+	unsigned int j;
 	unsigned int i;
 	jmlist_index *idx_list;
 	jmlist_status s;
@@ -186,9 +375,558 @@ int jmlist_benchmark(int argc,char *argv[])
 	gettimeofday(&tv_e,0);
 	printf("    ... access finished.\n");
 	ass_access_time = (double)((tv_e.tv_sec - tv_s.tv_sec) + (tv_e.tv_usec - tv_s.tv_usec)*1e-6);
+
+	/* the first access by index builds the order statistic tree */
+	printf("    ... accessing to %u random items by index...\n",INDEXED_SIZE);
+	gettimeofday(&tv_s,0);
+	for( i = 0 ; i < INDEXED_SIZE ; i++ )
+	{
+		s = jmlist_get_by_index(jml,idx_list[i] % INDEXED_SIZE,&ptr);
+		assert(s == JMLIST_ERROR_SUCCESS);
+	}
+	gettimeofday(&tv_e,0);
+	ass_index_time[0] = (double)((tv_e.tv_sec - tv_s.tv_sec) + (tv_e.tv_usec - tv_s.tv_usec)*1e-6);
 	
 	jmlist_free(jml);
 
+	params.flags = JMLIST_ASSOCIATIVE | JMLIST_ASS_ORDERED;
+	s = jmlist_create(&jml,&params);
+	assert(s == JMLIST_ERROR_SUCCESS);
+	for( i = 0 ; i < INDEXED_SIZE ; i++ )
+		jmlist_insert_with_key(jml,key_list[i],strlen(key_list[i]),key_list[i]);
+
+	printf("    ... accessing to %u random items by index (ordered)...\n",INDEXED_SIZE);
+	gettimeofday(&tv_s,0);
+	for( i = 0 ; i < INDEXED_SIZE ; i++ )
+	{
+		s = jmlist_get_by_index(jml,idx_list[i] % INDEXED_SIZE,&ptr);
+		assert(s == JMLIST_ERROR_SUCCESS);
+	}
+	gettimeofday(&tv_e,0);
+	ass_index_time[1] = (double)((tv_e.tv_sec - tv_s.tv_sec) + (tv_e.tv_usec - tv_s.tv_usec)*1e-6);
+
+	jmlist_free(jml);
+
+	for( i = 0 ; i < INDEXED_SIZE ; i++ )
+		free(key_list[i]);
+	free(key_list);
+
+	// JMLIST ASSOC LATENCY
+
+	params.flags = JMLIST_ASSOCIATIVE;
+	s = jmlist_create(&jml,&params);
+	assert(s == JMLIST_ERROR_SUCCESS);
+
+	printf("\n ------------------------------------------- \n");
+	printf(	" Benchmarking jmlist associative per operation latency.\n"
+			"    ... creating %u keys...\n",LATENCY_SIZE);
+
+	key_list = (void**)malloc(sizeof(void*)*LATENCY_SIZE);
+	for( i = 0 ; i < LATENCY_SIZE ; i++ ) {
+		sprintf(buffer,"key %d",i);
+		key_list[i] = strdup(buffer);
+	}
+
+	op_time = (double*)malloc(sizeof(double)*LATENCY_SIZE);
+
+	/* the hash index doubles several times during the inserts, the maximum
+	   shows the cost of the slowest single operation (it also catches the
+	   scheduler noise, the 99.9th percentile is less sensitive to it) */
+	printf("    ... inserting %u items in the list...\n",LATENCY_SIZE);
+	for( i = 0 ; i < LATENCY_SIZE ; i++ ) {
+		clock_gettime(CLOCK_MONOTONIC,&ts_s);
+		s = jmlist_insert_with_key(jml,key_list[i],strlen(key_list[i]),key_list[i]);
+		clock_gettime(CLOCK_MONOTONIC,&ts_e);
+		assert(s == JMLIST_ERROR_SUCCESS);
+
+		op_time[i] = jmlist_benchmark_elapsed(&ts_s,&ts_e);
+		lat_insert_avg += op_time[i];
+	}
+	lat_insert_avg /= LATENCY_SIZE;
+	qsort(op_time,LATENCY_SIZE,sizeof(double),jmlist_benchmark_compare_time);
+	lat_insert_p999 = op_time[LATENCY_SIZE - LATENCY_SIZE/1000];
+	lat_insert_max = op_time[LATENCY_SIZE-1];
+
+	printf("    ... accessing to %u items in the list...\n",LATENCY_SIZE);
+	for( i = 0 ; i < LATENCY_SIZE ; i++ ) {
+		clock_gettime(CLOCK_MONOTONIC,&ts_s);
+		s = jmlist_get_by_key(jml,key_list[i],strlen(key_list[i]),&ptr);
+		clock_gettime(CLOCK_MONOTONIC,&ts_e);
+		assert(s == JMLIST_ERROR_SUCCESS);
+		assert(ptr == (void*) key_list[i]);
+
+		op_time[i] = jmlist_benchmark_elapsed(&ts_s,&ts_e);
+		lat_access_avg += op_time[i];
+	}
+	lat_access_avg /= LATENCY_SIZE;
+	qsort(op_time,LATENCY_SIZE,sizeof(double),jmlist_benchmark_compare_time);
+	lat_access_p999 = op_time[LATENCY_SIZE - LATENCY_SIZE/1000];
+	lat_access_max = op_time[LATENCY_SIZE-1];
+	printf("    ... access finished.\n");
+
+	free(op_time);
+
+	/* random keys, so most lookups miss the cache */
+	printf("    ... accessing to %u random items, one by one and in batches of %u...\n",
+			LATENCY_SIZE,BATCH_SIZE);
+	for( i = 0 ; i < LATENCY_SIZE ; i += BATCH_SIZE ) {
+		for( j = 0 ; j < BATCH_SIZE ; j++ ) {
+			batch_keys[j] = key_list[rand() % LATENCY_SIZE];
+			batch_lens[j] = strlen(batch_keys[j]);
+		}
+
+		clock_gettime(CLOCK_MONOTONIC,&ts_s);
+		for( j = 0 ; j < BATCH_SIZE ; j++ )
+			jmlist_get_by_key(jml,batch_keys[j],batch_lens[j],&batch_ptrs[j]);
+		clock_gettime(CLOCK_MONOTONIC,&ts_e);
+		single_lookup_time += jmlist_benchmark_elapsed(&ts_s,&ts_e);
+
+		/* new keys, the ones above are now cached */
+		for( j = 0 ; j < BATCH_SIZE ; j++ ) {
+			batch_keys[j] = key_list[rand() % LATENCY_SIZE];
+			batch_lens[j] = strlen(batch_keys[j]);
+		}
+
+		clock_gettime(CLOCK_MONOTONIC,&ts_s);
+		s = jmlist_get_by_keys(jml,batch_keys,batch_lens,BATCH_SIZE,batch_ptrs,batch_found);
+		clock_gettime(CLOCK_MONOTONIC,&ts_e);
+		batch_lookup_time += jmlist_benchmark_elapsed(&ts_s,&ts_e);
+		assert(s == JMLIST_ERROR_SUCCESS);
+		for( j = 0 ; j < BATCH_SIZE ; j++ )
+			assert(batch_found[j] && (batch_ptrs[j] == batch_keys[j]));
+	}
+	printf("    ... access finished.\n");
+
+	printf("    ... freezing the list and accessing to %u random items, one by one and in batches...\n",LATENCY_SIZE);
+	clock_gettime(CLOCK_MONOTONIC,&ts_s);
+	s = jmlist_freeze(jml);
+	clock_gettime(CLOCK_MONOTONIC,&ts_e);
+	assert(s == JMLIST_ERROR_SUCCESS);
+	freeze_time = jmlist_benchmark_elapsed(&ts_s,&ts_e);
+	for( i = 0 ; i < LATENCY_SIZE ; i += BATCH_SIZE ) {
+		for( j = 0 ; j < BATCH_SIZE ; j++ ) {
+			batch_keys[j] = key_list[rand() % LATENCY_SIZE];
+			batch_lens[j] = strlen(batch_keys[j]);
+		}
+
+		clock_gettime(CLOCK_MONOTONIC,&ts_s);
+		for( j = 0 ; j < BATCH_SIZE ; j++ )
+			jmlist_get_by_key(jml,batch_keys[j],batch_lens[j],&batch_ptrs[j]);
+		clock_gettime(CLOCK_MONOTONIC,&ts_e);
+		frozen_lookup_time += jmlist_benchmark_elapsed(&ts_s,&ts_e);
+		for( j = 0 ; j < BATCH_SIZE ; j++ )
+			assert(batch_ptrs[j] == batch_keys[j]);
+
+		for( j = 0 ; j < BATCH_SIZE ; j++ ) {
+			batch_keys[j] = key_list[rand() % LATENCY_SIZE];
+			batch_lens[j] = strlen(batch_keys[j]);
+		}
+
+		clock_gettime(CLOCK_MONOTONIC,&ts_s);
+		s = jmlist_get_by_keys(jml,batch_keys,batch_lens,BATCH_SIZE,batch_ptrs,batch_found);
+		clock_gettime(CLOCK_MONOTONIC,&ts_e);
+		frozen_batch_time += jmlist_benchmark_elapsed(&ts_s,&ts_e);
+		assert(s == JMLIST_ERROR_SUCCESS);
+		for( j = 0 ; j < BATCH_SIZE ; j++ )
+			assert(batch_found[j] && (batch_ptrs[j] == batch_keys[j]));
+	}
+	printf("    ... access finished.\n");
+
+	/* oldest keys first, they're at the tail of the list */
+	s = jmlist_thaw(jml);
+	assert(s == JMLIST_ERROR_SUCCESS);
+	op_time = (double*)malloc(sizeof(double)*LATENCY_SIZE);
+	printf("    ... removing %u items from the list...\n",LATENCY_SIZE);
+	for( i = 0 ; i < LATENCY_SIZE ; i++ ) {
+		clock_gettime(CLOCK_MONOTONIC,&ts_s);
+		s = jmlist_remove_by_key(jml,key_list[i],strlen(key_list[i]));
+		clock_gettime(CLOCK_MONOTONIC,&ts_e);
+		assert(s == JMLIST_ERROR_SUCCESS);
+
+		op_time[i] = jmlist_benchmark_elapsed(&ts_s,&ts_e);
+		lat_remove_avg += op_time[i];
+	}
+	lat_remove_avg /= LATENCY_SIZE;
+	qsort(op_time,LATENCY_SIZE,sizeof(double),jmlist_benchmark_compare_time);
+	lat_remove_p999 = op_time[LATENCY_SIZE - LATENCY_SIZE/1000];
+	lat_remove_max = op_time[LATENCY_SIZE-1];
+	printf("    ... remove finished.\n");
+	free(op_time);
+
+	jmlist_free(jml);
+
+	/* same keys interned, lookups take the hash from the key and compare ids */
+	printf("    ... interning the keys and accessing to %u random items, one by one and in batches...\n",LATENCY_SIZE);
+	jmlist_intern_create(&intern_table);
+	ikey_list = (jmlist_key*)malloc(sizeof(jmlist_key)*LATENCY_SIZE);
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_ASSOCIATIVE | JMLIST_ASS_INTERNED;
+	params.ass_list.intern = intern_table;
+	jmlist_create(&jml,&params);
+	for( i = 0 ; i < LATENCY_SIZE ; i++ ) {
+		s = jmlist_intern_key(intern_table,key_list[i],strlen(key_list[i]),&ikey_list[i],0);
+		assert(s == JMLIST_ERROR_SUCCESS);
+		s = jmlist_insert_with_key(jml,ikey_list[i],strlen(key_list[i]),key_list[i]);
+		assert(s == JMLIST_ERROR_SUCCESS);
+	}
+	for( i = 0 ; i < LATENCY_SIZE ; i += BATCH_SIZE ) {
+		for( j = 0 ; j < BATCH_SIZE ; j++ ) {
+			batch_idx[j] = rand() % LATENCY_SIZE;
+			batch_keys[j] = ikey_list[batch_idx[j]];
+			batch_lens[j] = strlen(batch_keys[j]);
+		}
+
+		clock_gettime(CLOCK_MONOTONIC,&ts_s);
+		for( j = 0 ; j < BATCH_SIZE ; j++ )
+			jmlist_get_by_key(jml,batch_keys[j],batch_lens[j],&batch_ptrs[j]);
+		clock_gettime(CLOCK_MONOTONIC,&ts_e);
+		interned_lookup_time += jmlist_benchmark_elapsed(&ts_s,&ts_e);
+		for( j = 0 ; j < BATCH_SIZE ; j++ )
+			assert(batch_ptrs[j] == key_list[batch_idx[j]]);
+
+		for( j = 0 ; j < BATCH_SIZE ; j++ ) {
+			batch_idx[j] = rand() % LATENCY_SIZE;
+			batch_keys[j] = ikey_list[batch_idx[j]];
+			batch_lens[j] = strlen(batch_keys[j]);
+		}
+
+		clock_gettime(CLOCK_MONOTONIC,&ts_s);
+		s = jmlist_get_by_keys(jml,batch_keys,batch_lens,BATCH_SIZE,batch_ptrs,batch_found);
+		clock_gettime(CLOCK_MONOTONIC,&ts_e);
+		interned_batch_time += jmlist_benchmark_elapsed(&ts_s,&ts_e);
+		assert(s == JMLIST_ERROR_SUCCESS);
+		for( j = 0 ; j < BATCH_SIZE ; j++ )
+			assert(batch_found[j] && (batch_ptrs[j] == key_list[batch_idx[j]]));
+	}
+	printf("    ... access finished.\n");
+
+	jmlist_free(jml);
+	jmlist_intern_free(intern_table);
+	free(ikey_list);
+
+	/* same keys in an ordered list, looked up in the b+tree and then in the
+	   sorted array of the frozen list */
+	printf("    ... ordered list, accessing to %u random items by key and by floor, before and after freezing...\n",LATENCY_SIZE);
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_ASSOCIATIVE | JMLIST_ASS_ORDERED;
+	jmlist_create(&jml,&params);
+	for( i = 0 ; i < LATENCY_SIZE ; i++ ) {
+		s = jmlist_insert_with_key(jml,key_list[i],strlen(key_list[i]),key_list[i]);
+		assert(s == JMLIST_ERROR_SUCCESS);
+	}
+	for( frozen = 0 ; frozen < 2 ; frozen++ ) {
+		if( frozen ) {
+			clock_gettime(CLOCK_MONOTONIC,&ts_s);
+			s = jmlist_freeze(jml);
+			clock_gettime(CLOCK_MONOTONIC,&ts_e);
+			assert(s == JMLIST_ERROR_SUCCESS);
+			sorted_freeze_time = jmlist_benchmark_elapsed(&ts_s,&ts_e);
+		}
+
+		for( i = 0 ; i < LATENCY_SIZE ; i += BATCH_SIZE ) {
+			for( j = 0 ; j < BATCH_SIZE ; j++ ) {
+				batch_keys[j] = key_list[rand() % LATENCY_SIZE];
+				batch_lens[j] = strlen(batch_keys[j]);
+			}
+
+			clock_gettime(CLOCK_MONOTONIC,&ts_s);
+			for( j = 0 ; j < BATCH_SIZE ; j++ )
+				jmlist_get_by_key(jml,batch_keys[j],batch_lens[j],&batch_ptrs[j]);
+			clock_gettime(CLOCK_MONOTONIC,&ts_e);
+			ordered_lookup_time[frozen] += jmlist_benchmark_elapsed(&ts_s,&ts_e);
+			for( j = 0 ; j < BATCH_SIZE ; j++ )
+				assert(batch_ptrs[j] == batch_keys[j]);
+
+			/* one byte shorter, the floor is the key before it */
+			for( j = 0 ; j < BATCH_SIZE ; j++ ) {
+				batch_keys[j] = key_list[rand() % LATENCY_SIZE];
+				batch_lens[j] = strlen(batch_keys[j]) - 1;
+			}
+
+			clock_gettime(CLOCK_MONOTONIC,&ts_s);
+			for( j = 0 ; j < BATCH_SIZE ; j++ )
+				jmlist_get_floor(jml,batch_keys[j],batch_lens[j],true,0,0,&batch_ptrs[j]);
+			clock_gettime(CLOCK_MONOTONIC,&ts_e);
+			ordered_floor_time[frozen] += jmlist_benchmark_elapsed(&ts_s,&ts_e);
+		}
+	}
+	printf("    ... access finished.\n");
+
+	jmlist_free(jml);
+
+	/* a list with a few keys, scanned through its inline hashes and then
+	   with a hash index (small_max 1 builds it on the first insert) */
+	printf("    ... %u lookups in a list of %u keys, with and without hash index...\n",LATENCY_SIZE,JMLIST_ASS_DEF_SMALL);
+	for( small = 0 ; small < 2 ; small++ ) {
+		memset(&params,0,sizeof(params));
+		params.flags = JMLIST_ASSOCIATIVE;
+		params.ass_list.small_max = small ? 0 : 1;
+		jmlist_create(&jml,&params);
+		for( i = 0 ; i < JMLIST_ASS_DEF_SMALL ; i++ ) {
+			s = jmlist_insert_with_key(jml,key_list[i],strlen(key_list[i]),key_list[i]);
+			assert(s == JMLIST_ERROR_SUCCESS);
+		}
+		for( i = 0 ; i < LATENCY_SIZE ; i += BATCH_SIZE ) {
+			for( j = 0 ; j < BATCH_SIZE ; j++ ) {
+				batch_keys[j] = key_list[rand() % JMLIST_ASS_DEF_SMALL];
+				batch_lens[j] = strlen(batch_keys[j]);
+			}
+
+			clock_gettime(CLOCK_MONOTONIC,&ts_s);
+			for( j = 0 ; j < BATCH_SIZE ; j++ )
+				jmlist_get_by_key(jml,batch_keys[j],batch_lens[j],&batch_ptrs[j]);
+			clock_gettime(CLOCK_MONOTONIC,&ts_e);
+			small_lookup_time[small] += jmlist_benchmark_elapsed(&ts_s,&ts_e);
+			for( j = 0 ; j < BATCH_SIZE ; j++ )
+				assert(batch_ptrs[j] == batch_keys[j]);
+		}
+		jmlist_free(jml);
+	}
+	printf("    ... access finished.\n");
+
+	/* whole list seeks, an entry at a time, in batches of BATCH_SIZE and with
+	   the loops of jmlist_inline.h */
+	printf("    ... seeking lists of %u keys with seek_next, seek_next_batch and foreach...\n",LATENCY_SIZE);
+	for( ordered = 0 ; ordered < 2 ; ordered++ ) {
+		memset(&params,0,sizeof(params));
+		params.flags = JMLIST_ASSOCIATIVE | (ordered ? JMLIST_ASS_ORDERED : 0);
+		jmlist_create(&jml,&params);
+		for( i = 0 ; i < LATENCY_SIZE ; i++ ) {
+			s = jmlist_insert_with_key(jml,key_list[i],strlen(key_list[i]),key_list[i]);
+			assert(s == JMLIST_ERROR_SUCCESS);
+		}
+		for( batched = 0 ; batched < 3 ; batched++ ) {
+			seek_count = 0;
+			clock_gettime(CLOCK_MONOTONIC,&ts_s);
+			if( batched == 2 ) {
+				if( ordered ) {
+					JMLIST_BPT_FOREACH(jml,seek_ptr)
+						seek_count += (seek_ptr != 0);
+				} else {
+					JMLIST_ASS_FOREACH(jml,seek_ptr)
+						seek_count += (seek_ptr != 0);
+				}
+			} else {
+				jmlist_seek_start(jml,&seek_handle);
+				if( batched ) {
+					while( jmlist_seek_next_batch(jml,&seek_handle,batch_ptrs,BATCH_SIZE,&seek_n) == JMLIST_ERROR_SUCCESS )
+						seek_count += seek_n;
+				} else {
+					while( jmlist_seek_next(jml,&seek_handle,&batch_ptrs[0]) == JMLIST_ERROR_SUCCESS )
+						seek_count++;
+				}
+				jmlist_seek_end(jml,&seek_handle);
+			}
+			clock_gettime(CLOCK_MONOTONIC,&ts_e);
+			seek_time[ordered][batched] = jmlist_benchmark_elapsed(&ts_s,&ts_e);
+			assert(seek_count == LATENCY_SIZE);
+		}
+		jmlist_free(jml);
+	}
+	printf("    ... seeking finished.\n");
+
+	for( i = 0 ; i < LATENCY_SIZE ; i++ )
+		free(key_list[i]);
+	free(key_list);
+
+	// JMLIST ASSOCIATIVE CONCURRENT
+
+	printf("\n ------------------------------------------- \n");
+	printf(	" Benchmarking jmlist associative concurrent.\n"
+			" Random lookups of %u integer keys by 1 to %u threads.\n",CONCURRENT_SIZE,CONCURRENT_MAX_THREADS);
+
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_ASSOCIATIVE | JMLIST_ASS_KEY_U64 | JMLIST_ASS_CONCURRENT;
+	jmlist_create(&jml,&params);
+
+	for( i = 0 ; i < CONCURRENT_SIZE ; i++ ) {
+		s = jmlist_insert_with_ikey(jml,i,(void*)(uintptr_t)i);
+		assert(s == JMLIST_ERROR_SUCCESS);
+	}
+
+	for( thread_count = 1 ; thread_count <= CONCURRENT_MAX_THREADS ; thread_count *= 2 ) {
+		printf("    ... %u threads looking up %u keys each...\n",thread_count,CONCURRENT_LOOKUPS);
+		clock_gettime(CLOCK_MONOTONIC,&ts_s);
+		for( i = 0 ; i < thread_count ; i++ ) {
+			thread_args[i].jml = jml;
+			thread_args[i].seed = rand();
+			pthread_create(&threads[i],0,jmlist_benchmark_concurrent_routine,&thread_args[i]);
+		}
+		for( i = 0 ; i < thread_count ; i++ )
+			pthread_join(threads[i],0);
+		clock_gettime(CLOCK_MONOTONIC,&ts_e);
+		concurrent_time[thread_count] = jmlist_benchmark_elapsed(&ts_s,&ts_e);
+	}
+
+	jmlist_free(jml);
+
+	// JMLIST PARSE PARALLEL
+
+	printf("\n ------------------------------------------- \n");
+	printf(	" Benchmarking jmlist_parse_parallel.\n"
+			" Parsing %u entries of an indexed list by 1 to %u threads.\n",PARSE_SIZE,CONCURRENT_MAX_THREADS);
+
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_INDEXED | JMLIST_IDX_USE_SHIFT;
+	params.idx_list.malloc_inc = PARSE_SIZE;
+	jmlist_create(&jml,&params);
+	for( i = 0 ; i < PARSE_SIZE ; i++ ) {
+		s = jmlist_insert(jml,(void*)(uintptr_t)(i+1));
+		assert(s == JMLIST_ERROR_SUCCESS);
+	}
+	parse_out = (uint64_t*)calloc(PARSE_SIZE,sizeof(uint64_t));
+
+	for( thread_count = 1 ; thread_count <= CONCURRENT_MAX_THREADS ; thread_count *= 2 ) {
+		printf("    ... %u threads parsing the list...\n",thread_count);
+		clock_gettime(CLOCK_MONOTONIC,&ts_s);
+		s = jmlist_parse_parallel(jml,jmlist_benchmark_parse_routine,parse_out,thread_count);
+		clock_gettime(CLOCK_MONOTONIC,&ts_e);
+		assert((s == JMLIST_ERROR_SUCCESS) && parse_out[PARSE_SIZE-1]);
+		parse_time[thread_count] = jmlist_benchmark_elapsed(&ts_s,&ts_e);
+	}
+
+	free(parse_out);
+
+	// JMLIST FIND BUILTIN
+
+	printf("\n ------------------------------------------- \n");
+	printf(	" Benchmarking jmlist_find_builtin.\n"
+			" Finding the last of %u entries of an indexed list.\n",PARSE_SIZE);
+
+	printf("    ... jmlist_find with a callback...\n");
+	clock_gettime(CLOCK_MONOTONIC,&ts_s);
+	s = jmlist_find(jml,jmlist_benchmark_find_routine,(void*)(uintptr_t)PARSE_SIZE,&find_result,&ptr);
+	assert((s == JMLIST_ERROR_SUCCESS) && (find_result == jmlist_entry_found));
+	clock_gettime(CLOCK_MONOTONIC,&ts_e);
+	find_time[0] = jmlist_benchmark_elapsed(&ts_s,&ts_e);
+
+	printf("    ... jmlist_find_builtin with JMLIST_PRED_INT_EQ...\n");
+	clock_gettime(CLOCK_MONOTONIC,&ts_s);
+	for( i = 0 ; i < FIND_ROUNDS ; i++ ) {
+		s = jmlist_find_builtin(jml,JMLIST_PRED_INT_EQ,PARSE_SIZE,0,JMLIST_MATCH_FIRST,&find_index,1,&find_count);
+		assert((s == JMLIST_ERROR_SUCCESS) && (find_count == 1) && (find_index == PARSE_SIZE-1));
+	}
+	clock_gettime(CLOCK_MONOTONIC,&ts_e);
+	find_time[1] = jmlist_benchmark_elapsed(&ts_s,&ts_e);
+
+	// JMLIST PIPELINE
+
+	printf("\n ------------------------------------------- \n");
+	printf(	" Benchmarking jmlist_pipeline_reduce.\n"
+			" Sum of the squares of the even entries of an indexed list of %u entries.\n",PARSE_SIZE);
+
+	printf("    ... three passes with lists in between...\n");
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_LINKED;
+	jmlist_create(&pass_list[0],&params);
+	jmlist_create(&pass_list[1],&params);
+	pipe_sum[0] = 0;
+	clock_gettime(CLOCK_MONOTONIC,&ts_s);
+	s = jmlist_parse_parallel(jml,jmlist_benchmark_filter_pass,pass_list[0],1);
+	assert(s == JMLIST_ERROR_SUCCESS);
+	s = jmlist_parse_parallel(pass_list[0],jmlist_benchmark_map_pass,pass_list[1],1);
+	assert(s == JMLIST_ERROR_SUCCESS);
+	s = jmlist_parse_parallel(pass_list[1],jmlist_benchmark_reduce_pass,&pipe_sum[0],1);
+	assert(s == JMLIST_ERROR_SUCCESS);
+	clock_gettime(CLOCK_MONOTONIC,&ts_e);
+	pipeline_time[0] = jmlist_benchmark_elapsed(&ts_s,&ts_e);
+	jmlist_free(pass_list[0]);
+	jmlist_free(pass_list[1]);
+
+	jmlist_pipeline_init(jml,&pipe);
+	jmlist_pipeline_filter(&pipe,jmlist_benchmark_even,0);
+	jmlist_pipeline_map(&pipe,jmlist_benchmark_square,0);
+	for( i = 1 ; i <= 2 ; i++ ) {
+		thread_count = (i == 1) ? 1 : CONCURRENT_MAX_THREADS;
+		printf("    ... fused pass with %u threads...\n",thread_count);
+		pipe_sum[i] = 0;
+		clock_gettime(CLOCK_MONOTONIC,&ts_s);
+		s = jmlist_pipeline_reduce(&pipe,jmlist_benchmark_add,jmlist_benchmark_add_sums,
+				&pipe_sum[i],sizeof(pipe_sum[i]),0,thread_count);
+		clock_gettime(CLOCK_MONOTONIC,&ts_e);
+		assert((s == JMLIST_ERROR_SUCCESS) && (pipe_sum[i] == pipe_sum[0]));
+		pipeline_time[i] = jmlist_benchmark_elapsed(&ts_s,&ts_e);
+	}
+
+	// JMLIST SNAPSHOT
+
+	printf("\n ------------------------------------------- \n");
+	printf(	" Benchmarking jmlist_snapshot.\n"
+			" Replacing and parsing the %u entries of an indexed list with and without a snapshot.\n",PARSE_SIZE);
+
+	for( j = 0 ; j < 2 ; j++ ) {
+		printf("    ... %s...\n",j ? "snapshot open" : "no snapshot");
+		if( j ) {
+			s = jmlist_snapshot(jml,&snap);
+			assert(s == JMLIST_ERROR_SUCCESS);
+		}
+		clock_gettime(CLOCK_MONOTONIC,&ts_s);
+		for( i = 0 ; i < PARSE_SIZE ; i++ ) {
+			s = jmlist_replace_by_index(jml,i,(void*)(uintptr_t)(i+1));
+			assert(s == JMLIST_ERROR_SUCCESS);
+		}
+		clock_gettime(CLOCK_MONOTONIC,&ts_e);
+		snapshot_time[j][0] = jmlist_benchmark_elapsed(&ts_s,&ts_e);
+
+		pipe_sum[j] = 0;
+		clock_gettime(CLOCK_MONOTONIC,&ts_s);
+		if( j )
+			s = jmlist_snapshot_parse(snap,jmlist_benchmark_reduce_pass,&pipe_sum[j]);
+		else
+			s = jmlist_parse(jml,jmlist_benchmark_reduce_pass,&pipe_sum[j]);
+		clock_gettime(CLOCK_MONOTONIC,&ts_e);
+		assert((s == JMLIST_ERROR_SUCCESS) && (pipe_sum[j] == pipe_sum[0]));
+		snapshot_time[j][1] = jmlist_benchmark_elapsed(&ts_s,&ts_e);
+	}
+	jmlist_snapshot_free(snap);
+
+	jmlist_free(jml);
+
+	// JMLIST SEEK REMOVE CURRENT
+
+	printf("\n ------------------------------------------- \n");
+	printf(	" Benchmarking jmlist_seek_remove_current.\n"
+			" Removing the odd entries of a linked list of %u entries while seeking it.\n",REMOVE_SIZE);
+
+	remove_list = malloc(REMOVE_SIZE/2*sizeof(void*));
+	assert(remove_list);
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_LINKED;
+	for( j = 0 ; j < 2 ; j++ ) {
+		printf("    ... %s...\n",j ? "jmlist_seek_remove_current" : "jmlist_remove_by_ptr");
+		s = jmlist_create(&jml,&params);
+		assert(s == JMLIST_ERROR_SUCCESS);
+		for( i = 0 ; i < REMOVE_SIZE ; i++ ) {
+			s = jmlist_insert(jml,(void*)(uintptr_t)(i+1));
+			assert(s == JMLIST_ERROR_SUCCESS);
+		}
+
+		remove_count = 0;
+		clock_gettime(CLOCK_MONOTONIC,&ts_s);
+		jmlist_seek_start(jml,&remove_handle);
+		while( jmlist_seek_next(jml,&remove_handle,&ptr) == JMLIST_ERROR_SUCCESS ) {
+			if( !((uintptr_t)ptr & 1) )
+				continue;
+			if( j ) {
+				s = jmlist_seek_remove_current(jml,&remove_handle);
+				assert(s == JMLIST_ERROR_SUCCESS);
+			} else
+				remove_list[remove_count++] = ptr;
+		}
+		jmlist_seek_end(jml,&remove_handle);
+		for( i = 0 ; i < remove_count ; i++ ) {
+			s = jmlist_remove_by_ptr(jml,remove_list[i]);
+			assert(s == JMLIST_ERROR_SUCCESS);
+		}
+		clock_gettime(CLOCK_MONOTONIC,&ts_e);
+		remove_time[j] = jmlist_benchmark_elapsed(&ts_s,&ts_e);
+
+		jmlist_entry_count(jml,&remove_count);
+		assert(remove_count == REMOVE_SIZE/2);
+		jmlist_free(jml);
+	}
+	free(remove_list);
+
 	printf("\n list type     | insert time (k/s) | access time (k/s)\n");
 	printf(" indexed       | %17.3e | %15.3e \n",
 			INDEXED_SIZE_FLOAT/idx_insert_time*1e-3,
@@ -200,6 +938,71 @@ int jmlist_benchmark(int argc,char *argv[])
 			INDEXED_SIZE_FLOAT/ass_insert_time*1e-3,
 			INDEXED_SIZE_FLOAT/ass_access_time*1e-3);
 
+	printf("\n access by index (%u entries) | get_by_index (k/s)\n",INDEXED_SIZE);
+	printf(" associative                  | %18.3e \n",INDEXED_SIZE_FLOAT/ass_index_time[0]*1e-3);
+	printf(" associative ordered          | %18.3e \n",INDEXED_SIZE_FLOAT/ass_index_time[1]*1e-3);
+
+	printf("\n associative (%u keys) | avg latency (us) | 99.9%% latency (us) | max latency (us)\n",LATENCY_SIZE);
+	printf(" insert                   | %16.3f | %18.3f | %16.3f \n",
+			lat_insert_avg*1e6,lat_insert_p999*1e6,lat_insert_max*1e6);
+	printf(" get_by_key               | %16.3f | %18.3f | %16.3f \n",
+			lat_access_avg*1e6,lat_access_p999*1e6,lat_access_max*1e6);
+	printf(" remove_by_key            | %16.3f | %18.3f | %16.3f \n",
+			lat_remove_avg*1e6,lat_remove_p999*1e6,lat_remove_max*1e6);
+
+	printf("\n random lookups (%u keys) | get_by_key (k/s) | get_by_keys (k/s)\n",LATENCY_SIZE);
+	printf(" associative                | %16.3e | %17.3e \n",
+			LATENCY_SIZE/single_lookup_time*1e-3,LATENCY_SIZE/batch_lookup_time*1e-3);
+	printf(" frozen (freeze %6.3f s)    | %16.3e | %17.3e \n",
+			freeze_time,LATENCY_SIZE/frozen_lookup_time*1e-3,LATENCY_SIZE/frozen_batch_time*1e-3);
+	printf(" interned                   | %16.3e | %17.3e \n",
+			LATENCY_SIZE/interned_lookup_time*1e-3,LATENCY_SIZE/interned_batch_time*1e-3);
+
+	printf("\n ordered lookups (%u keys) | get_by_key (k/s) | get_floor (k/s)\n",LATENCY_SIZE);
+	printf(" b+tree                      | %16.3e | %15.3e \n",
+			LATENCY_SIZE/ordered_lookup_time[0]*1e-3,LATENCY_SIZE/ordered_floor_time[0]*1e-3);
+	printf(" frozen (freeze %6.3f s)    | %16.3e | %15.3e \n",
+			sorted_freeze_time,LATENCY_SIZE/ordered_lookup_time[1]*1e-3,LATENCY_SIZE/ordered_floor_time[1]*1e-3);
+
+	printf("\n small list lookups (%u keys) | get_by_key (k/s)\n",JMLIST_ASS_DEF_SMALL);
+	printf(" hash index                   | %16.3e \n",LATENCY_SIZE/small_lookup_time[0]*1e-3);
+	printf(" inline hashes                | %16.3e \n",LATENCY_SIZE/small_lookup_time[1]*1e-3);
+
+	printf("\n seeking (%u keys) | seek_next (k/s) | seek_next_batch (k/s) | foreach (k/s)\n",LATENCY_SIZE);
+	printf(" associative           | %15.3e | %21.3e | %13.3e \n",
+			LATENCY_SIZE/seek_time[0][0]*1e-3,LATENCY_SIZE/seek_time[0][1]*1e-3,LATENCY_SIZE/seek_time[0][2]*1e-3);
+	printf(" associative ordered   | %15.3e | %21.3e | %13.3e \n",
+			LATENCY_SIZE/seek_time[1][0]*1e-3,LATENCY_SIZE/seek_time[1][1]*1e-3,LATENCY_SIZE/seek_time[1][2]*1e-3);
+
+	printf("\n concurrent lookups (%u keys) | threads | get_by_ikey (k/s)\n",CONCURRENT_SIZE);
+	for( thread_count = 1 ; thread_count <= CONCURRENT_MAX_THREADS ; thread_count *= 2 )
+		printf(" associative concurrent       | %7u | %17.3e \n",
+				thread_count,thread_count*(double)CONCURRENT_LOOKUPS/concurrent_time[thread_count]*1e-3);
+
+	printf("\n parallel parse (%u entries) | threads | callbacks (k/s)\n",PARSE_SIZE);
+	for( thread_count = 1 ; thread_count <= CONCURRENT_MAX_THREADS ; thread_count *= 2 )
+		printf(" indexed                        | %7u | %15.3e \n",
+				thread_count,PARSE_SIZE/parse_time[thread_count]*1e-3);
+
+	printf("\n find last entry (%u entries) | entries compared (k/s)\n",PARSE_SIZE);
+	printf(" jmlist_find                     | %22.3e \n",PARSE_SIZE/find_time[0]*1e-3);
+	printf(" jmlist_find_builtin             | %22.3e \n",(double)PARSE_SIZE*FIND_ROUNDS/find_time[1]*1e-3);
+
+	printf("\n filter/map/reduce (%u entries) | entries (k/s)\n",PARSE_SIZE);
+	printf(" three passes                      | %13.3e \n",PARSE_SIZE/pipeline_time[0]*1e-3);
+	printf(" pipeline, 1 thread                | %13.3e \n",PARSE_SIZE/pipeline_time[1]*1e-3);
+	printf(" pipeline, %u threads               | %13.3e \n",CONCURRENT_MAX_THREADS,PARSE_SIZE/pipeline_time[2]*1e-3);
+
+	printf("\n snapshots (%u entries) | replace_by_index (k/s) | parse (k/s)\n",PARSE_SIZE);
+	printf(" no snapshot               | %22.3e | %11.3e \n",
+			PARSE_SIZE/snapshot_time[0][0]*1e-3,PARSE_SIZE/snapshot_time[0][1]*1e-3);
+	printf(" snapshot open             | %22.3e | %11.3e \n",
+			PARSE_SIZE/snapshot_time[1][0]*1e-3,PARSE_SIZE/snapshot_time[1][1]*1e-3);
+
+	printf("\n remove odd entries (%u entries) | entries seeked (k/s)\n",REMOVE_SIZE);
+	printf(" seek, then remove_by_ptr           | %20.3e \n",REMOVE_SIZE/remove_time[0]*1e-3);
+	printf(" seek_remove_current                | %20.3e \n",REMOVE_SIZE/remove_time[1]*1e-3);
+
 	jmlist_cleanup();
 
 	return EXIT_SUCCESS;
@@ -0,0 +1,233 @@
+/*
+	This file is part of jmlist.
+
+	The MIT License (MIT)
+	Copyright (c) 2014 Jean-François Mousinho
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in
+	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+	THE SOFTWARE.
+*/
+
+#ifndef _JMLIST_INLINE_H
+#define _JMLIST_INLINE_H
+
+#include "jmlist.h"
+
+/*
+ * inline access to the list structures, for loops where a call into jmlist.c
+ * for each entry costs more than the work done with it. nothing is checked
+ * here: jml must be a list of the type the accessor is for, indexes must be in
+ * range and the list must not change while a JMLIST_*FOREACH loop runs on it
+ * (entries can't be removed from inside the loop, jmlist_seek_* and
+ * jmlist_parse are still the way to do that). concurrent associative lists
+ * (JMLIST_ASS_CONCURRENT) are not supported.
+ *
+ * the entries are visited in the same order jmlist_seek_next returns them.
+ */
+
+/*
+ * number of entries of the list, same as jmlist_entry_count.
+ */
+static inline jmlist_index
+jmlist_inline_count(jmlist jml)
+{
+	if( jml->flags & JMLIST_INDEXED )
+		return jml->idx_list.usage;
+	if( jml->flags & JMLIST_LINKED )
+		return jml->lnk_list.usage;
+	return jml->ass_list.usage;
+}
+
+/*
+ * indexed lists. without JMLIST_IDX_USE_SHIFT removed entries leave holes,
+ * jmlist_idx_slots is the number of slots to look at and jmlist_idx_at returns
+ * JMLIST_EMPTY_PTR for the holes. with JMLIST_IDX_USE_SHIFT there are no holes,
+ * the usage first slots of jmlist_idx_array are the entries and a plain loop
+ * over them can be vectorised by the compiler.
+ */
+static inline jmlist_index
+jmlist_idx_slots(jmlist jml)
+{
+	return (jml->flags & JMLIST_IDX_USE_SHIFT) ? jml->idx_list.usage : jml->idx_list.capacity;
+}
+
+static inline void *
+jmlist_idx_at(jmlist jml,jmlist_index slot)
+{
+	return jml->idx_list.plist[slot];
+}
+
+static inline void **
+jmlist_idx_array(jmlist jml)
+{
+	return jml->idx_list.plist;
+}
+
+/*
+ * first entry of linked and unordered associative lists, the others follow
+ * through next.
+ */
+static inline linked_entry *
+jmlist_lnk_first(jmlist jml)
+{
+	return jml->lnk_list.phead;
+}
+
+static inline assoc_entry *
+jmlist_ass_first(jmlist jml)
+{
+	return jml->ass_list.phead;
+}
+
+/*
+ * cursor over any list type, used by JMLIST_BPT_FOREACH and JMLIST_FOREACH.
+ * ptr is the entry the cursor is at after jmlist_cursor_next returned true.
+ */
+typedef struct _jmlist_cursor
+{
+	jmlist_flags flags;
+	jmlist_index slot;
+	jmlist_index limit;
+	void **plist;
+	uint32_t *node;
+	linked_entry *lnk;
+	assoc_entry *ass;
+	bpt_node *leaf;
+	void *ptr;
+} jmlist_cursor;
+
+static inline jmlist_cursor
+jmlist_cursor_start(jmlist jml)
+{
+	jmlist_cursor cursor = { .flags = jml->flags };
+
+	if( jml->flags & JMLIST_INDEXED )
+	{
+		cursor.plist = jml->idx_list.plist;
+		cursor.limit = jmlist_idx_slots(jml);
+	} else if( jml->flags & JMLIST_LINKED )
+	{
+		cursor.lnk = jml->lnk_list.phead;
+	} else if( (jml->flags & JMLIST_ASS_ORDERED) && jml->ass_list.sorted )
+	{
+		/* frozen, entries are in ptr in eytzinger order and node has them sorted */
+		cursor.plist = jml->ass_list.sorted->ptr;
+		cursor.node = jml->ass_list.sorted->node;
+		cursor.limit = jml->ass_list.sorted->count;
+	} else if( jml->flags & JMLIST_ASS_ORDERED )
+	{
+		cursor.leaf = jml->ass_list.root;
+		while( cursor.leaf && !cursor.leaf->leaf )
+			cursor.leaf = cursor.leaf->u.child[0];
+	} else
+	{
+		cursor.ass = jml->ass_list.phead;
+	}
+
+	return cursor;
+}
+
+static inline bool
+jmlist_cursor_bpt_next(jmlist_cursor *cursor)
+{
+	if( cursor->node )
+	{
+		if( cursor->slot >= cursor->limit )
+			return false;
+		cursor->ptr = cursor->plist[cursor->node[cursor->slot++]];
+		return true;
+	}
+
+	while( cursor->leaf && (cursor->slot >= cursor->leaf->count) )
+	{
+		cursor->leaf = cursor->leaf->next;
+		cursor->slot = 0;
+	}
+	if( !cursor->leaf )
+		return false;
+
+	cursor->ptr = cursor->leaf->u.ptr[cursor->slot++];
+	return true;
+}
+
+static inline bool
+jmlist_cursor_next(jmlist_cursor *cursor)
+{
+	if( cursor->flags & JMLIST_INDEXED )
+	{
+		while( cursor->slot < cursor->limit )
+		{
+			cursor->ptr = cursor->plist[cursor->slot++];
+			if( cursor->ptr != JMLIST_EMPTY_PTR )
+				return true;
+		}
+		return false;
+	}
+
+	if( cursor->flags & JMLIST_LINKED )
+	{
+		if( !cursor->lnk )
+			return false;
+		cursor->ptr = cursor->lnk->ptr;
+		cursor->lnk = cursor->lnk->next;
+		return true;
+	}
+
+	if( cursor->flags & JMLIST_ASS_ORDERED )
+		return jmlist_cursor_bpt_next(cursor);
+
+	if( !cursor->ass )
+		return false;
+	cursor->ptr = cursor->ass->ptr;
+	cursor->ass = cursor->ass->next;
+	return true;
+}
+
+/*
+ * iteration macros, var is a pointer variable set to each entry of the list:
+ *
+ *	char *str;
+ *	JMLIST_LNK_FOREACH(jml,str)
+ *		printf("%s\n",str);
+ *
+ * the _IDX, _LNK, _ASS and _BPT versions are for indexed, linked, unordered
+ * associative and ordered associative lists, JMLIST_FOREACH works with all of
+ * them and checks the type of the list for each entry. break and continue work
+ * as in any loop.
+ */
+#define JMLIST_IDX_FOREACH(jml,var) \
+	for( jmlist_index _jmlist_i = 0, _jmlist_n = jmlist_idx_slots(jml) ; _jmlist_i < _jmlist_n ; _jmlist_i++ ) \
+		if( ((var) = (jml)->idx_list.plist[_jmlist_i]) == JMLIST_EMPTY_PTR ) {} else
+
+#define JMLIST_LNK_FOREACH(jml,var) \
+	for( linked_entry *_jmlist_e = (jml)->lnk_list.phead ; \
+			_jmlist_e && (((var) = _jmlist_e->ptr), true) ; _jmlist_e = _jmlist_e->next )
+
+#define JMLIST_ASS_FOREACH(jml,var) \
+	for( assoc_entry *_jmlist_e = (jml)->ass_list.phead ; \
+			_jmlist_e && (((var) = _jmlist_e->ptr), true) ; _jmlist_e = _jmlist_e->next )
+
+#define JMLIST_BPT_FOREACH(jml,var) \
+	for( jmlist_cursor _jmlist_c = jmlist_cursor_start(jml) ; \
+			jmlist_cursor_bpt_next(&_jmlist_c) && (((var) = _jmlist_c.ptr), true) ; )
+
+#define JMLIST_FOREACH(jml,var) \
+	for( jmlist_cursor _jmlist_c = jmlist_cursor_start(jml) ; \
+			jmlist_cursor_next(&_jmlist_c) && (((var) = _jmlist_c.ptr), true) ; )
+
+#endif
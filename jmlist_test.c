@@ -23,15 +23,19 @@
 	THE SOFTWARE.
 */
 
+#define _GNU_SOURCE
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 #include <time.h>
 #include <sys/time.h>
+#include <pthread.h>
 
 #include "jmlist_test.h"
 #include "jmlist.h"
+#include "jmlist_inline.h"
 
 void jmlist_test_print_status(char *func,jmlist_status status)
 {
@@ -51,6 +55,301 @@ find_routine(void *ptr,void *param,jmlist_lookup_result *result)
 	return JMLIST_ERROR_SUCCESS;
 }
 
+/* used by the concurrent list test, each thread works on its own range of keys */
+struct concurrent_arg
+{
+	jmlist jml;
+	uint64_t first;
+	int count;
+	int errors;
+};
+
+void *
+concurrent_routine(void *param)
+{
+	struct concurrent_arg *arg = (struct concurrent_arg*)param;
+	void *ptr;
+
+	for( int i = 0 ; i < arg->count ; i++ )
+		if( jmlist_insert_with_ikey(arg->jml,arg->first+i,(void*)(uintptr_t)(arg->first+i)) != JMLIST_ERROR_SUCCESS )
+			arg->errors++;
+
+	for( int i = 0 ; i < arg->count ; i++ )
+		if( (jmlist_get_by_ikey(arg->jml,arg->first+i,&ptr) != JMLIST_ERROR_SUCCESS) ||
+				((uintptr_t)ptr != arg->first+i) )
+			arg->errors++;
+
+	/* removes the odd keys */
+	for( int i = 1 ; i < arg->count ; i += 2 )
+		if( jmlist_remove_by_ikey(arg->jml,arg->first+i) != JMLIST_ERROR_SUCCESS )
+			arg->errors++;
+
+	return 0;
+}
+
+/* used by the concurrent seek test, each thread seeks the whole list */
+struct seek_arg
+{
+	jmlist jml;
+	int seen;
+};
+
+void *
+seek_routine(void *param)
+{
+	struct seek_arg *arg = (struct seek_arg*)param;
+	jmlist_seek_handle handle;
+	void *ptr;
+
+	for( int i = 0 ; i < 100 ; i++ )
+	{
+		jmlist_seek_start(arg->jml,&handle);
+		while( jmlist_seek_next(arg->jml,&handle,&ptr) == JMLIST_ERROR_SUCCESS )
+			arg->seen++;
+		jmlist_seek_end(arg->jml,&handle);
+	}
+
+	return 0;
+}
+
+/* used by the parallel parse test, counts the calls for each entry of the
+   keys array, some entries cost much more than the others */
+struct parse_arg
+{
+	char (*keys)[8];
+	int marks[5000];
+	int calls;
+	pthread_mutex_t lock;
+	jmlist inner;
+	jmlist_status inner_status;
+};
+
+void
+parse_parallel_routine(void *ptr,void *param)
+{
+	struct parse_arg *arg = (struct parse_arg*)param;
+	int i = (int)((char(*)[8])ptr - arg->keys);
+	volatile int spin;
+
+	if( (i % 97) == 0 )
+		for( spin = 0 ; spin < 100000 ; spin++ );
+
+	/* a parse from the callback runs in the thread of the callback, inner is
+	   only read by the thread passed entry 1 */
+	if( (i == 1) && arg->inner )
+	{
+		jmlist inner = arg->inner;
+		arg->inner = 0;
+		arg->inner_status = jmlist_parse_parallel(inner,parse_parallel_routine,param,4);
+	}
+
+	pthread_mutex_lock(&arg->lock);
+	arg->marks[i]++;
+	arg->calls++;
+	pthread_mutex_unlock(&arg->lock);
+}
+
+/* used by the parallel find test, matches the keys whose position in the keys
+   array ends in needle (modulo 1000) */
+struct find_arg
+{
+	char (*keys)[8];
+	int needle;
+};
+
+jmlist_status
+find_parallel_routine(void *ptr,void *param,jmlist_lookup_result *result)
+{
+	struct find_arg *arg = (struct find_arg*)param;
+	int i = (int)((char(*)[8])ptr - arg->keys);
+
+	*result = ((i % 1000) == arg->needle) ? jmlist_entry_found : jmlist_entry_not_found;
+	return JMLIST_ERROR_SUCCESS;
+}
+
+/* pipeline stages of test 33, entries are integers */
+bool
+pipeline_odd(void *ptr,void *param)
+{
+	return ((intptr_t)ptr) & 1;
+}
+
+void *
+pipeline_square(void *ptr,void *param)
+{
+	return (void*)((intptr_t)ptr * (intptr_t)ptr);
+}
+
+void
+pipeline_add(void *acc,void *ptr,void *param)
+{
+	*(uint64_t*)acc += (uintptr_t)ptr;
+}
+
+/* the copies of acc reduced by the threads start at a cache line */
+static bool pipe_parts_aligned = true;
+
+void
+pipeline_add_parts(void *acc,void *part,void *param)
+{
+	if( (uintptr_t)part & 63 )
+		pipe_parts_aligned = false;
+	*(uint64_t*)acc += *(uint64_t*)part;
+}
+
+/* order dependent, no combine */
+void
+pipeline_hash(void *acc,void *ptr,void *param)
+{
+	*(uint64_t*)acc = *(uint64_t*)acc*31 + (uintptr_t)ptr;
+}
+
+struct pipeline_out
+{
+	intptr_t out[5000];
+	int count;
+};
+
+void
+pipeline_sink(void *ptr,void *param)
+{
+	struct pipeline_out *out = (struct pipeline_out*)param;
+	out->out[out->count++] = (intptr_t)ptr;
+}
+
+/* used by the snapshot test, expected has the entries the snapshot was taken
+   with, the thread version checks the snapshot rounds times while the list is
+   changed by the main thread */
+struct snapshot_arg
+{
+	jmlist_snap snap;
+	intptr_t *expected;
+	int count;
+	int seen;
+	bool ok;
+	int rounds;
+	int failures;
+};
+
+void
+snapshot_check(void *ptr,void *param)
+{
+	struct snapshot_arg *arg = (struct snapshot_arg*)param;
+
+	if( (arg->seen >= arg->count) || ((intptr_t)ptr != arg->expected[arg->seen]) )
+		arg->ok = false;
+	arg->seen++;
+}
+
+bool
+snapshot_verify(struct snapshot_arg *arg)
+{
+	jmlist_seek_handle handle;
+	void *ptr;
+	int i = 0;
+
+	arg->seen = 0;
+	arg->ok = true;
+	if( (jmlist_snapshot_parse(arg->snap,snapshot_check,arg) != JMLIST_ERROR_SUCCESS) ||
+			!arg->ok || (arg->seen != arg->count) )
+		return false;
+
+	jmlist_snapshot_seek_start(arg->snap,&handle);
+	while( jmlist_snapshot_seek_next(arg->snap,&handle,&ptr) == JMLIST_ERROR_SUCCESS )
+		if( (i >= arg->count) || ((intptr_t)ptr != arg->expected[i++]) )
+			return false;
+	return i == arg->count;
+}
+
+void *
+snapshot_routine(void *param)
+{
+	struct snapshot_arg *arg = (struct snapshot_arg*)param;
+
+	for( int r = 0 ; r < arg->rounds ; r++ )
+		if( !snapshot_verify(arg) )
+			arg->failures++;
+
+	return 0;
+}
+
+/* reads the snapshot until it goes stale, the list is freed meanwhile */
+void *
+snapshot_stale_routine(void *param)
+{
+	struct snapshot_arg *arg = (struct snapshot_arg*)param;
+
+	for( int r = 0 ; r < arg->rounds ; r++ )
+	{
+		arg->seen = 0;
+		arg->ok = true;
+		if( jmlist_snapshot_parse(arg->snap,snapshot_check,arg) != JMLIST_ERROR_SUCCESS )
+			break;
+		if( !arg->ok || (arg->seen != arg->count) )
+			arg->failures++;
+	}
+
+	return 0;
+}
+
+/* plain loop over the slots of an indexed list, checks jmlist_find_builtin */
+jmlist_index
+find_builtin_reference(jmlist jml,jmlist_predicate pred,intptr_t a,intptr_t b,jmlist_index *indexes)
+{
+	jmlist_index count = 0;
+
+	for( jmlist_index i = 0 ; i < jml->idx_list.capacity ; i++ )
+	{
+		void *ptr = jml->idx_list.plist[i];
+		intptr_t s = (intptr_t)ptr;
+		uintptr_t u = (uintptr_t)ptr;
+		bool match;
+
+		if( (ptr == JMLIST_EMPTY_PTR) || ((jml->flags & JMLIST_IDX_USE_SHIFT) && (i >= jml->idx_list.usage)) )
+			continue;
+
+		switch( pred )
+		{
+			case JMLIST_PRED_PTR_RANGE: match = (u >= (uintptr_t)a) && (u < (uintptr_t)b); break;
+			case JMLIST_PRED_INT_LT: match = (s < a); break;
+			case JMLIST_PRED_INT_GT: match = (s > a); break;
+			case JMLIST_PRED_INT_RANGE: match = (s >= a) && (s < b); break;
+			default: match = (s == a); break;
+		}
+		if( match )
+			indexes[count++] = i;
+	}
+
+	return count;
+}
+
+int
+reverse_compare(jmlist_key key1_ptr,jmlist_key_length key1_len,jmlist_key key2_ptr,jmlist_key_length key2_len)
+{
+	int r = memcmp(key1_ptr,key2_ptr,(key1_len < key2_len) ? key1_len : key2_len);
+	if( r )
+		return -r;
+	return (int)key2_len - (int)key1_len;
+}
+
+static void *last_evicted = 0;
+
+void
+lru_evict(jmlist_key key_ptr,jmlist_key_length key_len,void *ptr)
+{
+	printf("lru_evict key_len=%u ptr=%p\n",key_len,ptr);
+	last_evicted = ptr;
+}
+
+/* list time of the ttl tests that don't call jmlist_expire */
+static jmlist_time test_now = 0;
+
+jmlist_time
+test_clock(void)
+{
+	return test_now;
+}
+
 int main(int argc,char *argv[])
 {
 	jmlist_status status;
@@ -500,6 +799,2275 @@ int main(int argc,char *argv[])
 
 	jmlist_free(jml);
 
+	/*
+	 * TEST 11: Test the ordered associative list. Keys are inserted out of order,
+	 * enough of them to split the b+tree nodes, seeking must return them sorted.
+	 */
+	printf(	"\n  TEST #11 ------------------------------------------------------- \n"
+			"    Test the ordered associative list, keys are inserted out of order\n"
+			"    and seeking must return them sorted, also test range seeking.\n\n");
+
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_ASSOCIATIVE | JMLIST_ASS_ORDERED;
+	jmlist_create(&jml,&params);
+
+	char okeys[1000][8];
+	jmlist_disable_debug();
+	for( int i = 0 ; i < 1000 ; i++ )
+	{
+		/* 7 is coprime with 1000 so all the keys are inserted */
+		sprintf(okeys[i],"k%03d",(i*7) % 1000);
+		jmlist_insert_with_key(jml,okeys[i],4,okeys[i]);
+	}
+
+	bool ordered = true;
+	jmlist_index seek_count = 0;
+	char *prev_key = "";
+	jmlist_seek_start(jml,&shandle);
+	while( jmlist_seek_next(jml,&shandle,&ptr) == JMLIST_ERROR_SUCCESS )
+	{
+		if( strcmp(prev_key,ptr) >= 0 )
+			ordered = false;
+		prev_key = ptr;
+		seek_count++;
+	}
+	jmlist_seek_end(jml,&shandle);
+	jmlist_enable_debug();
+
+	if( ordered && (seek_count == 1000) )
+		printf("  TEST #11.1 OK\n");
+	else
+		printf("  TEST #11.1 NOT OK\n");
+
+	status = jmlist_get_by_key(jml,"k500",4,&ptr);
+	if( (status == JMLIST_ERROR_SUCCESS) && !strcmp(ptr,"k500") )
+		printf("  TEST #11.2 OK\n");
+	else
+		printf("  TEST #11.2 NOT OK\n");
+
+	seek_count = 0;
+	jmlist_seek_range(jml,&shandle,"k100",4,"k110",4);
+	while( jmlist_seek_next(jml,&shandle,&ptr) == JMLIST_ERROR_SUCCESS )
+		seek_count++;
+	jmlist_seek_end(jml,&shandle);
+	if( seek_count == 10 )
+		printf("  TEST #11.3 OK\n");
+	else
+		printf("  TEST #11.3 NOT OK\n");
+
+	jmlist_disable_debug();
+	for( int i = 0 ; i < 1000 ; i += 2 )
+		jmlist_remove_by_key(jml,okeys[i],4);
+	jmlist_enable_debug();
+
+	jmlist_entry_count(jml,&count);
+	status = jmlist_get_by_index(jml,0,&ptr);
+	if( (count == 500) && (status == JMLIST_ERROR_SUCCESS) && !strcmp(ptr,"k001") )
+		printf("  TEST #11.4 OK\n");
+	else
+		printf("  TEST #11.4 NOT OK\n");
+
+	jmlist_free(jml);
+
+	params.ass_list.compare = reverse_compare;
+	jmlist_create(&jml,&params);
+	jmlist_insert_with_key(jml,"b",1,"b");
+	jmlist_insert_with_key(jml,"c",1,"c");
+	jmlist_insert_with_key(jml,"a",1,"a");
+	jmlist_dump(jml);
+	status = jmlist_get_by_index(jml,0,&ptr);
+	if( (status == JMLIST_ERROR_SUCCESS) && !strcmp(ptr,"c") )
+		printf("  TEST #11.5 OK\n");
+	else
+		printf("  TEST #11.5 NOT OK\n");
+	jmlist_free(jml);
+
+	/*
+	 * TEST 12: Test the hash index of associative lists. The table grows while
+	 * keys are inserted, lookups must find every key while the old buckets are
+	 * still being migrated and duplicated keys must return the same entry a
+	 * list walk would find (the newest one when inserting at head, the oldest
+	 * one when inserting at tail).
+	 */
+	printf(	"\n  TEST #12 ------------------------------------------------------- \n"
+			"    Test the hash index of associative lists during incremental growth\n"
+			"    and the lookup order of duplicated keys.\n\n");
+
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_ASSOCIATIVE;
+	jmlist_create(&jml,&params);
+
+	/* 17 entries make the table grow from 16 to 32 buckets, only a few old
+	   buckets are migrated at this point */
+	char hkeys[5000][8];
+	jmlist_disable_debug();
+	for( int i = 0 ; i < 17 ; i++ )
+	{
+		sprintf(hkeys[i],"h%04d",i);
+		jmlist_insert_with_key(jml,hkeys[i],5,hkeys[i]);
+	}
+	bool found_all = (jml->ass_list.old_buckets != 0);
+	for( int i = 0 ; i < 17 ; i++ )
+	{
+		if( (jmlist_get_by_key(jml,hkeys[i],5,&ptr) != JMLIST_ERROR_SUCCESS) || (ptr != hkeys[i]) )
+			found_all = false;
+	}
+	jmlist_enable_debug();
+
+	if( found_all )
+		printf("  TEST #12.1 OK\n");
+	else
+		printf("  TEST #12.1 NOT OK\n");
+
+	jmlist_disable_debug();
+	for( int i = 17 ; i < 5000 ; i++ )
+	{
+		sprintf(hkeys[i],"h%04d",i);
+		jmlist_insert_with_key(jml,hkeys[i],5,hkeys[i]);
+	}
+	for( int i = 0 ; i < 5000 ; i += 2 )
+		jmlist_remove_by_key(jml,hkeys[i],5);
+	found_all = true;
+	for( int i = 0 ; i < 5000 ; i++ )
+	{
+		status = jmlist_get_by_key(jml,hkeys[i],5,&ptr);
+		if( (i % 2) && ((status != JMLIST_ERROR_SUCCESS) || (ptr != hkeys[i])) )
+			found_all = false;
+		if( !(i % 2) && (status == JMLIST_ERROR_SUCCESS) )
+			found_all = false;
+	}
+	jmlist_enable_debug();
+
+	jmlist_entry_count(jml,&count);
+	if( found_all && (count == 2500) )
+		printf("  TEST #12.2 OK\n");
+	else
+		printf("  TEST #12.2 NOT OK\n");
+
+	/* the second dup entry shadows the first one on head inserts */
+	jmlist_insert_with_key(jml,"dup",3,"first");
+	jmlist_insert_with_key(jml,"dup",3,"second");
+	status = jmlist_get_by_key(jml,"dup",3,&ptr);
+	if( (status == JMLIST_ERROR_SUCCESS) && !strcmp(ptr,"second") )
+		printf("  TEST #12.3 OK\n");
+	else
+		printf("  TEST #12.3 NOT OK\n");
+
+	jmlist_free(jml);
+
+	params.flags = JMLIST_ASSOCIATIVE | JMLIST_ASS_INSERT_AT_TAIL;
+	jmlist_create(&jml,&params);
+	jmlist_insert_with_key(jml,"dup",3,"first");
+	jmlist_disable_debug();
+	for( int i = 0 ; i < 16 ; i++ )
+		jmlist_insert_with_key(jml,hkeys[i],5,hkeys[i]);
+	jmlist_enable_debug();
+	jmlist_insert_with_key(jml,"dup",3,"second");
+	status = jmlist_get_by_key(jml,"dup",3,&ptr);
+	if( (status == JMLIST_ERROR_SUCCESS) && !strcmp(ptr,"first") )
+		printf("  TEST #12.4 OK\n");
+	else
+		printf("  TEST #12.4 NOT OK\n");
+
+	jmlist_free(jml);
+
+	/*
+	 * TEST 13: Test batched key lookups, on the hashed associative list and on
+	 * the ordered one. Missing keys must be reported as not found.
+	 */
+	printf(	"\n  TEST #13 ------------------------------------------------------- \n"
+			"    Test batched key lookups with jmlist_get_by_keys.\n\n");
+
+	jmlist_key bkeys[40];
+	jmlist_key_length blens[40];
+	void *bptrs[40];
+	bool bfound[40];
+
+	for( int l = 0 ; l < 2 ; l++ )
+	{
+		memset(&params,0,sizeof(params));
+		params.flags = JMLIST_ASSOCIATIVE | (l ? JMLIST_ASS_ORDERED : 0);
+		jmlist_create(&jml,&params);
+
+		/* only the even keys are inserted */
+		jmlist_disable_debug();
+		for( int i = 0 ; i < 5000 ; i += 2 )
+			jmlist_insert_with_key(jml,hkeys[i],5,hkeys[i]);
+		jmlist_enable_debug();
+
+		for( int i = 0 ; i < 40 ; i++ )
+		{
+			bkeys[i] = hkeys[i*97];
+			blens[i] = 5;
+		}
+
+		bool batch_ok = true;
+		status = jmlist_get_by_keys(jml,bkeys,blens,40,bptrs,bfound);
+		for( int i = 0 ; i < 40 ; i++ )
+		{
+			if( !((i*97) % 2) && (!bfound[i] || (bptrs[i] != bkeys[i])) )
+				batch_ok = false;
+			if( ((i*97) % 2) && (bfound[i] || bptrs[i]) )
+				batch_ok = false;
+		}
+
+		if( jmlist_get_by_keys(0,bkeys,blens,40,bptrs,bfound) != JMLIST_ERROR_FAILURE )
+			batch_ok = false;
+
+		if( (status == JMLIST_ERROR_SUCCESS) && batch_ok )
+			printf("  TEST #13.%d OK\n",l+1);
+		else
+			printf("  TEST #13.%d NOT OK\n",l+1);
+
+		jmlist_free(jml);
+	}
+
+	/*
+	 * TEST 14: Test associative lists with fixed width keys. The keys passed to
+	 * insert are stack variables, they're copied into the entries by value.
+	 */
+	printf(	"\n  TEST #14 ------------------------------------------------------- \n"
+			"    Test associative lists with u32, u64 and pointer keys.\n\n");
+
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_ASSOCIATIVE | JMLIST_ASS_KEY_U32;
+	jmlist_create(&jml,&params);
+
+	jmlist_disable_debug();
+	for( uint32_t id = 0 ; id < 1000 ; id++ )
+		jmlist_insert_with_key(jml,&id,sizeof(id),hkeys[id]);
+	jmlist_enable_debug();
+
+	uint32_t id32 = 123;
+	status = jmlist_get_by_key(jml,&id32,sizeof(id32),&ptr);
+	if( (status == JMLIST_ERROR_SUCCESS) && (ptr == hkeys[123]) &&
+			(jmlist_get_by_ikey(jml,999,&ptr) == JMLIST_ERROR_SUCCESS) && (ptr == hkeys[999]) &&
+			(jmlist_get_by_ikey(jml,1000,&ptr) != JMLIST_ERROR_SUCCESS) )
+		printf("  TEST #14.1 OK\n");
+	else
+		printf("  TEST #14.1 NOT OK\n");
+
+	/* wrong key length is refused on insert and by the lookups, before the key
+	   is hashed (a longer key would overflow the integer it's loaded into) */
+	char wide_key[64];
+	jmlist_seek_handle wide_handle;
+	jmlist_lookup_result wide_result;
+	jmlist_index wide_n;
+	memset(wide_key,0x5a,sizeof(wide_key));
+	status = jmlist_insert_with_key(jml,"abc",3,hkeys[0]);
+	if( (status != JMLIST_ERROR_SUCCESS) && (jmlist_get_errno() == JMLIST_ERROR_INVALID_ARGUMENT) &&
+			(jmlist_get_by_key(jml,wide_key,sizeof(wide_key),&ptr) == JMLIST_ERROR_FAILURE) &&
+			(jmlist_get_errno() == JMLIST_ERROR_INVALID_ARGUMENT) &&
+			(jmlist_key_exists(jml,wide_key,sizeof(wide_key),&wide_result) == JMLIST_ERROR_FAILURE) &&
+			(jmlist_get_errno() == JMLIST_ERROR_INVALID_ARGUMENT) &&
+			(jmlist_remove_by_key(jml,wide_key,sizeof(wide_key)) == JMLIST_ERROR_FAILURE) &&
+			(jmlist_get_errno() == JMLIST_ERROR_INVALID_ARGUMENT) &&
+			(jmlist_get_all_by_key(jml,wide_key,sizeof(wide_key),0,0,&wide_n) == JMLIST_ERROR_FAILURE) &&
+			(jmlist_get_errno() == JMLIST_ERROR_INVALID_ARGUMENT) &&
+			(jmlist_seek_key(jml,&wide_handle,wide_key,sizeof(wide_key)) == JMLIST_ERROR_FAILURE) &&
+			(jmlist_get_errno() == JMLIST_ERROR_INVALID_ARGUMENT) )
+		printf("  TEST #14.2 OK\n");
+	else
+		printf("  TEST #14.2 NOT OK\n");
+
+	jmlist_free(jml);
+
+	params.flags = JMLIST_ASSOCIATIVE | JMLIST_ASS_KEY_U64;
+	jmlist_create(&jml,&params);
+	jmlist_insert_with_ikey(jml,0x100000001ULL,hkeys[1]);
+	jmlist_insert_with_ikey(jml,0x200000001ULL,hkeys[2]);
+	jmlist_remove_by_ikey(jml,0x100000001ULL);
+	jmlist_entry_count(jml,&count);
+	if( (count == 1) && (jmlist_get_by_ikey(jml,0x200000001ULL,&ptr) == JMLIST_ERROR_SUCCESS) && (ptr == hkeys[2]) &&
+			(jmlist_get_by_ikey(jml,0x100000001ULL,&ptr) != JMLIST_ERROR_SUCCESS) )
+		printf("  TEST #14.3 OK\n");
+	else
+		printf("  TEST #14.3 NOT OK\n");
+	jmlist_dump(jml);
+	jmlist_free(jml);
+
+	params.flags = JMLIST_ASSOCIATIVE | JMLIST_ASS_KEY_PTR;
+	jmlist_create(&jml,&params);
+	void *pkey = hkeys[7];
+	jmlist_insert_with_key(jml,&pkey,sizeof(pkey),"seven");
+	pkey = hkeys[8];
+	status = jmlist_get_by_key(jml,&pkey,sizeof(pkey),&ptr);
+	if( (status != JMLIST_ERROR_SUCCESS) &&
+			(jmlist_get_by_ikey(jml,(uintptr_t)hkeys[7],&ptr) == JMLIST_ERROR_SUCCESS) && !strcmp(ptr,"seven") )
+		printf("  TEST #14.4 OK\n");
+	else
+		printf("  TEST #14.4 NOT OK\n");
+	jmlist_free(jml);
+
+	/* conflicting key widths and ikey calls without a list fail */
+	bool width_ok = true;
+	jmlist_flags width_flags[3] = { JMLIST_ASS_KEY_U32 | JMLIST_ASS_KEY_U64, JMLIST_ASS_KEY_U32 | JMLIST_ASS_KEY_PTR,
+			JMLIST_ASS_KEY_U64 | JMLIST_ASS_KEY_PTR };
+	for( int i = 0 ; i < 3 ; i++ )
+	{
+		params.flags = JMLIST_ASSOCIATIVE | width_flags[i];
+		if( jmlist_create(&jml,&params) != JMLIST_ERROR_FAILURE )
+		{
+			width_ok = false;
+			jmlist_free(jml);
+		}
+	}
+	if( width_ok && (jmlist_insert_with_ikey(0,1,hkeys[1]) == JMLIST_ERROR_FAILURE) &&
+			(jmlist_get_by_ikey(0,1,&ptr) == JMLIST_ERROR_FAILURE) && (jmlist_remove_by_ikey(0,1) == JMLIST_ERROR_FAILURE) )
+		printf("  TEST #14.5 OK\n");
+	else
+		printf("  TEST #14.5 NOT OK\n");
+
+	/*
+	 * TEST 15: Test the lru associative list. With capacity 3, reading the
+	 * oldest entry makes the second one the least recently used, so that's
+	 * the one evicted by the next insert.
+	 */
+	printf(	"\n  TEST #15 ------------------------------------------------------- \n"
+			"    Test lru associative lists, promotion, eviction and counters.\n\n");
+
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_ASSOCIATIVE | JMLIST_ASS_LRU;
+	params.ass_list.capacity = 3;
+	params.ass_list.evict = lru_evict;
+	jmlist_create(&jml,&params);
+
+	jmlist_insert_with_key(jml,"a",1,"a");
+	jmlist_insert_with_key(jml,"b",1,"b");
+	jmlist_insert_with_key(jml,"c",1,"c");
+	jmlist_get_by_key(jml,"a",1,&ptr);
+	jmlist_insert_with_key(jml,"d",1,"d");
+
+	jmlist_entry_count(jml,&count);
+	if( (count == 3) && last_evicted && !strcmp(last_evicted,"b") &&
+			(jmlist_get_by_key(jml,"b",1,&ptr) != JMLIST_ERROR_SUCCESS) )
+		printf("  TEST #15.1 OK\n");
+	else
+		printf("  TEST #15.1 NOT OK\n");
+
+	/* recency order is d, a, c and c is the next to go */
+	jmlist_get_by_index(jml,0,&ptr);
+	bool lru_order = !strcmp(ptr,"d");
+	jmlist_get_by_index(jml,2,&ptr);
+	lru_order = lru_order && !strcmp(ptr,"c");
+	jmlist_insert_with_key(jml,"e",1,"e");
+	if( lru_order && !strcmp(last_evicted,"c") )
+		printf("  TEST #15.2 OK\n");
+	else
+		printf("  TEST #15.2 NOT OK\n");
+
+	jmlist_lru_info lru_info;
+	status = jmlist_lru_stats(jml,&lru_info);
+	if( (status == JMLIST_ERROR_SUCCESS) && (lru_info.hits == 1) && (lru_info.misses == 1) &&
+			(lru_info.evictions == 2) && (lru_info.usage == 3) && (lru_info.capacity == 3) )
+		printf("  TEST #15.3 OK\n");
+	else
+		printf("  TEST #15.3 NOT OK\n");
+	jmlist_dump(jml);
+	jmlist_free(jml);
+
+	/* duplicate keys, lookups return the most recently used one */
+	params.ass_list.capacity = 4;
+	jmlist_create(&jml,&params);
+	jmlist_insert_with_key(jml,"x",1,"x1");
+	jmlist_insert_with_key(jml,"y",1,"y");
+	jmlist_insert_with_key(jml,"x",1,"x2");
+	jmlist_get_by_key(jml,"y",1,&ptr);
+	lru_order = (jmlist_get_by_key(jml,"x",1,&ptr) == JMLIST_ERROR_SUCCESS) && !strcmp(ptr,"x2");
+	jmlist_insert_with_key(jml,"z",1,"z");
+	jmlist_insert_with_key(jml,"w",1,"w");
+	lru_order = lru_order && !strcmp(last_evicted,"x1");
+	jmlist_get_by_index(jml,2,&ptr);
+	lru_order = lru_order && !strcmp(ptr,"x2");
+	if( lru_order && (jmlist_get_by_key(jml,"x",1,&ptr) == JMLIST_ERROR_SUCCESS) && !strcmp(ptr,"x2") )
+		printf("  TEST #15.4 OK\n");
+	else
+		printf("  TEST #15.4 NOT OK\n");
+	jmlist_free(jml);
+
+	/*
+	 * TEST 16: Test entries with ttl. The list time is advanced with jmlist_expire,
+	 * one entry expires in 10 ticks and the other one far enough to be in an upper
+	 * level of the timer wheel.
+	 */
+	printf(	"\n  TEST #16 ------------------------------------------------------- \n"
+			"    Test associative entries with ttl and jmlist_expire.\n\n");
+
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_ASSOCIATIVE;
+	params.ass_list.evict = lru_evict;
+	jmlist_create(&jml,&params);
+
+	last_evicted = 0;
+	jmlist_expire(jml,1000);
+	jmlist_insert_with_key_ttl(jml,"short",5,"short",10);
+	jmlist_insert_with_key_ttl(jml,"long",4,"long",100000);
+	jmlist_insert_with_key(jml,"forever",7,"forever");
+
+	jmlist_expire(jml,1009);
+	status = jmlist_get_by_key(jml,"short",5,&ptr);
+	if( (status == JMLIST_ERROR_SUCCESS) && !last_evicted )
+		printf("  TEST #16.1 OK\n");
+	else
+		printf("  TEST #16.1 NOT OK\n");
+
+	jmlist_expire(jml,1010);
+	jmlist_entry_count(jml,&count);
+	if( (count == 2) && last_evicted && !strcmp(last_evicted,"short") &&
+			(jmlist_get_by_key(jml,"short",5,&ptr) != JMLIST_ERROR_SUCCESS) )
+		printf("  TEST #16.2 OK\n");
+	else
+		printf("  TEST #16.2 NOT OK\n");
+
+	jmlist_expire(jml,1000+100000);
+	jmlist_entry_count(jml,&count);
+	if( (count == 1) && !strcmp(last_evicted,"long") &&
+			(jmlist_get_by_key(jml,"forever",7,&ptr) == JMLIST_ERROR_SUCCESS) )
+		printf("  TEST #16.3 OK\n");
+	else
+		printf("  TEST #16.3 NOT OK\n");
+	jmlist_free(jml);
+
+	/* an expired duplicate doesn't hide the live one after it, in a list
+	   inserting at tail and in an lru list (where the live one is promoted) */
+	bool ttl_ok = true;
+	for( int i = 0 ; i < 2 ; i++ )
+	{
+		jmlist_lookup_result ttl_result;
+		void *ttl_ptrs[1];
+		bool ttl_found[1];
+		jmlist_key ttl_keys[1] = { "dup" };
+		jmlist_key_length ttl_lens[1] = { 3 };
+
+		memset(&params,0,sizeof(params));
+		params.flags = JMLIST_ASSOCIATIVE | (i ? JMLIST_ASS_LRU : JMLIST_ASS_INSERT_AT_TAIL);
+		params.ass_list.capacity = 10;
+		params.ass_list.clock = test_clock;
+		jmlist_create(&jml,&params);
+		test_now = 1000;
+		if( i )
+		{
+			jmlist_insert_with_key(jml,"dup",3,"live");
+			jmlist_insert_with_key_ttl(jml,"dup",3,"short",10);
+		} else
+		{
+			jmlist_insert_with_key_ttl(jml,"dup",3,"short",10);
+			jmlist_insert_with_key(jml,"dup",3,"live");
+		}
+		test_now = 1010;
+		if( (jmlist_get_by_key(jml,"dup",3,&ptr) != JMLIST_ERROR_SUCCESS) || strcmp(ptr,"live") )
+			ttl_ok = false;
+		if( (jmlist_key_exists(jml,"dup",3,&ttl_result) != JMLIST_ERROR_SUCCESS) || (ttl_result != jmlist_entry_found) )
+			ttl_ok = false;
+		if( (jmlist_get_by_keys(jml,ttl_keys,ttl_lens,1,ttl_ptrs,ttl_found) != JMLIST_ERROR_SUCCESS) ||
+				!ttl_found[0] || strcmp(ttl_ptrs[0],"live") )
+			ttl_ok = false;
+
+		/* remove_by_key takes the live one too and then finds no live entry
+		   left, the expired one stays until jmlist_expire */
+		if( (jmlist_remove_by_key(jml,"dup",3) != JMLIST_ERROR_SUCCESS) ||
+				(jmlist_get_by_key(jml,"dup",3,&ptr) != JMLIST_ERROR_FAILURE) ||
+				(jmlist_remove_by_key(jml,"dup",3) != JMLIST_ERROR_FAILURE) ||
+				(jmlist_get_errno() != JMLIST_ERROR_ENTRY_NOT_FOUND) ||
+				(jmlist_entry_count(jml,&count) != JMLIST_ERROR_SUCCESS) || (count != 1) )
+			ttl_ok = false;
+		jmlist_free(jml);
+	}
+	if( ttl_ok )
+		printf("  TEST #16.4 OK\n");
+	else
+		printf("  TEST #16.4 NOT OK\n");
+
+	/*
+	 * TEST 17: Test the membership filter. 3000 keys are inserted in a list whose
+	 * filter starts with the default capacity, it grows on the way (filter_grow),
+	 * then half of them are removed. The same is done with an ordered list whose
+	 * filter keeps its size until jmlist_filter_rebuild is called.
+	 */
+	printf(	"\n  TEST #17 ------------------------------------------------------- \n"
+			"    Test associative lists with a membership filter.\n\n");
+
+	for( int i = 0 ; i < 2 ; i++ )
+	{
+		memset(&params,0,sizeof(params));
+		params.flags = JMLIST_ASSOCIATIVE | JMLIST_ASS_FILTER | (i ? JMLIST_ASS_ORDERED : 0);
+		params.ass_list.filter_fpr = 0.001;
+		params.ass_list.filter_grow = !i;
+		jmlist_create(&jml,&params);
+
+		int j;
+		bool filter_ok = true;
+		jmlist_disable_debug();
+		for( j = 0 ; j < 3000 ; j++ )
+		{
+			sprintf(hkeys[j],"h%04d",j);
+			jmlist_insert_with_key(jml,hkeys[j],5,hkeys[j]);
+		}
+		for( j = 0 ; j < 3000 ; j++ )
+		{
+			if( (jmlist_get_by_key(jml,hkeys[j],5,&ptr) != JMLIST_ERROR_SUCCESS) || (ptr != hkeys[j]) )
+				filter_ok = false;
+		}
+		if( i )
+		{
+			filter_ok = filter_ok && (jml->ass_list.filter->capacity == JMLIST_ASS_FILTER_DEF_CAPACITY) &&
+					(jmlist_filter_rebuild(jml) == JMLIST_ERROR_SUCCESS);
+			for( j = 0 ; j < 3000 ; j++ )
+				if( jmlist_get_by_key(jml,hkeys[j],5,&ptr) != JMLIST_ERROR_SUCCESS )
+					filter_ok = false;
+		}
+		filter_ok = filter_ok && (jml->ass_list.filter->capacity >= 3000);
+		if( filter_ok )
+			printf("  TEST #17.%d OK\n",i*2+1);
+		else
+			printf("  TEST #17.%d NOT OK\n",i*2+1);
+
+		jmlist_lookup_result filter_result;
+		for( j = 0 ; j < 3000 ; j += 2 )
+			jmlist_remove_by_key(jml,hkeys[j],5);
+		for( j = 0 ; j < 3000 ; j++ )
+		{
+			jmlist_key_exists(jml,hkeys[j],5,&filter_result);
+			if( (filter_result == jmlist_entry_found) != (j & 1) )
+				filter_ok = false;
+		}
+		jmlist_enable_debug();
+		if( filter_ok )
+			printf("  TEST #17.%d OK\n",i*2+2);
+		else
+			printf("  TEST #17.%d NOT OK\n",i*2+2);
+		jmlist_free(jml);
+	}
+
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_ASSOCIATIVE | JMLIST_ASS_FILTER | JMLIST_ASS_ORDERED;
+	params.ass_list.compare = reverse_compare;
+	status = jmlist_create(&jml,&params);
+	if( status == JMLIST_ERROR_FAILURE )
+		printf("  TEST #17.5 OK\n");
+	else
+		printf("  TEST #17.5 NOT OK\n");
+
+	/*
+	 * TEST 18: Test frozen lists. A list with 3000 keys (and one duplicate) is
+	 * frozen, lookups must return the same entries as before and changes must fail
+	 * until the list is thawed.
+	 */
+	printf(	"\n  TEST #18 ------------------------------------------------------- \n"
+			"    Test jmlist_freeze and jmlist_thaw.\n\n");
+
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_ASSOCIATIVE;
+	jmlist_create(&jml,&params);
+
+	jmlist_disable_debug();
+	for( int i = 0 ; i < 3000 ; i++ )
+	{
+		sprintf(hkeys[i],"h%04d",i);
+		jmlist_insert_with_key(jml,hkeys[i],5,hkeys[i]);
+	}
+	jmlist_insert_with_key(jml,"h0042",5,"newer");
+	status = jmlist_freeze(jml);
+
+	bool frozen_ok = (status == JMLIST_ERROR_SUCCESS) && (jml->ass_list.frozen->count == 3000);
+	for( int i = 0 ; i < 3000 ; i++ )
+	{
+		status = jmlist_get_by_key(jml,hkeys[i],5,&ptr);
+		if( (status != JMLIST_ERROR_SUCCESS) || ((i != 42) && (ptr != hkeys[i])) )
+			frozen_ok = false;
+	}
+	jmlist_enable_debug();
+	if( frozen_ok && (jmlist_get_by_key(jml,"h0042",5,&ptr) == JMLIST_ERROR_SUCCESS) && !strcmp(ptr,"newer") &&
+			(jmlist_get_by_key(jml,"h9999",5,&ptr) != JMLIST_ERROR_SUCCESS) )
+		printf("  TEST #18.1 OK\n");
+	else
+		printf("  TEST #18.1 NOT OK\n");
+
+	if( (jmlist_insert_with_key(jml,"x",1,"x") == JMLIST_ERROR_FAILURE) &&
+			(jmlist_remove_by_key(jml,"h0001",5) == JMLIST_ERROR_FAILURE) )
+		printf("  TEST #18.2 OK\n");
+	else
+		printf("  TEST #18.2 NOT OK\n");
+
+	status = jmlist_thaw(jml);
+	if( (status == JMLIST_ERROR_SUCCESS) && (jmlist_remove_by_key(jml,"h0042",5) == JMLIST_ERROR_SUCCESS) &&
+			(jmlist_get_by_key(jml,"h0042",5,&ptr) == JMLIST_ERROR_SUCCESS) && (ptr == hkeys[42]) )
+		printf("  TEST #18.3 OK\n");
+	else
+		printf("  TEST #18.3 NOT OK\n");
+	jmlist_free(jml);
+
+	/*
+	 * TEST 19: Test duplicate keys. Three entries share key "dup" among 1000 other
+	 * keys, jmlist_get_all_by_key and jmlist_seek_key must return the three of them
+	 * in list order, in unordered and ordered lists.
+	 */
+	printf(	"\n  TEST #19 ------------------------------------------------------- \n"
+			"    Test jmlist_get_all_by_key and jmlist_seek_key.\n\n");
+
+	for( int i = 0 ; i < 2 ; i++ )
+	{
+		memset(&params,0,sizeof(params));
+		params.flags = JMLIST_ASSOCIATIVE | (i ? JMLIST_ASS_ORDERED : JMLIST_ASS_INSERT_AT_TAIL);
+		jmlist_create(&jml,&params);
+
+		jmlist_disable_debug();
+		for( int j = 0 ; j < 1000 ; j++ )
+		{
+			sprintf(hkeys[j],"h%04d",j);
+			jmlist_insert_with_key(jml,hkeys[j],5,hkeys[j]);
+			if( (j % 400) == 0 )
+				jmlist_insert_with_key(jml,"dup",3,hkeys[j]);
+		}
+		jmlist_enable_debug();
+
+		void *dups[4];
+		jmlist_index dup_count;
+		status = jmlist_get_all_by_key(jml,"dup",3,dups,2,&dup_count);
+		bool dup_ok = (status == JMLIST_ERROR_SUCCESS) && (dup_count == 3) && (dups[0] == hkeys[0]) && (dups[1] == hkeys[400]);
+		status = jmlist_get_all_by_key(jml,"dup",3,dups,4,&dup_count);
+		dup_ok = dup_ok && (status == JMLIST_ERROR_SUCCESS) && (dup_count == 3) && (dups[2] == hkeys[800]);
+		jmlist_get_all_by_key(jml,"none",4,dups,4,&dup_count);
+		if( dup_ok && !dup_count )
+			printf("  TEST #19.%d OK\n",i*2+1);
+		else
+			printf("  TEST #19.%d NOT OK\n",i*2+1);
+
+		jmlist_seek_handle key_handle;
+		dup_count = 0;
+		jmlist_seek_key(jml,&key_handle,"dup",3);
+		while( jmlist_seek_next(jml,&key_handle,&ptr) == JMLIST_ERROR_SUCCESS )
+		{
+			if( ptr != hkeys[dup_count*400] )
+				dup_ok = false;
+			dup_count++;
+		}
+		jmlist_seek_end(jml,&key_handle);
+		if( dup_ok && (dup_count == 3) )
+			printf("  TEST #19.%d OK\n",i*2+2);
+		else
+			printf("  TEST #19.%d NOT OK\n",i*2+2);
+		jmlist_free(jml);
+	}
+
+	/*
+	 * TEST 20: Test inserting at both ends and removing. Entries are inserted at
+	 * head and tail of the same list, order is checked after removes by key (O(1)
+	 * with the doubly linked list) and by index from both halves of the list.
+	 */
+	printf(	"\n  TEST #20 ------------------------------------------------------- \n"
+			"    Test jmlist_insert_with_key_at and removes.\n\n");
+
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_ASSOCIATIVE;
+	jmlist_create(&jml,&params);
+
+	jmlist_insert_with_key_at(jml,"b",1,"b",JMLIST_HEAD);
+	jmlist_insert_with_key_at(jml,"c",1,"c",JMLIST_TAIL);
+	jmlist_insert_with_key_at(jml,"a",1,"a",JMLIST_HEAD);
+	jmlist_insert_with_key_at(jml,"d",1,"d",JMLIST_TAIL);
+	jmlist_insert_with_key_at(jml,"x",1,"x1",JMLIST_TAIL);
+	jmlist_insert_with_key_at(jml,"x",1,"x0",JMLIST_HEAD);
+
+	char order[8];
+	int order_len = 0;
+	jmlist_seek_handle order_handle;
+	jmlist_seek_start(jml,&order_handle);
+	while( jmlist_seek_next(jml,&order_handle,&ptr) == JMLIST_ERROR_SUCCESS )
+		order[order_len++] = ((char*)ptr)[strlen(ptr)-1];
+	jmlist_seek_end(jml,&order_handle);
+	order[order_len] = 0;
+	jmlist_get_by_key(jml,"x",1,&ptr);
+	if( !strcmp(order,"0abcd1") && !strcmp(ptr,"x0") )
+		printf("  TEST #20.1 OK\n");
+	else
+		printf("  TEST #20.1 NOT OK\n");
+
+	/* removes "x0" (head) then "c" (middle), then index 3 is "x1" (tail) */
+	jmlist_remove_by_key(jml,"x",1);
+	jmlist_remove_by_key(jml,"c",1);
+	jmlist_remove_by_index(jml,3);
+	jmlist_remove_by_index(jml,0);
+	jmlist_entry_count(jml,&count);
+	jmlist_get_by_index(jml,1,&ptr);
+	if( (count == 2) && !strcmp(ptr,"d") && (jml->ass_list.ptail->ptr == ptr) &&
+			(jmlist_get_by_key(jml,"x",1,&ptr) != JMLIST_ERROR_SUCCESS) )
+		printf("  TEST #20.2 OK\n");
+	else
+		printf("  TEST #20.2 NOT OK\n");
+	jmlist_free(jml);
+
+	/*
+	 * TEST 21: Test concurrent lists. Four threads insert, get and remove their
+	 * own keys in the same list at once, then the keys left are checked along
+	 * with the entries and memory accounted by the shards.
+	 */
+	printf(	"\n  TEST #21 ------------------------------------------------------- \n"
+			"    Test JMLIST_ASS_CONCURRENT lists.\n\n");
+
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_ASSOCIATIVE | JMLIST_ASS_KEY_U64 | JMLIST_ASS_CONCURRENT | JMLIST_ASS_FILTER;
+	params.ass_list.shards = 8;
+	jmlist_create(&jml,&params);
+
+	pthread_t threads[4];
+	struct concurrent_arg thread_args[4];
+	jmlist_disable_debug();
+	for( int i = 0 ; i < 4 ; i++ )
+	{
+		thread_args[i].jml = jml;
+		thread_args[i].first = i*100000;
+		thread_args[i].count = 5000;
+		thread_args[i].errors = 0;
+		pthread_create(&threads[i],0,concurrent_routine,&thread_args[i]);
+	}
+	for( int i = 0 ; i < 4 ; i++ )
+		pthread_join(threads[i],0);
+
+	bool concurrent_ok = true;
+	for( int i = 0 ; i < 4 ; i++ )
+	{
+		concurrent_ok = concurrent_ok && !thread_args[i].errors;
+		for( int j = 0 ; j < 5000 ; j++ )
+			if( (jmlist_get_by_ikey(jml,i*100000+j,&ptr) == JMLIST_ERROR_SUCCESS) != !(j & 1) )
+				concurrent_ok = false;
+	}
+	jmlist_enable_debug();
+
+	jmlist_entry_count(jml,&count);
+	if( concurrent_ok && (count == 10000) )
+		printf("  TEST #21.1 OK\n");
+	else
+		printf("  TEST #21.1 NOT OK\n");
+
+	jmlist_shard_info shard_info;
+	jmlist_index shard_usage = 0;
+	bool shard_mem_ok = true;
+	for( jmlist_index i = 0 ; jmlist_shard_stats(jml,i,&shard_info) == JMLIST_ERROR_SUCCESS ; i++ )
+	{
+		shard_usage += shard_info.usage;
+		shard_mem_ok = shard_mem_ok && (shard_info.shard_count == 8) && shard_info.usage &&
+				(shard_info.mem.ass_list.used >= shard_info.usage*sizeof(assoc_entry));
+	}
+	jmlist_seek_handle shard_handle;
+	if( shard_mem_ok && (shard_usage == count) &&
+			(jmlist_seek_start(jml,&shard_handle) == JMLIST_ERROR_FAILURE) )
+		printf("  TEST #21.2 OK\n");
+	else
+		printf("  TEST #21.2 NOT OK\n");
+	jmlist_free(jml);
+
+	/* jmlist_find searches the shards */
+	jmlist_lookup_result shard_result;
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_ASSOCIATIVE | JMLIST_ASS_KEY_U64 | JMLIST_ASS_CONCURRENT;
+	params.ass_list.shards = 4;
+	jmlist_create(&jml,&params);
+	for( int i = 1 ; i <= 10 ; i++ )
+		jmlist_insert_with_ikey(jml,i,(void*)(uintptr_t)i);
+	ptr = 0;
+	if( (jmlist_find(jml,find_routine,(void*)(uintptr_t)7,&shard_result,&ptr) == JMLIST_ERROR_SUCCESS) &&
+			(shard_result == jmlist_entry_found) && (ptr == (void*)(uintptr_t)7) &&
+			(jmlist_find(jml,find_routine,(void*)(uintptr_t)11,&shard_result,&ptr) == JMLIST_ERROR_SUCCESS) &&
+			(shard_result == jmlist_entry_not_found) )
+		printf("  TEST #21.3 OK\n");
+	else
+		printf("  TEST #21.3 NOT OK\n");
+	jmlist_free(jml);
+
+	/*
+	 * TEST 22: Test key interning. The same key interned twice gives the same
+	 * copy and id, lists with interned keys find entries by id (including
+	 * duplicates and after freezing) and the arena is released with the table.
+	 */
+	printf(	"\n  TEST #22 ------------------------------------------------------- \n"
+			"    Test key interning and JMLIST_ASS_INTERNED lists.\n\n");
+
+	jmlist_memory_info intern_mem;
+	jmlist_memory_stats(&intern_mem);
+
+	jmlist_intern_table itable;
+	jmlist_key ikeys[3];
+	uint32_t iids[3];
+	jmlist_key ikey_ptr;
+	jmlist_key_length ikey_len;
+	char ibuf[8];
+	jmlist_intern_create(&itable);
+	jmlist_intern_key(itable,"alpha",5,&ikeys[0],&iids[0]);
+	jmlist_intern_key(itable,"beta",4,&ikeys[1],&iids[1]);
+	strcpy(ibuf,"alpha");
+	jmlist_intern_key(itable,ibuf,5,&ikeys[2],&iids[2]);
+	jmlist_intern_get_by_id(itable,iids[1],&ikey_ptr,&ikey_len);
+	if( (ikeys[0] == ikeys[2]) && (iids[0] == iids[2]) && (iids[0] != iids[1]) && (ikey_ptr == ikeys[1]) &&
+			(ikey_len == 4) && !strcmp(ikey_ptr,"beta") && (ikeys[0] != (jmlist_key)"alpha") &&
+			(jmlist_intern_find(itable,"gamma",5,&ikey_ptr,0) == JMLIST_ERROR_FAILURE) )
+		printf("  TEST #22.1 OK\n");
+	else
+		printf("  TEST #22.1 NOT OK\n");
+
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_ASSOCIATIVE | JMLIST_ASS_INTERNED;
+	params.ass_list.intern = itable;
+	jmlist_create(&jml,&params);
+
+	jmlist_disable_debug();
+	for( int i = 0 ; i < 1000 ; i++ )
+	{
+		sprintf(hkeys[i],"k%04d",i);
+		jmlist_intern_key(itable,hkeys[i],5,&ikey_ptr,0);
+		jmlist_insert_with_key(jml,ikey_ptr,5,hkeys[i]);
+	}
+	jmlist_insert_with_key(jml,ikeys[0],5,"a1");
+	jmlist_insert_with_key(jml,ikeys[0],5,"a2");
+
+	bool intern_ok = true;
+	for( int i = 0 ; i < 1000 ; i++ )
+	{
+		sprintf(ibuf,"k%04d",i);
+		if( (jmlist_intern_find(itable,ibuf,5,&ikey_ptr,0) != JMLIST_ERROR_SUCCESS) ||
+				(jmlist_get_by_key(jml,ikey_ptr,5,&ptr) != JMLIST_ERROR_SUCCESS) || (ptr != hkeys[i]) )
+			intern_ok = false;
+	}
+	jmlist_get_all_by_key(jml,ikeys[0],5,0,0,&count);
+	intern_ok = intern_ok && (count == 2) && (jmlist_get_by_key(jml,ikeys[1],4,&ptr) == JMLIST_ERROR_FAILURE);
+	jmlist_freeze(jml);
+	intern_ok = intern_ok && (jmlist_get_by_key(jml,ikeys[0],5,&ptr) == JMLIST_ERROR_SUCCESS) && !strcmp(ptr,"a2");
+	jmlist_thaw(jml);
+	jmlist_remove_by_key(jml,ikeys[0],5);
+	jmlist_enable_debug();
+
+	jmlist_get_by_key(jml,ikeys[2],5,&ptr);
+	if( intern_ok && !strcmp(ptr,"a1") )
+		printf("  TEST #22.2 OK\n");
+	else
+		printf("  TEST #22.2 NOT OK\n");
+
+	/* keys of another table or with another length are refused */
+	jmlist_intern_table itable2;
+	jmlist_key ikey2;
+	jmlist_lookup_result iresult;
+	jmlist_intern_create(&itable2);
+	jmlist_intern_key(itable2,"k0000",5,&ikey2,0);
+	jmlist_intern_find(itable,"k0001",5,&ikey_ptr,0);
+	char *iheap = strdup("k0001");
+	if( (jmlist_get_by_key(jml,ikey2,5,&ptr) == JMLIST_ERROR_FAILURE) &&
+			(jmlist_key_exists(jml,ikey2,5,&iresult) == JMLIST_ERROR_FAILURE) &&
+			(jmlist_insert_with_key(jml,ikey2,5,"x") == JMLIST_ERROR_FAILURE) &&
+			(jmlist_remove_by_key(jml,ikey2,5) == JMLIST_ERROR_FAILURE) &&
+			(jmlist_get_by_key(jml,ikey_ptr,4,&ptr) == JMLIST_ERROR_FAILURE) &&
+			(jmlist_get_by_key(jml,iheap,5,&ptr) == JMLIST_ERROR_FAILURE) &&
+			(jmlist_get_errno() == JMLIST_ERROR_INVALID_ARGUMENT) &&
+			(jmlist_get_by_key(jml,(char*)ikey_ptr+1,4,&ptr) == JMLIST_ERROR_FAILURE) &&
+			(jmlist_get_all_by_key(jml,ikey_ptr,4,0,0,&count) == JMLIST_ERROR_FAILURE) &&
+			(jmlist_get_by_key(jml,ikey_ptr,5,&ptr) == JMLIST_ERROR_SUCCESS) && (ptr == hkeys[1]) )
+		printf("  TEST #22.3 OK\n");
+	else
+		printf("  TEST #22.3 NOT OK\n");
+	jmlist_intern_free(itable2);
+	free(iheap);
+	jmlist_free(jml);
+
+	jmlist_intern_free(itable);
+	jmlist_memory_stats(&jml_mem);
+	if( jml_mem.used == intern_mem.used )
+		printf("  TEST #22.4 OK\n");
+	else
+		printf("  TEST #22.4 NOT OK\n");
+
+	/*
+	 * TEST 23: Test freezing ordered lists. The frozen list answers key,
+	 * floor and ceiling lookups and seeks its entries in order, changes fail
+	 * until it's thawed and the b+tree is rebuilt.
+	 */
+	printf(	"\n  TEST #23 ------------------------------------------------------- \n"
+			"    Test frozen ordered lists, floor and ceiling lookups.\n\n");
+
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_ASSOCIATIVE | JMLIST_ASS_ORDERED;
+	jmlist_create(&jml,&params);
+
+	/* even keys only, so odd keys fall between two entries */
+	jmlist_disable_debug();
+	for( int i = 999 ; i >= 0 ; i-- )
+	{
+		sprintf(hkeys[i],"s%04d",i*2);
+		jmlist_insert_with_key(jml,hkeys[i],5,hkeys[i]);
+	}
+	jmlist_insert_with_key(jml,hkeys[500],5,"dup");
+	jmlist_freeze(jml);
+
+	bool sorted_ok = true;
+	jmlist_key sorted_key;
+	char sbuf[8];
+	for( int i = 0 ; i < 1000 ; i++ )
+	{
+		sprintf(sbuf,"s%04d",i*2+1);
+		if( (jmlist_get_by_key(jml,hkeys[i],5,&ptr) != JMLIST_ERROR_SUCCESS) || (ptr != hkeys[i]) ||
+				(jmlist_get_by_key(jml,sbuf,5,&ptr) == JMLIST_ERROR_SUCCESS) ||
+				(jmlist_get_floor(jml,sbuf,5,true,&sorted_key,0,&ptr) != JMLIST_ERROR_SUCCESS) || (ptr != hkeys[i]) ||
+				((i < 999) && ((jmlist_get_ceiling(jml,sbuf,5,true,0,0,&ptr) != JMLIST_ERROR_SUCCESS) || (ptr != hkeys[i+1]))) )
+			sorted_ok = false;
+	}
+	jmlist_enable_debug();
+
+	jmlist_get_all_by_key(jml,hkeys[500],5,0,0,&count);
+	if( sorted_ok && (count == 2) && (jmlist_get_ceiling(jml,"s1999",5,false,0,0,&ptr) == JMLIST_ERROR_FAILURE) &&
+			(jmlist_get_floor(jml,hkeys[0],5,false,0,0,&ptr) == JMLIST_ERROR_FAILURE) &&
+			(jmlist_get_floor(jml,hkeys[501],5,false,0,0,&ptr) == JMLIST_ERROR_SUCCESS) && (ptr == hkeys[500]) &&
+			(jmlist_get_ceiling(jml,hkeys[499],5,false,0,0,&ptr) == JMLIST_ERROR_SUCCESS) && (ptr == hkeys[500]) )
+		printf("  TEST #23.1 OK\n");
+	else
+		printf("  TEST #23.1 NOT OK\n");
+
+	jmlist_index sorted_seen = 0;
+	jmlist_seek_handle sorted_handle;
+	jmlist_seek_range(jml,&sorted_handle,"s0100",5,"s0200",5);
+	while( jmlist_seek_next(jml,&sorted_handle,&ptr) == JMLIST_ERROR_SUCCESS )
+	{
+		if( ptr != hkeys[50+sorted_seen] )
+			sorted_ok = false;
+		sorted_seen++;
+	}
+	jmlist_seek_end(jml,&sorted_handle);
+
+	status = jmlist_insert_with_key(jml,"s0001",5,"new");
+	if( sorted_ok && (sorted_seen == 50) && (status == JMLIST_ERROR_FAILURE) )
+		printf("  TEST #23.2 OK\n");
+	else
+		printf("  TEST #23.2 NOT OK\n");
+
+	jmlist_thaw(jml);
+	jmlist_insert_with_key(jml,"s0001",5,"new");
+	jmlist_get_ceiling(jml,hkeys[0],5,false,0,0,&ptr);
+	jmlist_entry_count(jml,&count);
+	if( !strcmp(ptr,"new") && (count == 1002) )
+		printf("  TEST #23.3 OK\n");
+	else
+		printf("  TEST #23.3 NOT OK\n");
+	jmlist_free(jml);
+
+	/*
+	 * TEST 24: Test small associative lists. Up to small_max entries there's
+	 * no hash index, it's built when the list grows over small_max and it's
+	 * dropped when half of them remain, lookups and duplicates work in both.
+	 */
+	printf(	"\n  TEST #24 ------------------------------------------------------- \n"
+			"    Test small associative lists (no hash index below small_max).\n\n");
+
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_ASSOCIATIVE;
+	params.ass_list.small_max = 4;
+	jmlist_create(&jml,&params);
+
+	jmlist_insert_with_key(jml,"a",1,"a1");
+	jmlist_insert_with_key(jml,"b",1,"b");
+	jmlist_insert_with_key_at(jml,"a",1,"a2",JMLIST_TAIL);
+	jmlist_insert_with_key(jml,"c",1,"c");
+	bool small_ok = (jml->ass_list.bucket_count == 0) && (jml->ass_list.small_count == 4);
+	small_ok = small_ok && (jmlist_get_by_key(jml,"c",1,&ptr) == JMLIST_ERROR_SUCCESS) && !strcmp(ptr,"c") &&
+			(jmlist_get_by_key(jml,"d",1,&ptr) == JMLIST_ERROR_FAILURE);
+	jmlist_get_all_by_key(jml,"a",1,0,0,&count);
+	if( small_ok && (count == 2) && (jmlist_get_by_key(jml,"a",1,&ptr) == JMLIST_ERROR_SUCCESS) && !strcmp(ptr,"a1") )
+		printf("  TEST #24.1 OK\n");
+	else
+		printf("  TEST #24.1 NOT OK\n");
+
+	jmlist_insert_with_key(jml,"d",1,"d");
+	small_ok = (jml->ass_list.bucket_count != 0) && (jml->ass_list.small_count == 0);
+	small_ok = small_ok && (jmlist_get_by_key(jml,"d",1,&ptr) == JMLIST_ERROR_SUCCESS) && !strcmp(ptr,"d") &&
+			(jmlist_get_by_key(jml,"a",1,&ptr) == JMLIST_ERROR_SUCCESS) && !strcmp(ptr,"a1");
+	if( small_ok )
+		printf("  TEST #24.2 OK\n");
+	else
+		printf("  TEST #24.2 NOT OK\n");
+
+	/* 3 entries left is over small_max/2, the index is kept until 2 */
+	jmlist_remove_by_key(jml,"b",1);
+	jmlist_remove_by_key(jml,"c",1);
+	small_ok = (jml->ass_list.bucket_count != 0);
+	jmlist_remove_by_key(jml,"d",1);
+	small_ok = small_ok && (jml->ass_list.bucket_count == 0) && (jml->ass_list.small_count == 2);
+	jmlist_get_all_by_key(jml,"a",1,0,0,&count);
+	jmlist_remove_by_key(jml,"a",1);
+	if( small_ok && (count == 2) && (jmlist_get_by_key(jml,"a",1,&ptr) == JMLIST_ERROR_SUCCESS) && !strcmp(ptr,"a2") &&
+			(jmlist_get_by_key(jml,"b",1,&ptr) == JMLIST_ERROR_FAILURE) )
+		printf("  TEST #24.3 OK\n");
+	else
+		printf("  TEST #24.3 NOT OK\n");
+	jmlist_free(jml);
+
+	/*
+	 * TEST 25: Test index access on associative lists. Unordered lists build an
+	 * order statistic tree on the first access by index and keep it with the
+	 * inserts and removes, ordered lists find the index in the b+tree.
+	 */
+	printf(	"\n  TEST #25 ------------------------------------------------------- \n"
+			"    Test index access on associative lists (order statistic tree).\n\n");
+
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_ASSOCIATIVE;
+	jmlist_create(&jml,&params);
+
+	for( int i = 0 ; i < 5000 ; i++ )
+	{
+		sprintf(hkeys[i],"p%04d",i);
+		jmlist_insert_with_key_at(jml,hkeys[i],5,hkeys[i],JMLIST_TAIL);
+	}
+
+	bool order_ok = true;
+	for( int i = 0 ; i < 5000 ; i++ )
+	{
+		if( (jmlist_get_by_index(jml,i,&ptr) != JMLIST_ERROR_SUCCESS) || (ptr != hkeys[i]) )
+			order_ok = false;
+	}
+	if( order_ok && jml->ass_list.order_root && (jml->ass_list.order_root->size == 5000) )
+		printf("  TEST #25.1 OK\n");
+	else
+		printf("  TEST #25.1 NOT OK\n");
+
+	/* the tree follows the inserts, removes and replaces after it was built */
+	jmlist_remove_by_index(jml,2500);
+	jmlist_remove_by_key(jml,hkeys[0],5);
+	jmlist_insert_with_key_at(jml,"head",4,"head",JMLIST_HEAD);
+	jmlist_replace_by_index(jml,4998,"last");
+	jmlist_entry_count(jml,&count);
+	order_ok = (count == 4999);
+	order_ok = order_ok && (jmlist_get_by_index(jml,0,&ptr) == JMLIST_ERROR_SUCCESS) && !strcmp(ptr,"head");
+	order_ok = order_ok && (jmlist_get_by_index(jml,1,&ptr) == JMLIST_ERROR_SUCCESS) && (ptr == hkeys[1]);
+	order_ok = order_ok && (jmlist_get_by_index(jml,2500,&ptr) == JMLIST_ERROR_SUCCESS) && (ptr == hkeys[2501]);
+	order_ok = order_ok && (jmlist_get_by_index(jml,4998,&ptr) == JMLIST_ERROR_SUCCESS) && !strcmp(ptr,"last");
+	if( order_ok && (jmlist_get_by_index(jml,4999,&ptr) == JMLIST_ERROR_FAILURE) )
+		printf("  TEST #25.2 OK\n");
+	else
+		printf("  TEST #25.2 NOT OK\n");
+	jmlist_free(jml);
+
+	params.flags = JMLIST_ASSOCIATIVE | JMLIST_ASS_ORDERED;
+	jmlist_create(&jml,&params);
+	for( int i = 5000 ; i > 0 ; i-- )
+		jmlist_insert_with_key(jml,hkeys[i-1],5,hkeys[i-1]);
+	for( int i = 0 ; i < 5000 ; i += 2 )
+		jmlist_remove_by_key(jml,hkeys[i],5);
+
+	order_ok = true;
+	for( int i = 0 ; i < 2500 ; i++ )
+	{
+		if( (jmlist_get_by_index(jml,i,&ptr) != JMLIST_ERROR_SUCCESS) || (ptr != hkeys[2*i+1]) )
+			order_ok = false;
+	}
+	jmlist_remove_by_index(jml,1000);
+	if( order_ok && (jmlist_get_by_index(jml,1000,&ptr) == JMLIST_ERROR_SUCCESS) && (ptr == hkeys[2003]) &&
+			(jml->ass_list.root->size == 2499) )
+		printf("  TEST #25.3 OK\n");
+	else
+		printf("  TEST #25.3 NOT OK\n");
+	jmlist_free(jml);
+
+	/*
+	 * TEST 26: Test several seeks of the same list at once. The seek state is in
+	 * the handle, nested seeks and seeks from several threads work, lists with
+	 * JMLIST_SEEK_CHECKED fail the seeks started before a change.
+	 */
+	printf(	"\n  TEST #26 ------------------------------------------------------- \n"
+			"    Test nested and concurrent seeks of the same list.\n\n");
+
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_LINKED;
+	jmlist_create(&jml,&params);
+	for( int i = 0 ; i < 10 ; i++ )
+		jmlist_insert(jml,hkeys[i]);
+
+	jmlist_seek_handle outer_handle;
+	jmlist_seek_handle inner_handle;
+	void *inner_ptr;
+	int pairs = 0;
+	jmlist_seek_start(jml,&outer_handle);
+	while( jmlist_seek_next(jml,&outer_handle,&ptr) == JMLIST_ERROR_SUCCESS )
+	{
+		jmlist_seek_start(jml,&inner_handle);
+		while( jmlist_seek_next(jml,&inner_handle,&inner_ptr) == JMLIST_ERROR_SUCCESS )
+			pairs++;
+		jmlist_seek_end(jml,&inner_handle);
+	}
+	status = jmlist_seek_end(jml,&outer_handle);
+	if( (pairs == 100) && (status == JMLIST_ERROR_SUCCESS) &&
+			(jmlist_seek_end(jml,&outer_handle) == JMLIST_ERROR_FAILURE) )
+		printf("  TEST #26.1 OK\n");
+	else
+		printf("  TEST #26.1 NOT OK\n");
+	jmlist_free(jml);
+
+	params.flags = JMLIST_ASSOCIATIVE | JMLIST_ASS_ORDERED | JMLIST_SEEK_CHECKED;
+	jmlist_create(&jml,&params);
+	for( int i = 0 ; i < 1000 ; i++ )
+		jmlist_insert_with_key(jml,hkeys[i],5,hkeys[i]);
+
+	pthread_t seek_threads[4];
+	struct seek_arg seek_args[4];
+	bool seek_ok = true;
+	for( int i = 0 ; i < 4 ; i++ )
+	{
+		seek_args[i].jml = jml;
+		seek_args[i].seen = 0;
+		pthread_create(&seek_threads[i],0,seek_routine,&seek_args[i]);
+	}
+	for( int i = 0 ; i < 4 ; i++ )
+	{
+		pthread_join(seek_threads[i],0);
+		if( seek_args[i].seen != 100*1000 )
+			seek_ok = false;
+	}
+	if( seek_ok )
+		printf("  TEST #26.2 OK\n");
+	else
+		printf("  TEST #26.2 NOT OK\n");
+
+	jmlist_seek_start(jml,&outer_handle);
+	jmlist_seek_next(jml,&outer_handle,&ptr);
+	jmlist_remove_by_key(jml,hkeys[1],5);
+	status = jmlist_seek_next(jml,&outer_handle,&ptr);
+	jmlist_seek_end(jml,&outer_handle);
+	jmlist_seek_start(jml,&outer_handle);
+	if( (status == JMLIST_ERROR_FAILURE) && (jmlist_seek_next(jml,&outer_handle,&ptr) == JMLIST_ERROR_SUCCESS) &&
+			(ptr == hkeys[0]) )
+		printf("  TEST #26.3 OK\n");
+	else
+		printf("  TEST #26.3 NOT OK\n");
+	jmlist_seek_end(jml,&outer_handle);
+
+	/* calls that fail don't change the list, the seek goes on */
+	jmlist_seek_start(jml,&outer_handle);
+	jmlist_seek_next(jml,&outer_handle,&ptr);
+	seek_ok = (jmlist_insert_with_key(jml,hkeys[1],0,hkeys[1]) == JMLIST_ERROR_FAILURE) &&
+			(jmlist_remove_by_ptr(jml,hkeys[1]) == JMLIST_ERROR_FAILURE) &&
+			(jmlist_remove_by_index(jml,5000) == JMLIST_ERROR_FAILURE) &&
+			(jmlist_seek_next(jml,&outer_handle,&ptr) == JMLIST_ERROR_SUCCESS);
+	jmlist_seek_end(jml,&outer_handle);
+
+	/* freezing and thawing the unordered list change it too */
+	jmlist_seek_start(jml,&outer_handle);
+	jmlist_freeze(jml);
+	if( jmlist_seek_next(jml,&outer_handle,&ptr) != JMLIST_ERROR_FAILURE )
+		seek_ok = false;
+	jmlist_seek_start(jml,&outer_handle);
+	jmlist_thaw(jml);
+	if( jmlist_seek_next(jml,&outer_handle,&ptr) != JMLIST_ERROR_FAILURE )
+		seek_ok = false;
+	jmlist_seek_end(jml,&outer_handle);
+	jmlist_free(jml);
+
+	params.flags = JMLIST_LINKED | JMLIST_SEEK_CHECKED;
+	jmlist_create(&jml,&params);
+	jmlist_insert(jml,hkeys[0]);
+	jmlist_insert(jml,hkeys[1]);
+	jmlist_seek_start(jml,&outer_handle);
+	jmlist_seek_next(jml,&outer_handle,&ptr);
+	if( (jmlist_remove_by_ptr(jml,hkeys[2]) != JMLIST_ERROR_FAILURE) ||
+			(jmlist_remove_by_index(jml,2) != JMLIST_ERROR_FAILURE) ||
+			(jmlist_pop(jml,0) != JMLIST_ERROR_FAILURE) ||
+			(jmlist_seek_next(jml,&outer_handle,&ptr) != JMLIST_ERROR_SUCCESS) )
+		seek_ok = false;
+	jmlist_insert(jml,hkeys[2]);
+	if( jmlist_seek_next(jml,&outer_handle,&ptr) != JMLIST_ERROR_FAILURE )
+		seek_ok = false;
+	jmlist_seek_end(jml,&outer_handle);
+	jmlist_free(jml);
+	if( seek_ok )
+		printf("  TEST #26.4 OK\n");
+	else
+		printf("  TEST #26.4 NOT OK\n");
+
+	/*
+	 * TEST 27: Test jmlist_seek_next_batch. Seeking in batches must give the same
+	 * entries as jmlist_seek_next, for each list type, and end with
+	 * JMLIST_ERROR_OUT_OF_BOUNDS.
+	 */
+	printf(	"\n  TEST #27 ------------------------------------------------------- \n"
+			"    Test seeking lists in batches.\n\n");
+
+	jmlist_flags batch_flags[4] = { JMLIST_INDEXED, JMLIST_LINKED, JMLIST_ASSOCIATIVE,
+			JMLIST_ASSOCIATIVE | JMLIST_ASS_ORDERED };
+	void *batch_one[1000];
+	void *batch_out[7];
+	jmlist_index batch_n, batch_total;
+	for( int t = 0 ; t < 4 ; t++ )
+	{
+		bool batch_ok = true;
+		int one_total = 0;
+
+		memset(&params,0,sizeof(params));
+		params.flags = batch_flags[t];
+		params.idx_list.malloc_inc = JMLIST_IDXLIST_DEF_MALLOC_INC;
+		jmlist_create(&jml,&params);
+		for( int i = 0 ; i < 1000 ; i++ )
+		{
+			if( jml->flags & JMLIST_ASSOCIATIVE )
+				jmlist_insert_with_key(jml,hkeys[i],5,hkeys[i]);
+			else
+				jmlist_insert(jml,hkeys[i]);
+		}
+		/* leave holes in the indexed list */
+		if( jml->flags & JMLIST_INDEXED )
+			for( int i = 0 ; i < 1000 ; i += 3 )
+				jmlist_remove_by_ptr(jml,hkeys[i]);
+
+		jmlist_seek_start(jml,&outer_handle);
+		while( jmlist_seek_next(jml,&outer_handle,&ptr) == JMLIST_ERROR_SUCCESS )
+			batch_one[one_total++] = ptr;
+		jmlist_seek_end(jml,&outer_handle);
+
+		batch_total = 0;
+		jmlist_seek_start(jml,&outer_handle);
+		while( (status = jmlist_seek_next_batch(jml,&outer_handle,batch_out,7,&batch_n)) == JMLIST_ERROR_SUCCESS )
+		{
+			for( jmlist_index i = 0 ; i < batch_n ; i++ )
+				if( (batch_total + i >= (jmlist_index)one_total) || (batch_out[i] != batch_one[batch_total + i]) )
+					batch_ok = false;
+			batch_total += batch_n;
+		}
+		if( (batch_n != 0) || (batch_total != (jmlist_index)one_total) ||
+				(jmlist_seek_next(jml,&outer_handle,&ptr) == JMLIST_ERROR_SUCCESS) )
+			batch_ok = false;
+		jmlist_seek_end(jml,&outer_handle);
+
+		if( batch_ok && (one_total > 0) )
+			printf("  TEST #27.%d OK\n",t+1);
+		else
+			printf("  TEST #27.%d NOT OK\n",t+1);
+		if( t < 3 )
+			jmlist_free(jml);
+	}
+
+	/* ranges, and batches mixed with single seeks on the same handle */
+	batch_total = 0;
+	jmlist_seek_range(jml,&outer_handle,hkeys[100],5,hkeys[200],5);
+	jmlist_seek_next(jml,&outer_handle,&ptr);
+	while( jmlist_seek_next_batch(jml,&outer_handle,batch_out,7,&batch_n) == JMLIST_ERROR_SUCCESS )
+	{
+		if( batch_out[0] != hkeys[101 + batch_total] )
+			break;
+		batch_total += batch_n;
+		if( jmlist_seek_next(jml,&outer_handle,&ptr) == JMLIST_ERROR_SUCCESS )
+			batch_total++;
+	}
+	jmlist_seek_end(jml,&outer_handle);
+	jmlist_freeze(jml);
+	jmlist_index frozen_total = 0;
+	jmlist_seek_range(jml,&outer_handle,hkeys[100],5,hkeys[200],5);
+	while( jmlist_seek_next_batch(jml,&outer_handle,batch_out,7,&batch_n) == JMLIST_ERROR_SUCCESS )
+		frozen_total += batch_n;
+	jmlist_seek_end(jml,&outer_handle);
+	if( (batch_total == 99) && (frozen_total == 100) &&
+			(jmlist_seek_next_batch(jml,&outer_handle,batch_out,7,&batch_n) == JMLIST_ERROR_FAILURE) )
+		printf("  TEST #27.5 OK\n");
+	else
+		printf("  TEST #27.5 NOT OK\n");
+	jmlist_free(jml);
+
+	/*
+	 * TEST 28: Test the iteration macros of jmlist_inline.h. Each list type is
+	 * looped with its own macro and with JMLIST_FOREACH, both must visit the
+	 * entries jmlist_seek_next returns, in the same order.
+	 */
+	printf(	"\n  TEST #28 ------------------------------------------------------- \n"
+			"    Test the inline iteration macros.\n\n");
+
+	for( int t = 0 ; t < 5 ; t++ )
+	{
+		bool foreach_ok = true;
+		int one_total = 0, own_total = 0, any_total = 0;
+		char *entry;
+
+		memset(&params,0,sizeof(params));
+		params.flags = (t < 4) ? batch_flags[t] : (JMLIST_INDEXED | JMLIST_IDX_USE_SHIFT);
+		params.idx_list.malloc_inc = JMLIST_IDXLIST_DEF_MALLOC_INC;
+		jmlist_create(&jml,&params);
+		for( int i = 0 ; i < 1000 ; i++ )
+		{
+			if( jml->flags & JMLIST_ASSOCIATIVE )
+				jmlist_insert_with_key(jml,hkeys[i],5,hkeys[i]);
+			else
+				jmlist_insert(jml,hkeys[i]);
+		}
+		for( int i = 0 ; i < 1000 ; i += 3 )
+		{
+			if( jml->flags & JMLIST_ASSOCIATIVE )
+				jmlist_remove_by_key(jml,hkeys[i],5);
+			else
+				jmlist_remove_by_ptr(jml,hkeys[i]);
+		}
+		/* ordered lists are looped a second time frozen */
+		for( int frozen = 0 ; frozen < ((t == 3) ? 2 : 1) ; frozen++ )
+		{
+			if( frozen )
+				jmlist_freeze(jml);
+
+			one_total = own_total = any_total = 0;
+			jmlist_seek_start(jml,&outer_handle);
+			while( jmlist_seek_next(jml,&outer_handle,&ptr) == JMLIST_ERROR_SUCCESS )
+				batch_one[one_total++] = ptr;
+			jmlist_seek_end(jml,&outer_handle);
+
+			if( jml->flags & JMLIST_INDEXED ) {
+				JMLIST_IDX_FOREACH(jml,entry)
+					if( (own_total >= one_total) || (entry != batch_one[own_total++]) )
+						foreach_ok = false;
+			} else if( jml->flags & JMLIST_LINKED ) {
+				JMLIST_LNK_FOREACH(jml,entry)
+					if( (own_total >= one_total) || (entry != batch_one[own_total++]) )
+						foreach_ok = false;
+			} else if( jml->flags & JMLIST_ASS_ORDERED ) {
+				JMLIST_BPT_FOREACH(jml,entry)
+					if( (own_total >= one_total) || (entry != batch_one[own_total++]) )
+						foreach_ok = false;
+			} else {
+				JMLIST_ASS_FOREACH(jml,entry)
+					if( (own_total >= one_total) || (entry != batch_one[own_total++]) )
+						foreach_ok = false;
+			}
+			JMLIST_FOREACH(jml,entry)
+			{
+				if( (any_total >= one_total) || (entry != batch_one[any_total++]) )
+					foreach_ok = false;
+			}
+			if( (own_total != one_total) || (any_total != one_total) ||
+					(jmlist_inline_count(jml) != (jmlist_index)one_total) )
+				foreach_ok = false;
+		}
+
+		if( foreach_ok && (one_total > 0) )
+			printf("  TEST #28.%d OK\n",t+1);
+		else
+			printf("  TEST #28.%d NOT OK\n",t+1);
+		jmlist_free(jml);
+	}
+
+	/*
+	 * TEST 29: Test jmlist_parse_parallel. Every entry must be passed to the
+	 * callback once, for each list type, with callbacks of uneven cost.
+	 */
+	printf(	"\n  TEST #29 ------------------------------------------------------- \n"
+			"    Test parsing lists with several threads.\n\n");
+
+	struct parse_arg *parse_arg = (struct parse_arg*)calloc(1,sizeof(struct parse_arg));
+	jmlist_flags parse_flags[6] = { JMLIST_INDEXED, JMLIST_LINKED, JMLIST_ASSOCIATIVE,
+			JMLIST_ASSOCIATIVE | JMLIST_ASS_ORDERED, JMLIST_ASSOCIATIVE | JMLIST_ASS_ORDERED,
+			JMLIST_ASSOCIATIVE | JMLIST_ASS_CONCURRENT };
+	pthread_mutex_init(&parse_arg->lock,0);
+	parse_arg->keys = hkeys;
+	for( int t = 0 ; t < 6 ; t++ )
+	{
+		bool parse_ok = true;
+
+		memset(&params,0,sizeof(params));
+		params.flags = parse_flags[t];
+		params.idx_list.malloc_inc = JMLIST_IDXLIST_DEF_MALLOC_INC;
+		jmlist_create(&jml,&params);
+		for( int i = 0 ; i < 5000 ; i++ )
+		{
+			if( jml->flags & JMLIST_ASSOCIATIVE )
+				jmlist_insert_with_key(jml,hkeys[i],5,hkeys[i]);
+			else
+				jmlist_insert(jml,hkeys[i]);
+		}
+		for( int i = 0 ; i < 5000 ; i += 7 )
+		{
+			if( jml->flags & JMLIST_ASSOCIATIVE )
+				jmlist_remove_by_key(jml,hkeys[i],5);
+			else
+				jmlist_remove_by_ptr(jml,hkeys[i]);
+		}
+		if( t == 4 )
+			jmlist_freeze(jml);
+
+		memset(parse_arg->marks,0,sizeof(parse_arg->marks));
+		parse_arg->calls = 0;
+		if( jmlist_parse_parallel(jml,parse_parallel_routine,parse_arg,4) != JMLIST_ERROR_SUCCESS )
+			parse_ok = false;
+		for( int i = 0 ; i < 5000 ; i++ )
+			if( parse_arg->marks[i] != ((i % 7) ? 1 : 0) )
+				parse_ok = false;
+
+		if( parse_ok && (parse_arg->calls == 5000 - 715) )
+			printf("  TEST #29.%d OK\n",t+1);
+		else
+			printf("  TEST #29.%d NOT OK\n",t+1);
+		if( t < 5 )
+			jmlist_free(jml);
+	}
+
+	/* the pool threads are reused, one per cpu with nthreads 0, nested parses */
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_LINKED;
+	jmlist parse_inner;
+	jmlist_create(&parse_inner,&params);
+	for( int i = 0 ; i < 200 ; i++ )
+		jmlist_insert(parse_inner,hkeys[i]);
+	parse_arg->inner = parse_inner;
+	memset(parse_arg->marks,0,sizeof(parse_arg->marks));
+	parse_arg->calls = 0;
+	parse_arg->inner_status = JMLIST_ERROR_FAILURE;
+	status = jmlist_parse_parallel(jml,parse_parallel_routine,parse_arg,0);
+	if( (status == JMLIST_ERROR_SUCCESS) && (parse_arg->inner_status == JMLIST_ERROR_SUCCESS) &&
+			(parse_arg->calls == 5000 - 715 + 200) && (parse_arg->marks[1] == 2) && (parse_arg->marks[211] == 1) &&
+			(jmlist_parse_parallel(jml,0,parse_arg,4) == JMLIST_ERROR_FAILURE) )
+		printf("  TEST #29.7 OK\n");
+	else
+		printf("  TEST #29.7 NOT OK\n");
+	jmlist_free(parse_inner);
+	jmlist_free(jml);
+	pthread_mutex_destroy(&parse_arg->lock);
+	free(parse_arg);
+
+	/*
+	 * TEST 30: Test jmlist_find_parallel. With JMLIST_FIND_FIRST the match must
+	 * be the first one in list order, same as jmlist_find, with JMLIST_FIND_ANY
+	 * any of the matches.
+	 */
+	printf(	"\n  TEST #30 ------------------------------------------------------- \n"
+			"    Test finding entries with several threads.\n\n");
+
+	struct find_arg find_arg = { .keys = hkeys };
+	jmlist_lookup_result find_result;
+	for( int t = 0 ; t < 4 ; t++ )
+	{
+		bool find_ok = true;
+
+		memset(&params,0,sizeof(params));
+		params.flags = batch_flags[t];
+		params.idx_list.malloc_inc = JMLIST_IDXLIST_DEF_MALLOC_INC;
+		jmlist_create(&jml,&params);
+		for( int i = 0 ; i < 5000 ; i++ )
+		{
+			if( jml->flags & JMLIST_ASS_ORDERED )
+				jmlist_insert_with_key(jml,hkeys[i],5,hkeys[i]);
+			else if( jml->flags & JMLIST_ASSOCIATIVE )
+				jmlist_insert_with_key(jml,hkeys[4999-i],5,hkeys[4999-i]);
+			else if( jml->flags & JMLIST_LINKED )
+				jmlist_insert(jml,hkeys[4999-i]);
+			else
+				jmlist_insert(jml,hkeys[i]);
+		}
+
+		/* linked and associative lists insert at the head, the entries are in
+		   key order in all of them */
+		for( int round = 0 ; round < 20 ; round++ )
+		{
+			find_arg.needle = 777;
+			ptr = 0;
+			if( (jmlist_find_parallel(jml,find_parallel_routine,&find_arg,JMLIST_FIND_FIRST,4,&find_result,&ptr) !=
+					JMLIST_ERROR_SUCCESS) || (find_result != jmlist_entry_found) || (ptr != hkeys[777]) )
+				find_ok = false;
+
+			ptr = 0;
+			if( (jmlist_find_parallel(jml,find_parallel_routine,&find_arg,JMLIST_FIND_ANY,4,&find_result,&ptr) !=
+					JMLIST_ERROR_SUCCESS) || (find_result != jmlist_entry_found) ||
+					!ptr || ((((char(*)[8])ptr - hkeys) % 1000) != 777) )
+				find_ok = false;
+
+			find_arg.needle = 1000;
+			if( (jmlist_find_parallel(jml,find_parallel_routine,&find_arg,JMLIST_FIND_ANY,4,&find_result,&ptr) !=
+					JMLIST_ERROR_SUCCESS) || (find_result != jmlist_entry_not_found) )
+				find_ok = false;
+		}
+
+		if( find_ok )
+			printf("  TEST #30.%d OK\n",t+1);
+		else
+			printf("  TEST #30.%d NOT OK\n",t+1);
+		jmlist_free(jml);
+	}
+
+	/*
+	 * TEST 31: Test jmlist_find_builtin against a plain loop, on indexed lists
+	 * with and without holes and integers of both signs as entries.
+	 */
+	printf(	"\n  TEST #31 ------------------------------------------------------- \n"
+			"    Test finding entries with builtin predicates.\n\n");
+
+	jmlist_index *builtin_ref = (jmlist_index*)malloc(5000*sizeof(jmlist_index));
+	jmlist_index *builtin_out = (jmlist_index*)malloc(5000*sizeof(jmlist_index));
+	jmlist_flags builtin_flags[2] = { JMLIST_INDEXED, JMLIST_INDEXED | JMLIST_IDX_USE_SHIFT };
+	for( int t = 0 ; t < 2 ; t++ )
+	{
+		bool builtin_ok = true;
+
+		memset(&params,0,sizeof(params));
+		params.flags = builtin_flags[t];
+		params.idx_list.malloc_inc = JMLIST_IDXLIST_DEF_MALLOC_INC;
+		jmlist_create(&jml,&params);
+
+		/* values 3*i-7499, never 0, -1 or 2 */
+		for( int i = 0 ; i < 5000 ; i++ )
+			jmlist_insert(jml,(void*)(intptr_t)(3*i-7499));
+		for( int i = 0 ; i < 5000 ; i += 7 )
+			jmlist_remove_by_index(jml,i);
+
+		intptr_t args[6][2] = {
+			{ (intptr_t)jml->idx_list.plist[1002], 0 },
+			{ (intptr_t)jml->idx_list.plist[1000], (intptr_t)jml->idx_list.plist[1500] },
+			{ -5, 0 },
+			{ 2, 0 },
+			{ -1200, 0 },
+			{ -1200, 1201 }
+		};
+		for( int pred = JMLIST_PRED_PTR_EQ ; pred <= JMLIST_PRED_INT_RANGE ; pred++ )
+		{
+			jmlist_index ref_count = find_builtin_reference(jml,pred,args[pred][0],args[pred][1],builtin_ref);
+			jmlist_index count = 0;
+
+			if( (jmlist_find_builtin(jml,pred,args[pred][0],args[pred][1],JMLIST_MATCH_COUNT,0,0,&count) !=
+					JMLIST_ERROR_SUCCESS) || (count != ref_count) )
+				builtin_ok = false;
+
+			if( (jmlist_find_builtin(jml,pred,args[pred][0],args[pred][1],JMLIST_MATCH_ALL,builtin_out,5000,&count) !=
+					JMLIST_ERROR_SUCCESS) || (count != ref_count) ||
+					memcmp(builtin_out,builtin_ref,count*sizeof(jmlist_index)) )
+				builtin_ok = false;
+
+			if( (jmlist_find_builtin(jml,pred,args[pred][0],args[pred][1],JMLIST_MATCH_FIRST,builtin_out,1,&count) !=
+					JMLIST_ERROR_SUCCESS) || (count != (ref_count ? 1 : 0)) || (count && (builtin_out[0] != builtin_ref[0])) )
+				builtin_ok = false;
+
+			if( !ref_count )
+				builtin_ok = false;
+		}
+
+		/* stored indexes are limited by cap, count is not */
+		jmlist_index count = 0;
+		if( (jmlist_find_builtin(jml,JMLIST_PRED_INT_LT,0,0,JMLIST_MATCH_ALL,builtin_out,3,&count) !=
+				JMLIST_ERROR_SUCCESS) || (count != find_builtin_reference(jml,JMLIST_PRED_INT_LT,0,0,builtin_ref)) ||
+				memcmp(builtin_out,builtin_ref,3*sizeof(jmlist_index)) )
+			builtin_ok = false;
+
+		if( (jmlist_find_builtin(jml,JMLIST_PRED_INT_EQ,2,0,JMLIST_MATCH_FIRST,builtin_out,1,&count) !=
+				JMLIST_ERROR_SUCCESS) || count )
+			builtin_ok = false;
+
+		if( builtin_ok )
+			printf("  TEST #31.%d OK\n",t+1);
+		else
+			printf("  TEST #31.%d NOT OK\n",t+1);
+		jmlist_free(jml);
+	}
+
+	/* other list types are not supported */
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_LINKED;
+	jmlist_create(&jml,&params);
+	jmlist_insert(jml,(void*)(intptr_t)1);
+	jmlist_index builtin_count;
+	if( jmlist_find_builtin(jml,JMLIST_PRED_INT_EQ,1,0,JMLIST_MATCH_COUNT,0,0,&builtin_count) == JMLIST_ERROR_FAILURE )
+		printf("  TEST #31.3 OK\n");
+	else
+		printf("  TEST #31.3 NOT OK\n");
+	jmlist_free(jml);
+	free(builtin_ref);
+	free(builtin_out);
+
+	/*
+	 * TEST 32: Test jmlist_seek_start_reverse and jmlist_seek_prev, the reverse
+	 * seek must return the entries of jmlist_seek_next in the opposite order on
+	 * all list types, and both directions can be mixed on one handle.
+	 */
+	printf(	"\n  TEST #32 ------------------------------------------------------- \n"
+			"    Test seeking lists backwards.\n\n");
+
+	void **reverse_fwd = (void**)malloc(5000*sizeof(void*));
+	jmlist_flags reverse_flags[6] = { JMLIST_INDEXED, JMLIST_INDEXED | JMLIST_IDX_USE_SHIFT, JMLIST_LINKED,
+			JMLIST_ASSOCIATIVE, JMLIST_ASSOCIATIVE | JMLIST_ASS_ORDERED, JMLIST_ASSOCIATIVE | JMLIST_ASS_ORDERED };
+	for( int t = 0 ; t < 6 ; t++ )
+	{
+		bool reverse_ok = true;
+		jmlist_seek_handle reverse_handle;
+		jmlist_index n = 0;
+
+		memset(&params,0,sizeof(params));
+		params.flags = reverse_flags[t];
+		params.idx_list.malloc_inc = JMLIST_IDXLIST_DEF_MALLOC_INC;
+		jmlist_create(&jml,&params);
+		for( int i = 0 ; i < 5000 ; i++ )
+		{
+			if( jml->flags & JMLIST_ASSOCIATIVE )
+				jmlist_insert_with_key(jml,hkeys[i],5,hkeys[i]);
+			else
+				jmlist_insert(jml,hkeys[i]);
+		}
+
+		/* holes in indexed lists, merged leaves in ordered lists */
+		for( int i = 0 ; i < 5000 ; i += 7 )
+		{
+			if( jml->flags & JMLIST_ASSOCIATIVE )
+				jmlist_remove_by_key(jml,hkeys[i],5);
+			else if( jml->flags & JMLIST_INDEXED )
+				jmlist_remove_by_index(jml,i);
+		}
+		if( t == 5 )
+			jmlist_freeze(jml);
+
+		jmlist_seek_start(jml,&reverse_handle);
+		while( jmlist_seek_next(jml,&reverse_handle,&ptr) == JMLIST_ERROR_SUCCESS )
+			reverse_fwd[n++] = ptr;
+		jmlist_seek_end(jml,&reverse_handle);
+
+		jmlist_seek_start_reverse(jml,&reverse_handle);
+		for( jmlist_index i = 0 ; i < n ; i++ )
+		{
+			if( (jmlist_seek_prev(jml,&reverse_handle,&ptr) != JMLIST_ERROR_SUCCESS) || (ptr != reverse_fwd[n-1-i]) )
+				reverse_ok = false;
+		}
+		if( jmlist_seek_prev(jml,&reverse_handle,&ptr) != JMLIST_ERROR_FAILURE )
+			reverse_ok = false;
+
+		/* back and forth, the handle is between two entries */
+		if( (jmlist_seek_next(jml,&reverse_handle,&ptr) != JMLIST_ERROR_SUCCESS) || (ptr != reverse_fwd[0]) ||
+				(jmlist_seek_next(jml,&reverse_handle,&ptr) != JMLIST_ERROR_SUCCESS) || (ptr != reverse_fwd[1]) ||
+				(jmlist_seek_prev(jml,&reverse_handle,&ptr) != JMLIST_ERROR_SUCCESS) || (ptr != reverse_fwd[1]) ||
+				(jmlist_seek_next(jml,&reverse_handle,&ptr) != JMLIST_ERROR_SUCCESS) || (ptr != reverse_fwd[1]) )
+			reverse_ok = false;
+		jmlist_seek_end(jml,&reverse_handle);
+
+		if( (jml->flags & JMLIST_ASS_ORDERED) &&
+				(jmlist_seek_range(jml,&reverse_handle,hkeys[10],5,hkeys[20],5) == JMLIST_ERROR_SUCCESS) )
+		{
+			if( jmlist_seek_prev(jml,&reverse_handle,&ptr) != JMLIST_ERROR_FAILURE )
+				reverse_ok = false;
+			jmlist_seek_end(jml,&reverse_handle);
+		}
+
+		if( !n )
+			reverse_ok = false;
+
+		if( reverse_ok )
+			printf("  TEST #32.%d OK\n",t+1);
+		else
+			printf("  TEST #32.%d NOT OK\n",t+1);
+		jmlist_free(jml);
+	}
+
+	/* empty list */
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_ASSOCIATIVE | JMLIST_ASS_ORDERED;
+	jmlist_create(&jml,&params);
+	if( (jmlist_seek_start_reverse(jml,&outer_handle) == JMLIST_ERROR_SUCCESS) &&
+			(jmlist_seek_prev(jml,&outer_handle,&ptr) == JMLIST_ERROR_FAILURE) )
+		printf("  TEST #32.7 OK\n");
+	else
+		printf("  TEST #32.7 NOT OK\n");
+	jmlist_seek_end(jml,&outer_handle);
+	jmlist_free(jml);
+
+	/* linked list inserting at tail, oldest first, the handle stacks the
+	   entries once and walks again after going forward */
+	bool tail_ok = true;
+	jmlist_index tail_n = 0;
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_LINKED | JMLIST_LNK_INSERT_AT_TAIL;
+	jmlist_create(&jml,&params);
+	jmlist_push(jml,hkeys[0]);
+	for( int i = 1 ; i < 5000 ; i++ )
+		jmlist_insert(jml,hkeys[i]);
+	jmlist_seek_start_reverse(jml,&outer_handle);
+	while( jmlist_seek_prev(jml,&outer_handle,&ptr) == JMLIST_ERROR_SUCCESS )
+	{
+		if( ptr != hkeys[4999-tail_n++] )
+			tail_ok = false;
+		if( tail_n == 2500 )
+		{
+			if( (jmlist_seek_next(jml,&outer_handle,&ptr) != JMLIST_ERROR_SUCCESS) || (ptr != hkeys[2500]) ||
+					(jmlist_seek_prev(jml,&outer_handle,&ptr) != JMLIST_ERROR_SUCCESS) || (ptr != hkeys[2500]) )
+				tail_ok = false;
+		}
+	}
+	jmlist_seek_end(jml,&outer_handle);
+	if( tail_ok && (tail_n == 5000) && !outer_handle.back.entries )
+		printf("  TEST #32.8 OK\n");
+	else
+		printf("  TEST #32.8 NOT OK\n");
+	jmlist_free(jml);
+
+	/* restarting a linked handle without jmlist_seek_end frees its stack, a
+	   copy of a handle stacks its own entries */
+	bool restart_ok = true;
+	void *restart_last = 0;
+	jmlist_seek_handle restart_copy;
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_LINKED;
+	jmlist_create(&jml,&params);
+	for( int i = 0 ; i < 100 ; i++ )
+		jmlist_insert(jml,hkeys[i]);
+	jmlist_seek_start_reverse(jml,&outer_handle);
+	for( int i = 0 ; i < 10 ; i++ )
+	{
+		if( jmlist_seek_prev(jml,&outer_handle,&ptr) != JMLIST_ERROR_SUCCESS )
+			restart_ok = false;
+		if( !i )
+			restart_last = ptr;
+	}
+	restart_copy = outer_handle;
+	if( (jmlist_seek_prev(jml,&restart_copy,&ptr) != JMLIST_ERROR_SUCCESS) ||
+			(restart_copy.back.entries == outer_handle.back.entries) )
+		restart_ok = false;
+	jmlist_seek_end(jml,&restart_copy);
+	jmlist_seek_start_reverse(jml,&outer_handle);
+	if( outer_handle.back.entries ||
+			(jmlist_seek_prev(jml,&outer_handle,&ptr) != JMLIST_ERROR_SUCCESS) || (ptr != restart_last) )
+		restart_ok = false;
+	jmlist_seek_start(jml,&outer_handle);
+	if( outer_handle.back.entries )
+		restart_ok = false;
+	jmlist_seek_end(jml,&outer_handle);
+	if( restart_ok )
+		printf("  TEST #32.9 OK\n");
+	else
+		printf("  TEST #32.9 NOT OK\n");
+	jmlist_free(jml);
+	free(reverse_fwd);
+
+	/*
+	 * TEST 33: Test pipelines. Odd entries of 1..5000 are squared and summed
+	 * by a fused pass with 1 and 4 threads, reduced in list order without a
+	 * combine callback and passed to a sink.
+	 */
+	printf(	"\n  TEST #33 ------------------------------------------------------- \n"
+			"    Test filter, map and reduce pipelines.\n\n");
+
+	jmlist_pipeline pipe;
+	uint64_t pipe_sum, pipe_expected = 0, pipe_hash, pipe_hash_expected = 0;
+	jmlist pipe_lists[2];
+
+	for( int i = 1 ; i <= 5000 ; i += 2 )
+		pipe_expected += (uint64_t)i*i;
+
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_INDEXED;
+	params.idx_list.malloc_inc = JMLIST_IDXLIST_DEF_MALLOC_INC;
+	jmlist_create(&pipe_lists[0],&params);
+	params.flags = JMLIST_LINKED;
+	jmlist_create(&pipe_lists[1],&params);
+	for( int i = 1 ; i <= 5000 ; i++ )
+	{
+		jmlist_insert(pipe_lists[0],(void*)(intptr_t)i);
+		jmlist_insert(pipe_lists[1],(void*)(intptr_t)i);
+	}
+
+	/* 33.1 and 33.2, sum of the squares of the odd entries */
+	for( int t = 0 ; t < 2 ; t++ )
+	{
+		bool pipe_ok = true;
+
+		jmlist_pipeline_init(pipe_lists[t],&pipe);
+		jmlist_pipeline_filter(&pipe,pipeline_odd,0);
+		jmlist_pipeline_map(&pipe,pipeline_square,0);
+		for( unsigned int nthreads = 1 ; nthreads <= 4 ; nthreads *= 4 )
+		{
+			pipe_sum = 0;
+			if( (jmlist_pipeline_reduce(&pipe,pipeline_add,pipeline_add_parts,&pipe_sum,sizeof(pipe_sum),0,nthreads) !=
+					JMLIST_ERROR_SUCCESS) || (pipe_sum != pipe_expected) )
+				pipe_ok = false;
+		}
+		if( !pipe_parts_aligned ||
+				(jmlist_pipeline_reduce(&pipe,pipeline_add,pipeline_add_parts,&pipe_sum,SIZE_MAX,0,4) != JMLIST_ERROR_FAILURE) )
+			pipe_ok = false;
+
+		if( pipe_ok )
+			printf("  TEST #33.%d OK\n",t+1);
+		else
+			printf("  TEST #33.%d NOT OK\n",t+1);
+	}
+
+	/* 33.3, order dependent reduce of the linked list (inserted at the head) */
+	for( int i = 5000 ; i >= 1 ; i-- )
+		if( i & 1 )
+			pipe_hash_expected = pipe_hash_expected*31 + (uint64_t)i*i;
+	jmlist_pipeline_init(pipe_lists[1],&pipe);
+	jmlist_pipeline_filter(&pipe,pipeline_odd,0);
+	jmlist_pipeline_map(&pipe,pipeline_square,0);
+	pipe_hash = 0;
+	if( (jmlist_pipeline_reduce(&pipe,pipeline_hash,0,&pipe_hash,sizeof(pipe_hash),0,4) == JMLIST_ERROR_SUCCESS) &&
+			(pipe_hash == pipe_hash_expected) )
+		printf("  TEST #33.3 OK\n");
+	else
+		printf("  TEST #33.3 NOT OK\n");
+
+	/* 33.4, sink gets the entries in list order */
+	struct pipeline_out *pipe_out = (struct pipeline_out*)calloc(1,sizeof(struct pipeline_out));
+	bool pipe_sink_ok = true;
+	jmlist_pipeline_init(pipe_lists[0],&pipe);
+	jmlist_pipeline_filter(&pipe,pipeline_odd,0);
+	if( (jmlist_pipeline_run(&pipe,pipeline_sink,pipe_out,1) != JMLIST_ERROR_SUCCESS) || (pipe_out->count != 2500) )
+		pipe_sink_ok = false;
+	for( int i = 0 ; pipe_sink_ok && (i < 2500) ; i++ )
+		if( pipe_out->out[i] != 2*i+1 )
+			pipe_sink_ok = false;
+	if( pipe_sink_ok )
+		printf("  TEST #33.4 OK\n");
+	else
+		printf("  TEST #33.4 NOT OK\n");
+	free(pipe_out);
+
+	/* 33.5, stages are limited and an empty list leaves acc as it is */
+	bool pipe_limit_ok = true;
+	jmlist_pipeline_init(pipe_lists[0],&pipe);
+	for( int i = 0 ; i < JMLIST_PIPELINE_MAX_STAGES ; i++ )
+		if( jmlist_pipeline_map(&pipe,pipeline_square,0) != JMLIST_ERROR_SUCCESS )
+			pipe_limit_ok = false;
+	if( jmlist_pipeline_filter(&pipe,pipeline_odd,0) != JMLIST_ERROR_FAILURE )
+		pipe_limit_ok = false;
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_LINKED;
+	jmlist_create(&jml,&params);
+	jmlist_pipeline_init(jml,&pipe);
+	pipe_sum = 7;
+	if( (jmlist_pipeline_reduce(&pipe,pipeline_add,pipeline_add_parts,&pipe_sum,sizeof(pipe_sum),0,4) != JMLIST_ERROR_SUCCESS) ||
+			(pipe_sum != 7) )
+		pipe_limit_ok = false;
+	jmlist_free(jml);
+	if( pipe_limit_ok )
+		printf("  TEST #33.5 OK\n");
+	else
+		printf("  TEST #33.5 NOT OK\n");
+
+	jmlist_free(pipe_lists[0]);
+	jmlist_free(pipe_lists[1]);
+
+	/*
+	 * TEST 34: Test snapshots. Lists of each supported type are changed after
+	 * a snapshot is taken, the snapshot must still have the entries it was
+	 * taken with, also while it's read by another thread.
+	 */
+	printf(	"\n  TEST #34 ------------------------------------------------------- \n"
+			"    Test copy-on-write snapshots.\n\n");
+
+	struct snapshot_arg snap_arg, snap_arg2;
+	jmlist_index snap_count;
+	jmlist_seek_handle snap_handle;
+	void *snap_ptr;
+	bool snap_ok;
+
+	memset(&snap_arg,0,sizeof(snap_arg));
+	memset(&snap_arg2,0,sizeof(snap_arg2));
+	snap_arg.expected = (intptr_t*)malloc(20000*sizeof(intptr_t));
+	snap_arg2.expected = (intptr_t*)malloc(20000*sizeof(intptr_t));
+
+	/* 34.1, indexed list with holes, filled and grown after the snapshot */
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_INDEXED;
+	params.idx_list.malloc_inc = JMLIST_IDXLIST_DEF_MALLOC_INC;
+	jmlist_create(&jml,&params);
+	for( int i = 0 ; i < 5000 ; i++ )
+	{
+		jmlist_insert(jml,(void*)(intptr_t)(i+1));
+		snap_arg.expected[i] = i+1;
+	}
+	snap_arg.count = 5000;
+	snap_ok = (jmlist_snapshot(jml,&snap_arg.snap) == JMLIST_ERROR_SUCCESS);
+	jmlist_replace_by_index(jml,10,(void*)(intptr_t)99999);
+	for( int i = 3 ; i <= 5000 ; i += 3 )
+		jmlist_remove_by_ptr(jml,(void*)(intptr_t)i);
+	for( int i = 0 ; i < 3000 ; i++ )
+		jmlist_insert(jml,(void*)(intptr_t)(100000+i));
+	if( !snapshot_verify(&snap_arg) )
+		snap_ok = false;
+	jmlist_snapshot_free(snap_arg.snap);
+	jmlist_entry_count(jml,&snap_count);
+	if( snap_count != 5000-1666+3000 )
+		snap_ok = false;
+	jmlist_free(jml);
+	if( snap_ok )
+		printf("  TEST #34.1 OK\n");
+	else
+		printf("  TEST #34.1 NOT OK\n");
+
+	/* 34.2, shifted indexed list, pushed, popped and removed by index */
+	params.flags = JMLIST_INDEXED | JMLIST_IDX_USE_SHIFT;
+	jmlist_create(&jml,&params);
+	for( int i = 0 ; i < 3000 ; i++ )
+	{
+		jmlist_insert(jml,(void*)(intptr_t)(i+1));
+		snap_arg.expected[i] = i+1;
+	}
+	snap_arg.count = 3000;
+	snap_ok = (jmlist_snapshot(jml,&snap_arg.snap) == JMLIST_ERROR_SUCCESS);
+	for( int i = 0 ; i < 100 ; i++ )
+		jmlist_push(jml,(void*)(intptr_t)(50000+i));
+	for( int i = 0 ; i < 150 ; i++ )
+		jmlist_pop(jml,&snap_ptr);
+	for( int i = 0 ; i < 50 ; i++ )
+		jmlist_remove_by_index(jml,100);
+	jmlist_remove_by_ptr(jml,(void*)(intptr_t)2000);
+	if( !snapshot_verify(&snap_arg) )
+		snap_ok = false;
+	jmlist_snapshot_free(snap_arg.snap);
+	jmlist_get_by_index(jml,0,&snap_ptr);
+	if( (intptr_t)snap_ptr != 51 )
+		snap_ok = false;
+	jmlist_free(jml);
+	if( snap_ok )
+		printf("  TEST #34.2 OK\n");
+	else
+		printf("  TEST #34.2 NOT OK\n");
+
+	/* 34.3, linked list with two snapshots taken at different times */
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_LINKED;
+	jmlist_create(&jml,&params);
+	for( int i = 1 ; i <= 2000 ; i++ )
+		jmlist_insert(jml,(void*)(intptr_t)i);
+	for( int i = 0 ; i < 2000 ; i++ )
+		snap_arg.expected[i] = 2000-i;
+	snap_arg.count = 2000;
+	snap_ok = (jmlist_snapshot(jml,&snap_arg.snap) == JMLIST_ERROR_SUCCESS);
+	for( int i = 0 ; i < 5 ; i++ )
+		jmlist_pop(jml,&snap_ptr);
+	jmlist_remove_by_ptr(jml,(void*)(intptr_t)1000);
+	jmlist_remove_by_ptr(jml,(void*)(intptr_t)1);
+	jmlist_remove_by_index(jml,3);
+	jmlist_replace_by_index(jml,0,(void*)(intptr_t)77777);
+	for( int i = 0 ; i < 3 ; i++ )
+		jmlist_insert(jml,(void*)(intptr_t)(80000+i));
+	if( !snapshot_verify(&snap_arg) )
+		snap_ok = false;
+
+	snap_arg2.count = 0;
+	jmlist_seek_start(jml,&snap_handle);
+	while( jmlist_seek_next(jml,&snap_handle,&snap_ptr) == JMLIST_ERROR_SUCCESS )
+		snap_arg2.expected[snap_arg2.count++] = (intptr_t)snap_ptr;
+	jmlist_seek_end(jml,&snap_handle);
+	if( jmlist_snapshot(jml,&snap_arg2.snap) != JMLIST_ERROR_SUCCESS )
+		snap_ok = false;
+	for( int i = 0 ; i < 500 ; i++ )
+		jmlist_remove_by_index(jml,i);
+	jmlist_replace_by_index(jml,7,(void*)(intptr_t)88888);
+	if( !snapshot_verify(&snap_arg) || !snapshot_verify(&snap_arg2) )
+		snap_ok = false;
+	jmlist_snapshot_free(snap_arg.snap);
+	if( !snapshot_verify(&snap_arg2) )
+		snap_ok = false;
+	jmlist_snapshot_free(snap_arg2.snap);
+	jmlist_entry_count(jml,&snap_count);
+	if( snap_count != 2000-8+3-500 )
+		snap_ok = false;
+	jmlist_free(jml);
+	if( snap_ok )
+		printf("  TEST #34.3 OK\n");
+	else
+		printf("  TEST #34.3 NOT OK\n");
+
+	/* 34.4, associative list, keys removed and inserted again */
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_ASSOCIATIVE;
+	jmlist_create(&jml,&params);
+	for( int i = 0 ; i < 5000 ; i++ )
+	{
+		jmlist_insert_with_key(jml,hkeys[i],5,(void*)(intptr_t)(i+1));
+		snap_arg.expected[4999-i] = i+1;
+	}
+	snap_arg.count = 5000;
+	snap_ok = (jmlist_snapshot(jml,&snap_arg.snap) == JMLIST_ERROR_SUCCESS);
+	for( int i = 0 ; i < 5000 ; i += 2 )
+		jmlist_remove_by_key(jml,hkeys[i],5);
+	jmlist_replace_by_index(jml,0,(void*)(intptr_t)77777);
+	for( int i = 0 ; i < 1000 ; i += 2 )
+		jmlist_insert_with_key(jml,hkeys[i],5,(void*)(intptr_t)(90000+i));
+	if( !snapshot_verify(&snap_arg) )
+		snap_ok = false;
+	jmlist_snapshot_free(snap_arg.snap);
+	if( (jmlist_get_by_key(jml,hkeys[10],5,&snap_ptr) != JMLIST_ERROR_SUCCESS) || ((intptr_t)snap_ptr != 90010) )
+		snap_ok = false;
+	jmlist_free(jml);
+	if( snap_ok )
+		printf("  TEST #34.4 OK\n");
+	else
+		printf("  TEST #34.4 NOT OK\n");
+
+	/* 34.5, ordered lists are not supported, snapshots of a freed list go stale */
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_ASSOCIATIVE | JMLIST_ASS_ORDERED;
+	jmlist_create(&jml,&params);
+	snap_ok = (jmlist_snapshot(jml,&snap_arg.snap) == JMLIST_ERROR_FAILURE);
+	jmlist_free(jml);
+	params.flags = JMLIST_LINKED;
+	jmlist_create(&jml,&params);
+	jmlist_insert(jml,(void*)(intptr_t)1);
+	jmlist_snapshot(jml,&snap_arg.snap);
+	jmlist_pop(jml,&snap_ptr);
+	jmlist_free(jml);
+	jmlist_snapshot_seek_start(snap_arg.snap,&snap_handle);
+	if( jmlist_snapshot_seek_next(snap_arg.snap,&snap_handle,&snap_ptr) != JMLIST_ERROR_FAILURE )
+		snap_ok = false;
+	if( jmlist_snapshot_free(snap_arg.snap) != JMLIST_ERROR_SUCCESS )
+		snap_ok = false;
+	if( snap_ok )
+		printf("  TEST #34.5 OK\n");
+	else
+		printf("  TEST #34.5 NOT OK\n");
+
+	/* 34.6 and 34.7, snapshot read by a thread while the list changes */
+	for( int t = 0 ; t < 2 ; t++ )
+	{
+		pthread_t snap_thread;
+
+		memset(&params,0,sizeof(params));
+		params.flags = t ? JMLIST_INDEXED : JMLIST_LINKED;
+		params.idx_list.malloc_inc = JMLIST_IDXLIST_DEF_MALLOC_INC;
+		jmlist_create(&jml,&params);
+		for( int i = 0 ; i < 20000 ; i++ )
+		{
+			jmlist_insert(jml,(void*)(intptr_t)(i+1));
+			snap_arg.expected[t ? i : 19999-i] = i+1;
+		}
+		snap_arg.count = 20000;
+		snap_arg.rounds = 20;
+		snap_arg.failures = 0;
+		jmlist_snapshot(jml,&snap_arg.snap);
+		pthread_create(&snap_thread,0,snapshot_routine,&snap_arg);
+		for( int i = 0 ; i < 2000 ; i++ )
+		{
+			if( t )
+			{
+				jmlist_remove_by_ptr(jml,(void*)(intptr_t)(i+1));
+				jmlist_insert(jml,(void*)(intptr_t)(100000+i));
+				jmlist_insert(jml,(void*)(intptr_t)(200000+i));
+			} else
+			{
+				jmlist_pop(jml,&snap_ptr);
+				jmlist_insert(jml,(void*)(intptr_t)(100000+i));
+				jmlist_replace_by_index(jml,10,(void*)(intptr_t)(200000+i));
+				jmlist_remove_by_index(jml,20);
+			}
+		}
+		pthread_join(snap_thread,0);
+		jmlist_snapshot_free(snap_arg.snap);
+		jmlist_free(jml);
+		if( !snap_arg.failures )
+			printf("  TEST #34.%d OK\n",t+6);
+		else
+			printf("  TEST #34.%d NOT OK\n",t+6);
+	}
+
+	/* 34.8, the list is freed while a thread reads a snapshot of it */
+	{
+		pthread_t snap_thread;
+
+		memset(&params,0,sizeof(params));
+		params.flags = JMLIST_LINKED;
+		jmlist_create(&jml,&params);
+		for( int i = 0 ; i < 20000 ; i++ )
+		{
+			jmlist_insert(jml,(void*)(intptr_t)(i+1));
+			snap_arg.expected[19999-i] = i+1;
+		}
+		snap_arg.count = 20000;
+		snap_arg.rounds = 1000000;
+		snap_arg.failures = 0;
+		jmlist_snapshot(jml,&snap_arg.snap);
+		pthread_create(&snap_thread,0,snapshot_stale_routine,&snap_arg);
+		for( int i = 0 ; i < 2000 ; i++ )
+			jmlist_pop(jml,&snap_ptr);
+		jmlist_free(jml);
+		pthread_join(snap_thread,0);
+		jmlist_snapshot_seek_start(snap_arg.snap,&snap_handle);
+		if( jmlist_snapshot_seek_next(snap_arg.snap,&snap_handle,&snap_ptr) != JMLIST_ERROR_FAILURE )
+			snap_arg.failures++;
+		jmlist_snapshot_free(snap_arg.snap);
+		if( !snap_arg.failures )
+			printf("  TEST #34.8 OK\n");
+		else
+			printf("  TEST #34.8 NOT OK\n");
+	}
+
+	free(snap_arg.expected);
+	free(snap_arg2.expected);
+
+	/*
+	 * TEST 35: Test removing the current entry of a seek. Every third entry is
+	 * removed while seeking indexed, shifted, linked and associative lists,
+	 * forwards and backwards, the seek must go on with the entries left.
+	 */
+	printf(	"\n  TEST #35 ------------------------------------------------------- \n"
+			"    Test jmlist_seek_remove_current.\n\n");
+
+	jmlist_seek_handle rm_handle, rm_other;
+	jmlist_index rm_count;
+	void *rm_ptr;
+	bool rm_ok;
+	int rm_seen;
+
+	/* 35.1 to 35.4, forward seeks */
+	for( int t = 0 ; t < 4 ; t++ )
+	{
+		memset(&params,0,sizeof(params));
+		params.flags = (t == 0) ? JMLIST_INDEXED : (t == 1) ? (JMLIST_INDEXED | JMLIST_IDX_USE_SHIFT) :
+				(t == 2) ? JMLIST_LINKED : JMLIST_ASSOCIATIVE;
+		params.idx_list.malloc_inc = JMLIST_IDXLIST_DEF_MALLOC_INC;
+		jmlist_create(&jml,&params);
+		for( int i = 1 ; i <= 5000 ; i++ )
+		{
+			if( t == 3 )
+				jmlist_insert_with_key(jml,hkeys[i-1],5,(void*)(intptr_t)i);
+			else
+				jmlist_insert(jml,(void*)(intptr_t)i);
+		}
+
+		rm_ok = true;
+		rm_seen = 0;
+		jmlist_seek_start(jml,&rm_handle);
+		if( jmlist_seek_remove_current(jml,&rm_handle) != JMLIST_ERROR_FAILURE )
+			rm_ok = false;
+		while( jmlist_seek_next(jml,&rm_handle,&rm_ptr) == JMLIST_ERROR_SUCCESS )
+		{
+			rm_seen++;
+			if( (intptr_t)rm_ptr % 3 )
+				continue;
+			if( jmlist_seek_remove_current(jml,&rm_handle) != JMLIST_ERROR_SUCCESS )
+				rm_ok = false;
+			if( jmlist_seek_remove_current(jml,&rm_handle) != JMLIST_ERROR_FAILURE )
+				rm_ok = false;
+		}
+		jmlist_seek_end(jml,&rm_handle);
+		if( rm_seen != 5000 )
+			rm_ok = false;
+
+		/* the entries left are the others, in the same order */
+		rm_seen = 0;
+		jmlist_seek_start(jml,&rm_handle);
+		while( jmlist_seek_next(jml,&rm_handle,&rm_ptr) == JMLIST_ERROR_SUCCESS )
+		{
+			if( !((intptr_t)rm_ptr % 3) )
+				rm_ok = false;
+			rm_seen++;
+		}
+		jmlist_seek_end(jml,&rm_handle);
+		jmlist_entry_count(jml,&rm_count);
+		if( (rm_seen != 3334) || (rm_count != 3334) )
+			rm_ok = false;
+		if( (t == 1) && ((jmlist_get_by_index(jml,2,&rm_ptr) != JMLIST_ERROR_SUCCESS) || ((intptr_t)rm_ptr != 4)) )
+			rm_ok = false;
+		if( (t == 3) && ((jmlist_get_by_key(jml,hkeys[2],5,&rm_ptr) != JMLIST_ERROR_FAILURE) ||
+				(jmlist_get_by_key(jml,hkeys[3],5,&rm_ptr) != JMLIST_ERROR_SUCCESS)) )
+			rm_ok = false;
+		jmlist_free(jml);
+
+		if( rm_ok )
+			printf("  TEST #35.%d OK\n",t+1);
+		else
+			printf("  TEST #35.%d NOT OK\n",t+1);
+	}
+
+	/* 35.5, backward seeks of linked and associative lists */
+	rm_ok = true;
+	for( int t = 0 ; t < 2 ; t++ )
+	{
+		memset(&params,0,sizeof(params));
+		params.flags = t ? JMLIST_ASSOCIATIVE : JMLIST_LINKED;
+		jmlist_create(&jml,&params);
+		for( int i = 1 ; i <= 1000 ; i++ )
+		{
+			if( t )
+				jmlist_insert_with_key(jml,hkeys[i-1],5,(void*)(intptr_t)i);
+			else
+				jmlist_insert(jml,(void*)(intptr_t)i);
+		}
+
+		rm_seen = 0;
+		jmlist_seek_start_reverse(jml,&rm_handle);
+		while( jmlist_seek_prev(jml,&rm_handle,&rm_ptr) == JMLIST_ERROR_SUCCESS )
+		{
+			rm_seen++;
+			if( !((intptr_t)rm_ptr % 3) && (jmlist_seek_remove_current(jml,&rm_handle) != JMLIST_ERROR_SUCCESS) )
+				rm_ok = false;
+		}
+		jmlist_seek_end(jml,&rm_handle);
+
+		/* list order is 1000 down to 1 */
+		intptr_t rm_expected = 1000;
+		jmlist_seek_start(jml,&rm_handle);
+		while( jmlist_seek_next(jml,&rm_handle,&rm_ptr) == JMLIST_ERROR_SUCCESS )
+		{
+			while( !(rm_expected % 3) )
+				rm_expected--;
+			if( (intptr_t)rm_ptr != rm_expected-- )
+				rm_ok = false;
+		}
+		jmlist_seek_end(jml,&rm_handle);
+		jmlist_entry_count(jml,&rm_count);
+		if( (rm_seen != 1000) || (rm_count != 667) )
+			rm_ok = false;
+		jmlist_free(jml);
+	}
+	if( rm_ok )
+		printf("  TEST #35.5 OK\n");
+	else
+		printf("  TEST #35.5 NOT OK\n");
+
+	/* 35.6, checked seeks: the removing handle goes on, the others go stale.
+	   ordered lists are not supported */
+	memset(&params,0,sizeof(params));
+	params.flags = JMLIST_LINKED | JMLIST_SEEK_CHECKED;
+	jmlist_create(&jml,&params);
+	for( int i = 1 ; i <= 10 ; i++ )
+		jmlist_insert(jml,(void*)(intptr_t)i);
+	jmlist_seek_start(jml,&rm_handle);
+	jmlist_seek_start(jml,&rm_other);
+	jmlist_seek_next(jml,&rm_handle,&rm_ptr);
+	rm_ok = (jmlist_seek_remove_current(jml,&rm_handle) == JMLIST_ERROR_SUCCESS);
+	if( (jmlist_seek_next(jml,&rm_handle,&rm_ptr) != JMLIST_ERROR_SUCCESS) || ((intptr_t)rm_ptr != 9) )
+		rm_ok = false;
+	if( jmlist_seek_next(jml,&rm_other,&rm_ptr) != JMLIST_ERROR_FAILURE )
+		rm_ok = false;
+	jmlist_free(jml);
+	params.flags = JMLIST_ASSOCIATIVE | JMLIST_ASS_ORDERED;
+	jmlist_create(&jml,&params);
+	jmlist_insert_with_key(jml,hkeys[0],5,(void*)(intptr_t)1);
+	jmlist_seek_start(jml,&rm_handle);
+	jmlist_seek_next(jml,&rm_handle,&rm_ptr);
+	if( jmlist_seek_remove_current(jml,&rm_handle) != JMLIST_ERROR_FAILURE )
+		rm_ok = false;
+	jmlist_seek_end(jml,&rm_handle);
+	jmlist_free(jml);
+	if( rm_ok )
+		printf("  TEST #35.6 OK\n");
+	else
+		printf("  TEST #35.6 NOT OK\n");
+
+	/* 35.7, unchecked associative seeks: an entry removed through another
+	   handle or by key is stale for remove_current, small and hashed lists */
+	rm_ok = true;
+	for( int t = 0 ; t < 2 ; t++ )
+	{
+		memset(&params,0,sizeof(params));
+		params.flags = JMLIST_ASSOCIATIVE;
+		jmlist_create(&jml,&params);
+		for( int i = 0 ; i < (t ? 1000 : 3) ; i++ )
+			jmlist_insert_with_key(jml,hkeys[i],5,hkeys[i]);
+		jmlist_seek_start(jml,&rm_handle);
+		jmlist_seek_start(jml,&rm_other);
+		jmlist_seek_next(jml,&rm_handle,&rm_ptr);
+		jmlist_seek_next(jml,&rm_other,&rm_ptr);
+		if( (jmlist_seek_remove_current(jml,&rm_other) != JMLIST_ERROR_SUCCESS) ||
+				(jmlist_seek_remove_current(jml,&rm_handle) != JMLIST_ERROR_FAILURE) ||
+				(jmlist_get_errno() != JMLIST_ERROR_STALE_SEEK) )
+			rm_ok = false;
+		jmlist_seek_next(jml,&rm_other,&rm_ptr);
+		jmlist_seek_start(jml,&rm_handle);
+		jmlist_seek_next(jml,&rm_handle,&rm_ptr);
+		if( (jmlist_remove_by_key(jml,rm_ptr,5) != JMLIST_ERROR_SUCCESS) ||
+				(jmlist_seek_remove_current(jml,&rm_handle) != JMLIST_ERROR_FAILURE) ||
+				(jmlist_get_errno() != JMLIST_ERROR_STALE_SEEK) )
+			rm_ok = false;
+		jmlist_seek_end(jml,&rm_handle);
+		jmlist_seek_end(jml,&rm_other);
+		jmlist_entry_count(jml,&rm_count);
+		if( rm_count != (t ? 998 : 1) )
+			rm_ok = false;
+		jmlist_free(jml);
+	}
+	if( rm_ok )
+		printf("  TEST #35.7 OK\n");
+	else
+		printf("  TEST #35.7 NOT OK\n");
+
 	/* END OF TESTS */
 	status = jmlist_memory_stats(&jml_mem);
 	jmlist_test_print_status("jmlist_memory_stats",status);